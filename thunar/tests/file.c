@@ -0,0 +1,541 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Loads ThunarFiles for generated directory trees and sorts them by name.
+ * The default mode checks that files of the same name share their display
+ * name and that sorting, also from several threads at once, is consistent.
+ * The perf mode (-m perf) reports the time and the memory loading the files
+ * takes and the time of the first sort, which creates the collation keys,
+ * and of a second one.
+ * The cache case loads and renames files from several threads at once and
+ * checks that each GFile keeps mapping to exactly one ThunarFile.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#define CACHE_N_THREADS 4
+#define CACHE_N_FILES   200
+
+#include "thunar/thunar-file.h"
+#include "thunar/thunar-gobject-extensions.h"
+#include "thunar/thunar-preferences.h"
+
+
+
+/* names found in many directories of a source tree or a web site */
+static const gchar *common_names[] = {
+  "README",
+  "Makefile",
+  "index.html",
+  "meson.build",
+};
+
+
+
+static gchar *
+tree_file_name (const gchar *path,
+                guint        dir,
+                guint        n)
+{
+  if (n < G_N_ELEMENTS (common_names))
+    return g_strdup_printf ("%s/Directory %u/%s", path, dir, common_names[n]);
+  else
+    return g_strdup_printf ("%s/Directory %u/%s-%u-%u.txt", path, dir, (n % 2) ? "Document" : "notes", dir, n);
+}
+
+
+
+static void
+create_tree (const gchar *path,
+             guint        n_dirs,
+             guint        n_files)
+{
+  gchar *name;
+  guint  n, m;
+
+  for (n = 0; n < n_dirs; n++)
+    {
+      name = g_strdup_printf ("%s/Directory %u", path, n);
+      g_assert_cmpint (g_mkdir (name, 0700), ==, 0);
+      g_free (name);
+
+      for (m = 0; m < n_files; m++)
+        {
+          name = tree_file_name (path, n, m);
+          g_assert_true (g_file_set_contents (name, "", 0, NULL));
+          g_free (name);
+        }
+    }
+}
+
+
+
+static GPtrArray *
+load_tree (const gchar *path,
+           guint        n_dirs,
+           guint        n_files)
+{
+  GPtrArray *files;
+  GFile     *gfile;
+  gchar     *name;
+  guint      n, m;
+
+  files = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (n = 0; n < n_dirs; n++)
+    for (m = 0; m < n_files; m++)
+      {
+        name = tree_file_name (path, n, m);
+        gfile = g_file_new_for_path (name);
+        g_ptr_array_add (files, thunar_file_get (gfile, NULL));
+        g_object_unref (gfile);
+        g_free (name);
+      }
+
+  return files;
+}
+
+
+
+static void
+remove_tree (const gchar *path)
+{
+  const gchar *name;
+  gchar       *child;
+  GDir        *dir;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          child = g_build_filename (path, name, NULL);
+          remove_tree (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+
+
+/* resident memory of the process in bytes, 0 if unknown */
+static gsize
+resident_size (void)
+{
+  gchar *contents;
+  gsize  pages = 0;
+  gchar *p;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return 0;
+
+  /* the second field is the resident set size in pages */
+  p = strchr (contents, ' ');
+  if (p != NULL)
+    pages = g_ascii_strtoull (p + 1, NULL, 10);
+  g_free (contents);
+
+#ifdef HAVE_UNISTD_H
+  return pages * sysconf (_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+
+
+static gint
+compare_by_name (gconstpointer a,
+                 gconstpointer b)
+{
+  return thunar_file_compare_by_name (*(ThunarFile *const *) a, *(ThunarFile *const *) b, FALSE);
+}
+
+
+
+static gpointer
+sort_files (gpointer data)
+{
+  GPtrArray *files = data;
+
+  g_ptr_array_sort (files, compare_by_name);
+
+  return files;
+}
+
+
+
+static GPtrArray *
+copy_files (GPtrArray *files)
+{
+  GPtrArray *copy;
+  guint      n;
+
+  copy = g_ptr_array_sized_new (files->len);
+  for (n = 0; n < files->len; n++)
+    g_ptr_array_add (copy, g_ptr_array_index (files, n));
+
+  return copy;
+}
+
+
+
+typedef struct
+{
+  const gchar *path;
+  guint        index;
+  GPtrArray   *files;
+  GPtrArray   *kept;
+} CacheThread;
+
+
+
+static GFile *
+cache_file (const gchar *path,
+            const gchar *prefix,
+            guint        n)
+{
+  GFile *gfile;
+  gchar *name;
+
+  name = g_strdup_printf ("%s/%s-%u", path, prefix, n);
+  gfile = g_file_new_for_path (name);
+  g_free (name);
+
+  return gfile;
+}
+
+
+
+static gpointer
+cache_get_files (gpointer data)
+{
+  CacheThread *thread = data;
+  GFile       *gfile;
+  guint        n, m;
+
+  /* start at different files, so the threads race for the same shards */
+  for (m = 0; m < CACHE_N_FILES; m++)
+    {
+      n = (m + thread->index * CACHE_N_FILES / CACHE_N_THREADS) % CACHE_N_FILES;
+
+      gfile = cache_file (thread->path, "file", n);
+      g_ptr_array_index (thread->files, n) = thunar_file_get (gfile, NULL);
+      g_object_unref (gfile);
+
+      gfile = cache_file (thread->path, "keep", n);
+      g_ptr_array_index (thread->kept, n) = thunar_file_get (gfile, NULL);
+      g_object_unref (gfile);
+    }
+
+  return thread;
+}
+
+
+
+static gpointer
+cache_replace_files (gpointer data)
+{
+  CacheThread *thread = data;
+  ThunarFile  *file;
+  GFile       *gfile;
+  GFile       *renamed;
+  gchar       *old_name, *new_name;
+  guint        n;
+
+  for (n = thread->index; n < CACHE_N_FILES; n += CACHE_N_THREADS)
+    {
+      gfile = cache_file (thread->path, "file", n);
+      renamed = cache_file (thread->path, "renamed", n);
+      old_name = g_file_get_path (gfile);
+      new_name = g_file_get_path (renamed);
+
+      /* like a rename by a job, while the others load files of the same shards */
+      g_assert_cmpint (g_rename (old_name, new_name), ==, 0);
+      thunar_file_replace_file (g_ptr_array_index (thread->files, n), renamed);
+
+      g_object_unref (gfile);
+      gfile = cache_file (thread->path, "keep", (n + CACHE_N_FILES / 2) % CACHE_N_FILES);
+      file = thunar_file_get (gfile, NULL);
+      g_assert_true (file == g_ptr_array_index (thread->kept, (n + CACHE_N_FILES / 2) % CACHE_N_FILES));
+      g_object_unref (file);
+
+      g_free (old_name);
+      g_free (new_name);
+      g_object_unref (renamed);
+      g_object_unref (gfile);
+    }
+
+  return thread;
+}
+
+
+
+static void
+test_shared_names (void)
+{
+  GPtrArray   *files;
+  const gchar *name;
+  gchar       *path;
+  guint        n, m;
+
+  path = g_dir_make_tmp ("thunar-file-XXXXXX", NULL);
+  g_assert_nonnull (path);
+  create_tree (path, 3, 8);
+  files = load_tree (path, 3, 8);
+
+  /* each README of the tree uses the same display name string */
+  for (m = 0; m < G_N_ELEMENTS (common_names); m++)
+    {
+      name = thunar_file_get_display_name (g_ptr_array_index (files, m));
+      g_assert_cmpstr (name, ==, common_names[m]);
+      for (n = 1; n < 3; n++)
+        g_assert_true (thunar_file_get_display_name (g_ptr_array_index (files, n * 8 + m)) == name);
+    }
+
+  g_ptr_array_unref (files);
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+static void
+test_sort (void)
+{
+  GPtrArray *files;
+  GPtrArray *sorted[4];
+  GThread   *threads[G_N_ELEMENTS (sorted)];
+  gchar     *path;
+  guint      n, m;
+
+  path = g_dir_make_tmp ("thunar-file-XXXXXX", NULL);
+  g_assert_nonnull (path);
+  create_tree (path, 20, 50);
+  files = load_tree (path, 20, 50);
+
+  /* the first sort creates the collation keys, let several threads race for them */
+  for (n = 0; n < G_N_ELEMENTS (sorted); n++)
+    threads[n] = g_thread_new ("sort", sort_files, copy_files (files));
+  for (n = 0; n < G_N_ELEMENTS (sorted); n++)
+    sorted[n] = g_thread_join (threads[n]);
+
+  for (m = 1; m < files->len; m++)
+    g_assert_cmpint (compare_by_name (&g_ptr_array_index (sorted[0], m - 1), &g_ptr_array_index (sorted[0], m)), <=, 0);
+
+  for (n = 1; n < G_N_ELEMENTS (sorted); n++)
+    for (m = 0; m < files->len; m++)
+      g_assert_true (g_ptr_array_index (sorted[n], m) == g_ptr_array_index (sorted[0], m));
+
+  for (n = 0; n < G_N_ELEMENTS (sorted); n++)
+    g_ptr_array_unref (sorted[n]);
+  g_ptr_array_unref (files);
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+static void
+test_cache (void)
+{
+  CacheThread threads[CACHE_N_THREADS];
+  GThread    *handles[CACHE_N_THREADS];
+  GHashTable *seen;
+  ThunarFile *file;
+  GFile      *gfile;
+  gchar      *path;
+  gchar      *name;
+  guint       n, t;
+  guint       n_files, hits, misses, contended;
+  guint       hits_before, misses_before;
+
+  path = g_dir_make_tmp ("thunar-file-XXXXXX", NULL);
+  g_assert_nonnull (path);
+  for (n = 0; n < CACHE_N_FILES; n++)
+    {
+      name = g_strdup_printf ("%s/file-%u", path, n);
+      g_assert_true (g_file_set_contents (name, "", 0, NULL));
+      g_free (name);
+      name = g_strdup_printf ("%s/keep-%u", path, n);
+      g_assert_true (g_file_set_contents (name, "", 0, NULL));
+      g_free (name);
+    }
+
+  thunar_file_cache_get_stats (NULL, &hits_before, &misses_before, NULL);
+
+  /* all threads load the same files at once */
+  for (t = 0; t < CACHE_N_THREADS; t++)
+    {
+      threads[t].path = path;
+      threads[t].index = t;
+      threads[t].files = g_ptr_array_new_full (CACHE_N_FILES, g_object_unref);
+      threads[t].kept = g_ptr_array_new_full (CACHE_N_FILES, g_object_unref);
+      g_ptr_array_set_size (threads[t].files, CACHE_N_FILES);
+      g_ptr_array_set_size (threads[t].kept, CACHE_N_FILES);
+      handles[t] = g_thread_new ("cache-get", cache_get_files, &threads[t]);
+    }
+  for (t = 0; t < CACHE_N_THREADS; t++)
+    g_thread_join (handles[t]);
+
+  /* each of them got the one ThunarFile of each GFile */
+  seen = g_hash_table_new (NULL, NULL);
+  for (n = 0; n < CACHE_N_FILES; n++)
+    {
+      g_assert_nonnull (g_ptr_array_index (threads[0].files, n));
+      g_assert_nonnull (g_ptr_array_index (threads[0].kept, n));
+      g_assert_true (g_hash_table_add (seen, g_ptr_array_index (threads[0].files, n)));
+      g_assert_true (g_hash_table_add (seen, g_ptr_array_index (threads[0].kept, n)));
+
+      for (t = 1; t < CACHE_N_THREADS; t++)
+        {
+          g_assert_true (g_ptr_array_index (threads[t].files, n) == g_ptr_array_index (threads[0].files, n));
+          g_assert_true (g_ptr_array_index (threads[t].kept, n) == g_ptr_array_index (threads[0].kept, n));
+        }
+    }
+  g_hash_table_destroy (seen);
+
+  /* every file was missed once and found by the other threads */
+  thunar_file_cache_get_stats (&n_files, &hits, &misses, &contended);
+  g_assert_cmpuint (n_files, >=, 2 * CACHE_N_FILES);
+  g_assert_cmpuint (misses - misses_before, >=, 2 * CACHE_N_FILES);
+  g_assert_cmpuint (hits - hits_before, >=, 2 * CACHE_N_FILES * (CACHE_N_THREADS - 1));
+  g_test_message ("%u files from %u threads: %u hits, %u misses, %u contended locks",
+                  2 * CACHE_N_FILES, CACHE_N_THREADS, hits - hits_before, misses - misses_before, contended);
+
+  /* rename them from several threads, each one its own part of the files */
+  for (t = 0; t < CACHE_N_THREADS; t++)
+    handles[t] = g_thread_new ("cache-replace", cache_replace_files, &threads[t]);
+  for (t = 0; t < CACHE_N_THREADS; t++)
+    g_thread_join (handles[t]);
+
+  /* the new location maps to the same ThunarFile, the old one to none */
+  for (n = 0; n < CACHE_N_FILES; n++)
+    {
+      gfile = cache_file (path, "renamed", n);
+      g_assert_true (g_file_equal (thunar_file_get_file (g_ptr_array_index (threads[0].files, n)), gfile));
+
+      file = thunar_file_cache_lookup (gfile);
+      g_assert_true (file == g_ptr_array_index (threads[0].files, n));
+      g_object_unref (file);
+
+      file = thunar_file_get (gfile, NULL);
+      g_assert_true (file == g_ptr_array_index (threads[0].files, n));
+      g_object_unref (file);
+      g_object_unref (gfile);
+
+      gfile = cache_file (path, "file", n);
+      g_assert_null (thunar_file_cache_lookup (gfile));
+      g_object_unref (gfile);
+    }
+
+  for (t = 0; t < CACHE_N_THREADS; t++)
+    {
+      g_ptr_array_unref (threads[t].files);
+      g_ptr_array_unref (threads[t].kept);
+    }
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+static void
+test_performance (void)
+{
+  /* directories and files per directory */
+  static const guint trees[][2] = {
+    { 100, 100 },  /*  10k files */
+    { 1000, 100 }, /* 100k files */
+  };
+  GPtrArray *files;
+  gdouble    load_time, first_sort_time, second_sort_time;
+  gchar     *path;
+  gsize      resident;
+  guint      n;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  for (n = 0; n < G_N_ELEMENTS (trees); n++)
+    {
+      path = g_dir_make_tmp ("thunar-file-XXXXXX", NULL);
+      g_assert_nonnull (path);
+      create_tree (path, trees[n][0], trees[n][1]);
+
+      resident = resident_size ();
+      g_test_timer_start ();
+      files = load_tree (path, trees[n][0], trees[n][1]);
+      load_time = g_test_timer_elapsed ();
+      resident = MAX (resident_size (), resident) - resident;
+
+      g_test_timer_start ();
+      sort_files (files);
+      first_sort_time = g_test_timer_elapsed ();
+
+      g_test_timer_start ();
+      sort_files (files);
+      second_sort_time = g_test_timer_elapsed ();
+
+      g_test_message ("%u files: loaded in %.1f ms, %" G_GSIZE_FORMAT " bytes resident per file, "
+                      "first sort %.1f ms, second sort %.1f ms",
+                      files->len, load_time * 1000.0, resident / files->len,
+                      first_sort_time * 1000.0, second_sort_time * 1000.0);
+      g_test_minimized_result (first_sort_time, "first sort of %u files", files->len);
+
+      g_ptr_array_unref (files);
+      remove_tree (path);
+      g_free (path);
+    }
+}
+
+
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  /* run on the default preferences, without touching the ones of the user */
+  thunar_preferences_xfconf_init_failed ();
+  thunar_g_initialize_transformations ();
+
+  g_test_add_func ("/file/shared-names", test_shared_names);
+  g_test_add_func ("/file/sort", test_sort);
+  g_test_add_func ("/file/cache", test_cache);
+  g_test_add_func ("/file/performance", test_performance);
+
+  return g_test_run ();
+}
@@ -0,0 +1,561 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Builds a search index over a generated directory tree and compares what
+ * a lookup finds with what a search without the index finds, first on the
+ * tree as it was indexed, then after files and folders were added and
+ * removed the way the folder monitors report it. The perf mode (-m perf)
+ * times lookups in an index of about a million entries.
+ *
+ * The index is written to a temporary cache directory, not to the one of
+ * the user.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include "thunar/thunar-file.h"
+#include "thunar/thunar-folder.h"
+#include "thunar/thunar-gobject-extensions.h"
+#include "thunar/thunar-preferences.h"
+#include "thunar/thunar-search-index.h"
+#include "thunar/thunar-tree-view-model.h"
+
+
+
+/* every MATCH_EVERY-th file of a directory matches the query */
+#define MATCH_EVERY (10)
+#define QUERY       "needle"
+
+/* how long monitor events may take to reach the index */
+#define EVENT_TIMEOUT (5 * G_TIME_SPAN_SECOND)
+
+/* a lookup should answer within this time, even on a large tree */
+#define LOOKUP_TARGET_MS (100.0)
+
+
+
+static void
+create_tree (const gchar *path,
+             guint        depth,
+             guint        n_dirs,
+             guint        n_files)
+{
+  gchar *name;
+  guint  n;
+
+  for (n = 0; n < n_files; n++)
+    {
+      if (n % MATCH_EVERY == 0)
+        name = g_strdup_printf ("%s/%s-%u.txt", path, QUERY, n);
+      else
+        name = g_strdup_printf ("%s/file-%u.txt", path, n);
+
+      g_assert_true (g_file_set_contents (name, "", 0, NULL));
+      g_free (name);
+    }
+
+  /* never part of the results, hidden files are not shown */
+  name = g_strdup_printf ("%s/.%s-hidden.txt", path, QUERY);
+  g_assert_true (g_file_set_contents (name, "", 0, NULL));
+  g_free (name);
+
+  if (depth == 0)
+    return;
+
+  for (n = 0; n < n_dirs; n++)
+    {
+      name = g_strdup_printf ("%s/dir-%u", path, n);
+      g_assert_cmpint (g_mkdir (name, 0700), ==, 0);
+      create_tree (name, depth - 1, n_dirs, n_files);
+      g_free (name);
+    }
+}
+
+
+
+static void
+remove_tree (const gchar *path)
+{
+  const gchar *name;
+  gchar       *child;
+  GDir        *dir;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          child = g_build_filename (path, name, NULL);
+          remove_tree (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+
+
+/* records the tree like a search does while walking it */
+static void
+index_tree (ThunarSearchIndexBuilder *builder,
+            const gchar              *path,
+            guint32                   parent)
+{
+  const gchar *name;
+  gchar       *child;
+  gchar       *key;
+  gboolean     is_directory;
+  guint32      id;
+  GDir        *dir;
+
+  dir = g_dir_open (path, 0, NULL);
+  g_assert_nonnull (dir);
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      /* the walk skips hidden files unless they are shown */
+      if (*name == '.')
+        continue;
+
+      child = g_build_filename (path, name, NULL);
+      is_directory = g_file_test (child, G_FILE_TEST_IS_DIR);
+      key = thunar_g_utf8_normalize_for_search (name, TRUE, TRUE);
+      id = thunar_search_index_builder_add (builder, parent, name, key, is_directory, FALSE);
+      if (is_directory)
+        index_tree (builder, child, id);
+      g_free (key);
+      g_free (child);
+    }
+
+  g_dir_close (dir);
+}
+
+
+
+static void
+build_index (const gchar *path)
+{
+  ThunarSearchIndexBuilder *builder;
+  GFile                    *gfile;
+
+  gfile = g_file_new_for_path (path);
+  builder = thunar_search_index_builder_new (gfile, FALSE);
+  g_assert_nonnull (builder);
+
+  index_tree (builder, path, THUNAR_SEARCH_INDEX_BUILDER_ROOT);
+  thunar_search_index_builder_commit (builder);
+
+  thunar_search_index_builder_free (builder);
+  g_object_unref (gfile);
+}
+
+
+
+static ThunarSearchMatcher *
+matcher_new (const gchar *query)
+{
+  ThunarSearchMatcher *matcher;
+  gchar               *normalized;
+  gchar              **terms;
+
+  normalized = thunar_g_utf8_normalize_for_search (query, TRUE, TRUE);
+  terms = thunar_util_split_search_query (normalized, NULL);
+  g_assert_nonnull (terms);
+  matcher = thunar_util_search_matcher_new (terms);
+  g_strfreev (terms);
+  g_free (normalized);
+
+  return matcher;
+}
+
+
+
+static gint
+compare_paths (gconstpointer a,
+               gconstpointer b)
+{
+  return strcmp (*(const gchar *const *) a, *(const gchar *const *) b);
+}
+
+
+
+static gchar **
+sorted_paths (GPtrArray *paths)
+{
+  g_ptr_array_sort (paths, compare_paths);
+  g_ptr_array_add (paths, NULL);
+
+  return (gchar **) g_ptr_array_free (paths, FALSE);
+}
+
+
+
+/* searches @path like a view does with the index turned off, so the
+ * results come from the search workers walking the folders */
+static void
+search_walk (const gchar *path,
+             GPtrArray   *paths)
+{
+  ThunarTreeViewModel *model;
+  ThunarFolder        *folder;
+  ThunarFile          *file;
+  GtkTreeIter          iter;
+  GMainLoop           *loop;
+  GFile               *gfile;
+  gchar               *query;
+  gboolean             valid;
+
+  gfile = g_file_new_for_path (path);
+  file = thunar_file_get (gfile, NULL);
+  g_assert_nonnull (file);
+  folder = thunar_folder_get_for_file (file);
+  g_assert_nonnull (folder);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  model = thunar_tree_view_model_new ();
+  g_signal_connect_swapped (model, "search-done", G_CALLBACK (g_main_loop_quit), loop);
+
+  /* the model strips the query in place */
+  query = g_strdup (QUERY);
+  thunar_tree_view_model_set_folder (model, folder, query);
+  g_main_loop_run (loop);
+
+  for (valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
+    {
+      ThunarFile *result = thunar_tree_view_model_get_file (model, &iter);
+
+      g_ptr_array_add (paths, g_file_get_path (thunar_file_get_file (result)));
+      g_object_unref (result);
+    }
+
+  thunar_tree_view_model_set_folder (model, NULL, NULL);
+  g_object_unref (model);
+  g_main_loop_unref (loop);
+  g_free (query);
+  g_object_unref (folder);
+  g_object_unref (file);
+  g_object_unref (gfile);
+}
+
+
+
+/* searches @path through the index, and walks the folders which are
+ * not part of it like the search job does */
+static gchar **
+search_index (const gchar *path,
+              guint       *n_unindexed)
+{
+  ThunarSearchMatcher *matcher;
+  GPtrArray           *paths;
+  GFile               *gfile;
+  GList               *files;
+  GList               *unindexed;
+  GList               *lp;
+
+  gfile = g_file_new_for_path (path);
+  matcher = matcher_new (QUERY);
+
+  g_assert_true (thunar_search_index_lookup (gfile, matcher, FALSE, &files, &unindexed));
+
+  paths = g_ptr_array_new ();
+  for (lp = files; lp != NULL; lp = lp->next)
+    g_ptr_array_add (paths, g_file_get_path (lp->data));
+  for (lp = unindexed; lp != NULL; lp = lp->next)
+    {
+      gchar *unindexed_path = g_file_get_path (lp->data);
+      search_walk (unindexed_path, paths);
+      g_free (unindexed_path);
+    }
+
+  *n_unindexed = g_list_length (unindexed);
+
+  g_list_free_full (files, g_object_unref);
+  g_list_free_full (unindexed, g_object_unref);
+  thunar_util_search_matcher_free (matcher);
+  g_object_unref (gfile);
+
+  return sorted_paths (paths);
+}
+
+
+
+/* the monitor events are applied in the background, so give the
+ * index some time to catch up before comparing */
+static void
+assert_index_matches_walk (const gchar *path,
+                           guint        n_unindexed_expected)
+{
+  GPtrArray *paths;
+  gchar    **walked;
+  gchar    **indexed = NULL;
+  guint      n_unindexed = 0;
+  gint64     end_time;
+
+  paths = g_ptr_array_new ();
+  search_walk (path, paths);
+  walked = sorted_paths (paths);
+  g_assert_nonnull (walked[0]);
+
+  end_time = g_get_monotonic_time () + EVENT_TIMEOUT;
+  for (;;)
+    {
+      indexed = search_index (path, &n_unindexed);
+      if ((g_strv_equal ((const gchar *const *) indexed, (const gchar *const *) walked) && n_unindexed == n_unindexed_expected)
+          || g_get_monotonic_time () > end_time)
+        break;
+
+      g_strfreev (indexed);
+      g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+    }
+
+  g_assert_cmpstrv (indexed, walked);
+  g_assert_cmpuint (n_unindexed, ==, n_unindexed_expected);
+
+  g_strfreev (indexed);
+  g_strfreev (walked);
+}
+
+
+
+static void
+report_added (const gchar *path)
+{
+  ThunarFile *file;
+  GFile      *gfile;
+
+  gfile = g_file_new_for_path (path);
+  file = thunar_file_get (gfile, NULL);
+  g_assert_nonnull (file);
+  thunar_search_index_file_added (file);
+  g_object_unref (file);
+  g_object_unref (gfile);
+}
+
+
+
+static void
+report_removed (const gchar *path)
+{
+  GFile *gfile;
+
+  gfile = g_file_new_for_path (path);
+  thunar_search_index_file_removed (gfile);
+  g_object_unref (gfile);
+}
+
+
+
+static void
+test_results (void)
+{
+  gchar *path;
+  gchar *name;
+
+  path = g_dir_make_tmp ("thunar-search-index-XXXXXX", NULL);
+  g_assert_nonnull (path);
+
+  /* 3 levels of 3 directories, 20 files each */
+  create_tree (path, 2, 3, 20);
+  build_index (path);
+  assert_index_matches_walk (path, 0);
+
+  /* a new file in an indexed folder comes from the overlay */
+  name = g_strdup_printf ("%s/dir-0/%s-added.txt", path, QUERY);
+  g_assert_true (g_file_set_contents (name, "", 0, NULL));
+  report_added (name);
+  g_free (name);
+  assert_index_matches_walk (path, 0);
+
+  /* hidden ones are left out, like by the walk */
+  name = g_strdup_printf ("%s/dir-0/.%s-added.txt", path, QUERY);
+  g_assert_true (g_file_set_contents (name, "", 0, NULL));
+  report_added (name);
+  g_free (name);
+  assert_index_matches_walk (path, 0);
+
+  /* removed files and folders are dropped, with everything inside */
+  name = g_strdup_printf ("%s/dir-1/%s-0.txt", path, QUERY);
+  g_assert_cmpint (g_remove (name), ==, 0);
+  report_removed (name);
+  g_free (name);
+  name = g_strdup_printf ("%s/dir-2", path);
+  remove_tree (name);
+  report_removed (name);
+  g_free (name);
+  assert_index_matches_walk (path, 0);
+
+  /* a new folder is not known to the index and has to be walked, which
+   * also finds what was created in it before the monitor reported it */
+  name = g_strdup_printf ("%s/dir-0/%s-folder", path, QUERY);
+  g_assert_cmpint (g_mkdir (name, 0700), ==, 0);
+  create_tree (name, 1, 2, 10);
+  report_added (name);
+  g_free (name);
+  assert_index_matches_walk (path, 1);
+
+  /* a removed folder vanishes from the unindexed ones as well */
+  name = g_strdup_printf ("%s/dir-0/%s-folder", path, QUERY);
+  remove_tree (name);
+  report_removed (name);
+  g_free (name);
+  assert_index_matches_walk (path, 0);
+
+  /* a search in a subfolder only sees what is inside of it */
+  name = g_strdup_printf ("%s/dir-0", path);
+  assert_index_matches_walk (name, 0);
+  g_free (name);
+
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+static void
+test_performance (void)
+{
+  /* queries on file names which are rare, common, and too short
+   * for the trigrams, so every entry has to be looked at */
+  static const gchar *queries[] = {
+    QUERY,
+    "report",
+    "ne",
+  };
+  ThunarSearchIndexBuilder *builder;
+  ThunarSearchMatcher      *matcher;
+  GFile                    *gfile;
+  GList                    *files;
+  GList                    *unindexed;
+  gdouble                   elapsed;
+  gchar                    *path;
+  gchar                    *name;
+  gchar                    *key;
+  guint32                   dir_id;
+  guint                     n_entries = 1;
+  guint                     n_results;
+  guint                     n, m;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  path = g_dir_make_tmp ("thunar-search-index-XXXXXX", NULL);
+  g_assert_nonnull (path);
+  gfile = g_file_new_for_path (path);
+
+  /* 1000 folders of 1000 files, which only exist in the index */
+  builder = thunar_search_index_builder_new (gfile, FALSE);
+  for (n = 0; n < 1000; n++)
+    {
+      name = g_strdup_printf ("Folder %u", n);
+      key = thunar_g_utf8_normalize_for_search (name, TRUE, TRUE);
+      dir_id = thunar_search_index_builder_add (builder, THUNAR_SEARCH_INDEX_BUILDER_ROOT, name, key, TRUE, FALSE);
+      g_free (key);
+      g_free (name);
+
+      for (m = 0; m < 1000; m++)
+        {
+          if (m % 1000 == 0)
+            name = g_strdup_printf ("%s %u-%u.txt", QUERY, n, m);
+          else if (m % 100 == 0)
+            name = g_strdup_printf ("Report %u-%u.odt", n, m);
+          else
+            name = g_strdup_printf ("Document %u-%u.txt", n, m);
+          key = thunar_g_utf8_normalize_for_search (name, TRUE, TRUE);
+          thunar_search_index_builder_add (builder, dir_id, name, key, FALSE, FALSE);
+          g_free (key);
+          g_free (name);
+        }
+
+      n_entries += 1001;
+    }
+
+  g_test_timer_start ();
+  thunar_search_index_builder_commit (builder);
+  elapsed = g_test_timer_elapsed ();
+  thunar_search_index_builder_free (builder);
+  g_test_message ("%u entries: index written in %.1f ms", n_entries, elapsed * 1000.0);
+
+  for (n = 0; n < G_N_ELEMENTS (queries); n++)
+    {
+      matcher = matcher_new (queries[n]);
+
+      g_test_timer_start ();
+      g_assert_true (thunar_search_index_lookup (gfile, matcher, FALSE, &files, &unindexed));
+      elapsed = g_test_timer_elapsed ();
+
+      n_results = g_list_length (files);
+      g_assert_cmpuint (n_results, >, 0);
+      g_assert_null (unindexed);
+
+      g_test_message ("%u entries, \"%s\": %u results in %.1f ms (target %.0f ms)",
+                      n_entries, queries[n], n_results, elapsed * 1000.0, LOOKUP_TARGET_MS);
+      g_test_minimized_result (elapsed, "lookup of \"%s\" in %u entries", queries[n], n_entries);
+
+      g_list_free_full (files, g_object_unref);
+      thunar_util_search_matcher_free (matcher);
+    }
+
+  g_object_unref (gfile);
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+int
+main (int    argc,
+      char **argv)
+{
+  gchar *cache_dir;
+  gint   result;
+
+  /* the index lives in the cache directory, which GLib looks up once */
+  cache_dir = g_dir_make_tmp ("thunar-search-index-cache-XXXXXX", NULL);
+  g_assert_nonnull (cache_dir);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  /* run on the default preferences, without touching the ones of the user */
+  thunar_preferences_xfconf_init_failed ();
+  thunar_g_initialize_transformations ();
+
+  g_test_add_func ("/search-index/results", test_results);
+  g_test_add_func ("/search-index/performance", test_performance);
+
+  result = g_test_run ();
+
+  remove_tree (cache_dir);
+  g_free (cache_dir);
+
+  return result;
+}
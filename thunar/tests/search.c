@@ -0,0 +1,314 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Runs searches the way a view does, through a ThunarTreeViewModel, on
+ * generated directory trees, and checks the search matcher on names with
+ * a term at every position. The default mode checks the results, the
+ * perf mode (-m perf) reports how many files per second a search in trees
+ * of growing size goes through, with 1, 2, 4 and 8 search workers.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+
+#include "thunar/thunar-file.h"
+#include "thunar/thunar-folder.h"
+#include "thunar/thunar-gobject-extensions.h"
+#include "thunar/thunar-preferences.h"
+#include "thunar/thunar-tree-view-model.h"
+#include "thunar/thunar-util.h"
+
+
+
+/* every MATCH_EVERY-th file of a directory matches the query */
+#define MATCH_EVERY (10)
+#define QUERY       "needle"
+
+
+
+static guint
+create_tree (const gchar *path,
+             guint        depth,
+             guint        n_dirs,
+             guint        n_files)
+{
+  gchar *name;
+  guint  n_matches = 0;
+  guint  n;
+
+  for (n = 0; n < n_files; n++)
+    {
+      if (n % MATCH_EVERY == 0)
+        {
+          name = g_strdup_printf ("%s/%s-%u.txt", path, QUERY, n);
+          n_matches++;
+        }
+      else
+        name = g_strdup_printf ("%s/file-%u.txt", path, n);
+
+      g_assert_true (g_file_set_contents (name, "", 0, NULL));
+      g_free (name);
+    }
+
+  if (depth == 0)
+    return n_matches;
+
+  for (n = 0; n < n_dirs; n++)
+    {
+      name = g_strdup_printf ("%s/dir-%u", path, n);
+      g_assert_cmpint (g_mkdir (name, 0700), ==, 0);
+      n_matches += create_tree (name, depth - 1, n_dirs, n_files);
+      g_free (name);
+    }
+
+  return n_matches;
+}
+
+
+
+static void
+remove_tree (const gchar *path)
+{
+  const gchar *name;
+  gchar       *child;
+  GDir        *dir;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          child = g_build_filename (path, name, NULL);
+          remove_tree (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+
+
+static guint
+search (const gchar *path,
+        gdouble     *elapsed)
+{
+  ThunarTreeViewModel *model;
+  ThunarFolder        *folder;
+  ThunarFile          *file;
+  GMainLoop           *loop;
+  GFile               *gfile;
+  gchar               *query;
+  guint                n_results;
+
+  gfile = g_file_new_for_path (path);
+  file = thunar_file_get (gfile, NULL);
+  g_assert_nonnull (file);
+  folder = thunar_folder_get_for_file (file);
+  g_assert_nonnull (folder);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  model = thunar_tree_view_model_new ();
+  g_signal_connect_swapped (model, "search-done", G_CALLBACK (g_main_loop_quit), loop);
+
+  /* the model strips the query in place */
+  query = g_strdup (QUERY);
+
+  g_test_timer_start ();
+  thunar_tree_view_model_set_folder (model, folder, query);
+  g_main_loop_run (loop);
+  if (elapsed != NULL)
+    *elapsed = g_test_timer_elapsed ();
+
+  n_results = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (model), NULL);
+
+  thunar_tree_view_model_set_folder (model, NULL, NULL);
+  g_object_unref (model);
+  g_main_loop_unref (loop);
+  g_free (query);
+  g_object_unref (folder);
+  g_object_unref (file);
+  g_object_unref (gfile);
+
+  return n_results;
+}
+
+
+
+static void
+test_results (void)
+{
+  gchar *path;
+  guint  n_matches;
+
+  path = g_dir_make_tmp ("thunar-search-XXXXXX", NULL);
+  g_assert_nonnull (path);
+
+  /* 4 levels of 3 directories, 20 files each */
+  n_matches = create_tree (path, 3, 3, 20);
+  g_assert_cmpuint (search (path, NULL), ==, n_matches);
+
+  /* the second search finds the same, with the files already cached */
+  g_assert_cmpuint (search (path, NULL), ==, n_matches);
+
+  remove_tree (path);
+  g_free (path);
+}
+
+
+
+/* whether @matcher finds @term in @str like strstr() on the normalized string */
+static void
+check_match (const gchar *str,
+             const gchar *term)
+{
+  ThunarSearchMatcher *matcher;
+  gchar               *terms[] = { (gchar *) term, NULL };
+  gchar               *normalized;
+  gboolean             expected;
+  gboolean             matched;
+
+  matcher = thunar_util_search_matcher_new (terms);
+  normalized = thunar_g_utf8_normalize_for_search (str, TRUE, TRUE);
+
+  expected = strstr (normalized, term) != NULL;
+  matched = thunar_util_search_matcher_match (matcher, str);
+  if (matched != expected)
+    g_test_fail_printf ("\"%s\" in \"%s\": matched %d, strstr %d", term, str, matched, expected);
+
+  g_free (normalized);
+  thunar_util_search_matcher_free (matcher);
+}
+
+
+
+static void
+test_matcher (void)
+{
+  /* the longer terms cross the 16 byte blocks the matcher scans */
+  static const gchar *terms[] = { "n", "ne", "nee", "needle", "needle-in-a-hay" };
+  /* the second and third repeat the first byte of the terms, in both cases */
+  static const gchar fillers[] = { '-', 'n', 'N' };
+  gchar  str[48];
+  gchar *prefixed;
+  gsize  len, pos, n, t, f;
+
+  for (len = 1; len <= 40; len++)
+    for (t = 0; t < G_N_ELEMENTS (terms); t++)
+      for (f = 0; f < G_N_ELEMENTS (fillers); f++)
+        for (pos = 0; pos < len; pos++)
+          {
+            memset (str, fillers[f], len);
+            str[len] = '\0';
+
+            /* in mixed case, cut off if it does not fit before the end */
+            for (n = 0; terms[t][n] != '\0' && pos + n < len; n++)
+              str[pos + n] = (n % 2 == 0) ? g_ascii_toupper (terms[t][n]) : terms[t][n];
+
+            check_match (str, terms[t]);
+
+            /* the same after normalizing, which is not only lowering the case */
+            prefixed = g_strconcat ("\xc3\x89", str, NULL);
+            check_match (prefixed, terms[t]);
+            g_free (prefixed);
+          }
+}
+
+
+
+static void
+test_performance (void)
+{
+  /* depth, directories per directory and files per directory */
+  static const guint trees[][3] = {
+    { 2, 10, 10 },  /*   1.1k files */
+    { 3, 10, 10 },  /*  11.1k files */
+    { 3, 10, 100 }, /* 111.1k files */
+  };
+  /* THUNAR_SEARCH_MAX_WORKERS is the upper bound */
+  static const guint workers[] = { 1, 2, 4, 8 };
+  gdouble elapsed;
+  gchar  *path;
+  gchar  *n_workers;
+  guint   n_files, n_dirs;
+  guint   n, w, level;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  for (n = 0; n < G_N_ELEMENTS (trees); n++)
+    {
+      path = g_dir_make_tmp ("thunar-search-XXXXXX", NULL);
+      g_assert_nonnull (path);
+      create_tree (path, trees[n][0], trees[n][1], trees[n][2]);
+
+      for (level = 0, n_dirs = 1, n_files = 0; level <= trees[n][0]; level++, n_dirs *= trees[n][1])
+        n_files += n_dirs * trees[n][2];
+
+      /* search once up front, so all worker counts find the
+       * directories in the page cache and the files loaded */
+      search (path, NULL);
+
+      /* the number of workers is read when a search starts */
+      for (w = 0; w < G_N_ELEMENTS (workers); w++)
+        {
+          n_workers = g_strdup_printf ("%u", workers[w]);
+          g_setenv ("THUNAR_SEARCH_WORKERS", n_workers, TRUE);
+          g_free (n_workers);
+
+          search (path, &elapsed);
+          g_test_message ("%u files, %u workers: %.1f ms, %.0f files/s",
+                          n_files, workers[w], elapsed * 1000.0, n_files / elapsed);
+          g_test_maximized_result (n_files / elapsed, "files/s in %u files with %u workers", n_files, workers[w]);
+        }
+
+      g_unsetenv ("THUNAR_SEARCH_WORKERS");
+
+      remove_tree (path);
+      g_free (path);
+    }
+}
+
+
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  /* run on the default preferences, without touching the ones of the user */
+  thunar_preferences_xfconf_init_failed ();
+  thunar_g_initialize_transformations ();
+
+  g_test_add_func ("/search/matcher", test_matcher);
+  g_test_add_func ("/search/results", test_results);
+  g_test_add_func ("/search/performance", test_performance);
+
+  return g_test_run ();
+}
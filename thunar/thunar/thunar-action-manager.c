@@ -29,6 +29,9 @@
 #include "thunar/thunar-action-manager.h"
 #include "thunar/thunar-application.h"
 #include "thunar/thunar-archive-dialog.h"
+#ifdef HAVE_LIBARCHIVE
+#include "thunar/thunar-archive-file.h"
+#endif
 #include "thunar/thunar-archive-job.h"
 #include "thunar/thunar-archive-utils.h"
 #include "thunar/thunar-browser.h"
@@ -40,6 +43,7 @@
 #include "thunar/thunar-gobject-extensions.h"
 #include "thunar/thunar-gtk-extensions.h"
 #include "thunar/thunar-icon-factory.h"
+#include "thunar/thunar-io-jobs.h"
 #include "thunar/thunar-io-scan-directory.h"
 #include "thunar/thunar-preferences.h"
 #include "thunar/thunar-private.h"
@@ -152,6 +156,12 @@ static void
 thunar_action_manager_open_paths (GAppInfo            *app_info,
                                   GList               *file_list,
                                   ThunarActionManager *action_mgr);
+#ifdef HAVE_LIBARCHIVE
+static gboolean
+thunar_action_manager_open_archive_members (GAppInfo            *app_info,
+                                            GList               *path_list,
+                                            ThunarActionManager *action_mgr);
+#endif
 static void
 thunar_action_manager_open_windows (ThunarActionManager *action_mgr,
                                     GList               *directories);
@@ -245,6 +255,8 @@ static gboolean
 thunar_action_manager_action_compress (ThunarActionManager *action_mgr);
 static gboolean
 thunar_action_manager_action_extract_here (ThunarActionManager *action_mgr);
+static gboolean
+thunar_action_manager_action_browse_archive (ThunarActionManager *action_mgr);
 static void
 thunar_action_manager_sendto_device (ThunarActionManager *action_mgr,
                                      ThunarDevice        *device);
@@ -376,6 +388,7 @@ static XfceGtkActionEntry thunar_action_manager_action_entries[] =
     { THUNAR_ACTION_MANAGER_ACTION_EJECT,              NULL,                                               "",                  XFCE_GTK_MENU_ITEM,       N_ ("_Eject"),                          N_ ("Eject the selected device"),                                                                            NULL,                  G_CALLBACK (thunar_action_manager_action_eject),               },
     { THUNAR_ACTION_MANAGER_ACTION_COMPRESS,           "<Actions>/ThunarActionManager/compress",           "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Co_mpress..."),                    N_ ("Create an archive from the selected files"),                                                            "package-x-generic",   G_CALLBACK (thunar_action_manager_action_compress),            },
     { THUNAR_ACTION_MANAGER_ACTION_EXTRACT_HERE,       "<Actions>/ThunarActionManager/extract-here",       "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("E_xtract Here"),                   N_ ("Extract the selected archive to the current folder"),                                                   "package-x-generic",   G_CALLBACK (thunar_action_manager_action_extract_here),        },
+    { THUNAR_ACTION_MANAGER_ACTION_BROWSE_ARCHIVE,     "<Actions>/ThunarActionManager/browse-archive",     "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("_Browse Archive"),                 N_ ("Show the contents of the selected archive without extracting it"),                                      "package-x-generic",   G_CALLBACK (thunar_action_manager_action_browse_archive),      },
     { THUNAR_ACTION_MANAGER_ACTION_ADD_TO_FAVORITES,      "<Actions>/ThunarActionManager/add-to-favorites",      "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Add to _Favorites"),               N_ ("Add the selected files to Favorites"),                                                                  "starred",             G_CALLBACK (thunar_action_manager_action_add_to_favorites),    },
     { THUNAR_ACTION_MANAGER_ACTION_REMOVE_FROM_FAVORITES, "<Actions>/ThunarActionManager/remove-from-favorites", "",                  XFCE_GTK_IMAGE_MENU_ITEM, N_ ("Remove from Fa_vorites"),          N_ ("Remove the selected files from Favorites"),                                                             "non-starred",         G_CALLBACK (thunar_action_manager_action_remove_from_favorites),},
 };
@@ -990,6 +1003,12 @@ thunar_action_manager_open_paths (GAppInfo            *app_info,
   gchar               *name;
   guint                n;
 
+#ifdef HAVE_LIBARCHIVE
+  /* members of a browsed archive are extracted before they are opened */
+  if (thunar_action_manager_open_archive_members (app_info, path_list, action_mgr))
+    return;
+#endif
+
   /* determine the screen on which to launch the application */
   screen = gtk_widget_get_screen (action_mgr->widget);
 
@@ -1046,6 +1065,130 @@ thunar_action_manager_open_paths (GAppInfo            *app_info,
 
 
 
+#ifdef HAVE_LIBARCHIVE
+static void
+thunar_action_manager_archive_member_error (ThunarJob           *job,
+                                            GError              *error,
+                                            ThunarActionManager *action_mgr)
+{
+  const gchar *member;
+
+  member = g_object_get_data (G_OBJECT (job), "archive-member");
+  thunar_dialogs_show_error (action_mgr->widget, error, _("Failed to open file \"%s\""), member);
+
+  /* nothing to open */
+  g_object_set_data (G_OBJECT (job), "archive-member-failed", GINT_TO_POINTER (TRUE));
+}
+
+
+
+static void
+thunar_action_manager_archive_member_finished (ThunarJob           *job,
+                                               ThunarActionManager *action_mgr)
+{
+  GAppInfo *app_info;
+  GList     path_list;
+
+  if (g_object_get_data (G_OBJECT (job), "archive-member-failed") != NULL)
+    return;
+
+  app_info = g_object_get_data (G_OBJECT (job), "app-info");
+
+  path_list.data = g_object_get_data (G_OBJECT (job), "target-file");
+  path_list.next = path_list.prev = NULL;
+
+  thunar_action_manager_open_paths (app_info, &path_list, action_mgr);
+}
+
+
+
+static GFile *
+thunar_action_manager_archive_member_target (ThunarArchiveFile *file)
+{
+  GFile *target_file;
+  gchar *uri;
+  gchar *checksum;
+  gchar *filename;
+
+  /* one directory per archive, so the members keep their names and layout */
+  uri = g_file_get_uri (thunar_archive_file_get_archive (file));
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  filename = g_build_filename (g_get_user_cache_dir (), "Thunar", "archives", checksum,
+                               thunar_archive_file_get_member (file), NULL);
+  target_file = g_file_new_for_path (filename);
+  g_free (filename);
+  g_free (checksum);
+  g_free (uri);
+
+  return target_file;
+}
+
+
+
+/**
+ * thunar_action_manager_open_archive_members:
+ * @app_info   : the application to open the files with.
+ * @path_list  : the #GFile<!---->s to open.
+ * @action_mgr : a #ThunarActionManager.
+ *
+ * Members of a browsed archive cannot be passed to other applications, so each
+ * of them is extracted on its own and opened once the extraction finished. The
+ * other files in @path_list are opened right away.
+ *
+ * Return value: %FALSE if @path_list contains no archive members.
+ **/
+static gboolean
+thunar_action_manager_open_archive_members (GAppInfo            *app_info,
+                                            GList               *path_list,
+                                            ThunarActionManager *action_mgr)
+{
+  ThunarArchiveFile *file;
+  ThunarJob         *job;
+  GFile             *target_file;
+  GList             *other_paths = NULL;
+  GList             *lp;
+  gboolean           has_members = FALSE;
+
+  for (lp = path_list; lp != NULL; lp = lp->next)
+    {
+      if (!THUNAR_IS_ARCHIVE_FILE (lp->data))
+        {
+          other_paths = g_list_prepend (other_paths, lp->data);
+          continue;
+        }
+
+      has_members = TRUE;
+      file = THUNAR_ARCHIVE_FILE (lp->data);
+      target_file = thunar_action_manager_archive_member_target (file);
+
+      job = thunar_io_jobs_extract_archive_member (thunar_archive_file_get_archive (file),
+                                                   thunar_archive_file_get_member (file),
+                                                   target_file);
+      g_object_set_data_full (G_OBJECT (job), "app-info", g_object_ref (app_info), g_object_unref);
+      g_object_set_data_full (G_OBJECT (job), "target-file", target_file, g_object_unref);
+      g_object_set_data_full (G_OBJECT (job), "archive-member",
+                              g_file_get_basename (G_FILE (file)), g_free);
+      g_signal_connect_object (job, "error", G_CALLBACK (thunar_action_manager_archive_member_error), action_mgr, 0);
+      g_signal_connect_object (job, "finished", G_CALLBACK (thunar_action_manager_archive_member_finished), action_mgr, 0);
+
+      thunar_job_launch (job);
+      g_object_unref (job);
+    }
+
+  if (has_members && other_paths != NULL)
+    {
+      other_paths = g_list_reverse (other_paths);
+      thunar_action_manager_open_paths (app_info, other_paths, action_mgr);
+    }
+
+  g_list_free (other_paths);
+
+  return has_members;
+}
+#endif
+
+
+
 static void
 thunar_action_manager_open_windows (ThunarActionManager *action_mgr,
                                     GList               *directories)
@@ -2030,6 +2173,18 @@ thunar_action_manager_append_menu_item (ThunarActionManager      *action_mgr,
         return item;
       }
 
+    case THUNAR_ACTION_MANAGER_ACTION_BROWSE_ARCHIVE:
+#ifdef HAVE_LIBARCHIVE
+      /* Only show browse if a single local archive is selected */
+      if (action_mgr->n_files_to_process != 1
+          || !thunar_file_is_local (THUNAR_FILE (action_mgr->files_to_process->data))
+          || !thunar_archive_utils_is_archive (THUNAR_FILE (action_mgr->files_to_process->data)))
+        return NULL;
+      return xfce_gtk_menu_item_new_from_action_entry (action_entry, G_OBJECT (action_mgr), GTK_MENU_SHELL (menu));
+#else
+      return NULL;
+#endif
+
     case THUNAR_ACTION_MANAGER_ACTION_ADD_TO_FAVORITES:
       {
         /* Only show if files are selected and not already all in favorites */
@@ -3165,7 +3320,7 @@ thunar_action_manager_create_document_submenu_new (ThunarActionManager *action_m
   if (G_LIKELY (templates_dir != NULL))
     {
       /* load the ThunarFiles */
-      files = thunar_io_scan_directory (NULL, templates_dir, G_FILE_QUERY_INFO_NONE, TRUE, FALSE, TRUE, &file_scan_limit, NULL);
+      files = thunar_io_scan_directory (NULL, templates_dir, G_FILE_QUERY_INFO_NONE, TRUE, FALSE, TRUE, &file_scan_limit, 0, NULL);
     }
 
   submenu = gtk_menu_new ();
@@ -3780,6 +3935,50 @@ thunar_action_manager_action_compress (ThunarActionManager *action_mgr)
 
 
 
+/**
+ * thunar_action_manager_action_browse_archive:
+ * @action_mgr : a #ThunarActionManager instance
+ *
+ * Shows the contents of the selected archive like a directory, using its index.
+ *
+ * Return value: TRUE if the action was handled.
+ **/
+static gboolean
+thunar_action_manager_action_browse_archive (ThunarActionManager *action_mgr)
+{
+#ifdef HAVE_LIBARCHIVE
+  ThunarFile *directory;
+  GError     *error = NULL;
+  GFile      *root;
+
+  _thunar_return_val_if_fail (THUNAR_IS_ACTION_MANAGER (action_mgr), FALSE);
+
+  if (action_mgr->files_to_process == NULL)
+    return FALSE;
+
+  root = thunar_archive_file_new (thunar_file_get_file (THUNAR_FILE (action_mgr->files_to_process->data)), "");
+  directory = thunar_file_get (root, &error);
+  g_object_unref (root);
+
+  if (directory == NULL)
+    {
+      thunar_dialogs_show_error (action_mgr->widget, error, _("Failed to open the archive"));
+      g_error_free (error);
+      return TRUE;
+    }
+
+  /* the folder enumerates the members from the index of the archive */
+  thunar_navigator_change_directory (THUNAR_NAVIGATOR (action_mgr), directory);
+  g_object_unref (directory);
+
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+
+
 /**
  * thunar_action_manager_action_extract_here:
  * @action_mgr : a #ThunarActionManager instance
@@ -82,6 +82,7 @@ typedef enum
   THUNAR_ACTION_MANAGER_ACTION_EJECT,
   THUNAR_ACTION_MANAGER_ACTION_COMPRESS,
   THUNAR_ACTION_MANAGER_ACTION_EXTRACT_HERE,
+  THUNAR_ACTION_MANAGER_ACTION_BROWSE_ARCHIVE,
   THUNAR_ACTION_MANAGER_ACTION_ADD_TO_FAVORITES,
   THUNAR_ACTION_MANAGER_ACTION_REMOVE_FROM_FAVORITES,
 
@@ -47,6 +47,9 @@
 #endif
 
 #include "thunar/thunar-application.h"
+#ifdef HAVE_LIBARCHIVE
+#include "thunar/thunar-archive-file.h"
+#endif
 #include "thunar/thunar-browser.h"
 #include "thunar/thunar-dbus-service.h"
 #include "thunar/thunar-dialogs.h"
@@ -410,6 +413,11 @@ thunar_application_startup (GApplication *gapp)
 
   thunar_application_dbus_init (application);
 
+#ifdef HAVE_LIBARCHIVE
+  /* allow browsing archives like directories */
+  thunar_archive_file_register ();
+#endif
+
   G_APPLICATION_CLASS (thunar_application_parent_class)->startup (gapp);
 
   /* connect to the session manager */
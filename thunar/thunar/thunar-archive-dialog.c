@@ -185,9 +185,19 @@ thunar_archive_dialog_init (ThunarArchiveDialog *dialog)
 
   /* Populate format combo box */
   formats = thunar_archive_utils_get_all_formats ();
+  dialog->selected_format = THUNAR_ARCHIVE_FORMAT_UNKNOWN;
   for (lp = formats; lp != NULL; lp = lp->next)
     {
       info = (const ThunarArchiveFormatInfo *) lp->data;
+
+      /* e.g. .tar.zst without zstd support */
+      if (!thunar_archive_utils_can_create (info->format))
+        continue;
+
+      /* the first format is the default, ZIP unless it is missing */
+      if (dialog->selected_format == THUNAR_ARCHIVE_FORMAT_UNKNOWN)
+        dialog->selected_format = info->format;
+
       text = g_strdup_printf ("%s (%s)", info->description, info->extension);
       gtk_combo_box_text_append (GTK_COMBO_BOX_TEXT (dialog->format_combo),
                                   info->name, text);
@@ -195,9 +205,7 @@ thunar_archive_dialog_init (ThunarArchiveDialog *dialog)
     }
   g_list_free (formats);
 
-  /* Set default format to ZIP */
   gtk_combo_box_set_active (GTK_COMBO_BOX (dialog->format_combo), 0);
-  dialog->selected_format = THUNAR_ARCHIVE_FORMAT_ZIP;
 
   g_signal_connect (G_OBJECT (dialog->format_combo), "changed",
                     G_CALLBACK (thunar_archive_dialog_format_changed), dialog);
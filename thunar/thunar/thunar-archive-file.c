@@ -0,0 +1,836 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * A ThunarArchiveFile is a read-only #GFile for a member of a local archive,
+ * backed by the #ThunarArchiveIndex of that archive. The URI scheme is
+ * registered with the default #GVfs, so a ThunarFolder lists the members
+ * of an archive like the files of any other directory.
+ *
+ * The URIs look like thunar-archive://<escaped archive uri>/<member path>.
+ * The root of the archive has an empty member path, its parent is the
+ * directory that contains the archive.
+ *
+ * Reading a member extracts only that member to a temporary file.
+ */
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "thunar/thunar-archive-file.h"
+#include "thunar/thunar-archive-index.h"
+#include "thunar/thunar-private.h"
+
+#include <glib/gi18n.h>
+
+
+
+#define THUNAR_ARCHIVE_FILE_URI_PREFIX THUNAR_ARCHIVE_FILE_SCHEME "://"
+
+
+
+typedef struct _ThunarArchiveEnumeratorClass ThunarArchiveEnumeratorClass;
+typedef struct _ThunarArchiveEnumerator      ThunarArchiveEnumerator;
+
+#define THUNAR_TYPE_ARCHIVE_ENUMERATOR (thunar_archive_enumerator_get_type ())
+#define THUNAR_ARCHIVE_ENUMERATOR(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_ARCHIVE_ENUMERATOR, ThunarArchiveEnumerator))
+
+GType thunar_archive_enumerator_get_type (void) G_GNUC_CONST;
+
+static void              thunar_archive_file_iface_init       (GFileIface      *iface);
+static void              thunar_archive_file_finalize         (GObject         *object);
+static void              thunar_archive_enumerator_finalize   (GObject         *object);
+static GFileInfo        *thunar_archive_enumerator_next_file  (GFileEnumerator *enumerator,
+                                                               GCancellable    *cancellable,
+                                                               GError         **error);
+static gboolean          thunar_archive_enumerator_close      (GFileEnumerator *enumerator,
+                                                               GCancellable    *cancellable,
+                                                               GError         **error);
+
+
+
+struct _ThunarArchiveFileClass
+{
+  GObjectClass __parent__;
+};
+
+struct _ThunarArchiveFile
+{
+  GObject  __parent__;
+
+  GFile   *archive_file;
+  gchar   *member;       /* relative to the archive root, "" for the root */
+};
+
+struct _ThunarArchiveEnumeratorClass
+{
+  GFileEnumeratorClass __parent__;
+};
+
+struct _ThunarArchiveEnumerator
+{
+  GFileEnumerator __parent__;
+
+  GList          *infos;
+};
+
+
+
+G_DEFINE_TYPE_WITH_CODE (ThunarArchiveFile, thunar_archive_file, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE (G_TYPE_FILE, thunar_archive_file_iface_init))
+
+G_DEFINE_TYPE (ThunarArchiveEnumerator, thunar_archive_enumerator, G_TYPE_FILE_ENUMERATOR)
+
+
+
+static void
+thunar_archive_file_class_init (ThunarArchiveFileClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_archive_file_finalize;
+}
+
+
+
+static void
+thunar_archive_file_init (ThunarArchiveFile *file)
+{
+  file->archive_file = NULL;
+  file->member = NULL;
+}
+
+
+
+static void
+thunar_archive_file_finalize (GObject *object)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (object);
+
+  g_object_unref (file->archive_file);
+  g_free (file->member);
+
+  (*G_OBJECT_CLASS (thunar_archive_file_parent_class)->finalize) (object);
+}
+
+
+
+/* joins @relative_path to @member and resolves "." and "..", without
+ * ever leaving the archive */
+static gchar *
+thunar_archive_file_resolve (const gchar *member,
+                             const gchar *relative_path)
+{
+  GString *path;
+  gchar  **parts;
+  gchar   *joined;
+  gchar   *slash;
+  guint    n;
+
+  if (*relative_path == '/')
+    joined = g_strdup (relative_path);
+  else
+    joined = g_strconcat (member, "/", relative_path, NULL);
+
+  path = g_string_new (NULL);
+  parts = g_strsplit (joined, "/", -1);
+
+  for (n = 0; parts[n] != NULL; n++)
+    {
+      if (*parts[n] == '\0' || strcmp (parts[n], ".") == 0)
+        continue;
+
+      if (strcmp (parts[n], "..") == 0)
+        {
+          slash = strrchr (path->str, '/');
+          g_string_truncate (path, (slash != NULL) ? (gsize) (slash - path->str) : 0);
+          continue;
+        }
+
+      if (path->len > 0)
+        g_string_append_c (path, '/');
+      g_string_append (path, parts[n]);
+    }
+
+  g_strfreev (parts);
+  g_free (joined);
+
+  return g_string_free (path, FALSE);
+}
+
+
+
+static GFileInfo *
+thunar_archive_file_info_new (const gchar *name,
+                              guint32      mode,
+                              guint64      size,
+                              gint64       mtime)
+{
+  GFileInfo *info;
+  GIcon     *icon;
+  gchar     *content_type;
+  gchar     *display_name;
+
+  info = g_file_info_new ();
+
+  if (S_ISDIR (mode))
+    {
+      g_file_info_set_file_type (info, G_FILE_TYPE_DIRECTORY);
+      content_type = g_strdup ("inode/directory");
+    }
+  else
+    {
+      g_file_info_set_file_type (info, S_ISREG (mode) ? G_FILE_TYPE_REGULAR : G_FILE_TYPE_SPECIAL);
+      content_type = g_content_type_guess (name, NULL, 0, NULL);
+    }
+
+  display_name = g_filename_display_name (name);
+  g_file_info_set_name (info, name);
+  g_file_info_set_display_name (info, display_name);
+  g_file_info_set_size (info, size);
+  g_file_info_set_is_hidden (info, *name == '.');
+  g_file_info_set_is_backup (info, g_str_has_suffix (name, "~"));
+  g_free (display_name);
+
+  g_file_info_set_content_type (info, content_type);
+  icon = g_content_type_get_icon (content_type);
+  g_file_info_set_icon (info, icon);
+  g_object_unref (icon);
+  icon = g_content_type_get_symbolic_icon (content_type);
+  g_file_info_set_symbolic_icon (info, icon);
+  g_object_unref (icon);
+  g_free (content_type);
+
+  g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED, MAX (mtime, 0));
+  g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE, mode);
+
+  /* archives are browsed read-only, and nothing is executed from them */
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, TRUE);
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, FALSE);
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, FALSE);
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE, FALSE);
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH, FALSE);
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME, FALSE);
+
+  return info;
+}
+
+
+
+/* looks up the member of @file in the index, @index_return is only set on success */
+static const ThunarArchiveMember *
+thunar_archive_file_lookup_member (ThunarArchiveFile   *file,
+                                   ThunarArchiveIndex **index_return,
+                                   GCancellable        *cancellable,
+                                   GError             **error)
+{
+  const ThunarArchiveMember *member;
+  ThunarArchiveIndex        *index;
+
+  index = thunar_archive_index_get (file->archive_file, cancellable, error);
+  if (index == NULL)
+    return NULL;
+
+  member = thunar_archive_index_lookup (index, file->member);
+  if (member == NULL)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                   _("\"%s\" is not a file in the archive"), file->member);
+      thunar_archive_index_unref (index);
+      return NULL;
+    }
+
+  *index_return = index;
+
+  return member;
+}
+
+
+
+static GFile *
+thunar_archive_file_dup (GFile *gfile)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+
+  return thunar_archive_file_new (file->archive_file, file->member);
+}
+
+
+
+static guint
+thunar_archive_file_hash (GFile *gfile)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+
+  return g_file_hash (file->archive_file) ^ g_str_hash (file->member);
+}
+
+
+
+static gboolean
+thunar_archive_file_equal (GFile *gfile1,
+                           GFile *gfile2)
+{
+  ThunarArchiveFile *file1 = THUNAR_ARCHIVE_FILE (gfile1);
+  ThunarArchiveFile *file2 = THUNAR_ARCHIVE_FILE (gfile2);
+
+  return strcmp (file1->member, file2->member) == 0
+         && g_file_equal (file1->archive_file, file2->archive_file);
+}
+
+
+
+static gboolean
+thunar_archive_file_is_native (GFile *gfile)
+{
+  return FALSE;
+}
+
+
+
+static gboolean
+thunar_archive_file_has_uri_scheme (GFile      *gfile,
+                                    const char *uri_scheme)
+{
+  return g_ascii_strcasecmp (uri_scheme, THUNAR_ARCHIVE_FILE_SCHEME) == 0;
+}
+
+
+
+static char *
+thunar_archive_file_get_uri_scheme (GFile *gfile)
+{
+  return g_strdup (THUNAR_ARCHIVE_FILE_SCHEME);
+}
+
+
+
+static char *
+thunar_archive_file_get_basename (GFile *gfile)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+  const gchar       *slash;
+
+  if (*file->member == '\0')
+    return g_file_get_basename (file->archive_file);
+
+  slash = strrchr (file->member, '/');
+
+  return g_strdup ((slash != NULL) ? slash + 1 : file->member);
+}
+
+
+
+static char *
+thunar_archive_file_get_path (GFile *gfile)
+{
+  /* members only exist inside of the archive */
+  return NULL;
+}
+
+
+
+static char *
+thunar_archive_file_get_uri (GFile *gfile)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+  gchar             *archive_uri;
+  gchar             *escaped_archive;
+  gchar             *escaped_member;
+  gchar             *uri;
+
+  archive_uri = g_file_get_uri (file->archive_file);
+  escaped_archive = g_uri_escape_string (archive_uri, NULL, FALSE);
+  escaped_member = g_uri_escape_string (file->member, "/", FALSE);
+
+  uri = g_strconcat (THUNAR_ARCHIVE_FILE_URI_PREFIX, escaped_archive, "/", escaped_member, NULL);
+
+  g_free (escaped_member);
+  g_free (escaped_archive);
+  g_free (archive_uri);
+
+  return uri;
+}
+
+
+
+static char *
+thunar_archive_file_get_parse_name (GFile *gfile)
+{
+  return thunar_archive_file_get_uri (gfile);
+}
+
+
+
+static GFile *
+thunar_archive_file_get_parent (GFile *gfile)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+  const gchar       *slash;
+  GFile             *parent;
+  gchar             *member;
+
+  /* leaving the archive */
+  if (*file->member == '\0')
+    return g_file_get_parent (file->archive_file);
+
+  slash = strrchr (file->member, '/');
+  member = (slash != NULL) ? g_strndup (file->member, slash - file->member) : g_strdup ("");
+  parent = thunar_archive_file_new (file->archive_file, member);
+  g_free (member);
+
+  return parent;
+}
+
+
+
+static gboolean
+thunar_archive_file_prefix_matches (GFile *prefix,
+                                    GFile *gfile)
+{
+  ThunarArchiveFile *prefix_file = THUNAR_ARCHIVE_FILE (prefix);
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+  gsize              len;
+
+  if (!g_file_equal (prefix_file->archive_file, file->archive_file))
+    return FALSE;
+
+  /* everything in the archive is below its root */
+  if (*prefix_file->member == '\0')
+    return *file->member != '\0';
+
+  len = strlen (prefix_file->member);
+
+  return strncmp (file->member, prefix_file->member, len) == 0 && file->member[len] == '/';
+}
+
+
+
+static char *
+thunar_archive_file_get_relative_path (GFile *parent,
+                                       GFile *descendant)
+{
+  ThunarArchiveFile *parent_file = THUNAR_ARCHIVE_FILE (parent);
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (descendant);
+  gsize              len;
+
+  if (!thunar_archive_file_prefix_matches (parent, descendant))
+    return NULL;
+
+  len = strlen (parent_file->member);
+
+  return g_strdup (file->member + ((len > 0) ? len + 1 : 0));
+}
+
+
+
+static GFile *
+thunar_archive_file_resolve_relative_path (GFile      *gfile,
+                                           const char *relative_path)
+{
+  ThunarArchiveFile *file = THUNAR_ARCHIVE_FILE (gfile);
+  GFile             *child;
+  gchar             *member;
+
+  member = thunar_archive_file_resolve (file->member, relative_path);
+  child = thunar_archive_file_new (file->archive_file, member);
+  g_free (member);
+
+  return child;
+}
+
+
+
+static GFile *
+thunar_archive_file_get_child_for_display_name (GFile      *gfile,
+                                                const char *display_name,
+                                                GError    **error)
+{
+  return thunar_archive_file_resolve_relative_path (gfile, display_name);
+}
+
+
+
+static GFileEnumerator *
+thunar_archive_file_enumerate_children (GFile              *gfile,
+                                        const char         *attributes,
+                                        GFileQueryInfoFlags flags,
+                                        GCancellable       *cancellable,
+                                        GError            **error)
+{
+  const ThunarArchiveMember *member;
+  ThunarArchiveEnumerator   *enumerator;
+  ThunarArchiveFile         *file = THUNAR_ARCHIVE_FILE (gfile);
+  ThunarArchiveIndex        *index;
+  GPtrArray                 *children;
+  guint                      n;
+
+  if (*file->member == '\0')
+    {
+      index = thunar_archive_index_get (file->archive_file, cancellable, error);
+      if (index == NULL)
+        return NULL;
+    }
+  else
+    {
+      member = thunar_archive_file_lookup_member (file, &index, cancellable, error);
+      if (member == NULL)
+        return NULL;
+
+      if (!S_ISDIR (member->mode))
+        {
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_DIRECTORY,
+                               _("The file is not a directory"));
+          thunar_archive_index_unref (index);
+          return NULL;
+        }
+    }
+
+  enumerator = g_object_new (THUNAR_TYPE_ARCHIVE_ENUMERATOR, "container", gfile, NULL);
+
+  /* an empty directory has no list */
+  children = thunar_archive_index_list (index, file->member);
+  for (n = (children != NULL) ? children->len : 0; n > 0; n--)
+    {
+      member = g_ptr_array_index (children, n - 1);
+      enumerator->infos = g_list_prepend (enumerator->infos,
+                                          thunar_archive_file_info_new (member->name, member->mode,
+                                                                        member->size, member->mtime));
+    }
+
+  thunar_archive_index_unref (index);
+
+  return G_FILE_ENUMERATOR (enumerator);
+}
+
+
+
+static GFileInfo *
+thunar_archive_file_query_info (GFile              *gfile,
+                                const char         *attributes,
+                                GFileQueryInfoFlags flags,
+                                GCancellable       *cancellable,
+                                GError            **error)
+{
+  const ThunarArchiveMember *member;
+  ThunarArchiveFile         *file = THUNAR_ARCHIVE_FILE (gfile);
+  ThunarArchiveIndex        *index;
+  GFileInfo                 *archive_info;
+  GFileInfo                 *info;
+
+  /* the root is the archive, shown as a directory */
+  if (*file->member == '\0')
+    {
+      archive_info = g_file_query_info (file->archive_file,
+                                        G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                        G_FILE_QUERY_INFO_NONE, cancellable, error);
+      if (archive_info == NULL)
+        return NULL;
+
+      info = thunar_archive_file_info_new (g_file_info_get_name (archive_info), S_IFDIR | 0555, 0,
+                                           g_file_info_get_attribute_uint64 (archive_info, G_FILE_ATTRIBUTE_TIME_MODIFIED));
+      g_object_unref (archive_info);
+
+      return info;
+    }
+
+  member = thunar_archive_file_lookup_member (file, &index, cancellable, error);
+  if (member == NULL)
+    return NULL;
+
+  info = thunar_archive_file_info_new (member->name, member->mode, member->size, member->mtime);
+  thunar_archive_index_unref (index);
+
+  return info;
+}
+
+
+
+static GFileInfo *
+thunar_archive_file_query_filesystem_info (GFile        *gfile,
+                                           const char   *attributes,
+                                           GCancellable *cancellable,
+                                           GError      **error)
+{
+  GFileInfo *info;
+
+  info = g_file_info_new ();
+  g_file_info_set_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE, "archive");
+  g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_FILESYSTEM_READONLY, TRUE);
+
+  return info;
+}
+
+
+
+static GFileInputStream *
+thunar_archive_file_read (GFile        *gfile,
+                          GCancellable *cancellable,
+                          GError      **error)
+{
+  const ThunarArchiveMember *member;
+  ThunarArchiveFile         *file = THUNAR_ARCHIVE_FILE (gfile);
+  ThunarArchiveIndex        *index;
+  GFileInputStream          *stream = NULL;
+  GFileIOStream             *iostream;
+  GFile                     *tmp_file;
+
+  member = thunar_archive_file_lookup_member (file, &index, cancellable, error);
+  if (member == NULL)
+    return NULL;
+
+  tmp_file = g_file_new_tmp ("thunar-archive-XXXXXX", &iostream, error);
+  if (tmp_file != NULL)
+    {
+      g_object_unref (iostream);
+
+      /* only this member is extracted, the others are skipped */
+      if (thunar_archive_index_extract (index, file->member, tmp_file, cancellable, error))
+        stream = g_file_read (tmp_file, cancellable, error);
+
+      /* the open stream keeps the contents around */
+      g_file_delete (tmp_file, NULL, NULL);
+      g_object_unref (tmp_file);
+    }
+
+  thunar_archive_index_unref (index);
+
+  return stream;
+}
+
+
+
+static void
+thunar_archive_file_iface_init (GFileIface *iface)
+{
+  iface->dup = thunar_archive_file_dup;
+  iface->hash = thunar_archive_file_hash;
+  iface->equal = thunar_archive_file_equal;
+  iface->is_native = thunar_archive_file_is_native;
+  iface->has_uri_scheme = thunar_archive_file_has_uri_scheme;
+  iface->get_uri_scheme = thunar_archive_file_get_uri_scheme;
+  iface->get_basename = thunar_archive_file_get_basename;
+  iface->get_path = thunar_archive_file_get_path;
+  iface->get_uri = thunar_archive_file_get_uri;
+  iface->get_parse_name = thunar_archive_file_get_parse_name;
+  iface->get_parent = thunar_archive_file_get_parent;
+  iface->prefix_matches = thunar_archive_file_prefix_matches;
+  iface->get_relative_path = thunar_archive_file_get_relative_path;
+  iface->resolve_relative_path = thunar_archive_file_resolve_relative_path;
+  iface->get_child_for_display_name = thunar_archive_file_get_child_for_display_name;
+  iface->enumerate_children = thunar_archive_file_enumerate_children;
+  iface->query_info = thunar_archive_file_query_info;
+  iface->query_filesystem_info = thunar_archive_file_query_filesystem_info;
+  iface->read_fn = thunar_archive_file_read;
+}
+
+
+
+static void
+thunar_archive_enumerator_class_init (ThunarArchiveEnumeratorClass *klass)
+{
+  GFileEnumeratorClass *enumerator_class;
+  GObjectClass         *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = thunar_archive_enumerator_finalize;
+
+  enumerator_class = G_FILE_ENUMERATOR_CLASS (klass);
+  enumerator_class->next_file = thunar_archive_enumerator_next_file;
+  enumerator_class->close_fn = thunar_archive_enumerator_close;
+}
+
+
+
+static void
+thunar_archive_enumerator_init (ThunarArchiveEnumerator *enumerator)
+{
+  enumerator->infos = NULL;
+}
+
+
+
+static void
+thunar_archive_enumerator_finalize (GObject *object)
+{
+  ThunarArchiveEnumerator *enumerator = THUNAR_ARCHIVE_ENUMERATOR (object);
+
+  g_list_free_full (enumerator->infos, g_object_unref);
+
+  (*G_OBJECT_CLASS (thunar_archive_enumerator_parent_class)->finalize) (object);
+}
+
+
+
+static GFileInfo *
+thunar_archive_enumerator_next_file (GFileEnumerator *enumerator,
+                                     GCancellable    *cancellable,
+                                     GError         **error)
+{
+  ThunarArchiveEnumerator *archive_enumerator = THUNAR_ARCHIVE_ENUMERATOR (enumerator);
+  GFileInfo               *info;
+
+  if (archive_enumerator->infos == NULL)
+    return NULL;
+
+  info = archive_enumerator->infos->data;
+  archive_enumerator->infos = g_list_delete_link (archive_enumerator->infos, archive_enumerator->infos);
+
+  return info;
+}
+
+
+
+static gboolean
+thunar_archive_enumerator_close (GFileEnumerator *enumerator,
+                                 GCancellable    *cancellable,
+                                 GError         **error)
+{
+  ThunarArchiveEnumerator *archive_enumerator = THUNAR_ARCHIVE_ENUMERATOR (enumerator);
+
+  g_list_free_full (archive_enumerator->infos, g_object_unref);
+  archive_enumerator->infos = NULL;
+
+  return TRUE;
+}
+
+
+
+static GFile *
+thunar_archive_file_lookup (GVfs       *vfs,
+                            const char *identifier,
+                            gpointer    user_data)
+{
+  const gchar *host;
+  const gchar *slash;
+  GFile       *archive_file;
+  GFile       *file = NULL;
+  gchar       *escaped_archive;
+  gchar       *archive_uri;
+  gchar       *member;
+
+  if (g_ascii_strncasecmp (identifier, THUNAR_ARCHIVE_FILE_URI_PREFIX, strlen (THUNAR_ARCHIVE_FILE_URI_PREFIX)) != 0)
+    return NULL;
+
+  host = identifier + strlen (THUNAR_ARCHIVE_FILE_URI_PREFIX);
+  slash = strchr (host, '/');
+
+  escaped_archive = (slash != NULL) ? g_strndup (host, slash - host) : g_strdup (host);
+  archive_uri = g_uri_unescape_string (escaped_archive, NULL);
+  member = g_uri_unescape_string ((slash != NULL) ? slash + 1 : "", NULL);
+
+  if (archive_uri != NULL && *archive_uri != '\0' && member != NULL)
+    {
+      archive_file = g_file_new_for_uri (archive_uri);
+      file = thunar_archive_file_new (archive_file, member);
+      g_object_unref (archive_file);
+    }
+
+  g_free (member);
+  g_free (archive_uri);
+  g_free (escaped_archive);
+
+  /* let gio fall back to its default */
+  return file;
+}
+
+
+
+/**
+ * thunar_archive_file_register:
+ *
+ * Registers the THUNAR_ARCHIVE_FILE_SCHEME URI scheme with the default
+ * #GVfs, so g_file_new_for_uri() and g_file_parse_name() return
+ * #ThunarArchiveFile<!---->s for it. Call once on startup.
+ **/
+void
+thunar_archive_file_register (void)
+{
+  if (!g_vfs_register_uri_scheme (g_vfs_get_default (), THUNAR_ARCHIVE_FILE_SCHEME,
+                                  thunar_archive_file_lookup, NULL, NULL,
+                                  thunar_archive_file_lookup, NULL, NULL))
+    g_warning ("Failed to register the %s URI scheme", THUNAR_ARCHIVE_FILE_SCHEME);
+}
+
+
+
+/**
+ * thunar_archive_file_new:
+ * @archive_file : a local archive.
+ * @member       : the path of a member of @archive_file, or "" for the
+ *                 root of the archive.
+ *
+ * Return value: a #GFile for @member. Release with g_object_unref().
+ **/
+GFile *
+thunar_archive_file_new (GFile       *archive_file,
+                         const gchar *member)
+{
+  ThunarArchiveFile *file;
+
+  _thunar_return_val_if_fail (G_IS_FILE (archive_file), NULL);
+  _thunar_return_val_if_fail (member != NULL, NULL);
+
+  file = g_object_new (THUNAR_TYPE_ARCHIVE_FILE, NULL);
+  file->archive_file = g_object_ref (archive_file);
+  file->member = thunar_archive_file_resolve ("", member);
+
+  return G_FILE (file);
+}
+
+
+
+/**
+ * thunar_archive_file_get_archive:
+ * @file : a #ThunarArchiveFile.
+ *
+ * Return value: the archive which contains @file, owned by @file.
+ **/
+GFile *
+thunar_archive_file_get_archive (ThunarArchiveFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_ARCHIVE_FILE (file), NULL);
+
+  return file->archive_file;
+}
+
+
+
+/**
+ * thunar_archive_file_get_member:
+ * @file : a #ThunarArchiveFile.
+ *
+ * Return value: the path of @file inside of the archive, "" for the root.
+ **/
+const gchar *
+thunar_archive_file_get_member (ThunarArchiveFile *file)
+{
+  _thunar_return_val_if_fail (THUNAR_IS_ARCHIVE_FILE (file), NULL);
+
+  return file->member;
+}
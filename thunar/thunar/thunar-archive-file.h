@@ -0,0 +1,54 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_ARCHIVE_FILE_H__
+#define __THUNAR_ARCHIVE_FILE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS;
+
+/* URI scheme of the files inside of a browsed archive */
+#define THUNAR_ARCHIVE_FILE_SCHEME "thunar-archive"
+
+typedef struct _ThunarArchiveFileClass ThunarArchiveFileClass;
+typedef struct _ThunarArchiveFile      ThunarArchiveFile;
+
+#define THUNAR_TYPE_ARCHIVE_FILE            (thunar_archive_file_get_type ())
+#define THUNAR_ARCHIVE_FILE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), THUNAR_TYPE_ARCHIVE_FILE, ThunarArchiveFile))
+#define THUNAR_ARCHIVE_FILE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), THUNAR_TYPE_ARCHIVE_FILE, ThunarArchiveFileClass))
+#define THUNAR_IS_ARCHIVE_FILE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), THUNAR_TYPE_ARCHIVE_FILE))
+#define THUNAR_IS_ARCHIVE_FILE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), THUNAR_TYPE_ARCHIVE_FILE))
+#define THUNAR_ARCHIVE_FILE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), THUNAR_TYPE_ARCHIVE_FILE, ThunarArchiveFileClass))
+
+GType        thunar_archive_file_get_type     (void) G_GNUC_CONST;
+
+void         thunar_archive_file_register     (void);
+
+GFile       *thunar_archive_file_new          (GFile             *archive_file,
+                                               const gchar       *member) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+
+GFile       *thunar_archive_file_get_archive  (ThunarArchiveFile *file);
+
+const gchar *thunar_archive_file_get_member   (ThunarArchiveFile *file);
+
+G_END_DECLS;
+
+#endif /* !__THUNAR_ARCHIVE_FILE_H__ */
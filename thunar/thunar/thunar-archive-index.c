@@ -0,0 +1,759 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The archive index lists the members of an archive, so that an archive can
+ * be browsed without unpacking it. Building the index only reads the headers
+ * of the members and skips their data, which for zip and 7z archives means
+ * reading just the central directory.
+ *
+ * Indexes are cached in the user's cache directory, one file per archive named
+ * after the checksum of its URI. The file holds a serialized GVariant of the
+ * type THUNAR_ARCHIVE_INDEX_TYPE and is only used as long as the size and the
+ * modification time of the archive match the ones stored in it.
+ *
+ * Directories which are only implied by the paths of their children, as is
+ * common in tarballs, are added to the index as well.
+ *
+ * The most recently used indexes are also kept in memory, so browsing an
+ * archive or opening its members does not load the index over and over.
+ */
+
+#include <errno.h>
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "thunar/thunar-archive-index.h"
+#include "thunar/thunar-private.h"
+
+#include <archive.h>
+#include <archive_entry.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+
+
+#define THUNAR_ARCHIVE_INDEX_VERSION (1)
+
+/* version, archive size, archive mtime, members (path, size, mtime, mode) */
+#define THUNAR_ARCHIVE_INDEX_TYPE "(utxa(stxu))"
+
+#define THUNAR_ARCHIVE_INDEX_BUFFER_SIZE (64 * 1024)
+
+/* number of indexes kept in memory */
+#define THUNAR_ARCHIVE_INDEX_CACHE_SIZE (4)
+
+
+
+struct _ThunarArchiveIndex
+{
+  gint        ref_count;
+
+  GPtrArray  *members;     /* ThunarArchiveMember, in archive order */
+  GHashTable *paths;       /* path -> ThunarArchiveMember */
+  GHashTable *directories; /* directory path -> GPtrArray of ThunarArchiveMember */
+
+  gchar      *filename;    /* local path of the archive */
+  guint64     size;        /* of the archive when it was indexed */
+  gint64      mtime;
+};
+
+
+
+/* archive uri -> ThunarArchiveIndex, and the uris, most recently used first */
+static GHashTable *index_cache = NULL;
+static GQueue      index_cache_lru = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC (index_cache);
+
+
+
+static void
+thunar_archive_member_free (gpointer data)
+{
+  ThunarArchiveMember *member = data;
+
+  g_free (member->path);
+  g_free (member);
+}
+
+
+
+/* turns the name of an archive entry into a member path, or returns %NULL
+ * for names which do not point into the archive, like "../foo" */
+static gchar *
+thunar_archive_index_normalize (const gchar *pathname)
+{
+  GString *path;
+  gchar  **parts;
+  guint    n;
+
+  if (pathname == NULL)
+    return NULL;
+
+  path = g_string_new (NULL);
+  parts = g_strsplit (pathname, "/", -1);
+
+  for (n = 0; parts[n] != NULL; n++)
+    {
+      /* leading slashes, duplicate slashes and "." */
+      if (*parts[n] == '\0' || strcmp (parts[n], ".") == 0)
+        continue;
+
+      if (strcmp (parts[n], "..") == 0)
+        {
+          g_string_truncate (path, 0);
+          break;
+        }
+
+      if (path->len > 0)
+        g_string_append_c (path, '/');
+      g_string_append (path, parts[n]);
+    }
+
+  g_strfreev (parts);
+
+  if (path->len == 0)
+    {
+      g_string_free (path, TRUE);
+      return NULL;
+    }
+
+  return g_string_free (path, FALSE);
+}
+
+
+
+static void
+thunar_archive_index_add (ThunarArchiveIndex *index,
+                          const gchar        *path,
+                          guint64             size,
+                          gint64              mtime,
+                          guint32             mode)
+{
+  ThunarArchiveMember *member;
+  const gchar         *slash;
+  GPtrArray           *children;
+  gchar               *parent;
+
+  /* a later entry replaces an earlier one, like on extraction */
+  member = g_hash_table_lookup (index->paths, path);
+  if (member != NULL)
+    {
+      member->size = size;
+      member->mtime = mtime;
+      member->mode = mode;
+      return;
+    }
+
+  slash = strrchr (path, '/');
+  parent = (slash != NULL) ? g_strndup (path, slash - path) : g_strdup ("");
+
+  /* make sure the parent directory is listed as well */
+  if (*parent != '\0' && !g_hash_table_contains (index->paths, parent))
+    thunar_archive_index_add (index, parent, 0, mtime, S_IFDIR | 0755);
+
+  member = g_new0 (ThunarArchiveMember, 1);
+  member->path = g_strdup (path);
+  member->name = (slash != NULL) ? member->path + (slash - path) + 1 : member->path;
+  member->size = size;
+  member->mtime = mtime;
+  member->mode = mode;
+
+  g_ptr_array_add (index->members, member);
+  g_hash_table_insert (index->paths, member->path, member);
+
+  children = g_hash_table_lookup (index->directories, parent);
+  if (children == NULL)
+    {
+      children = g_ptr_array_new ();
+      g_hash_table_insert (index->directories, parent, children);
+      parent = NULL;
+    }
+  g_ptr_array_add (children, member);
+
+  g_free (parent);
+}
+
+
+
+static struct archive *
+thunar_archive_index_open (ThunarArchiveIndex *index,
+                           GError            **error)
+{
+  struct archive *archive;
+
+  archive = archive_read_new ();
+  archive_read_support_filter_all (archive);
+  archive_read_support_format_all (archive);
+
+  if (archive_read_open_filename (archive, index->filename, THUNAR_ARCHIVE_INDEX_BUFFER_SIZE) != ARCHIVE_OK)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   _("Failed to open archive: %s"), archive_error_string (archive));
+      archive_read_free (archive);
+      return NULL;
+    }
+
+  return archive;
+}
+
+
+
+static gboolean
+thunar_archive_index_build (ThunarArchiveIndex *index,
+                            GCancellable       *cancellable,
+                            GError            **error)
+{
+  struct archive       *archive;
+  struct archive_entry *entry;
+  const gchar          *pathname;
+  gchar                *path;
+  gboolean              success = FALSE;
+  gint                  result;
+
+  archive = thunar_archive_index_open (index, error);
+  if (archive == NULL)
+    return FALSE;
+
+  for (;;)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        break;
+
+      result = archive_read_next_header (archive, &entry);
+      if (result == ARCHIVE_EOF)
+        {
+          success = TRUE;
+          break;
+        }
+      else if (result < ARCHIVE_WARN)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("Failed to read archive: %s"), archive_error_string (archive));
+          break;
+        }
+
+      pathname = archive_entry_pathname (entry);
+      if (pathname == NULL)
+        pathname = archive_entry_pathname_utf8 (entry);
+
+      path = thunar_archive_index_normalize (pathname);
+      if (path != NULL)
+        {
+          thunar_archive_index_add (index, path,
+                                    archive_entry_size (entry),
+                                    archive_entry_mtime (entry),
+                                    archive_entry_mode (entry));
+          g_free (path);
+        }
+
+      /* the data is not needed, so don't decompress it */
+      if (archive_read_data_skip (archive) < ARCHIVE_WARN)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("Failed to read archive: %s"), archive_error_string (archive));
+          break;
+        }
+    }
+
+  archive_read_free (archive);
+
+  return success;
+}
+
+
+
+static gchar *
+thunar_archive_index_cache_filename (GFile *archive_file)
+{
+  gchar *uri;
+  gchar *checksum;
+  gchar *filename;
+
+  uri = g_file_get_uri (archive_file);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  filename = g_strconcat (g_get_user_cache_dir (), G_DIR_SEPARATOR_S, "Thunar", G_DIR_SEPARATOR_S,
+                          "archives", G_DIR_SEPARATOR_S, checksum, ".toc", NULL);
+  g_free (checksum);
+  g_free (uri);
+
+  return filename;
+}
+
+
+
+static gboolean
+thunar_archive_index_load_cache (ThunarArchiveIndex *index,
+                                 const gchar        *cache_filename,
+                                 guint64             size,
+                                 gint64              mtime)
+{
+  GMappedFile  *mapped;
+  GVariantIter *iter;
+  GVariant     *variant;
+  GBytes       *bytes;
+  const gchar  *path;
+  guint64       cached_size;
+  guint64       member_size;
+  gint64        cached_mtime;
+  gint64        member_mtime;
+  guint32       version;
+  guint32       mode;
+  gboolean      valid;
+
+  mapped = g_mapped_file_new (cache_filename, FALSE, NULL);
+  if (mapped == NULL)
+    return FALSE;
+
+  /* never trust the cache, a broken file is read as an empty index */
+  bytes = g_mapped_file_get_bytes (mapped);
+  variant = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (THUNAR_ARCHIVE_INDEX_TYPE), bytes, FALSE));
+  g_bytes_unref (bytes);
+  g_mapped_file_unref (mapped);
+
+  g_variant_get (variant, "(utxa(stxu))", &version, &cached_size, &cached_mtime, &iter);
+
+  valid = (version == THUNAR_ARCHIVE_INDEX_VERSION && cached_size == size && cached_mtime == mtime);
+  if (valid)
+    {
+      while (g_variant_iter_next (iter, "(&stxu)", &path, &member_size, &member_mtime, &mode))
+        if (*path != '\0')
+          thunar_archive_index_add (index, path, member_size, member_mtime, mode);
+    }
+
+  g_variant_iter_free (iter);
+  g_variant_unref (variant);
+
+  return valid;
+}
+
+
+
+static void
+thunar_archive_index_save_cache (ThunarArchiveIndex *index,
+                                 const gchar        *cache_filename,
+                                 guint64             size,
+                                 gint64              mtime)
+{
+  ThunarArchiveMember *member;
+  GVariantBuilder      builder;
+  GVariant            *variant;
+  GError              *error = NULL;
+  gchar               *dirname;
+  guint                n;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(stxu)"));
+  for (n = 0; n < index->members->len; n++)
+    {
+      member = g_ptr_array_index (index->members, n);
+      g_variant_builder_add (&builder, "(stxu)", member->path, member->size, member->mtime, member->mode);
+    }
+
+  variant = g_variant_ref_sink (g_variant_new ("(utxa(stxu))", THUNAR_ARCHIVE_INDEX_VERSION, size, mtime, &builder));
+
+  dirname = g_path_get_dirname (cache_filename);
+  if (g_mkdir_with_parents (dirname, 0700) != 0
+      || !g_file_set_contents (cache_filename, g_variant_get_data (variant), g_variant_get_size (variant), &error))
+    {
+      g_debug ("Failed to write archive index %s: %s", cache_filename,
+               (error != NULL) ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_free (dirname);
+  g_variant_unref (variant);
+}
+
+
+
+/* loads the index from the cache, or reads it from the archive */
+static ThunarArchiveIndex *
+thunar_archive_index_load (GFile        *archive_file,
+                           gchar        *filename,
+                           guint64       size,
+                           gint64        mtime,
+                           GCancellable *cancellable,
+                           GError      **error)
+{
+  ThunarArchiveIndex *index;
+  gchar              *cache_filename;
+
+  index = g_new0 (ThunarArchiveIndex, 1);
+  index->ref_count = 1;
+  index->filename = filename;
+  index->size = size;
+  index->mtime = mtime;
+  index->members = g_ptr_array_new_with_free_func (thunar_archive_member_free);
+  index->paths = g_hash_table_new (g_str_hash, g_str_equal);
+  index->directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+
+  cache_filename = thunar_archive_index_cache_filename (archive_file);
+
+  if (!thunar_archive_index_load_cache (index, cache_filename, size, mtime))
+    {
+      if (thunar_archive_index_build (index, cancellable, error))
+        {
+          thunar_archive_index_save_cache (index, cache_filename, size, mtime);
+        }
+      else
+        {
+          thunar_archive_index_unref (index);
+          index = NULL;
+        }
+    }
+
+  g_free (cache_filename);
+
+  return index;
+}
+
+
+
+/**
+ * thunar_archive_index_get:
+ * @archive_file : a local archive.
+ * @cancellable  : a #GCancellable or %NULL.
+ * @error        : return location for errors or %NULL.
+ *
+ * Returns the index of @archive_file. Indexes of recently used archives are
+ * kept in memory as long as the size and the modification time of the archive
+ * do not change. Otherwise the index is loaded from the cache, or read from
+ * the archive if there is no up to date index in the cache. The latter may
+ * take a while for compressed tarballs, so this should be called from a
+ * #ThunarJob.
+ *
+ * This function is thread-safe.
+ *
+ * Return value: the #ThunarArchiveIndex, or %NULL on error. Release with
+ *               thunar_archive_index_unref().
+ **/
+ThunarArchiveIndex *
+thunar_archive_index_get (GFile        *archive_file,
+                          GCancellable *cancellable,
+                          GError      **error)
+{
+  ThunarArchiveIndex *index;
+  GFileInfo          *info;
+  GList              *lp;
+  gchar              *filename;
+  gchar              *uri;
+  guint64             size;
+  gint64              mtime;
+
+  _thunar_return_val_if_fail (G_IS_FILE (archive_file), NULL);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  /* libarchive only reads local files */
+  filename = g_file_get_path (archive_file);
+  if (filename == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Only local archives can be browsed"));
+      return NULL;
+    }
+
+  info = g_file_query_info (archive_file,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                            G_FILE_QUERY_INFO_NONE, cancellable, error);
+  if (info == NULL)
+    {
+      g_free (filename);
+      return NULL;
+    }
+
+  size = g_file_info_get_size (info);
+  mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  g_object_unref (info);
+
+  uri = g_file_get_uri (archive_file);
+
+  G_LOCK (index_cache);
+  index = (index_cache != NULL) ? g_hash_table_lookup (index_cache, uri) : NULL;
+  if (index != NULL && index->size == size && index->mtime == mtime)
+    {
+      /* move to the front of the lru list */
+      lp = g_queue_find_custom (&index_cache_lru, uri, (GCompareFunc) g_strcmp0);
+      g_queue_unlink (&index_cache_lru, lp);
+      g_queue_push_head_link (&index_cache_lru, lp);
+
+      thunar_archive_index_ref (index);
+      G_UNLOCK (index_cache);
+
+      g_free (filename);
+      g_free (uri);
+      return index;
+    }
+  G_UNLOCK (index_cache);
+
+  /* not under the lock, this may take a while */
+  index = thunar_archive_index_load (archive_file, filename, size, mtime, cancellable, error);
+  if (index == NULL)
+    {
+      g_free (uri);
+      return NULL;
+    }
+
+  G_LOCK (index_cache);
+  if (index_cache == NULL)
+    index_cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) thunar_archive_index_unref);
+
+  /* the queue and the table share the uri */
+  lp = g_queue_find_custom (&index_cache_lru, uri, (GCompareFunc) g_strcmp0);
+  if (lp != NULL)
+    {
+      g_hash_table_remove (index_cache, lp->data);
+      g_free (lp->data);
+      g_queue_delete_link (&index_cache_lru, lp);
+    }
+
+  g_queue_push_head (&index_cache_lru, uri);
+  g_hash_table_insert (index_cache, uri, thunar_archive_index_ref (index));
+
+  /* drop the least recently used indexes */
+  while (g_queue_get_length (&index_cache_lru) > THUNAR_ARCHIVE_INDEX_CACHE_SIZE)
+    {
+      uri = g_queue_pop_tail (&index_cache_lru);
+      g_hash_table_remove (index_cache, uri);
+      g_free (uri);
+    }
+  G_UNLOCK (index_cache);
+
+  return index;
+}
+
+
+
+/**
+ * thunar_archive_index_ref:
+ * @index : a #ThunarArchiveIndex.
+ *
+ * Increments the reference count of @index.
+ *
+ * Return value: @index.
+ **/
+ThunarArchiveIndex *
+thunar_archive_index_ref (ThunarArchiveIndex *index)
+{
+  _thunar_return_val_if_fail (index != NULL, NULL);
+
+  g_atomic_int_inc (&index->ref_count);
+
+  return index;
+}
+
+
+
+/**
+ * thunar_archive_index_unref:
+ * @index : a #ThunarArchiveIndex.
+ *
+ * Decrements the reference count of @index and frees it once it
+ * drops to zero.
+ **/
+void
+thunar_archive_index_unref (ThunarArchiveIndex *index)
+{
+  _thunar_return_if_fail (index != NULL);
+
+  if (g_atomic_int_dec_and_test (&index->ref_count))
+    {
+      g_hash_table_destroy (index->directories);
+      g_hash_table_destroy (index->paths);
+      g_ptr_array_unref (index->members);
+      g_free (index->filename);
+      g_free (index);
+    }
+}
+
+
+
+/**
+ * thunar_archive_index_lookup:
+ * @index : a #ThunarArchiveIndex.
+ * @path  : the path of a member, relative to the archive root.
+ *
+ * Return value: the member at @path, or %NULL if there is none.
+ **/
+const ThunarArchiveMember *
+thunar_archive_index_lookup (ThunarArchiveIndex *index,
+                             const gchar        *path)
+{
+  _thunar_return_val_if_fail (index != NULL, NULL);
+  _thunar_return_val_if_fail (path != NULL, NULL);
+
+  return g_hash_table_lookup (index->paths, path);
+}
+
+
+
+/**
+ * thunar_archive_index_list:
+ * @index     : a #ThunarArchiveIndex.
+ * @directory : the path of a directory in the archive, or "" for the
+ *              archive root.
+ *
+ * Return value: the #ThunarArchiveMember<!---->s in @directory, owned by
+ *               @index, or %NULL if @directory is not a directory with
+ *               members.
+ **/
+GPtrArray *
+thunar_archive_index_list (ThunarArchiveIndex *index,
+                           const gchar        *directory)
+{
+  _thunar_return_val_if_fail (index != NULL, NULL);
+  _thunar_return_val_if_fail (directory != NULL, NULL);
+
+  return g_hash_table_lookup (index->directories, directory);
+}
+
+
+
+/**
+ * thunar_archive_index_extract:
+ * @index       : a #ThunarArchiveIndex.
+ * @path        : the path of a regular file in the archive.
+ * @target_file : where to write the contents of @path to.
+ * @cancellable : a #GCancellable or %NULL.
+ * @error       : return location for errors or %NULL.
+ *
+ * Extracts the single member @path to @target_file, skipping over all
+ * other members. This is blocking and should be called from a #ThunarJob.
+ *
+ * Return value: %TRUE on success, %FALSE otherwise.
+ **/
+gboolean
+thunar_archive_index_extract (ThunarArchiveIndex *index,
+                              const gchar        *path,
+                              GFile              *target_file,
+                              GCancellable       *cancellable,
+                              GError            **error)
+{
+  const ThunarArchiveMember *member;
+  struct archive            *archive;
+  struct archive_entry      *entry;
+  GFileOutputStream         *stream = NULL;
+  const gchar               *pathname;
+  gboolean                   success = FALSE;
+  gboolean                   found;
+  gchar                     *buffer = NULL;
+  gchar                     *entry_path;
+  gssize                     n_read;
+  gint                       result;
+
+  _thunar_return_val_if_fail (index != NULL, FALSE);
+  _thunar_return_val_if_fail (path != NULL, FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), FALSE);
+  _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  member = thunar_archive_index_lookup (index, path);
+  if (member == NULL || !S_ISREG (member->mode))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_REGULAR_FILE,
+                   _("\"%s\" is not a file in the archive"), path);
+      return FALSE;
+    }
+
+  archive = thunar_archive_index_open (index, error);
+  if (archive == NULL)
+    return FALSE;
+
+  /* seek to the member, the data of all others is skipped */
+  for (found = FALSE; !found;)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        goto out;
+
+      result = archive_read_next_header (archive, &entry);
+      if (result == ARCHIVE_EOF)
+        {
+          /* the archive changed since it was indexed */
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                       _("\"%s\" is not a file in the archive"), path);
+          goto out;
+        }
+      else if (result < ARCHIVE_WARN)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("Failed to read archive: %s"), archive_error_string (archive));
+          goto out;
+        }
+
+      pathname = archive_entry_pathname (entry);
+      if (pathname == NULL)
+        pathname = archive_entry_pathname_utf8 (entry);
+
+      entry_path = thunar_archive_index_normalize (pathname);
+      found = (entry_path != NULL && strcmp (entry_path, path) == 0 && archive_entry_filetype (entry) == AE_IFREG);
+      g_free (entry_path);
+
+      if (!found && archive_read_data_skip (archive) < ARCHIVE_WARN)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("Failed to read archive: %s"), archive_error_string (archive));
+          goto out;
+        }
+    }
+
+  stream = g_file_replace (target_file, NULL, FALSE, G_FILE_CREATE_NONE, cancellable, error);
+  if (stream == NULL)
+    goto out;
+
+  buffer = g_malloc (THUNAR_ARCHIVE_INDEX_BUFFER_SIZE);
+  for (;;)
+    {
+      n_read = archive_read_data (archive, buffer, THUNAR_ARCHIVE_INDEX_BUFFER_SIZE);
+      if (n_read == 0)
+        break;
+      else if (n_read < 0)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                       _("Failed to read archive: %s"), archive_error_string (archive));
+          goto out;
+        }
+
+      if (!g_output_stream_write_all (G_OUTPUT_STREAM (stream), buffer, n_read, NULL, cancellable, error))
+        goto out;
+    }
+
+  success = g_output_stream_close (G_OUTPUT_STREAM (stream), cancellable, error);
+
+out:
+  if (stream != NULL)
+    {
+      g_object_unref (stream);
+
+      /* don't leave a truncated file behind */
+      if (!success)
+        g_file_delete (target_file, NULL, NULL);
+    }
+
+  g_free (buffer);
+  archive_read_free (archive);
+
+  return success;
+}
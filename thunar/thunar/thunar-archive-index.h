@@ -0,0 +1,68 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_ARCHIVE_INDEX_H__
+#define __THUNAR_ARCHIVE_INDEX_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ThunarArchiveIndex ThunarArchiveIndex;
+
+/* a file or directory inside of an archive */
+typedef struct
+{
+  gchar       *path;  /* relative to the archive root, without trailing slash */
+  const gchar *name;  /* last component of path */
+  guint64      size;
+  gint64       mtime;
+  guint32      mode;  /* including the file type bits */
+} ThunarArchiveMember;
+
+ThunarArchiveIndex *
+thunar_archive_index_get (GFile        *archive_file,
+                          GCancellable *cancellable,
+                          GError      **error) G_GNUC_WARN_UNUSED_RESULT;
+
+ThunarArchiveIndex *
+thunar_archive_index_ref (ThunarArchiveIndex *index);
+
+void
+thunar_archive_index_unref (ThunarArchiveIndex *index);
+
+const ThunarArchiveMember *
+thunar_archive_index_lookup (ThunarArchiveIndex *index,
+                             const gchar        *path);
+
+GPtrArray *
+thunar_archive_index_list (ThunarArchiveIndex *index,
+                           const gchar        *directory);
+
+gboolean
+thunar_archive_index_extract (ThunarArchiveIndex *index,
+                              const gchar        *path,
+                              GFile              *target_file,
+                              GCancellable       *cancellable,
+                              GError            **error);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_ARCHIVE_INDEX_H__ */
@@ -21,12 +21,36 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
 #include "thunar/thunar-archive-job.h"
 #include "thunar/thunar-archive-utils.h"
 #include "thunar/thunar-private.h"
 
 #include <glib/gi18n.h>
 
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#include <archive_entry.h>
+
+/* Size of the buffer files are streamed through */
+#define THUNAR_ARCHIVE_JOB_BUFFER_SIZE (64 * 1024)
+
+/* File attributes needed to store a file in an archive */
+#define THUNAR_ARCHIVE_JOB_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+  G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET "," \
+  G_FILE_ATTRIBUTE_UNIX_MODE "," \
+  G_FILE_ATTRIBUTE_TIME_MODIFIED
+#endif
+
 /* Operation types */
 typedef enum
 {
@@ -34,6 +58,16 @@ typedef enum
   THUNAR_ARCHIVE_OPERATION_EXTRACT,
 } ThunarArchiveOperation;
 
+#ifdef HAVE_LIBARCHIVE
+/* A file to store in an archive */
+typedef struct
+{
+  GFile     *file;
+  GFileInfo *info;
+  gchar     *pathname; /* inside of the archive */
+} ThunarArchiveEntry;
+#endif
+
 /* Property identifiers */
 enum
 {
@@ -71,6 +105,11 @@ struct _ThunarArchiveJob
   GFile                  *archive_file;
   GFile                  *target_dir;
   ThunarArchiveFormat     format;
+
+  /* progress, in bytes */
+  guint64                 total_size;
+  guint64                 processed_size;
+  gint64                  last_update_time;
 };
 
 G_DEFINE_TYPE (ThunarArchiveJob, thunar_archive_job, THUNAR_TYPE_JOB)
@@ -150,6 +189,9 @@ thunar_archive_job_init (ThunarArchiveJob *job)
   job->target_dir = NULL;
   job->format = THUNAR_ARCHIVE_FORMAT_ZIP;
   job->operation = THUNAR_ARCHIVE_OPERATION_COMPRESS;
+  job->total_size = 0;
+  job->processed_size = 0;
+  job->last_update_time = 0;
 }
 
 
@@ -243,19 +285,652 @@ thunar_archive_job_set_property (GObject      *object,
 
 
 
+#ifdef HAVE_LIBARCHIVE
+static void
+thunar_archive_job_check_pause (ThunarArchiveJob *job)
+{
+  while (thunar_job_is_paused (THUNAR_JOB (job)) && !thunar_job_is_cancelled (THUNAR_JOB (job)))
+    {
+      g_usleep (500 * 1000); /* 500ms pause */
+    }
+}
+
+
+
+static void
+thunar_archive_job_progress (ThunarArchiveJob *job,
+                             guint64           processed_size)
+{
+  gint64 current_time;
+
+  job->processed_size = processed_size;
+
+  if (G_UNLIKELY (job->total_size == 0))
+    return;
+
+  /* notify callers not more then every 500ms, the signal is sent to the main loop */
+  current_time = g_get_monotonic_time ();
+  if (current_time - job->last_update_time > (500 * 1000))
+    {
+      thunar_job_percent (THUNAR_JOB (job), (job->processed_size * 100.0) / job->total_size);
+      job->last_update_time = current_time;
+    }
+}
+
+
+
+static void
+thunar_archive_job_set_archive_error (GError         **error,
+                                      struct archive  *archive,
+                                      const gchar     *message)
+{
+  const gchar *reason = archive_error_string (archive);
+
+  if (reason != NULL)
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s: %s", message, reason);
+  else
+    g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED, message);
+}
+
+
+
+static void
+thunar_archive_entry_free (gpointer data)
+{
+  ThunarArchiveEntry *entry = data;
+
+  g_object_unref (entry->file);
+  g_object_unref (entry->info);
+  g_free (entry->pathname);
+  g_free (entry);
+}
+
+
+
+/* collects @file and, for directories, all files below it, parents first */
+static gboolean
+thunar_archive_job_collect (ThunarArchiveJob  *job,
+                            GFile             *file,
+                            GFileInfo         *info,
+                            const gchar       *pathname,
+                            GPtrArray         *entries,
+                            GError           **error)
+{
+  ThunarArchiveEntry *entry;
+  GFileEnumerator    *enumerator;
+  GCancellable       *cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
+  GFileInfo          *child_info;
+  GFile              *child;
+  gchar              *child_pathname;
+  gboolean            success = TRUE;
+
+  entry = g_new0 (ThunarArchiveEntry, 1);
+  entry->file = g_object_ref (file);
+  entry->info = g_object_ref (info);
+  entry->pathname = g_strdup (pathname);
+  g_ptr_array_add (entries, entry);
+
+  if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR)
+    job->total_size += g_file_info_get_size (info);
+
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+    return TRUE;
+
+  enumerator = g_file_enumerate_children (file, THUNAR_ARCHIVE_JOB_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          cancellable, error);
+  if (enumerator == NULL)
+    return FALSE;
+
+  while (success)
+    {
+      if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error)
+          || !g_file_enumerator_iterate (enumerator, &child_info, &child, cancellable, error))
+        {
+          success = FALSE;
+          break;
+        }
+
+      /* end of the directory */
+      if (child_info == NULL)
+        break;
+
+      child_pathname = g_build_filename (pathname, g_file_info_get_name (child_info), NULL);
+      success = thunar_archive_job_collect (job, child, child_info, child_pathname, entries, error);
+      g_free (child_pathname);
+    }
+
+  g_object_unref (enumerator);
+
+  return success;
+}
+
+
+
+static gboolean
+thunar_archive_job_set_format (struct archive      *archive,
+                               ThunarArchiveFormat  format,
+                               GError             **error)
+{
+  gchar *threads;
+  gint   result;
+
+  switch (format)
+    {
+    case THUNAR_ARCHIVE_FORMAT_ZIP:
+      result = archive_write_set_format_zip (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_7Z:
+      result = archive_write_set_format_7zip (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR:
+      result = archive_write_set_format_pax_restricted (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR_GZ:
+      result = archive_write_set_format_pax_restricted (archive);
+      if (result == ARCHIVE_OK)
+        result = archive_write_add_filter_gzip (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR_BZ2:
+      result = archive_write_set_format_pax_restricted (archive);
+      if (result == ARCHIVE_OK)
+        result = archive_write_add_filter_bzip2 (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
+      result = archive_write_set_format_pax_restricted (archive);
+      if (result == ARCHIVE_OK)
+        result = archive_write_add_filter_xz (archive);
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR_ZST:
+      result = archive_write_set_format_pax_restricted (archive);
+      if (result == ARCHIVE_OK)
+        result = archive_write_add_filter_zstd (archive);
+      break;
+
+    default:
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Unsupported archive format"));
+      return FALSE;
+    }
+
+  if (result < ARCHIVE_WARN)
+    {
+      thunar_archive_job_set_archive_error (error, archive, _("Unsupported archive format"));
+      return FALSE;
+    }
+
+  /* xz and zstd split the stream into blocks and compress those on all
+   * cores; the option is ignored by libarchive versions not knowing it */
+  if (format == THUNAR_ARCHIVE_FORMAT_TAR_XZ || format == THUNAR_ARCHIVE_FORMAT_TAR_ZST)
+    {
+      threads = g_strdup_printf ("%u", g_get_num_processors ());
+      if (archive_write_set_filter_option (archive, NULL, "threads", threads) != ARCHIVE_OK)
+        g_debug ("Compressing with a single thread: %s", archive_error_string (archive));
+      g_free (threads);
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_archive_job_write_entry (ThunarArchiveJob    *job,
+                                struct archive      *archive,
+                                ThunarArchiveEntry  *entry,
+                                guchar              *buffer,
+                                GError             **error)
+{
+  struct archive_entry *archive_entry;
+  GInputStream         *stream = NULL;
+  GCancellable         *cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
+  GFileType             type;
+  gssize                n_read;
+  guint32               mode;
+  gboolean              success = FALSE;
+
+  type = g_file_info_get_file_type (entry->info);
+
+  /* not every file system knows about unix modes */
+  if (g_file_info_has_attribute (entry->info, G_FILE_ATTRIBUTE_UNIX_MODE))
+    mode = g_file_info_get_attribute_uint32 (entry->info, G_FILE_ATTRIBUTE_UNIX_MODE) & 07777;
+  else
+    mode = (type == G_FILE_TYPE_DIRECTORY) ? 0755 : 0644;
+
+  archive_entry = archive_entry_new ();
+  archive_entry_set_pathname (archive_entry, entry->pathname);
+  archive_entry_set_perm (archive_entry, mode);
+  archive_entry_set_mtime (archive_entry, g_file_info_get_attribute_uint64 (entry->info, G_FILE_ATTRIBUTE_TIME_MODIFIED), 0);
+
+  switch (type)
+    {
+    case G_FILE_TYPE_DIRECTORY:
+      archive_entry_set_filetype (archive_entry, AE_IFDIR);
+      break;
+
+    case G_FILE_TYPE_SYMBOLIC_LINK:
+      archive_entry_set_filetype (archive_entry, AE_IFLNK);
+      archive_entry_set_symlink (archive_entry, g_file_info_get_symlink_target (entry->info));
+      break;
+
+    case G_FILE_TYPE_REGULAR:
+      archive_entry_set_filetype (archive_entry, AE_IFREG);
+      archive_entry_set_size (archive_entry, g_file_info_get_size (entry->info));
+
+      stream = G_INPUT_STREAM (g_file_read (entry->file, cancellable, error));
+      if (stream == NULL)
+        goto out;
+      break;
+
+    default:
+      /* sockets, pipes and devices are left out, like zip does */
+      success = TRUE;
+      goto out;
+    }
+
+  if (archive_write_header (archive, archive_entry) < ARCHIVE_WARN)
+    {
+      thunar_archive_job_set_archive_error (error, archive, _("Failed to create archive"));
+      goto out;
+    }
+
+  /* stream the file contents through the buffer */
+  while (stream != NULL)
+    {
+      thunar_archive_job_check_pause (job);
+
+      n_read = g_input_stream_read (stream, buffer, THUNAR_ARCHIVE_JOB_BUFFER_SIZE, cancellable, error);
+      if (n_read < 0)
+        goto out;
+      else if (n_read == 0)
+        break;
+
+      if (archive_write_data (archive, buffer, n_read) != n_read)
+        {
+          thunar_archive_job_set_archive_error (error, archive, _("Failed to create archive"));
+          goto out;
+        }
+
+      thunar_archive_job_progress (job, job->processed_size + n_read);
+    }
+
+  success = TRUE;
+
+out:
+  if (stream != NULL)
+    g_object_unref (stream);
+
+  archive_entry_free (archive_entry);
+
+  return success;
+}
+
+
+
+static gboolean
+thunar_archive_job_compress_execute (ThunarArchiveJob *job,
+                                      GError          **error)
+{
+  struct archive *archive = NULL;
+  GCancellable   *cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
+  GPtrArray      *entries;
+  GFileInfo      *info;
+  GList          *lp;
+  gchar          *archive_path;
+  gchar          *basename;
+  guchar         *buffer = NULL;
+  gboolean        opened = FALSE;
+  gboolean        success = FALSE;
+  gboolean        collected;
+  guint           n;
+
+  g_return_val_if_fail (job->archive_file != NULL, FALSE);
+  g_return_val_if_fail (job->source_files != NULL, FALSE);
+
+  archive_path = g_file_get_path (job->archive_file);
+  if (archive_path == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_FILENAME,
+                           _("Invalid archive filename"));
+      return FALSE;
+    }
+
+  /* collect all files first, to know the total size for the progress */
+  thunar_job_info_message (THUNAR_JOB (job), _("Collecting files..."));
+  entries = g_ptr_array_new_with_free_func (thunar_archive_entry_free);
+
+  for (lp = job->source_files; lp != NULL; lp = lp->next)
+    {
+      info = g_file_query_info (G_FILE (lp->data), THUNAR_ARCHIVE_JOB_ATTRIBUTES,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, error);
+      if (info == NULL)
+        goto cleanup;
+
+      /* the source files are stored with their basename, like before */
+      basename = g_file_get_basename (G_FILE (lp->data));
+      collected = thunar_archive_job_collect (job, G_FILE (lp->data), info, basename, entries, error);
+      g_free (basename);
+      g_object_unref (info);
+
+      if (!collected)
+        goto cleanup;
+    }
+
+  archive = archive_write_new ();
+  if (!thunar_archive_job_set_format (archive, job->format, error))
+    goto cleanup;
+
+  if (archive_write_open_filename (archive, archive_path) != ARCHIVE_OK)
+    {
+      thunar_archive_job_set_archive_error (error, archive, _("Failed to create archive"));
+      goto cleanup;
+    }
+  opened = TRUE;
+
+  thunar_job_info_message (THUNAR_JOB (job), _("Creating archive..."));
+  thunar_job_percent (THUNAR_JOB (job), 0.0);
+
+  buffer = g_malloc (THUNAR_ARCHIVE_JOB_BUFFER_SIZE);
+
+  for (n = 0; n < entries->len; n++)
+    {
+      if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
+        goto cleanup;
+
+      if (!thunar_archive_job_write_entry (job, archive, g_ptr_array_index (entries, n), buffer, error))
+        goto cleanup;
+    }
+
+  /* writes the trailer or central directory */
+  if (archive_write_close (archive) != ARCHIVE_OK)
+    {
+      thunar_archive_job_set_archive_error (error, archive, _("Failed to create archive"));
+      goto cleanup;
+    }
+
+  thunar_job_percent (THUNAR_JOB (job), 100.0);
+  success = TRUE;
+
+cleanup:
+  if (archive != NULL)
+    archive_write_free (archive);
+
+  /* don't leave an incomplete archive behind */
+  if (opened && !success)
+    g_file_delete (job->archive_file, NULL, NULL);
+
+  g_ptr_array_unref (entries);
+  g_free (buffer);
+  g_free (archive_path);
+
+  return success;
+}
+
+
+
+static gboolean
+thunar_archive_job_extract_execute (ThunarArchiveJob *job,
+                                     GError          **error)
+{
+  struct archive       *reader = NULL;
+  struct archive       *writer = NULL;
+  struct archive_entry *entry;
+  GCancellable         *cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
+  GFileInfo            *info;
+  const gchar          *name;
+  const void           *block;
+  size_t                block_size;
+  la_int64_t            offset;
+  gchar                *archive_path = NULL;
+  gchar                *target_path = NULL;
+  gchar                *real_path;
+  gchar                *path;
+  gboolean              success = FALSE;
+  gint                  result;
+  gint                  saved_errno;
+
+  g_return_val_if_fail (job->archive_file != NULL, FALSE);
+  g_return_val_if_fail (job->target_dir != NULL, FALSE);
+
+  archive_path = g_file_get_path (job->archive_file);
+  target_path = g_file_get_path (job->target_dir);
+
+  if (archive_path == NULL || target_path == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_FILENAME,
+                           _("Invalid file path"));
+      goto cleanup;
+    }
+
+  /* ARCHIVE_EXTRACT_SECURE_SYMLINKS refuses every path that runs through a
+   * symlink, so resolve the ones above the target directory (e.g. a
+   * symlinked home or Downloads directory) before joining the entries */
+  real_path = realpath (target_path, NULL);
+  if (real_path == NULL)
+    {
+      saved_errno = errno;
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                   "%s: %s", _("Failed to extract archive"), g_strerror (saved_errno));
+      goto cleanup;
+    }
+  g_free (target_path);
+  target_path = g_strdup (real_path);
+  free (real_path);
+
+  /* the progress is measured on the bytes read from the (compressed) archive */
+  info = g_file_query_info (job->archive_file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE, cancellable, error);
+  if (info == NULL)
+    goto cleanup;
+
+  job->total_size = g_file_info_get_size (info);
+  g_object_unref (info);
+
+  /* libarchive detects the format itself */
+  reader = archive_read_new ();
+  archive_read_support_filter_all (reader);
+  archive_read_support_format_all (reader);
+
+  if (archive_read_open_filename (reader, archive_path, THUNAR_ARCHIVE_JOB_BUFFER_SIZE) != ARCHIVE_OK)
+    {
+      thunar_archive_job_set_archive_error (error, reader, _("Failed to extract archive"));
+      goto cleanup;
+    }
+
+  /* refuse entries which would end up outside of the target directory */
+  writer = archive_write_disk_new ();
+  archive_write_disk_set_options (writer,
+                                  ARCHIVE_EXTRACT_TIME
+                                  | ARCHIVE_EXTRACT_PERM
+                                  | ARCHIVE_EXTRACT_SECURE_SYMLINKS
+                                  | ARCHIVE_EXTRACT_SECURE_NODOTDOT);
+  archive_write_disk_set_standard_lookup (writer);
+
+  thunar_job_info_message (THUNAR_JOB (job), _("Extracting archive..."));
+  thunar_job_percent (THUNAR_JOB (job), 0.0);
+
+  for (;;)
+    {
+      if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
+        goto cleanup;
+
+      result = archive_read_next_header (reader, &entry);
+      if (result == ARCHIVE_EOF)
+        break;
+      else if (result < ARCHIVE_WARN)
+        {
+          thunar_archive_job_set_archive_error (error, reader, _("Failed to extract archive"));
+          goto cleanup;
+        }
+
+      /* entries are stored relative to the target directory; leading
+       * slashes are dropped, like tar does */
+      for (name = archive_entry_pathname (entry); *name == '/'; name++)
+        ;
+      path = g_build_filename (target_path, name, NULL);
+      archive_entry_set_pathname (entry, path);
+      g_free (path);
+
+      name = archive_entry_hardlink (entry);
+      if (name != NULL)
+        {
+          for (; *name == '/'; name++)
+            ;
+          path = g_build_filename (target_path, name, NULL);
+          archive_entry_set_hardlink (entry, path);
+          g_free (path);
+        }
+
+      if (archive_write_header (writer, entry) < ARCHIVE_WARN)
+        {
+          thunar_archive_job_set_archive_error (error, writer, _("Failed to extract archive"));
+          goto cleanup;
+        }
+
+      /* stream the contents block by block */
+      for (;;)
+        {
+          thunar_archive_job_check_pause (job);
+
+          if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
+            goto cleanup;
+
+          result = archive_read_data_block (reader, &block, &block_size, &offset);
+          if (result == ARCHIVE_EOF)
+            break;
+          else if (result < ARCHIVE_WARN)
+            {
+              thunar_archive_job_set_archive_error (error, reader, _("Failed to extract archive"));
+              goto cleanup;
+            }
+
+          if (archive_write_data_block (writer, block, block_size, offset) < ARCHIVE_WARN)
+            {
+              thunar_archive_job_set_archive_error (error, writer, _("Failed to extract archive"));
+              goto cleanup;
+            }
+
+          thunar_archive_job_progress (job, archive_filter_bytes (reader, -1));
+        }
+
+      if (archive_write_finish_entry (writer) < ARCHIVE_WARN)
+        {
+          thunar_archive_job_set_archive_error (error, writer, _("Failed to extract archive"));
+          goto cleanup;
+        }
+    }
+
+  thunar_job_percent (THUNAR_JOB (job), 100.0);
+  success = TRUE;
+
+cleanup:
+  if (reader != NULL)
+    archive_read_free (reader);
+
+  /* also restores the times and modes of the extracted directories */
+  if (writer != NULL)
+    archive_write_free (writer);
+
+  g_free (archive_path);
+  g_free (target_path);
+
+  return success;
+}
+#else
+/* runs @argv in @cwd and waits for it, or with @filter_argv set, pipes
+ * the output of @argv through that, into @filter_output if not %NULL.
+ * The job thread copies the data, tar -I only runs compressors with
+ * arguments since GNU tar 1.31 */
+static gboolean
+thunar_archive_job_run (ThunarArchiveJob    *job,
+                        const gchar         *cwd,
+                        const gchar * const *argv,
+                        const gchar * const *filter_argv,
+                        const gchar         *filter_output,
+                        GError             **error)
+{
+  GSubprocessLauncher *launcher;
+  GSubprocessFlags     filter_flags;
+  GSubprocess         *process;
+  GSubprocess         *filter = NULL;
+  GCancellable        *cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
+  gboolean             success = FALSE;
+
+  launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDERR_PIPE
+                                        | (filter_argv != NULL ? G_SUBPROCESS_FLAGS_STDOUT_PIPE
+                                                               : G_SUBPROCESS_FLAGS_STDOUT_SILENCE));
+  if (cwd != NULL)
+    g_subprocess_launcher_set_cwd (launcher, cwd);
+  process = g_subprocess_launcher_spawnv (launcher, argv, error);
+  g_object_unref (launcher);
+
+  if (process == NULL)
+    return FALSE;
+
+  if (filter_argv != NULL)
+    {
+      filter_flags = G_SUBPROCESS_FLAGS_STDIN_PIPE | G_SUBPROCESS_FLAGS_STDERR_PIPE;
+      if (filter_output == NULL)
+        filter_flags |= G_SUBPROCESS_FLAGS_STDOUT_SILENCE;
+
+      launcher = g_subprocess_launcher_new (filter_flags);
+      if (filter_output != NULL)
+        g_subprocess_launcher_set_stdout_file_path (launcher, filter_output);
+      filter = g_subprocess_launcher_spawnv (launcher, filter_argv, error);
+      g_object_unref (launcher);
+
+      if (filter == NULL)
+        {
+          g_subprocess_force_exit (process);
+          goto cleanup;
+        }
+
+      if (g_output_stream_splice (g_subprocess_get_stdin_pipe (filter),
+                                  g_subprocess_get_stdout_pipe (process),
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE
+                                  | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                  cancellable, error) < 0
+          || !g_subprocess_wait_check (filter, cancellable, error))
+        {
+          g_subprocess_force_exit (process);
+          g_subprocess_force_exit (filter);
+          goto cleanup;
+        }
+    }
+
+  success = g_subprocess_wait_check (process, cancellable, error);
+
+cleanup:
+  if (filter != NULL)
+    g_object_unref (filter);
+  g_object_unref (process);
+
+  return success;
+}
+
+
+
 static gboolean
 thunar_archive_job_compress_execute (ThunarArchiveJob *job,
                                       GError          **error)
 {
-  GSubprocess *process = NULL;
-  gchar       *archive_path = NULL;
-  gchar      **argv = NULL;
-  GList       *lp;
-  GPtrArray   *args;
-  gboolean     success = FALSE;
-  GFile       *working_dir = NULL;
-  gchar       *cwd = NULL;
-  gint         i;
+  gchar        *archive_path = NULL;
+  gchar       **argv = NULL;
+  const gchar  *xz_argv[] = { "xz", "-T0", "-c", NULL };
+  const gchar  *zstd_argv[] = { "zstd", "-q", "-T0", "-c", NULL };
+  const gchar **filter_argv = NULL;
+  GList        *lp;
+  GPtrArray    *args;
+  gboolean      success = FALSE;
+  GFile        *working_dir = NULL;
+  gchar        *cwd = NULL;
+  gint          i;
 
   g_return_val_if_fail (job->archive_file != NULL, FALSE);
   g_return_val_if_fail (job->source_files != NULL, FALSE);
@@ -297,15 +972,19 @@ thunar_archive_job_compress_execute (ThunarArchiveJob *job,
       break;
 
     case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
+    case THUNAR_ARCHIVE_FORMAT_TAR_ZST:
+      /* -T0 makes the compressor use all cores */
       g_ptr_array_add (args, g_strdup ("tar"));
-      g_ptr_array_add (args, g_strdup ("-cJf"));
-      g_ptr_array_add (args, g_strdup (archive_path));
+      g_ptr_array_add (args, g_strdup ("-cf"));
+      g_ptr_array_add (args, g_strdup ("-"));
+      filter_argv = (job->format == THUNAR_ARCHIVE_FORMAT_TAR_XZ) ? xz_argv : zstd_argv;
       break;
 
     case THUNAR_ARCHIVE_FORMAT_7Z:
       g_ptr_array_add (args, g_strdup ("7z"));
       g_ptr_array_add (args, g_strdup ("a"));
       g_ptr_array_add (args, g_strdup ("-bd"));
+      g_ptr_array_add (args, g_strdup ("-mmt=on"));
       g_ptr_array_add (args, g_strdup (archive_path));
       break;
 
@@ -335,34 +1014,9 @@ thunar_archive_job_compress_execute (ThunarArchiveJob *job,
   thunar_job_info_message (THUNAR_JOB (job), _("Creating archive..."));
   thunar_job_percent (THUNAR_JOB (job), 0.0);
 
-  /* Execute the command */
-  process = g_subprocess_newv ((const gchar * const *) argv,
-                               G_SUBPROCESS_FLAGS_STDOUT_SILENCE |
-                               G_SUBPROCESS_FLAGS_STDERR_PIPE,
-                               error);
-
-  if (process == NULL)
-    goto cleanup;
-
-  /* Set working directory by using launcher instead */
-  g_object_unref (process);
-
-  GSubprocessLauncher *launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_SILENCE |
-                                                              G_SUBPROCESS_FLAGS_STDERR_PIPE);
-  g_subprocess_launcher_set_cwd (launcher, cwd);
-
-  process = g_subprocess_launcher_spawnv (launcher,
-                                          (const gchar * const *) argv,
-                                          error);
-  g_object_unref (launcher);
-
-  if (process == NULL)
-    goto cleanup;
-
-  /* Wait for completion */
-  success = g_subprocess_wait_check (process,
-                                     thunar_job_get_cancellable (THUNAR_JOB (job)),
-                                     error);
+  /* Execute the command in the directory of the files */
+  success = thunar_archive_job_run (job, cwd, (const gchar * const *) argv,
+                                    filter_argv, archive_path, error);
 
   if (!success && error != NULL && *error == NULL)
     {
@@ -372,12 +1026,9 @@ thunar_archive_job_compress_execute (ThunarArchiveJob *job,
 
   /* Update progress */
   if (success)
-    thunar_job_percent (THUNAR_JOB (job), 1.0);
+    thunar_job_percent (THUNAR_JOB (job), 100.0);
 
 cleanup:
-  if (process != NULL)
-    g_object_unref (process);
-
   g_free (archive_path);
   g_free (cwd);
 
@@ -400,10 +1051,11 @@ static gboolean
 thunar_archive_job_extract_execute (ThunarArchiveJob *job,
                                      GError          **error)
 {
-  GSubprocess         *process = NULL;
   gchar               *archive_path = NULL;
   gchar               *target_path = NULL;
   gchar              **argv = NULL;
+  const gchar         *tar_argv[] = { "tar", "-xf", "-", "-C", NULL, NULL };
+  const gchar        **filter_argv = NULL;
   GPtrArray           *args;
   gboolean             success = FALSE;
   ThunarArchiveFormat  format;
@@ -452,10 +1104,22 @@ thunar_archive_job_extract_execute (ThunarArchiveJob *job,
       g_ptr_array_add (args, g_strdup (target_path));
       break;
 
+    case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
+    case THUNAR_ARCHIVE_FORMAT_TAR_ZST:
+      /* older tars don't detect zstd, decompress into tar instead,
+       * the same way as it was compressed */
+      g_ptr_array_add (args, g_strdup (job->format == THUNAR_ARCHIVE_FORMAT_TAR_XZ ? "xz" : "zstd"));
+      g_ptr_array_add (args, g_strdup ("-d"));
+      g_ptr_array_add (args, g_strdup ("-c"));
+      g_ptr_array_add (args, g_strdup ("-q"));
+      g_ptr_array_add (args, g_strdup (archive_path));
+      tar_argv[4] = target_path;
+      filter_argv = tar_argv;
+      break;
+
     case THUNAR_ARCHIVE_FORMAT_TAR:
     case THUNAR_ARCHIVE_FORMAT_TAR_GZ:
     case THUNAR_ARCHIVE_FORMAT_TAR_BZ2:
-    case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
       g_ptr_array_add (args, g_strdup ("tar"));
       g_ptr_array_add (args, g_strdup ("-xf"));
       g_ptr_array_add (args, g_strdup (archive_path));
@@ -486,18 +1150,8 @@ thunar_archive_job_extract_execute (ThunarArchiveJob *job,
   thunar_job_percent (THUNAR_JOB (job), 0.0);
 
   /* Execute the command */
-  process = g_subprocess_newv ((const gchar * const *) argv,
-                               G_SUBPROCESS_FLAGS_STDOUT_SILENCE |
-                               G_SUBPROCESS_FLAGS_STDERR_PIPE,
-                               error);
-
-  if (process == NULL)
-    goto cleanup;
-
-  /* Wait for completion */
-  success = g_subprocess_wait_check (process,
-                                     thunar_job_get_cancellable (THUNAR_JOB (job)),
-                                     error);
+  success = thunar_archive_job_run (job, NULL, (const gchar * const *) argv,
+                                    filter_argv, NULL, error);
 
   if (!success && error != NULL && *error == NULL)
     {
@@ -507,12 +1161,9 @@ thunar_archive_job_extract_execute (ThunarArchiveJob *job,
 
   /* Update progress */
   if (success)
-    thunar_job_percent (THUNAR_JOB (job), 1.0);
+    thunar_job_percent (THUNAR_JOB (job), 100.0);
 
 cleanup:
-  if (process != NULL)
-    g_object_unref (process);
-
   g_free (archive_path);
   g_free (target_path);
 
@@ -525,6 +1176,7 @@ cleanup:
 
   return success;
 }
+#endif
 
 
 
@@ -560,15 +1212,23 @@ thunar_archive_job_compress (GList               *source_files,
                              GFile               *archive_file,
                              ThunarArchiveFormat  format)
 {
+  ThunarJob *job;
+
   g_return_val_if_fail (source_files != NULL, NULL);
   g_return_val_if_fail (G_IS_FILE (archive_file), NULL);
 
-  return g_object_new (THUNAR_TYPE_ARCHIVE_JOB,
-                       "operation", THUNAR_ARCHIVE_OPERATION_COMPRESS,
-                       "source-files", source_files,
-                       "archive-file", archive_file,
-                       "format", format,
-                       NULL);
+  job = g_object_new (THUNAR_TYPE_ARCHIVE_JOB,
+                      "operation", THUNAR_ARCHIVE_OPERATION_COMPRESS,
+                      "source-files", source_files,
+                      "archive-file", archive_file,
+                      "format", format,
+                      NULL);
+
+#ifdef HAVE_LIBARCHIVE
+  thunar_job_set_pausable (job, TRUE);
+#endif
+
+  return job;
 }
 
 
@@ -586,12 +1246,20 @@ ThunarJob *
 thunar_archive_job_extract (GFile *archive_file,
                             GFile *target_dir)
 {
+  ThunarJob *job;
+
   g_return_val_if_fail (G_IS_FILE (archive_file), NULL);
   g_return_val_if_fail (G_IS_FILE (target_dir), NULL);
 
-  return g_object_new (THUNAR_TYPE_ARCHIVE_JOB,
-                       "operation", THUNAR_ARCHIVE_OPERATION_EXTRACT,
-                       "archive-file", archive_file,
-                       "target-dir", target_dir,
-                       NULL);
+  job = g_object_new (THUNAR_TYPE_ARCHIVE_JOB,
+                      "operation", THUNAR_ARCHIVE_OPERATION_EXTRACT,
+                      "archive-file", archive_file,
+                      "target-dir", target_dir,
+                      NULL);
+
+#ifdef HAVE_LIBARCHIVE
+  thunar_job_set_pausable (job, TRUE);
+#endif
+
+  return job;
 }
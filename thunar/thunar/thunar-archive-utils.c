@@ -25,6 +25,10 @@
 #include "thunar/thunar-file.h"
 #include <gio/gio.h>
 
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#endif
+
 /* Archive format information table */
 static const ThunarArchiveFormatInfo archive_formats[] = {
   {
@@ -68,6 +72,13 @@ static const ThunarArchiveFormatInfo archive_formats[] = {
     ".tar",
     "application/x-tar",
     "TAR Archive"
+  },
+  {
+    THUNAR_ARCHIVE_FORMAT_TAR_ZST,
+    "TAR.ZST",
+    ".tar.zst",
+    "application/x-zstd-compressed-tar",
+    "Compressed TAR Archive (zstd)"
   }
 };
 
@@ -75,6 +86,31 @@ static const gint n_archive_formats = G_N_ELEMENTS (archive_formats);
 
 
 
+#ifdef HAVE_LIBARCHIVE
+/* libarchive runs the compressor program if it was built without the
+ * library, and returns ARCHIVE_WARN when setting up the filter then */
+static gboolean
+thunar_archive_utils_filter_is_usable (gint         result,
+                                       const gchar *program)
+{
+  gchar    *path;
+  gboolean  usable;
+
+  if (result == ARCHIVE_OK)
+    return TRUE;
+  if (result != ARCHIVE_WARN)
+    return FALSE;
+
+  path = g_find_program_in_path (program);
+  usable = (path != NULL);
+  g_free (path);
+
+  return usable;
+}
+#endif
+
+
+
 /**
  * thunar_archive_utils_is_archive:
  * @file : a #ThunarFile.
@@ -107,6 +143,7 @@ thunar_archive_utils_is_archive (ThunarFile *file)
   if (g_content_type_is_a (content_type, "application/gzip") ||
       g_content_type_is_a (content_type, "application/x-bzip") ||
       g_content_type_is_a (content_type, "application/x-xz") ||
+      g_content_type_is_a (content_type, "application/zstd") ||
       g_content_type_is_a (content_type, "application/x-archive") ||
       g_content_type_is_a (content_type, "application/x-rar"))
     return TRUE;
@@ -359,6 +396,10 @@ thunar_archive_utils_get_unique_filename (GFile       *directory,
 gboolean
 thunar_archive_utils_can_compress (void)
 {
+#ifdef HAVE_LIBARCHIVE
+  /* archives are written in-process */
+  return TRUE;
+#else
   /* Check for required utilities */
   gchar *zip_path = g_find_program_in_path ("zip");
   gchar *tar_path = g_find_program_in_path ("tar");
@@ -369,6 +410,7 @@ thunar_archive_utils_can_compress (void)
   g_free (tar_path);
 
   return can_compress;
+#endif
 }
 
 
@@ -385,6 +427,21 @@ thunar_archive_utils_can_compress (void)
 gboolean
 thunar_archive_utils_can_extract (ThunarArchiveFormat format)
 {
+#ifdef HAVE_LIBARCHIVE
+  struct archive *archive;
+  gint            result;
+
+  /* archives are read in-process, only zstd is missing from some
+   * libarchive builds */
+  if (format != THUNAR_ARCHIVE_FORMAT_TAR_ZST)
+    return (format != THUNAR_ARCHIVE_FORMAT_UNKNOWN);
+
+  archive = archive_read_new ();
+  result = archive_read_support_filter_zstd (archive);
+  archive_read_free (archive);
+
+  return thunar_archive_utils_filter_is_usable (result, "zstd");
+#else
   gchar    *program = NULL;
   gboolean  result = FALSE;
 
@@ -397,10 +454,91 @@ thunar_archive_utils_can_extract (ThunarArchiveFormat format)
     case THUNAR_ARCHIVE_FORMAT_TAR:
     case THUNAR_ARCHIVE_FORMAT_TAR_GZ:
     case THUNAR_ARCHIVE_FORMAT_TAR_BZ2:
+      program = g_find_program_in_path ("tar");
+      break;
+
     case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
+    case THUNAR_ARCHIVE_FORMAT_TAR_ZST:
+      /* the compressor is piped into tar, which might not know about zstd */
+      program = g_find_program_in_path (format == THUNAR_ARCHIVE_FORMAT_TAR_XZ ? "xz" : "zstd");
+      if (program != NULL)
+        {
+          g_free (program);
+          program = g_find_program_in_path ("tar");
+        }
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_7Z:
+      program = g_find_program_in_path ("7z");
+      if (program == NULL)
+        program = g_find_program_in_path ("7za");
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  result = (program != NULL);
+  g_free (program);
+
+  return result;
+#endif
+}
+
+
+
+/**
+ * thunar_archive_utils_can_create:
+ * @format : a #ThunarArchiveFormat.
+ *
+ * Checks if archives of the given @format can be created, that is if
+ * libarchive or the required utilities support it.
+ *
+ * Return value: %TRUE if @format can be created, %FALSE otherwise.
+ **/
+gboolean
+thunar_archive_utils_can_create (ThunarArchiveFormat format)
+{
+#ifdef HAVE_LIBARCHIVE
+  struct archive *archive;
+  gint            result;
+
+  /* only zstd is missing from some libarchive builds */
+  if (format != THUNAR_ARCHIVE_FORMAT_TAR_ZST)
+    return (format != THUNAR_ARCHIVE_FORMAT_UNKNOWN);
+
+  archive = archive_write_new ();
+  result = archive_write_add_filter_zstd (archive);
+  archive_write_free (archive);
+
+  return thunar_archive_utils_filter_is_usable (result, "zstd");
+#else
+  gchar    *program = NULL;
+  gboolean  result = FALSE;
+
+  switch (format)
+    {
+    case THUNAR_ARCHIVE_FORMAT_ZIP:
+      program = g_find_program_in_path ("zip");
+      break;
+
+    case THUNAR_ARCHIVE_FORMAT_TAR:
+    case THUNAR_ARCHIVE_FORMAT_TAR_GZ:
+    case THUNAR_ARCHIVE_FORMAT_TAR_BZ2:
       program = g_find_program_in_path ("tar");
       break;
 
+    case THUNAR_ARCHIVE_FORMAT_TAR_XZ:
+    case THUNAR_ARCHIVE_FORMAT_TAR_ZST:
+      /* tar is piped into the compressor */
+      program = g_find_program_in_path (format == THUNAR_ARCHIVE_FORMAT_TAR_XZ ? "xz" : "zstd");
+      if (program != NULL)
+        {
+          g_free (program);
+          program = g_find_program_in_path ("tar");
+        }
+      break;
+
     case THUNAR_ARCHIVE_FORMAT_7Z:
       program = g_find_program_in_path ("7z");
       if (program == NULL)
@@ -415,4 +553,5 @@ thunar_archive_utils_can_extract (ThunarArchiveFormat format)
   g_free (program);
 
   return result;
+#endif
 }
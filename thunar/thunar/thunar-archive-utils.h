@@ -34,6 +34,7 @@ typedef enum
   THUNAR_ARCHIVE_FORMAT_TAR_XZ,
   THUNAR_ARCHIVE_FORMAT_7Z,
   THUNAR_ARCHIVE_FORMAT_TAR,
+  THUNAR_ARCHIVE_FORMAT_TAR_ZST,
   THUNAR_ARCHIVE_FORMAT_UNKNOWN
 } ThunarArchiveFormat;
 
@@ -59,6 +60,7 @@ gchar               *thunar_archive_utils_get_unique_filename(GFile
                                                                const gchar         *extension);
 gboolean             thunar_archive_utils_can_compress       (void);
 gboolean             thunar_archive_utils_can_extract        (ThunarArchiveFormat  format);
+gboolean             thunar_archive_utils_can_create         (ThunarArchiveFormat  format);
 
 G_END_DECLS;
 
@@ -73,6 +73,9 @@
 /* Dump the file cache every X second, set to 0 to disable */
 #define DUMP_FILE_CACHE 0
 
+/* Number of independently locked parts of the file cache, must be a power of 2 */
+#define FILE_CACHE_N_SHARDS 16
+
 /* Minimum delay between two 'changed' signals of the same file */
 #define FILE_CHANGED_SIGNAL_RATE_LIMIT 100 /* in milliseconds */
 
@@ -150,20 +153,32 @@ thunar_file_reset_thumbnail (ThunarFile         *file,
 
 
 
-static GRecMutex G_LOCK_NAME (file_cache_mutex);
-
 /* In order to limit the number of total file watches */
 /* Note that a global, system-wide limit is defined in '/proc/sys/fs/inotify/max_user_watches' */
 #define THUNAR_FILE_WATCH_MAX 10000
 static gint thunar_file_watch_total_count = 0;
 
-#define G_REC_LOCK(name) g_rec_mutex_lock (&G_LOCK_NAME (name))
-#define G_REC_UNLOCK(name) g_rec_mutex_unlock (&G_LOCK_NAME (name))
 
 
+/* The file cache maps GFiles to weak references of their ThunarFiles. It is
+ * split by the hash of the GFile, so jobs which create files concurrently
+ * rarely wait for each other. The counters are only updated while the shard
+ * is locked and are read by thunar_file_cache_get_stats() and
+ * thunar_file_cache_dump() */
+typedef struct
+{
+  GRecMutex   mutex;
+  GHashTable *table;
+
+  guint hits;
+  guint misses;
+  guint contended;
+} ThunarFileCacheShard;
+
 
-static ThunarUserManager *user_manager;
-static GHashTable        *file_cache;
+
+static ThunarUserManager   *user_manager;
+static ThunarFileCacheShard file_cache[FILE_CACHE_N_SHARDS];
 static guint32            effective_user_id;
 static gboolean           enable_smart_sort;
 static GQuark             thunar_file_watch_quark;
@@ -208,12 +223,13 @@ struct _ThunarFile
   GFileType  kind;
   GFile     *gfile;
 
-  gchar *content_type;
+  /* interned with g_intern_string() */
+  const gchar *content_type;
 
   gchar *icon_name;
 
   gchar               *custom_icon_name;
-  gchar               *display_name;
+  gchar               *display_name; /* a #GRefString, shared by files of the same name */
   gchar               *basename;
   const gchar         *device_type;
   gboolean             is_thumbnail;
@@ -224,7 +240,7 @@ struct _ThunarFile
 
   ThunarThumbnailer *thumbnailer;
 
-  /* sorting */
+  /* sorting, computed on first use, see thunar_file_get_collate_key() */
   gchar *collate_key;
   gchar *collate_key_nocase;
 
@@ -294,6 +310,71 @@ weak_ref_free (GWeakRef *ref)
 }
 
 
+
+static guint
+thunar_file_cache_shard_index (const GFile *gfile)
+{
+  guint hash = g_file_hash (gfile);
+
+  /* mix the upper bits in, g_file_hash() of paths differs mostly in those */
+  return (hash ^ (hash >> 16)) & (FILE_CACHE_N_SHARDS - 1);
+}
+
+
+
+static void
+thunar_file_cache_shard_lock (ThunarFileCacheShard *shard)
+{
+  if (!g_rec_mutex_trylock (&shard->mutex))
+    {
+      g_rec_mutex_lock (&shard->mutex);
+      shard->contended++;
+    }
+
+  /* allocate the table on-demand */
+  if (G_UNLIKELY (shard->table == NULL))
+    {
+      shard->table = g_hash_table_new_full (g_file_hash,
+                                            (GEqualFunc) g_file_equal,
+                                            (GDestroyNotify) g_object_unref,
+                                            (GDestroyNotify) weak_ref_free);
+    }
+}
+
+
+
+/* locks and returns the part of the file cache which holds @gfile */
+static ThunarFileCacheShard *
+thunar_file_cache_lock (const GFile *gfile)
+{
+  ThunarFileCacheShard *shard = &file_cache[thunar_file_cache_shard_index (gfile)];
+
+  thunar_file_cache_shard_lock (shard);
+
+  return shard;
+}
+
+
+
+static void
+thunar_file_cache_unlock (ThunarFileCacheShard *shard)
+{
+  g_rec_mutex_unlock (&shard->mutex);
+}
+
+
+
+/* @shard must be the locked shard of @file */
+static void
+thunar_file_cache_insert (ThunarFileCacheShard *shard,
+                          ThunarFile           *file)
+{
+  g_hash_table_insert (shard->table,
+                       g_object_ref (file->gfile),
+                       weak_ref_new (G_OBJECT (file)));
+}
+
+
 #ifdef G_ENABLE_DEBUG
 #ifdef HAVE_ATEXIT
 static gboolean thunar_file_atexit_registered = FALSE;
@@ -319,22 +400,26 @@ thunar_file_atexit_foreach (gpointer key,
 static void
 thunar_file_atexit (void)
 {
-  G_REC_LOCK (file_cache_mutex);
+  guint n, n_files = 0;
 
-  if (file_cache == NULL || g_hash_table_size (file_cache) == 0)
+  for (n = 0; n < FILE_CACHE_N_SHARDS; n++)
     {
-      G_REC_UNLOCK (file_cache_mutex);
-      return;
+      thunar_file_cache_shard_lock (&file_cache[n]);
+      n_files += g_hash_table_size (file_cache[n].table);
     }
 
-  g_print ("--- Leaked a total of %u ThunarFile objects:\n",
-           g_hash_table_size (file_cache));
+  if (n_files > 0)
+    {
+      g_print ("--- Leaked a total of %u ThunarFile objects:\n", n_files);
 
-  g_hash_table_foreach (file_cache, thunar_file_atexit_foreach, NULL);
+      for (n = 0; n < FILE_CACHE_N_SHARDS; n++)
+        g_hash_table_foreach (file_cache[n].table, thunar_file_atexit_foreach, NULL);
 
-  g_print ("\n");
+      g_print ("\n");
+    }
 
-  G_REC_UNLOCK (file_cache_mutex);
+  for (n = FILE_CACHE_N_SHARDS; n > 0; n--)
+    thunar_file_cache_unlock (&file_cache[n - 1]);
 }
 #endif
 #endif
@@ -359,19 +444,30 @@ thunar_file_cache_dump_foreach (gpointer gfile,
 static gboolean
 thunar_file_cache_dump (gpointer user_data)
 {
-  G_REC_LOCK (file_cache_mutex);
+  ThunarFileCacheShard *shard;
+  guint                 n;
+  guint                 n_files = 0, hits = 0, misses = 0, contended = 0;
 
-  if (file_cache != NULL)
+  for (n = 0; n < FILE_CACHE_N_SHARDS; n++)
     {
-      g_print ("--- %d ThunarFile objects in cache:\n",
-               g_hash_table_size (file_cache));
+      shard = &file_cache[n];
+      thunar_file_cache_shard_lock (shard);
 
-      g_hash_table_foreach (file_cache, thunar_file_cache_dump_foreach, NULL);
+      g_print ("--- shard %u: %u ThunarFile objects, %u hits, %u misses, %u contended locks\n",
+               n, g_hash_table_size (shard->table), shard->hits, shard->misses, shard->contended);
 
-      g_print ("\n");
+      g_hash_table_foreach (shard->table, thunar_file_cache_dump_foreach, NULL);
+
+      n_files += g_hash_table_size (shard->table);
+      hits += shard->hits;
+      misses += shard->misses;
+      contended += shard->contended;
+
+      thunar_file_cache_unlock (shard);
     }
 
-  G_REC_UNLOCK (file_cache_mutex);
+  g_print ("--- %u ThunarFile objects in cache, %u hits, %u misses (%.1f%% hit rate), %u contended locks\n\n",
+           n_files, hits, misses, hits + misses > 0 ? 100.0 * hits / (hits + misses) : 0.0, contended);
 
   return TRUE;
 }
@@ -506,7 +602,8 @@ thunar_file_dispose (GObject *object)
 static void
 thunar_file_finalize (GObject *object)
 {
-  ThunarFile *file = THUNAR_FILE (object);
+  ThunarFile           *file = THUNAR_FILE (object);
+  ThunarFileCacheShard *shard;
 
   if (file->signal_changed_source_id != 0)
     g_source_remove (file->signal_changed_source_id);
@@ -528,9 +625,9 @@ thunar_file_finalize (GObject *object)
     g_object_unref (file->thumbnailer);
 
   /* drop the entry from the cache */
-  G_REC_LOCK (file_cache_mutex);
-  g_hash_table_remove (file_cache, file->gfile);
-  G_REC_UNLOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (file->gfile);
+  g_hash_table_remove (shard->table, file->gfile);
+  thunar_file_cache_unlock (shard);
 
   /* release file info */
   if (file->info != NULL)
@@ -543,13 +640,10 @@ thunar_file_finalize (GObject *object)
   /* free the custom icon name */
   g_free (file->custom_icon_name);
 
-  /* content type info */
-  g_free (file->content_type);
-
   g_free (file->icon_name);
 
   /* free display name and basename */
-  g_free (file->display_name);
+  g_clear_pointer (&file->display_name, g_ref_string_release);
   g_free (file->basename);
 
   /* free collate keys */
@@ -790,9 +884,15 @@ void
 thunar_file_replace_file (ThunarFile *file,
                           GFile      *renamed_file)
 {
-  GFile *previous_file;
+  ThunarFileCacheShard *previous_shard;
+  ThunarFileCacheShard *shard;
+  GFile                *previous_file;
 
-  G_REC_LOCK (file_cache_mutex);
+  /* lock both shards in the same order as everybody else, to avoid deadlocks */
+  previous_shard = &file_cache[thunar_file_cache_shard_index (file->gfile)];
+  shard = &file_cache[thunar_file_cache_shard_index (renamed_file)];
+  thunar_file_cache_shard_lock (MIN (previous_shard, shard));
+  thunar_file_cache_shard_lock (MAX (previous_shard, shard));
 
   /* get the old location */
   previous_file = file->gfile;
@@ -801,7 +901,7 @@ thunar_file_replace_file (ThunarFile *file,
   file->gfile = g_object_ref (renamed_file);
 
   /* drop the previous entry from the cache */
-  g_hash_table_remove (file_cache, previous_file);
+  g_hash_table_remove (previous_shard->table, previous_file);
 
   /* need to re-register the monitor handle for the new uri */
   thunar_file_watch_reconnect (file);
@@ -810,11 +910,10 @@ thunar_file_replace_file (ThunarFile *file,
   g_object_unref (previous_file);
 
   /* insert the new entry */
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
+  thunar_file_cache_insert (shard, file);
 
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (MAX (previous_shard, shard));
+  thunar_file_cache_unlock (MIN (previous_shard, shard));
 }
 
 
@@ -930,14 +1029,12 @@ thunar_file_info_clear (ThunarFile *file)
   file->custom_icon_name = NULL;
 
   /* free display name and basename */
-  g_free (file->display_name);
-  file->display_name = NULL;
+  g_clear_pointer (&file->display_name, g_ref_string_release);
 
   g_free (file->basename);
   file->basename = NULL;
 
   /* content type */
-  g_free (file->content_type);
   file->content_type = NULL;
 
   g_free (file->icon_name);
@@ -993,7 +1090,7 @@ thunar_file_info_reload (ThunarFile   *file,
   const gchar       *target_uri;
   const gchar       *display_name;
   gchar             *p;
-  gchar             *casefold;
+  gchar             *name;
   gchar             *path;
   GKeyFile          *key_file;
   gboolean           launcher_name;
@@ -1074,19 +1171,18 @@ thunar_file_info_reload (ThunarFile   *file,
           g_object_unref (preferences);
           if (thunar_g_vfs_metadata_is_supported () && xfce_g_file_is_trusted (file->gfile, NULL, NULL) && launcher_name == TRUE)
             {
-              g_free (file->display_name);
+              g_clear_pointer (&file->display_name, g_ref_string_release);
 
-              file->display_name = g_key_file_get_locale_string (key_file,
-                                                                 G_KEY_FILE_DESKTOP_GROUP,
-                                                                 G_KEY_FILE_DESKTOP_KEY_NAME,
-                                                                 NULL, NULL);
+              name = g_key_file_get_locale_string (key_file,
+                                                   G_KEY_FILE_DESKTOP_GROUP,
+                                                   G_KEY_FILE_DESKTOP_KEY_NAME,
+                                                   NULL, NULL);
 
               /* drop the name if it's empty or has invalid encoding */
-              if (xfce_str_is_empty (file->display_name) || !g_utf8_validate (file->display_name, -1, NULL))
-                {
-                  g_free (file->display_name);
-                  file->display_name = NULL;
-                }
+              if (!xfce_str_is_empty (name) && g_utf8_validate (name, -1, NULL))
+                file->display_name = g_ref_string_new_intern (name);
+
+              g_free (name);
             }
 
           /* free the key file */
@@ -1108,40 +1204,31 @@ thunar_file_info_reload (ThunarFile   *file,
   if (file->display_name == NULL)
     {
       if (G_UNLIKELY (thunar_file_is_trash (file)))
-        file->display_name = g_strdup (_("Trash"));
+        file->display_name = g_ref_string_new_intern (_("Trash"));
       else if (G_UNLIKELY (thunar_file_is_favorites (file)))
-        file->display_name = g_strdup (_("Favorites"));
+        file->display_name = g_ref_string_new_intern (_("Favorites"));
       else if (G_LIKELY (file->info != NULL))
         {
           display_name = g_file_info_get_display_name (file->info);
           if (G_LIKELY (display_name != NULL))
             {
               if (strcmp (display_name, "/") == 0)
-                file->display_name = g_strdup (_("File System"));
+                file->display_name = g_ref_string_new_intern (_("File System"));
               else
-                file->display_name = g_strdup (display_name);
+                file->display_name = g_ref_string_new_intern (display_name);
             }
         }
 
       /* fall back to a name for the gfile */
       if (file->display_name == NULL)
-        file->display_name = thunar_g_file_get_display_name (file->gfile);
+        {
+          name = thunar_g_file_get_display_name (file->gfile);
+          file->display_name = g_ref_string_new_intern (name);
+          g_free (name);
+        }
     }
 
-  /* create case sensitive collation key */
-  file->collate_key = thunar_collate_key_for_filename (file->display_name);
-
-  /* lowercase the display name */
-  casefold = g_utf8_casefold (file->display_name, -1);
-
-  /* if the lowercase name is equal, only peek the already hash key */
-  if (casefold != NULL && strcmp (casefold, file->display_name) != 0)
-    file->collate_key_nocase = thunar_collate_key_for_filename (casefold);
-  else
-    file->collate_key_nocase = file->collate_key;
-
-  /* cleanup */
-  g_free (casefold);
+  /* the collation keys are created once the file gets sorted */
 }
 
 
@@ -1151,11 +1238,12 @@ thunar_file_get_async_finish (GObject      *object,
                               GAsyncResult *result,
                               gpointer      user_data)
 {
-  ThunarFileGetData *data = user_data;
-  ThunarFile        *file;
-  GFileInfo         *file_info;
-  GError            *error = NULL;
-  GFile             *location = G_FILE (object);
+  ThunarFileGetData    *data = user_data;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
+  GFileInfo            *file_info;
+  GError               *error = NULL;
+  GFile                *location = G_FILE (object);
 
   _thunar_return_if_fail (G_IS_FILE (location));
   _thunar_return_if_fail (G_IS_ASYNC_RESULT (result));
@@ -1186,11 +1274,9 @@ thunar_file_get_async_finish (GObject      *object,
     }
 
   /* insert the file into the cache */
-  G_REC_LOCK (file_cache_mutex);
-  g_hash_table_insert (file_cache,
-                       g_object_ref (file->gfile),
-                       weak_ref_new (G_OBJECT (file)));
-  G_REC_UNLOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (file->gfile);
+  thunar_file_cache_insert (shard, file);
+  thunar_file_cache_unlock (shard);
 
   /* pass the loaded file and possible errors to the return function */
   (data->func) (location, file, error, data->user_data);
@@ -1229,19 +1315,20 @@ thunar_file_load (ThunarFile   *file,
                   GCancellable *cancellable,
                   GError      **error)
 {
-  GError    *err = NULL;
-  GFileInfo *info = NULL;
-  gboolean   mounted = TRUE;
+  ThunarFileCacheShard *shard;
+  GError               *err = NULL;
+  GFileInfo            *info = NULL;
+  gboolean              mounted = TRUE;
 
   _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   _thunar_return_val_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable), FALSE);
   _thunar_return_val_if_fail (G_IS_FILE (file->gfile), FALSE);
 
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (file->gfile);
 
   /* remove the file from cache */
-  g_hash_table_remove (file_cache, file->gfile);
+  g_hash_table_remove (shard->table, file->gfile);
 
   /* Handle virtual favorites:/// folder specially */
   if (thunar_g_file_is_favorites (file->gfile))
@@ -1265,10 +1352,8 @@ thunar_file_load (ThunarFile   *file,
       thunar_file_info_reload (file, cancellable);
 
       /* (re)insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-      G_REC_UNLOCK (file_cache_mutex);
+      thunar_file_cache_insert (shard, file);
+      thunar_file_cache_unlock (shard);
       return TRUE;
     }
 
@@ -1295,10 +1380,8 @@ thunar_file_load (ThunarFile   *file,
       g_propagate_error (error, err);
 
       /* even if we failed to load it, re-add the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
-      G_REC_UNLOCK (file_cache_mutex);
+      thunar_file_cache_insert (shard, file);
+      thunar_file_cache_unlock (shard);
       return FALSE;
     }
 
@@ -1318,12 +1401,10 @@ thunar_file_load (ThunarFile   *file,
   /* (re)insert the file into the cache */
   if (file->kind != G_FILE_TYPE_UNKNOWN)
     {
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
+      thunar_file_cache_insert (shard, file);
     }
 
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   return TRUE;
 }
@@ -1348,13 +1429,14 @@ ThunarFile *
 thunar_file_get (GFile   *gfile,
                  GError **error)
 {
-  ThunarFile *file;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
 
   _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
 
   /* both lookup and insert must happen in the same critical section
    * because the insert is contigent upon the lookup */
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (gfile);
 
   /* check if we already have a cached version of that file */
   file = thunar_file_cache_lookup (gfile);
@@ -1373,7 +1455,7 @@ thunar_file_get (GFile   *gfile,
         {
           /* Just check that it's been cached, if appropriate */
           if (file->kind != G_FILE_TYPE_UNKNOWN)
-            _thunar_assert (g_hash_table_contains (file_cache, file->gfile) == TRUE);
+            _thunar_assert (g_hash_table_contains (shard->table, file->gfile) == TRUE);
         }
       else
         {
@@ -1386,7 +1468,7 @@ thunar_file_get (GFile   *gfile,
     }
 
   /* finished related activity on the cache */
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   return file;
 }
@@ -1417,13 +1499,14 @@ thunar_file_get_with_info (GFile     *gfile,
                            GFileInfo *recent_info,
                            gboolean   not_mounted)
 {
-  ThunarFile *file;
+  ThunarFileCacheShard *shard;
+  ThunarFile           *file;
 
   _thunar_return_val_if_fail (G_IS_FILE (gfile), NULL);
   _thunar_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
 
   /* all contingent lookups and inserts must happen in the same critical section */
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (gfile);
 
   /* check if we already have a cached version of that file */
   file = thunar_file_cache_lookup (gfile);
@@ -1452,13 +1535,11 @@ thunar_file_get_with_info (GFile     *gfile,
         FLAG_UNSET (file, THUNAR_FILE_FLAG_IS_MOUNTED);
 
       /* insert the file into the cache */
-      g_hash_table_insert (file_cache,
-                           g_object_ref (file->gfile),
-                           weak_ref_new (G_OBJECT (file)));
+      thunar_file_cache_insert (shard, file);
     }
 
   /* done reading and writing the cache for this file instance */
-  G_REC_UNLOCK (file_cache_mutex);
+  thunar_file_cache_unlock (shard);
 
   if (recent_info != NULL)
     file->recent_info = g_object_ref (recent_info);
@@ -2592,7 +2673,7 @@ thunar_file_set_content_type (ThunarFile  *file,
   _thunar_return_if_fail (THUNAR_IS_FILE (file));
 
   if (G_LIKELY (file->content_type == NULL))
-    file->content_type = g_strdup (content_type);
+    file->content_type = g_intern_string (content_type);
 }
 
 
@@ -4514,6 +4595,58 @@ thunar_file_reload (ThunarFile *file)
 
 
 
+/**
+ * thunar_file_reload_with_info:
+ * @file : a #ThunarFile instance.
+ * @info : a #GFileInfo queried for @file, e.g. in a #ThunarJob.
+ *
+ * Like thunar_file_reload(), but takes the file information from @info
+ * instead of querying it, so the I/O can happen in a separate thread.
+ *
+ * Return value: %TRUE on success, %FALSE if @file was destroyed.
+ **/
+gboolean
+thunar_file_reload_with_info (ThunarFile *file,
+                              GFileInfo  *info)
+{
+  ThunarFileCacheShard *shard;
+
+  _thunar_return_val_if_fail (THUNAR_IS_FILE (file), FALSE);
+  _thunar_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
+
+  /* the favorites folder has a synthetic info */
+  if (thunar_g_file_is_favorites (file->gfile))
+    return thunar_file_reload (file);
+
+  /* clear file pxmap cache */
+  thunar_icon_factory_clear_pixmap_cache (file);
+
+  shard = thunar_file_cache_lock (file->gfile);
+
+  /* remove the file from cache */
+  g_hash_table_remove (shard->table, file->gfile);
+
+  /* reset the file and update it from the new info */
+  thunar_file_info_clear (file);
+  file->info = g_object_ref (info);
+  thunar_file_info_reload (file, NULL);
+
+  /* (re)insert the file into the cache */
+  if (file->kind != G_FILE_TYPE_UNKNOWN)
+    {
+      thunar_file_cache_insert (shard, file);
+    }
+
+  thunar_file_cache_unlock (shard);
+
+  /* ... and tell others */
+  thunar_file_changed (file);
+
+  return TRUE;
+}
+
+
+
 static gboolean
 thunar_file_reload_cb_once (gpointer user_data)
 {
@@ -4652,6 +4785,77 @@ thunar_file_compare_by_type (ThunarFile *a,
 
 
 
+/**
+ * thunar_file_get_collate_key:
+ * @file : a #ThunarFile.
+ *
+ * Returns the case sensitive collation key of the display name of @file.
+ * Most files are never sorted by name, so the key is only created here,
+ * when it is needed first. Files may be sorted in multiple threads, so the
+ * key is published atomically.
+ *
+ * Return value: the collation key, owned by @file.
+ **/
+static const gchar *
+thunar_file_get_collate_key (const ThunarFile *file)
+{
+  gchar *key;
+
+  key = g_atomic_pointer_get (&file->collate_key);
+  if (G_LIKELY (key != NULL))
+    return key;
+
+  key = thunar_collate_key_for_filename (file->display_name);
+
+  /* another thread might have been faster */
+  if (!g_atomic_pointer_compare_and_exchange (&((ThunarFile *) file)->collate_key, NULL, key))
+    g_free (key);
+
+  return g_atomic_pointer_get (&file->collate_key);
+}
+
+
+
+/**
+ * thunar_file_get_collate_key_nocase:
+ * @file : a #ThunarFile.
+ *
+ * Like thunar_file_get_collate_key(), but for the case folded display name.
+ * If case folding does not change the name, the case sensitive key is shared.
+ *
+ * Return value: the collation key, owned by @file.
+ **/
+static const gchar *
+thunar_file_get_collate_key_nocase (const ThunarFile *file)
+{
+  gchar *casefold;
+  gchar *key;
+
+  key = g_atomic_pointer_get (&file->collate_key_nocase);
+  if (G_LIKELY (key != NULL))
+    return key;
+
+  /* lowercase the display name */
+  casefold = g_utf8_casefold (file->display_name, -1);
+
+  /* if the lowercase name is equal, only peek the already hash key */
+  if (strcmp (casefold, file->display_name) != 0)
+    key = thunar_collate_key_for_filename (casefold);
+  else
+    key = (gchar *) thunar_file_get_collate_key (file);
+
+  g_free (casefold);
+
+  /* another thread might have been faster */
+  if (!g_atomic_pointer_compare_and_exchange (&((ThunarFile *) file)->collate_key_nocase, NULL, key)
+      && key != file->collate_key)
+    g_free (key);
+
+  return g_atomic_pointer_get (&file->collate_key_nocase);
+}
+
+
+
 /**
  * thunar_file_compare_by_name:
  * @file_a         : the first #ThunarFile.
@@ -4681,11 +4885,11 @@ thunar_file_compare_by_name (const ThunarFile *file_a,
 
   /* case insensitive checking */
   if (G_LIKELY (!case_sensitive))
-    result = g_strcmp0 (file_a->collate_key_nocase, file_b->collate_key_nocase);
+    result = g_strcmp0 (thunar_file_get_collate_key_nocase (file_a), thunar_file_get_collate_key_nocase (file_b));
 
   /* fall-back to case sensitive */
   if (result == 0)
-    result = g_strcmp0 (file_a->collate_key, file_b->collate_key);
+    result = g_strcmp0 (thunar_file_get_collate_key (file_a), thunar_file_get_collate_key (file_b));
 
   /* this happens in the trash */
   if (result == 0)
@@ -4746,30 +4950,27 @@ thunar_file_same_filesystem (const ThunarFile *file_a,
 ThunarFile *
 thunar_file_cache_lookup (const GFile *file)
 {
-  GWeakRef   *ref;
-  ThunarFile *cached_file;
+  ThunarFileCacheShard *shard;
+  GWeakRef             *ref;
+  ThunarFile           *cached_file;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
 
-  G_REC_LOCK (file_cache_mutex);
+  shard = thunar_file_cache_lock (file);
 
-  /* allocate the ThunarFile cache on-demand */
-  if (G_UNLIKELY (file_cache == NULL))
-    {
-      file_cache = g_hash_table_new_full (g_file_hash,
-                                          (GEqualFunc) g_file_equal,
-                                          (GDestroyNotify) g_object_unref,
-                                          (GDestroyNotify) weak_ref_free);
-    }
-
-  ref = g_hash_table_lookup (file_cache, file);
+  ref = g_hash_table_lookup (shard->table, file);
 
   if (ref == NULL)
     cached_file = NULL;
   else
     cached_file = g_weak_ref_get (ref);
 
-  G_REC_UNLOCK (file_cache_mutex);
+  if (cached_file != NULL)
+    shard->hits++;
+  else
+    shard->misses++;
+
+  thunar_file_cache_unlock (shard);
 
   return cached_file;
 }
@@ -4801,6 +5002,55 @@ thunar_file_cached_display_name (const GFile *file)
 
 
 
+/**
+ * thunar_file_cache_get_stats:
+ * @n_files   : return location for the number of cached files or %NULL.
+ * @hits      : return location for the number of lookups which found a file or %NULL.
+ * @misses    : return location for the number of lookups which did not or %NULL.
+ * @contended : return location for the number of times a lock of the
+ *              cache had to be waited for or %NULL.
+ *
+ * Sums up the counters of all parts of the file cache, which are also
+ * printed when DUMP_FILE_CACHE is enabled.
+ **/
+void
+thunar_file_cache_get_stats (guint *n_files,
+                             guint *hits,
+                             guint *misses,
+                             guint *contended)
+{
+  ThunarFileCacheShard *shard;
+  guint                 n;
+
+  if (n_files != NULL)
+    *n_files = 0;
+  if (hits != NULL)
+    *hits = 0;
+  if (misses != NULL)
+    *misses = 0;
+  if (contended != NULL)
+    *contended = 0;
+
+  for (n = 0; n < FILE_CACHE_N_SHARDS; n++)
+    {
+      shard = &file_cache[n];
+      thunar_file_cache_shard_lock (shard);
+
+      if (n_files != NULL)
+        *n_files += g_hash_table_size (shard->table);
+      if (hits != NULL)
+        *hits += shard->hits;
+      if (misses != NULL)
+        *misses += shard->misses;
+      if (contended != NULL)
+        *contended += shard->contended;
+
+      thunar_file_cache_unlock (shard);
+    }
+}
+
+
+
 static gint
 compare_app_infos (gconstpointer a,
                    gconstpointer b)
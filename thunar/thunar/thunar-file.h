@@ -373,6 +373,9 @@ gchar *
 thunar_collate_key_for_filename (const gchar *str);
 gboolean
 thunar_file_reload (ThunarFile *file);
+gboolean
+thunar_file_reload_with_info (ThunarFile *file,
+                              GFileInfo  *info);
 void
 thunar_file_reload_idle (ThunarFile *file);
 void
@@ -393,6 +396,11 @@ ThunarFile *
 thunar_file_cache_lookup (const GFile *file);
 gchar *
 thunar_file_cached_display_name (const GFile *file);
+void
+thunar_file_cache_get_stats (guint *n_files,
+                             guint *hits,
+                             guint *misses,
+                             guint *contended);
 
 
 GList *
@@ -22,7 +22,9 @@
 #include "thunar/thunar-gobject-extensions.h"
 #include "thunar/thunar-io-jobs.h"
 #include "thunar/thunar-job.h"
+#include "thunar/thunar-preferences.h"
 #include "thunar/thunar-private.h"
+#include "thunar/thunar-search-index.h"
 
 #include <libxfce4util/libxfce4util.h>
 
@@ -101,6 +103,8 @@ thunar_folder_monitor (GFileMonitor     *monitor,
 static void
 thunar_folder_reset_monitor (ThunarFolder *folder);
 static void
+thunar_folder_reload_changed_files (ThunarFolder *folder);
+static void
 thunar_folder_load_content_types (ThunarFolder *folder,
                                   GHashTable   *files);
 static void
@@ -140,6 +144,7 @@ struct _ThunarFolder
 
   ThunarJob *job;
   ThunarJob *content_type_job;
+  ThunarJob *reload_job;
 
   ThunarFile *corresponding_file;
 
@@ -149,6 +154,9 @@ struct _ThunarFolder
   /* Files which were changed recently. The key is a ThunarFile; value is NULL (unimportant)*/
   GHashTable *changed_files_map;
 
+  /* Files which are reloaded by the reload job. The key is a ThunarFile; value is the GFile it was queried for */
+  GHashTable *reloading_files_map;
+
   /* Files which were added recently. The key is a ThunarFile; value is NULL (unimportant)*/
   GHashTable *added_files_map;
 
@@ -348,6 +356,7 @@ thunar_folder_init (ThunarFolder *folder)
   folder->added_files_map = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
   folder->removed_files_map = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
   folder->changed_files_map = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
+  folder->reloading_files_map = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, g_object_unref);
 
   folder->loaded = FALSE;
   folder->reload_info = FALSE;
@@ -390,6 +399,15 @@ thunar_folder_finalize (GObject *object)
       folder->content_type_job = NULL;
     }
 
+  /* stop reloading changed files */
+  if (G_UNLIKELY (folder->reload_job != NULL))
+    {
+      g_signal_handlers_disconnect_by_data (folder->reload_job, folder);
+      thunar_job_cancel (THUNAR_JOB (folder->reload_job));
+      g_object_unref (folder->reload_job);
+      folder->reload_job = NULL;
+    }
+
   /* stop any running tumbnailing timeout source */
   if (folder->thumbnail_updated_timeout_source_id != 0)
     g_source_remove (folder->thumbnail_updated_timeout_source_id);
@@ -440,6 +458,7 @@ thunar_folder_finalize (GObject *object)
   g_hash_table_destroy (folder->files_map);
   g_hash_table_destroy (folder->loaded_files_map);
   g_hash_table_destroy (folder->changed_files_map);
+  g_hash_table_destroy (folder->reloading_files_map);
   g_hash_table_destroy (folder->added_files_map);
   g_hash_table_destroy (folder->removed_files_map);
 
@@ -587,27 +606,12 @@ _thunar_folder_files_update_timeout (gpointer data)
   g_hash_table_remove_all (files);
   g_hash_table_remove_all (folder->added_files_map);
 
-  /* reload files which were changed and send a 'changed' signal for them, if required */
-  g_hash_table_iter_init (&iter, folder->changed_files_map);
-  while (g_hash_table_iter_next (&iter, &key, NULL))
-    {
-      /* block 'changed' signals for this file until reload is done, in order to prevent recursion */
-      g_signal_handlers_block_by_func (G_OBJECT (key), G_CALLBACK (thunar_folder_file_changed), folder);
-      thunar_file_reload (THUNAR_FILE (key));
-      g_signal_handlers_unblock_by_func (G_OBJECT (key), G_CALLBACK (thunar_folder_file_changed), folder);
-
-      /* only send the 'changed' signal for files which are already part of this folder */
-      if (!g_hash_table_contains (folder->files_map, key))
-        continue;
-
-      g_hash_table_add (files, g_object_ref (key));
-    }
-
-  if (g_hash_table_size (files) > 0)
-    g_signal_emit (G_OBJECT (folder), folder_signals[FILES_CHANGED], 0, files);
-
   g_hash_table_destroy (files);
-  g_hash_table_remove_all (folder->changed_files_map);
+
+  /* reload files which were changed, unless a reload is still running. In that
+   * case the files are picked up as soon as the running reload finished */
+  if (folder->reload_job == NULL && g_hash_table_size (folder->changed_files_map) > 0)
+    thunar_folder_reload_changed_files (folder);
 
   /* Loading is done for this folder */
   if (folder->loaded == FALSE && folder->job == NULL)
@@ -705,17 +709,36 @@ thunar_folder_files_ready (ThunarJob    *job,
                            GList        *files,
                            ThunarFolder *folder)
 {
-  GList *lp;
+  GList   *lp;
+  gboolean first_chunk;
 
   _thunar_return_val_if_fail (THUNAR_IS_FOLDER (folder), FALSE);
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
 
+  first_chunk = g_hash_table_size (folder->files_map) == 0
+                && g_hash_table_size (folder->added_files_map) == 0;
+
   /* merge the list with the existing list of new files */
   for (lp = files; lp != NULL; lp = lp->next)
-    g_hash_table_add (folder->loaded_files_map, g_object_ref (lp->data));
+    {
+      g_hash_table_add (folder->loaded_files_map, g_object_ref (lp->data));
+
+      /* show new files while the rest of the folder is still being read. Files
+       * which are gone are only known once reading is done, see thunar_folder_finished() */
+      if (!g_hash_table_contains (folder->files_map, lp->data))
+        thunar_folder_add_file (folder, lp->data);
+    }
 
   thunar_g_list_free_full (files);
 
+  /* don't wait for the update timeout with the first files of an empty folder,
+   * so they get painted as soon as possible */
+  if (first_chunk && folder->files_update_timeout_source_id != 0)
+    {
+      g_source_remove (folder->files_update_timeout_source_id);
+      _thunar_folder_files_update_timeout (folder);
+    }
+
   /* indicate that we took over ownership of the file list */
   return TRUE;
 }
@@ -734,6 +757,104 @@ _thunar_folder_load_content_types_finished (ThunarFolder *folder, ThunarJob *job
 
 
 
+static void
+_thunar_folder_reload_changed_files_finished (ThunarFolder *folder,
+                                              ThunarJob    *job)
+{
+  ThunarFile    *file;
+  GFileInfo     *info;
+  GHashTable    *files = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
+  GHashTableIter iter;
+  gpointer       key, g_file;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (THUNAR_IS_JOB (job));
+
+  g_hash_table_iter_init (&iter, folder->reloading_files_map);
+  while (g_hash_table_iter_next (&iter, &key, &g_file))
+    {
+      file = THUNAR_FILE (key);
+      info = g_object_steal_data (G_OBJECT (g_file), "file-info");
+
+      /* block 'changed' signals for this file until reload is done, in order to prevent recursion */
+      g_signal_handlers_block_by_func (G_OBJECT (file), G_CALLBACK (thunar_folder_file_changed), folder);
+
+      /* fall back to a synchronous reload if the query failed or the file was renamed meanwhile */
+      if (info != NULL && g_file_equal (g_file, thunar_file_get_file (file)))
+        thunar_file_reload_with_info (file, info);
+      else
+        thunar_file_reload (file);
+
+      g_signal_handlers_unblock_by_func (G_OBJECT (file), G_CALLBACK (thunar_folder_file_changed), folder);
+
+      if (info != NULL)
+        g_object_unref (info);
+
+      /* only send the 'changed' signal for files which are already part of this folder */
+      if (g_hash_table_contains (folder->files_map, file))
+        g_hash_table_add (files, g_object_ref (file));
+    }
+
+  g_hash_table_remove_all (folder->reloading_files_map);
+
+  g_object_unref (folder->reload_job);
+  folder->reload_job = NULL;
+
+  if (g_hash_table_size (files) > 0)
+    g_signal_emit (G_OBJECT (folder), folder_signals[FILES_CHANGED], 0, files);
+
+  g_hash_table_destroy (files);
+
+  /* files which changed while the job was running */
+  if (g_hash_table_size (folder->changed_files_map) > 0 && folder->files_update_timeout_source_id == 0)
+    folder->files_update_timeout_source_id = g_timeout_add (THUNAR_FOLDER_UPDATE_TIMEOUT, (GSourceFunc) _thunar_folder_files_update_timeout, folder);
+}
+
+
+
+/**
+ * thunar_folder_reload_changed_files:
+ * @folder : a #ThunarFolder instance.
+ *
+ * Starts a job which queries the file info of all changed files at once. The
+ * files are reloaded and a single 'files-changed' signal is sent once the job
+ * finished, so the main loop does not block on slow mounts.
+ **/
+static void
+thunar_folder_reload_changed_files (ThunarFolder *folder)
+{
+  GHashTable    *g_files = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
+  GHashTableIter iter;
+  gpointer       key;
+  GFile         *g_file;
+
+  _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
+  _thunar_return_if_fail (folder->reload_job == NULL);
+
+  g_hash_table_iter_init (&iter, folder->changed_files_map);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      g_file = thunar_file_get_file (THUNAR_FILE (key));
+
+      /* drop stale results of a previously cancelled job */
+      g_object_set_data (G_OBJECT (g_file), "file-info", NULL);
+
+      g_hash_table_insert (folder->reloading_files_map, g_object_ref (key), g_object_ref (g_file));
+      g_hash_table_add (g_files, g_object_ref (g_file));
+    }
+
+  g_hash_table_remove_all (folder->changed_files_map);
+
+  folder->reload_job = thunar_io_jobs_query_file_infos (g_files);
+  g_signal_connect_object (folder->reload_job, "finished", G_CALLBACK (_thunar_folder_reload_changed_files_finished), folder, G_CONNECT_SWAPPED);
+
+  thunar_job_launch (THUNAR_JOB (folder->reload_job));
+
+  g_hash_table_destroy (g_files);
+}
+
+
+
 /**
  * thunar_folder_load_content_types:
  * @folder : a #ThunarFolder instance.
@@ -995,6 +1116,10 @@ thunar_folder_monitor (GFileMonitor     *monitor,
       /* Add the file to our map via the timeout source */
       thunar_folder_add_file (folder, event_file_thunar);
 
+      /* keep the search index in sync */
+      if (thunar_search_index_is_enabled ())
+        thunar_search_index_file_added (event_file_thunar);
+
       /* if we already ship the ThunarFile, reload it */
       if (g_hash_table_lookup (folder->files_map, event_file_thunar) != NULL)
         thunar_file_reload (event_file_thunar);
@@ -1009,6 +1134,10 @@ thunar_folder_monitor (GFileMonitor     *monitor,
       if (event_type == G_FILE_MONITOR_EVENT_MOVED_OUT && other_file != NULL)
         thunar_file_move_thumbnail_cache_file (event_file, other_file);
 
+      /* keep the search index in sync */
+      if (thunar_search_index_is_enabled ())
+        thunar_search_index_file_removed (event_file);
+
       /* If the ThunarFile is not known to us, than we cannot remove it */
       if (event_file_thunar == NULL)
         break;
@@ -1023,6 +1152,10 @@ thunar_folder_monitor (GFileMonitor     *monitor,
 
     case G_FILE_MONITOR_EVENT_RENAMED:
 
+      /* keep the search index in sync, the new name is added after the reload */
+      if (thunar_search_index_is_enabled ())
+        thunar_search_index_file_removed (event_file);
+
       /* in case source and dest are already the same ThunarFile, just assume we have no source ThunarFile */
       if (event_file_thunar != NULL && event_file_thunar == other_file_thunar)
         {
@@ -1070,6 +1203,9 @@ thunar_folder_monitor (GFileMonitor     *monitor,
           thunar_file_move_thumbnail_cache_file (event_file, other_file);
         }
 
+      if (thunar_search_index_is_enabled ())
+        thunar_search_index_file_added (renamed_file);
+
       break;
 
     case G_FILE_MONITOR_EVENT_CHANGED:
@@ -1273,6 +1409,9 @@ void
 thunar_folder_reload (ThunarFolder *folder,
                       gboolean      reload_info)
 {
+  ThunarPreferences *preferences;
+  guint              first_chunk_files;
+
   _thunar_return_if_fail (THUNAR_IS_FOLDER (folder));
 
   /* reload file info too? */
@@ -1298,7 +1437,12 @@ thunar_folder_reload (ThunarFolder *folder,
   folder->loaded = FALSE;
   g_object_notify (G_OBJECT (folder), "loading");
 
-  folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file));
+  /* number of files to show before the rest of the folder is read */
+  preferences = thunar_preferences_get ();
+  g_object_get (G_OBJECT (preferences), "misc-first-paint-files", &first_chunk_files, NULL);
+  g_object_unref (preferences);
+
+  folder->job = thunar_io_jobs_list_directory (thunar_file_get_file (folder->corresponding_file), first_chunk_files);
   g_signal_connect (folder->job, "error", G_CALLBACK (thunar_folder_error), folder);
   g_signal_connect (folder->job, "finished", G_CALLBACK (thunar_folder_finished), folder);
   g_signal_connect (folder->job, "files-ready", G_CALLBACK (thunar_folder_files_ready), folder);
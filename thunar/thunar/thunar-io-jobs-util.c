@@ -83,7 +83,7 @@ thunar_io_jobs_util_next_duplicate_file (ThunarJob             *job,
     }
 
   old_filename = g_file_get_basename (file);
-  file_list = thunar_io_scan_directory (NULL, parent_file, G_FILE_QUERY_INFO_NONE, FALSE, FALSE, FALSE, NULL, NULL);
+  file_list = thunar_io_scan_directory (NULL, parent_file, G_FILE_QUERY_INFO_NONE, FALSE, FALSE, FALSE, NULL, 0, NULL);
   filename = thunar_util_next_new_file_name_raw (file_list,
                                                  old_filename,
                                                  name_mode,
@@ -23,6 +23,9 @@
 #endif
 
 #include "thunar/thunar-application.h"
+#ifdef HAVE_LIBARCHIVE
+#include "thunar/thunar-archive-index.h"
+#endif
 #include "thunar/thunar-enum-types.h"
 #include "thunar/thunar-file.h"
 #include "thunar/thunar-gio-extensions.h"
@@ -33,6 +36,7 @@
 #include "thunar/thunar-job.h"
 #include "thunar/thunar-preferences.h"
 #include "thunar/thunar-private.h"
+#include "thunar/thunar-search-index.h"
 #include "thunar/thunar-simple-job.h"
 #include "thunar/thunar-thumbnail-cache.h"
 #include "thunar/thunar-transfer-job.h"
@@ -61,7 +65,7 @@ _tij_collect_nofollow (ThunarJob *job,
       /* try to scan the directory */
       child_file_list = thunar_io_scan_directory (job, lp->data,
                                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                                  TRUE, unlinking, FALSE, NULL, &err);
+                                                  TRUE, unlinking, FALSE, NULL, 0, &err);
 
       /* prepend the new files to the existing list */
       file_list = thunar_g_list_prepend_deep (file_list, lp->data);
@@ -1341,10 +1345,11 @@ _thunar_io_jobs_ls (ThunarJob *job,
   GError *err = NULL;
   GFile  *directory;
   GList  *file_list = NULL;
+  guint   first_chunk_files;
 
   _thunar_return_val_if_fail (THUNAR_IS_JOB (job), FALSE);
   _thunar_return_val_if_fail (param_values != NULL, FALSE);
-  _thunar_return_val_if_fail (param_values->len == 1, FALSE);
+  _thunar_return_val_if_fail (param_values->len == 2, FALSE);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
@@ -1352,14 +1357,16 @@ _thunar_io_jobs_ls (ThunarJob *job,
 
   /* determine the directory to list */
   directory = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  first_chunk_files = g_value_get_uint (&g_array_index (param_values, GValue, 1));
 
   /* make sure the object is valid */
   _thunar_assert (G_IS_FILE (directory));
 
-  /* collect directory contents (non-recursively) */
+  /* collect directory contents (non-recursively), chunks are handed over while scanning */
   file_list = thunar_io_scan_directory (job, directory,
                                         G_FILE_QUERY_INFO_NONE,
-                                        FALSE, FALSE, TRUE, NULL, &err);
+                                        FALSE, FALSE, TRUE, NULL,
+                                        first_chunk_files, &err);
 
   /* abort on errors or cancellation */
   if (err != NULL)
@@ -1400,12 +1407,26 @@ _thunar_io_jobs_ls (ThunarJob *job,
 
 
 
+/**
+ * thunar_io_jobs_list_directory:
+ * @directory         : the #GFile of the directory to list.
+ * @first_chunk_files : number of files in the first "files-ready" chunk, or 0
+ *                      to emit "files-ready" only once all files were read.
+ *
+ * Lists the files of @directory in a separate thread and passes them to the
+ * "files-ready" handlers, see thunar_io_scan_directory() for the chunks.
+ *
+ * Returns: (transfer full): the #ThunarJob which manages the separate thread
+ **/
 ThunarJob *
-thunar_io_jobs_list_directory (GFile *directory)
+thunar_io_jobs_list_directory (GFile *directory,
+                               guint  first_chunk_files)
 {
   _thunar_return_val_if_fail (G_IS_FILE (directory), NULL);
 
-  return thunar_simple_job_new (_thunar_io_jobs_ls, 1, G_TYPE_FILE, directory);
+  return thunar_simple_job_new (_thunar_io_jobs_ls, 2,
+                                G_TYPE_FILE, directory,
+                                G_TYPE_UINT, first_chunk_files);
 }
 
 
@@ -1570,24 +1591,172 @@ thunar_io_jobs_count_files (ThunarFile *file)
 
 
 
+/* upper bound for the number of threads used by a recursive search */
+#define THUNAR_SEARCH_MAX_WORKERS (8)
+
+/* number of matches a worker collects before handing them to the model */
+#define THUNAR_SEARCH_BATCH_SIZE (256)
+
+/* how long (in microseconds) an idle worker sleeps before looking for work again */
+#define THUNAR_SEARCH_IDLE_WAIT (5 * G_TIME_SPAN_MILLISECOND)
+
+
+
+typedef struct _ThunarSearchPool      ThunarSearchPool;
+typedef struct _ThunarSearchWorker    ThunarSearchWorker;
+typedef struct _ThunarSearchDirectory ThunarSearchDirectory;
+
+struct _ThunarSearchDirectory
+{
+  GFile  *file;
+  guint32 index_id; /* id of the directory in the index builder, if any */
+};
+
+struct _ThunarSearchWorker
+{
+  ThunarSearchPool *pool;
+  GThread          *thread;
+
+  /* directories waiting to be scanned; the owner pops from the
+   * head (depth-first), other workers steal from the tail */
+  GMutex  lock;
+  GQueue  directories;
+
+  /* matches not yet handed over to the model */
+  GList *batch;
+  guint  batch_len;
+};
+
+struct _ThunarSearchPool
+{
+  ThunarTreeViewModel           *model;
+  ThunarJob                     *job;
+  ThunarSearchMatcher           *matcher;
+  enum ThunarTreeViewModelSearch search_type;
+  gboolean                       show_hidden;
+
+  /* collects all names seen by the walk, if the search index is in use */
+  ThunarSearchIndexBuilder *builder;
+
+  /* number of directories queued or being scanned */
+  gint pending;
+  gint n_idle;
+
+  GMutex idle_lock;
+  GCond  idle_cond;
+
+  guint              n_workers;
+  ThunarSearchWorker workers[THUNAR_SEARCH_MAX_WORKERS];
+};
+
+
+
 static void
-_thunar_search_folder (ThunarTreeViewModel           *model,
-                       ThunarJob                     *job,
-                       gchar                         *uri,
-                       gchar                        **search_query_c_terms,
-                       enum ThunarTreeViewModelSearch search_type,
-                       gboolean                       show_hidden)
+_thunar_search_worker_flush (ThunarSearchWorker *worker)
 {
-  GCancellable    *cancellable;
-  GFileEnumerator *enumerator;
-  GFile           *directory;
-  GList           *files_found = NULL; /* contains the matching files in this folder only */
-  const gchar *namespace;
-  const gchar *display_name;
-  gchar       *display_name_c; /* converted to ignore case */
-
-  cancellable = thunar_job_get_cancellable (THUNAR_JOB (job));
-  directory = g_file_new_for_uri (uri);
+  if (worker->batch == NULL)
+    return;
+
+  if (thunar_job_is_cancelled (worker->pool->job))
+    thunar_g_list_free_full (worker->batch);
+  else
+    thunar_tree_view_model_add_search_files (worker->pool->model, worker->batch);
+
+  worker->batch = NULL;
+  worker->batch_len = 0;
+}
+
+
+
+static void
+_thunar_search_directory_free (gpointer data)
+{
+  ThunarSearchDirectory *directory = data;
+
+  g_object_unref (directory->file);
+  g_free (directory);
+}
+
+
+
+static void
+_thunar_search_worker_push (ThunarSearchWorker *worker,
+                            GFile              *file,
+                            guint32             index_id)
+{
+  ThunarSearchPool      *pool = worker->pool;
+  ThunarSearchDirectory *directory;
+
+  directory = g_new (ThunarSearchDirectory, 1);
+  directory->file = g_object_ref (file);
+  directory->index_id = index_id;
+
+  /* account for the directory before it becomes visible to others,
+   * so the pool can never look finished while work is queued */
+  g_atomic_int_inc (&pool->pending);
+
+  g_mutex_lock (&worker->lock);
+  g_queue_push_head (&worker->directories, directory);
+  g_mutex_unlock (&worker->lock);
+
+  /* wake up an idle worker which can steal the directory */
+  if (g_atomic_int_get (&pool->n_idle) > 0)
+    {
+      g_mutex_lock (&pool->idle_lock);
+      g_cond_signal (&pool->idle_cond);
+      g_mutex_unlock (&pool->idle_lock);
+    }
+}
+
+
+
+static ThunarSearchDirectory *
+_thunar_search_worker_pop (ThunarSearchWorker *worker)
+{
+  ThunarSearchPool      *pool = worker->pool;
+  ThunarSearchDirectory *directory;
+  guint                  n, i;
+
+  /* prefer our own, most recently discovered directory */
+  g_mutex_lock (&worker->lock);
+  directory = g_queue_pop_head (&worker->directories);
+  g_mutex_unlock (&worker->lock);
+
+  if (directory != NULL)
+    return directory;
+
+  /* steal the oldest (and usually largest) subtree from another worker */
+  n = worker - pool->workers;
+  for (i = 1; directory == NULL && i < pool->n_workers; i++)
+    {
+      ThunarSearchWorker *victim = &pool->workers[(n + i) % pool->n_workers];
+
+      g_mutex_lock (&victim->lock);
+      directory = g_queue_pop_tail (&victim->directories);
+      g_mutex_unlock (&victim->lock);
+    }
+
+  return directory;
+}
+
+
+
+static void
+_thunar_search_folder (ThunarSearchWorker    *worker,
+                       ThunarSearchDirectory *search_directory)
+{
+  ThunarSearchPool *pool = worker->pool;
+  GCancellable     *cancellable;
+  GFileEnumerator  *enumerator;
+  GFile            *directory = search_directory->file;
+  gboolean          is_recent;
+  gboolean          is_hidden;
+  guint32           index_id = 0;
+  const gchar      *namespace;
+  const gchar      *display_name;
+  gchar            *display_name_c; /* converted to ignore case, for the index */
+
+  cancellable = thunar_job_get_cancellable (pool->job);
   namespace = G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_TARGET_URI "," G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," G_FILE_ATTRIBUTE_STANDARD_NAME ", recent::*";
 
   /* The directory enumerator MUST NOT follow symlinks itself, meaning that any symlinks that
@@ -1598,13 +1767,12 @@ _thunar_search_folder (ThunarTreeViewModel           *model,
    * which allows them to appear in the search results. */
   enumerator = g_file_enumerate_children (directory, namespace, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, cancellable, NULL);
   if (enumerator == NULL)
-    {
-      g_object_unref (directory);
-      return;
-    }
+    return;
+
+  is_recent = g_file_has_uri_scheme (directory, "recent");
 
   /* go through every file in the folder and check if it matches */
-  while (thunar_job_is_cancelled (THUNAR_JOB (job)) == FALSE)
+  while (thunar_job_is_cancelled (pool->job) == FALSE)
     {
       GFile     *file;
       GFileInfo *info;
@@ -1615,7 +1783,7 @@ _thunar_search_folder (ThunarTreeViewModel           *model,
       if (G_UNLIKELY (info == NULL))
         break;
 
-      if (g_file_has_uri_scheme (directory, "recent"))
+      if (is_recent)
         {
           file = g_file_new_for_uri (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI));
           g_object_unref (info);
@@ -1629,53 +1797,192 @@ _thunar_search_folder (ThunarTreeViewModel           *model,
       else
         file = g_file_get_child (directory, g_file_info_get_name (info));
 
+      /* same logic as thunar_file_is_hidden() */
+      is_hidden = g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN)
+                  || g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP);
+
       /* respect last-show-hidden */
-      if (show_hidden == FALSE)
+      if (pool->show_hidden == FALSE && is_hidden)
         {
-          /* same logic as thunar_file_is_hidden() */
-          if (g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN)
-              || g_file_info_get_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP))
-            {
-              g_object_unref (file);
-              g_object_unref (info);
-              continue;
-            }
+          g_object_unref (file);
+          g_object_unref (info);
+          continue;
         }
 
       type = g_file_info_get_file_type (info);
 
-      /* handle directories */
-      if (type == G_FILE_TYPE_DIRECTORY && search_type == THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE)
+      display_name = g_file_info_get_display_name (info);
+
+      /* remember the entry for later searches */
+      if (pool->builder != NULL)
         {
-          gchar *file_uri = g_file_get_uri (file);
-          _thunar_search_folder (model, job, file_uri, search_query_c_terms, search_type, show_hidden);
-          g_free (file_uri);
+          display_name_c = thunar_g_utf8_normalize_for_search (display_name, TRUE, TRUE);
+          index_id = thunar_search_index_builder_add (pool->builder, search_directory->index_id,
+                                                      g_file_info_get_name (info), display_name_c,
+                                                      type == G_FILE_TYPE_DIRECTORY, is_hidden);
+          g_free (display_name_c);
         }
 
-      /* prepare entry display name */
-      display_name = g_file_info_get_display_name (info);
-      display_name_c = thunar_g_utf8_normalize_for_search (display_name, TRUE, TRUE);
+      /* queue directories, they are scanned by whichever worker gets to them first */
+      if (type == G_FILE_TYPE_DIRECTORY && pool->search_type == THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE)
+        _thunar_search_worker_push (worker, file, index_id);
 
       /* search for all substrings */
-      if (thunar_util_search_terms_match (search_query_c_terms, display_name_c))
-        files_found = g_list_prepend (files_found, thunar_file_get (file, NULL));
+      if (thunar_util_search_matcher_match (pool->matcher, display_name))
+        {
+          worker->batch = g_list_prepend (worker->batch, thunar_file_get (file, NULL));
+          if (++worker->batch_len >= THUNAR_SEARCH_BATCH_SIZE)
+            _thunar_search_worker_flush (worker);
+        }
 
       /* free memory */
-      g_free (display_name_c);
       g_object_unref (file);
       g_object_unref (info);
     }
 
   g_object_unref (enumerator);
-  g_object_unref (directory);
+}
 
-  if (thunar_job_is_cancelled (THUNAR_JOB (job)))
+
+
+static gpointer
+_thunar_search_worker_run (gpointer user_data)
+{
+  ThunarSearchWorker    *worker = user_data;
+  ThunarSearchPool      *pool = worker->pool;
+  ThunarSearchDirectory *directory;
+  gint64                 end_time;
+
+  while (thunar_job_is_cancelled (pool->job) == FALSE)
+    {
+      directory = _thunar_search_worker_pop (worker);
+      if (directory != NULL)
+        {
+          _thunar_search_folder (worker, directory);
+          _thunar_search_directory_free (directory);
+
+          /* the last directory is done, release the idle workers */
+          if (g_atomic_int_dec_and_test (&pool->pending))
+            {
+              g_mutex_lock (&pool->idle_lock);
+              g_cond_broadcast (&pool->idle_cond);
+              g_mutex_unlock (&pool->idle_lock);
+            }
+
+          continue;
+        }
+
+      /* nothing to do right now, hand over what we found so far */
+      _thunar_search_worker_flush (worker);
+
+      g_mutex_lock (&pool->idle_lock);
+      if (g_atomic_int_get (&pool->pending) == 0)
+        {
+          g_mutex_unlock (&pool->idle_lock);
+          break;
+        }
+
+      /* wait with a timeout, so cancellation is noticed even without a wakeup */
+      g_atomic_int_inc (&pool->n_idle);
+      end_time = g_get_monotonic_time () + THUNAR_SEARCH_IDLE_WAIT;
+      g_cond_wait_until (&pool->idle_cond, &pool->idle_lock, end_time);
+      g_atomic_int_add (&pool->n_idle, -1);
+      g_mutex_unlock (&pool->idle_lock);
+    }
+
+  _thunar_search_worker_flush (worker);
+
+  return NULL;
+}
+
+
+
+static void
+_thunar_search_pool_run (ThunarSearchPool *pool,
+                         GList            *directories)
+{
+  ThunarSearchWorker *worker;
+  const gchar        *n_workers;
+  GList              *lp;
+  guint               n;
+
+  /* a flat search only scans one folder, there is nothing to distribute;
+   * THUNAR_SEARCH_WORKERS overrides the number of threads for benchmarks */
+  if (pool->search_type == THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE)
+    {
+      n_workers = g_getenv ("THUNAR_SEARCH_WORKERS");
+      n = (n_workers != NULL) ? g_ascii_strtoull (n_workers, NULL, 10) : g_get_num_processors ();
+      pool->n_workers = CLAMP (n, 1, THUNAR_SEARCH_MAX_WORKERS);
+    }
+  else
+    pool->n_workers = 1;
+
+  g_mutex_init (&pool->idle_lock);
+  g_cond_init (&pool->idle_cond);
+
+  for (n = 0; n < pool->n_workers; n++)
     {
-      thunar_g_list_free_full (files_found);
-      return;
+      worker = &pool->workers[n];
+      worker->pool = pool;
+      g_mutex_init (&worker->lock);
+      g_queue_init (&worker->directories);
     }
 
-  thunar_tree_view_model_add_search_files (model, files_found);
+  for (lp = directories; lp != NULL; lp = lp->next)
+    _thunar_search_worker_push (&pool->workers[0], lp->data, THUNAR_SEARCH_INDEX_BUILDER_ROOT);
+
+  /* the job thread itself acts as the first worker */
+  for (n = 1; n < pool->n_workers; n++)
+    pool->workers[n].thread = g_thread_new ("thunar-search", _thunar_search_worker_run, &pool->workers[n]);
+
+  _thunar_search_worker_run (&pool->workers[0]);
+
+  for (n = 0; n < pool->n_workers; n++)
+    {
+      worker = &pool->workers[n];
+      if (worker->thread != NULL)
+        g_thread_join (worker->thread);
+
+      /* only left over when the search was cancelled */
+      g_queue_clear_full (&worker->directories, _thunar_search_directory_free);
+      g_mutex_clear (&worker->lock);
+    }
+
+  g_cond_clear (&pool->idle_cond);
+  g_mutex_clear (&pool->idle_lock);
+}
+
+
+
+static void
+_thunar_search_add_indexed_files (ThunarSearchPool *pool,
+                                  GList            *files)
+{
+  GList      *files_found = NULL;
+  GList      *lp;
+  ThunarFile *file;
+  guint       n = 0;
+
+  for (lp = files; lp != NULL && !thunar_job_is_cancelled (pool->job); lp = lp->next)
+    {
+      /* files which vanished without us noticing are skipped */
+      file = thunar_file_get (lp->data, NULL);
+      if (file == NULL)
+        continue;
+
+      files_found = g_list_prepend (files_found, file);
+      if (++n >= THUNAR_SEARCH_BATCH_SIZE)
+        {
+          thunar_tree_view_model_add_search_files (pool->model, files_found);
+          files_found = NULL;
+          n = 0;
+        }
+    }
+
+  if (thunar_job_is_cancelled (pool->job))
+    thunar_g_list_free_full (files_found);
+  else if (files_found != NULL)
+    thunar_tree_view_model_add_search_files (pool->model, files_found);
 }
 
 
@@ -1685,41 +1992,73 @@ _thunar_job_search_directory (ThunarJob *job,
                               GArray    *param_values,
                               GError   **error)
 {
-  ThunarTreeViewModel           *model;
-  ThunarFile                    *directory;
-  const char                    *search_query_c;
-  gchar                        **search_query_c_terms;
-  gboolean                       is_source_device_local;
-  ThunarRecursiveSearchMode      mode;
-  gboolean                       show_hidden;
-  enum ThunarTreeViewModelSearch search_type;
-  gchar                         *directory_uri;
-
-  search_type = THUNAR_TREE_VIEW_MODEL_SEARCH_NON_RECURSIVE;
+  ThunarSearchPool          pool = { 0, };
+  ThunarFile               *directory;
+  const char               *search_query_c;
+  gboolean                  is_source_device_local;
+  gboolean                  use_index;
+  ThunarRecursiveSearchMode mode;
+  gchar                   **search_query_c_terms;
+  GList                    *indexed_files = NULL;
+  GList                    *directories = NULL;
 
   if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
     return FALSE;
 
-  model = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  pool.job = job;
+  pool.model = g_value_get_object (&g_array_index (param_values, GValue, 0));
   search_query_c = g_value_get_string (&g_array_index (param_values, GValue, 1));
   directory = g_value_get_object (&g_array_index (param_values, GValue, 2));
   mode = g_value_get_enum (&g_array_index (param_values, GValue, 3));
-  show_hidden = g_value_get_boolean (&g_array_index (param_values, GValue, 4));
+  pool.show_hidden = g_value_get_boolean (&g_array_index (param_values, GValue, 4));
+  use_index = g_value_get_boolean (&g_array_index (param_values, GValue, 5));
 
   search_query_c_terms = thunar_util_split_search_query (search_query_c, error);
   if (search_query_c_terms == NULL)
     return FALSE;
 
+  pool.matcher = thunar_util_search_matcher_new (search_query_c_terms);
+  g_strfreev (search_query_c_terms);
+
+  pool.search_type = THUNAR_TREE_VIEW_MODEL_SEARCH_NON_RECURSIVE;
   is_source_device_local = thunar_g_file_is_on_local_device (thunar_file_get_file (directory));
   if (mode == THUNAR_RECURSIVE_SEARCH_ALWAYS || (mode == THUNAR_RECURSIVE_SEARCH_LOCAL && is_source_device_local))
-    search_type = THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE;
+    pool.search_type = THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE;
+
+  /* the index only covers recursive searches on local disks */
+  if (use_index && is_source_device_local && pool.search_type == THUNAR_TREE_VIEW_MODEL_SEARCH_RECURSIVE)
+    {
+      if (thunar_search_index_lookup (thunar_file_get_file (directory), pool.matcher, pool.show_hidden,
+                                      &indexed_files, &directories))
+        {
+          /* only walk what is missing from the index */
+          _thunar_search_add_indexed_files (&pool, indexed_files);
+          thunar_g_list_free_full (indexed_files);
+        }
+      else
+        {
+          /* walk everything and index it on the way */
+          pool.builder = thunar_search_index_builder_new (thunar_file_get_file (directory), pool.show_hidden);
+          directories = g_list_prepend (NULL, g_object_ref (thunar_file_get_file (directory)));
+        }
+    }
+  else
+    {
+      directories = g_list_prepend (NULL, g_object_ref (thunar_file_get_file (directory)));
+    }
 
-  directory_uri = thunar_file_dup_uri (directory);
+  _thunar_search_pool_run (&pool, directories);
 
-  _thunar_search_folder (model, job, directory_uri, search_query_c_terms, search_type, show_hidden);
+  if (pool.builder != NULL)
+    {
+      /* an interrupted walk would leave holes in the index */
+      if (!thunar_job_is_cancelled (job))
+        thunar_search_index_builder_commit (pool.builder);
+      thunar_search_index_builder_free (pool.builder);
+    }
 
-  g_free (directory_uri);
-  g_strfreev (search_query_c_terms);
+  thunar_g_list_free_full (directories);
+  thunar_util_search_matcher_free (pool.matcher);
 
   return TRUE;
 }
@@ -1734,20 +2073,23 @@ thunar_io_jobs_search_directory (ThunarTreeViewModel *model,
   ThunarPreferences        *preferences;
   ThunarRecursiveSearchMode mode;
   gboolean                  show_hidden;
+  gboolean                  use_index;
 
   preferences = thunar_preferences_get ();
 
   /* grab a reference of preferences determine the current recursive search mode */
   g_object_get (G_OBJECT (preferences), "misc-recursive-search", &mode, NULL);
   g_object_get (G_OBJECT (preferences), "last-show-hidden", &show_hidden, NULL);
+  g_object_get (G_OBJECT (preferences), "misc-search-index", &use_index, NULL);
 
   g_object_unref (preferences);
-  return thunar_simple_job_new (_thunar_job_search_directory, 5,
+  return thunar_simple_job_new (_thunar_job_search_directory, 6,
                                 THUNAR_TYPE_TREE_VIEW_MODEL, model,
                                 G_TYPE_STRING, search_query,
                                 THUNAR_TYPE_FILE, directory,
                                 G_TYPE_ENUM, mode,
-                                G_TYPE_BOOLEAN, show_hidden);
+                                G_TYPE_BOOLEAN, show_hidden,
+                                G_TYPE_BOOLEAN, use_index);
 }
 
 
@@ -2000,6 +2342,138 @@ thunar_io_jobs_load_content_types (GHashTable *files)
 
 
 
+static gboolean
+_thunar_job_query_file_infos (ThunarJob *job,
+                              GArray    *param_values,
+                              GError   **error)
+{
+  GCancellable  *cancellable;
+  GHashTable    *g_files;
+  GFileInfo     *info;
+  gpointer       g_file;
+  GHashTableIter iter;
+
+  if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
+    return FALSE;
+
+  g_files = g_value_get_boxed (&g_array_index (param_values, GValue, 0));
+  cancellable = thunar_job_get_cancellable (job);
+
+  g_hash_table_iter_init (&iter, g_files);
+  while (g_hash_table_iter_next (&iter, &g_file, NULL) && !thunar_job_is_cancelled (job))
+    {
+      /* files we fail to query are left out, the caller handles them */
+      info = g_file_query_info (G_FILE (g_file), THUNARX_FILE_INFO_NAMESPACE,
+                                G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+      if (info != NULL)
+        g_object_set_data_full (G_OBJECT (g_file), "file-info", info, g_object_unref);
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * thunar_io_jobs_query_file_infos:
+ * @g_files: a #GHashTable of #GFile<!---->s
+ *
+ * Queries the file information of the passed #GFile<!---->s in a separate thread.
+ * Once finished, the #GFileInfo of each #GFile is attached to it as "file-info"
+ * data, unless it could not be queried.
+ *
+ * Returns: (transfer full): the #ThunarJob which manages the separate thread
+ **/
+ThunarJob *
+thunar_io_jobs_query_file_infos (GHashTable *g_files)
+{
+  return thunar_simple_job_new (_thunar_job_query_file_infos, 1,
+                                THUNAR_TYPE_G_FILE_HASH_TABLE, g_files);
+}
+
+
+
+#ifdef HAVE_LIBARCHIVE
+static gboolean
+_thunar_job_extract_archive_member (ThunarJob *job,
+                                    GArray    *param_values,
+                                    GError   **error)
+{
+  ThunarArchiveIndex *index;
+  GCancellable       *cancellable;
+  const gchar        *member;
+  GFile              *archive_file;
+  GFile              *target_file;
+  GFile              *target_parent;
+  GError             *err = NULL;
+  gboolean            success;
+
+  if (thunar_job_set_error_if_cancelled (THUNAR_JOB (job), error))
+    return FALSE;
+
+  archive_file = g_value_get_object (&g_array_index (param_values, GValue, 0));
+  member = g_value_get_string (&g_array_index (param_values, GValue, 1));
+  target_file = g_value_get_object (&g_array_index (param_values, GValue, 2));
+  cancellable = thunar_job_get_cancellable (job);
+
+  /* usually cached from browsing the archive */
+  index = thunar_archive_index_get (archive_file, cancellable, error);
+  if (index == NULL)
+    return FALSE;
+
+  /* members are extracted below a cache directory which may not exist yet */
+  target_parent = g_file_get_parent (target_file);
+  if (target_parent != NULL
+      && !g_file_make_directory_with_parents (target_parent, cancellable, &err)
+      && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_EXISTS))
+    {
+      g_propagate_error (error, err);
+      g_object_unref (target_parent);
+      thunar_archive_index_unref (index);
+      return FALSE;
+    }
+  g_clear_error (&err);
+  if (target_parent != NULL)
+    g_object_unref (target_parent);
+
+  success = thunar_archive_index_extract (index, member, target_file, cancellable, error);
+  thunar_archive_index_unref (index);
+
+  return success;
+}
+
+
+
+/**
+ * thunar_io_jobs_extract_archive_member:
+ * @archive_file : a local archive.
+ * @member       : the path of a file in @archive_file.
+ * @target_file  : where to write the contents of @member to.
+ *
+ * Extracts the single file @member of @archive_file to @target_file in a
+ * separate thread, without unpacking the rest of the archive. The parent
+ * directories of @target_file are created as needed.
+ *
+ * Returns: (transfer full): the #ThunarJob which manages the separate thread
+ **/
+ThunarJob *
+thunar_io_jobs_extract_archive_member (GFile       *archive_file,
+                                       const gchar *member,
+                                       GFile       *target_file)
+{
+  _thunar_return_val_if_fail (G_IS_FILE (archive_file), NULL);
+  _thunar_return_val_if_fail (member != NULL, NULL);
+  _thunar_return_val_if_fail (G_IS_FILE (target_file), NULL);
+
+  return thunar_simple_job_new (_thunar_job_extract_archive_member, 3,
+                                G_TYPE_FILE, archive_file,
+                                G_TYPE_STRING, member,
+                                G_TYPE_FILE, target_file);
+}
+#endif
+
+
+
 static gboolean
 _thunar_job_load_statusbar_text (ThunarJob *job,
                                  GArray    *param_values,
@@ -61,7 +61,8 @@ thunar_io_jobs_change_mode (GList         *files,
                             ThunarFileMode file_mode,
                             gboolean       recursive) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *
-thunar_io_jobs_list_directory (GFile *directory) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+thunar_io_jobs_list_directory (GFile *directory,
+                               guint  first_chunk_files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *
 thunar_io_jobs_rename_file (ThunarFile            *file,
                             const gchar           *display_name,
@@ -82,6 +83,14 @@ thunar_io_jobs_set_metadata_for_files (GList      *files,
 ThunarJob *
 thunar_io_jobs_load_content_types (GHashTable *files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
 ThunarJob *
+thunar_io_jobs_query_file_infos (GHashTable *g_files) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+#ifdef HAVE_LIBARCHIVE
+ThunarJob *
+thunar_io_jobs_extract_archive_member (GFile       *archive_file,
+                                       const gchar *member,
+                                       GFile       *target_file) G_GNUC_MALLOC G_GNUC_WARN_UNUSED_RESULT;
+#endif
+ThunarJob *
 thunar_io_jobs_load_statusbar_text_for_folder (ThunarStandardView *standard_view,
                                                ThunarFolder       *folder);
 ThunarJob *
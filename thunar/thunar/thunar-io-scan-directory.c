@@ -27,6 +27,15 @@
 #include <gio/gio.h>
 
 
+
+/* time after which the first chunk of files is handed over, even if not full (in microseconds) */
+#define THUNAR_IO_SCAN_FIRST_CHUNK_BUDGET (50 * 1000)
+
+/* size and maximum age of the following chunks of files (in microseconds) */
+#define THUNAR_IO_SCAN_CHUNK_FILES    (4096)
+#define THUNAR_IO_SCAN_CHUNK_INTERVAL (250 * 1000)
+
+
 /**
  * thunar_io_scan_directory:
  * @job                 : a #ThunarJob instance
@@ -36,10 +45,17 @@
  * @unlinking           : TRUE if within an unlinking job's call stack, FALSE otherwise
  * @return_thunar_files : TRUE in order to return the result as a list of #ThunarFile's, FALSE to return a list of #GFile's
  * @n_files_max         : Maximum number of files to scan, NULL for unlimited
+ * @first_chunk_files   : Size of the first chunk of files to hand over while scanning, 0 to not use chunks
  * @error               : Will be se on any error
  *
  * Scans the passed folder for files and returns them as a #GList
  *
+ * If @first_chunk_files is not 0, the folder is scanned non-recursively and the
+ * files are handed over to @job in chunks by emitting its "files-ready" signal.
+ * The first chunk is emitted as soon as it holds @first_chunk_files files or
+ * THUNAR_IO_SCAN_FIRST_CHUNK_BUDGET passed, so the caller can show some files
+ * right away. Only the files of the last chunk are returned then.
+ *
  * Return value: (transfer full): the #GLIst of #GFiles or #ThunarFiles, to be released with e.g. 'g_list_free_full'
  **/
 GList *
@@ -50,6 +66,7 @@ thunar_io_scan_directory (ThunarJob          *job,
                           gboolean            unlinking,
                           gboolean            return_thunar_files,
                           guint              *n_files_max,
+                          guint               first_chunk_files,
                           GError            **error)
 {
   GFileEnumerator *enumerator;
@@ -64,8 +81,12 @@ thunar_io_scan_directory (ThunarJob          *job,
   ThunarFile   *thunar_file;
   gboolean      is_mounted;
   GCancellable *cancellable = NULL;
+  guint         n_chunk_files = 0;
+  guint         chunk_files_max = first_chunk_files;
+  gint64        chunk_deadline = 0;
 
   _thunar_return_val_if_fail (G_IS_FILE (file), NULL);
+  _thunar_return_val_if_fail (first_chunk_files == 0 || (job != NULL && return_thunar_files && !recursively), NULL);
   _thunar_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
   /* abort if the job was cancelled */
@@ -154,6 +175,9 @@ thunar_io_scan_directory (ThunarJob          *job,
       return NULL;
     }
 
+  if (first_chunk_files > 0)
+    chunk_deadline = g_get_monotonic_time () + THUNAR_IO_SCAN_FIRST_CHUNK_BUDGET;
+
   /* iterate over children one by one */
   while (job == NULL || !thunar_job_is_cancelled (THUNAR_JOB (job)))
     {
@@ -244,7 +268,7 @@ thunar_io_scan_directory (ThunarJob          *job,
           && g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
         {
           child_files = thunar_io_scan_directory (job, child_file, flags, recursively,
-                                                  unlinking, return_thunar_files, n_files_max, &err);
+                                                  unlinking, return_thunar_files, n_files_max, 0, &err);
 
           /* prepend children to the file list to make sure they're
            * processed first (required for unlinking) */
@@ -253,6 +277,20 @@ thunar_io_scan_directory (ThunarJob          *job,
 
       g_object_unref (child_file);
       g_object_unref (info);
+
+      /* hand over the files scanned so far, if the chunk is full or too old */
+      if (first_chunk_files > 0
+          && (++n_chunk_files >= chunk_files_max || g_get_monotonic_time () >= chunk_deadline))
+        {
+          /* the handler of the signal takes over ownership of the file list */
+          if (!thunar_job_files_ready (job, files))
+            thunar_g_list_free_full (files);
+
+          files = NULL;
+          n_chunk_files = 0;
+          chunk_files_max = MAX (first_chunk_files, THUNAR_IO_SCAN_CHUNK_FILES);
+          chunk_deadline = g_get_monotonic_time () + THUNAR_IO_SCAN_CHUNK_INTERVAL;
+        }
     }
 
   /* release the enumerator */
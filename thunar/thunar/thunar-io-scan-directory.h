@@ -34,6 +34,7 @@ thunar_io_scan_directory (ThunarJob          *job,
                           gboolean            unlinking,
                           gboolean            return_thunar_files,
                           guint              *n_files_max,
+                          guint               first_chunk_files,
                           GError            **error);
 
 G_END_DECLS
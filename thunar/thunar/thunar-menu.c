@@ -351,6 +351,7 @@ thunar_menu_add_sections (ThunarMenu        *menu,
       item_added = FALSE;
       item_added |= (thunar_action_manager_append_menu_item (menu->action_mgr, GTK_MENU_SHELL (menu), THUNAR_ACTION_MANAGER_ACTION_COMPRESS, FALSE) != NULL);
       item_added |= (thunar_action_manager_append_menu_item (menu->action_mgr, GTK_MENU_SHELL (menu), THUNAR_ACTION_MANAGER_ACTION_EXTRACT_HERE, FALSE) != NULL);
+      item_added |= (thunar_action_manager_append_menu_item (menu->action_mgr, GTK_MENU_SHELL (menu), THUNAR_ACTION_MANAGER_ACTION_BROWSE_ARCHIVE, FALSE) != NULL);
       if (item_added)
         xfce_gtk_menu_append_separator (GTK_MENU_SHELL (menu));
     }
@@ -150,6 +150,8 @@ enum
   PROP_MISC_USE_CSD,
   PROP_SMART_SORT,
   PROP_MISC_FILE_DRAG_MODE,
+  PROP_MISC_SEARCH_INDEX,
+  PROP_MISC_FIRST_PAINT_FILES,
 #ifdef HAVE_VTE
   PROP_TERMINAL_HEIGHT,
   PROP_TERMINAL_VISIBLE,
@@ -1543,6 +1545,33 @@ thunar_preferences_class_init (ThunarPreferencesClass *klass)
                      THUNAR_FILE_DRAG_MODE_MENU_ALWAYS,
                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * ThunarPreferences:misc-search-index:
+   *
+   * Whether recursive searches on local disks should keep an index of
+   * the file names in the cache directory and answer later searches from it.
+   **/
+  preferences_props[PROP_MISC_SEARCH_INDEX] =
+  g_param_spec_boolean ("misc-search-index",
+                        "MiscSearchIndex",
+                        NULL,
+                        FALSE,
+                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * ThunarPreferences:misc-first-paint-files:
+   *
+   * Number of files which are shown right away when a folder is loaded,
+   * before the remaining files are merged in while the folder is read.
+   * Zero shows the folder contents only once reading is done.
+   **/
+  preferences_props[PROP_MISC_FIRST_PAINT_FILES] =
+  g_param_spec_uint ("misc-first-paint-files",
+                     "MiscFirstPaintFiles",
+                     NULL,
+                     0, G_MAXUINT, 200,
+                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
 #ifdef HAVE_VTE
   /**              
    * ThunarPreferences:terminal-height:
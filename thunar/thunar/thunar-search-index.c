@@ -0,0 +1,1694 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * The search index keeps the names of all files below directories which were
+ * searched recursively before, so that later searches in those directories do
+ * not have to walk the file system again.
+ *
+ * There is one index file per mount point in the user's cache directory. It is
+ * memory-mapped and consists of the following, tightly packed sections:
+ *
+ *   IndexHeader
+ *   IndexRoot    roots[n_roots]         directories which were walked completely
+ *   IndexEntry   entries[n_entries]     in breadth-first order, children sorted by name
+ *   IndexTrigram trigrams[n_trigrams]   sorted by trigram
+ *   guint32      postings[n_postings]   entry ids, grouped by trigram
+ *   gchar        strings[strings_size]  zero-terminated names and search keys
+ *
+ * Changes reported by the folder monitors after the index was written are kept
+ * in memory on top of the mapped file. Directories which appeared since then are
+ * reported as unindexed, so the caller can walk them instead. The monitor events
+ * are handed to a worker thread, so the main thread never waits for the lock.
+ */
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include "thunar/thunar-gobject-extensions.h"
+#include "thunar/thunar-preferences.h"
+#include "thunar/thunar-private.h"
+#include "thunar/thunar-search-index.h"
+#include "thunar/thunar-util.h"
+
+#include <glib/gstdio.h>
+
+
+
+#define THUNAR_SEARCH_INDEX_MAGIC "ThunarSI"
+#define THUNAR_SEARCH_INDEX_VERSION (1)
+
+/* indexed directories are walked again after this time, since changes
+ * outside of monitored folders are not noticed otherwise */
+#define THUNAR_SEARCH_INDEX_MAX_AGE (24 * G_TIME_SPAN_HOUR)
+
+#define INDEX_NONE (G_MAXUINT32)
+
+#define INDEX_TRIGRAM(s) (((guint32) (guchar) (s)[0] << 16) | ((guint32) (guchar) (s)[1] << 8) | (guint32) (guchar) (s)[2])
+
+#define INDEX_ENTRY_NAME(mount, id) ((mount)->strings + (mount)->entries[(id)].name)
+#define INDEX_ENTRY_KEY(mount, id) ((mount)->strings + (mount)->entries[(id)].key)
+#define INDEX_ENTRY_REMOVED(mount, id) g_hash_table_contains ((mount)->removed, GUINT_TO_POINTER ((id) + 1))
+
+
+
+enum
+{
+  INDEX_ENTRY_DIRECTORY = 1 << 0,
+  INDEX_ENTRY_HIDDEN = 1 << 1,
+};
+
+enum
+{
+  INDEX_ROOT_WITH_HIDDEN = 1 << 0,
+};
+
+
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 glib_version;
+  guint32 mount;
+  guint32 n_roots;
+  guint32 n_entries;
+  guint32 n_trigrams;
+  guint32 n_postings;
+  guint32 strings_size;
+} IndexHeader;
+
+typedef struct
+{
+  gint64  timestamp;
+  guint32 entry;
+  guint32 flags;
+} IndexRoot;
+
+typedef struct
+{
+  guint32 parent;
+  guint32 flags;
+  guint32 name;
+  guint32 key;
+  guint32 first_child;
+  guint32 n_children;
+} IndexEntry;
+
+typedef struct
+{
+  guint32 trigram;
+  guint32 offset;
+  guint32 count;
+} IndexTrigram;
+
+G_STATIC_ASSERT (sizeof (IndexHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (IndexRoot) == 16);
+
+typedef struct
+{
+  gchar   *key;
+  guint32  flags;
+} IndexAdded;
+
+typedef struct
+{
+  gchar *path;     /* mount point this index belongs to */
+  gchar *filename; /* location of the index file */
+
+  GMappedFile        *mapped;
+  const IndexHeader  *header;
+  const IndexRoot    *roots;
+  const IndexEntry   *entries;
+  const IndexTrigram *trigrams;
+  const guint32      *postings;
+  const gchar        *strings;
+
+  /* changes reported by folder monitors since the index was written */
+  GHashTable *added;     /* absolute path -> IndexAdded */
+  GHashTable *removed;   /* set of entry id + 1 */
+  GPtrArray  *unindexed; /* directories whose content is not known */
+
+  /* paths removed while a new index is written, NULL otherwise */
+  GPtrArray *removed_meanwhile;
+} IndexMount;
+
+typedef struct
+{
+  gchar   *path;
+  gchar   *key;     /* NULL if the file was removed */
+  guint32  flags;
+} IndexEvent;
+
+typedef struct
+{
+  guint32      parent;
+  guint32      flags;
+  const gchar *name;
+  const gchar *key;
+} IndexNode;
+
+typedef struct
+{
+  guint32 parent;
+  guint32 flags;
+  gchar  *name;
+  gchar  *key;
+} BuilderEntry;
+
+struct _ThunarSearchIndexBuilder
+{
+  GMutex  lock;
+  gchar  *root;
+  guint32 flags;
+  GArray *entries;
+};
+
+
+
+/* protects the contents of the mounts */
+static GMutex      index_lock;
+static GHashTable *index_mounts = NULL;
+
+/* only one index is written at a time */
+static GMutex index_commit_lock;
+
+/* monitor events, processed in order by a single thread */
+static GThreadPool *index_events = NULL;
+
+/* cached "misc-search-index" setting, only used from the main thread */
+static ThunarPreferences *index_preferences = NULL;
+static gboolean           index_enabled;
+
+
+
+static guint32
+index_glib_version (void)
+{
+  /* the normalized search keys depend on GLib's unicode tables */
+  return glib_major_version * 10000 + glib_minor_version * 100 + glib_micro_version;
+}
+
+
+
+static gchar *
+index_cache_directory (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "Thunar", "search-index", NULL);
+}
+
+
+
+static gboolean
+index_path_is_below (const gchar *path,
+                     const gchar *directory)
+{
+  gsize len = strlen (directory);
+
+  if (strncmp (path, directory, len) != 0)
+    return FALSE;
+
+  /* equal, inside the directory, or the directory is the file system root */
+  return path[len] == '\0' || path[len] == '/' || (len > 0 && directory[len - 1] == '/');
+}
+
+
+
+static gchar *
+index_mount_point (const gchar *path)
+{
+  GStatBuf sb;
+  dev_t    dev;
+  gchar   *mount_point;
+  gchar   *parent;
+
+  if (g_stat (path, &sb) != 0)
+    return NULL;
+
+  dev = sb.st_dev;
+  mount_point = g_strdup (path);
+
+  /* go up until the parent lives on a different device */
+  for (;;)
+    {
+      parent = g_path_get_dirname (mount_point);
+      if (strcmp (parent, mount_point) == 0 || g_stat (parent, &sb) != 0 || sb.st_dev != dev)
+        {
+          g_free (parent);
+          break;
+        }
+
+      g_free (mount_point);
+      mount_point = parent;
+    }
+
+  return mount_point;
+}
+
+
+
+static void
+index_added_free (gpointer data)
+{
+  IndexAdded *added = data;
+
+  g_free (added->key);
+  g_free (added);
+}
+
+
+
+static IndexMount *
+index_mount_new (const gchar *filename)
+{
+  IndexMount *mount;
+
+  mount = g_new0 (IndexMount, 1);
+  mount->filename = g_strdup (filename);
+  mount->added = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, index_added_free);
+  mount->removed = g_hash_table_new (g_direct_hash, g_direct_equal);
+  mount->unindexed = g_ptr_array_new_with_free_func (g_free);
+
+  return mount;
+}
+
+
+
+static void
+index_mount_unmap (IndexMount *mount)
+{
+  if (mount->mapped != NULL)
+    g_mapped_file_unref (mount->mapped);
+
+  mount->mapped = NULL;
+  mount->header = NULL;
+  mount->roots = NULL;
+  mount->entries = NULL;
+  mount->trigrams = NULL;
+  mount->postings = NULL;
+  mount->strings = NULL;
+}
+
+
+
+static void
+index_mount_free (IndexMount *mount)
+{
+  index_mount_unmap (mount);
+  g_hash_table_destroy (mount->added);
+  g_hash_table_destroy (mount->removed);
+  g_ptr_array_unref (mount->unindexed);
+  if (mount->removed_meanwhile != NULL)
+    g_ptr_array_unref (mount->removed_meanwhile);
+  g_free (mount->filename);
+  g_free (mount->path);
+  g_free (mount);
+}
+
+
+
+static gboolean
+index_mount_map (IndexMount *mount)
+{
+  const IndexHeader *header;
+  GMappedFile       *mapped;
+  const gchar       *data;
+  guint64            length;
+  guint64            size;
+  guint32            n;
+
+  mapped = g_mapped_file_new (mount->filename, FALSE, NULL);
+  if (mapped == NULL)
+    return FALSE;
+
+  data = g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  header = (const IndexHeader *) data;
+
+  if (length < sizeof (IndexHeader)
+      || memcmp (header->magic, THUNAR_SEARCH_INDEX_MAGIC, sizeof (header->magic)) != 0
+      || header->version != THUNAR_SEARCH_INDEX_VERSION
+      || header->glib_version != index_glib_version ())
+    goto invalid;
+
+  size = sizeof (IndexHeader)
+         + (guint64) header->n_roots * sizeof (IndexRoot)
+         + (guint64) header->n_entries * sizeof (IndexEntry)
+         + (guint64) header->n_trigrams * sizeof (IndexTrigram)
+         + (guint64) header->n_postings * sizeof (guint32)
+         + header->strings_size;
+  if (size != length || header->strings_size == 0 || data[length - 1] != '\0')
+    goto invalid;
+
+  mount->roots = (const IndexRoot *) (data + sizeof (IndexHeader));
+  mount->entries = (const IndexEntry *) (mount->roots + header->n_roots);
+  mount->trigrams = (const IndexTrigram *) (mount->entries + header->n_entries);
+  mount->postings = (const guint32 *) (mount->trigrams + header->n_trigrams);
+  mount->strings = (const gchar *) (mount->postings + header->n_postings);
+
+  /* never trust the cache, a broken file must not crash the search */
+  if (header->mount >= header->strings_size)
+    goto invalid;
+  for (n = 0; n < header->n_roots; n++)
+    if (mount->roots[n].entry >= header->n_entries)
+      goto invalid;
+  for (n = 0; n < header->n_entries; n++)
+    {
+      const IndexEntry *entry = &mount->entries[n];
+
+      if ((entry->parent != INDEX_NONE && entry->parent >= n)
+          || entry->name >= header->strings_size
+          || entry->key >= header->strings_size
+          || (guint64) entry->first_child + entry->n_children > header->n_entries
+          || (entry->n_children > 0 && entry->first_child <= n))
+        goto invalid;
+    }
+  for (n = 0; n < header->n_trigrams; n++)
+    if ((guint64) mount->trigrams[n].offset + mount->trigrams[n].count > header->n_postings)
+      goto invalid;
+  for (n = 0; n < header->n_postings; n++)
+    if (mount->postings[n] >= header->n_entries)
+      goto invalid;
+
+  mount->mapped = mapped;
+  mount->header = header;
+
+  return TRUE;
+
+invalid:
+  g_mapped_file_unref (mapped);
+  index_mount_unmap (mount);
+  return FALSE;
+}
+
+
+
+/* copies what is needed to read the entries of @mount without holding the lock,
+ * the mapped file is only unmapped once the copy is released as well; with
+ * @with_overlay, the files and folders added since the index was written are
+ * copied too */
+static IndexMount *
+index_mount_snapshot (IndexMount *mount,
+                      gboolean    with_overlay)
+{
+  IndexMount    *snapshot;
+  IndexAdded    *added;
+  IndexAdded    *copy;
+  GHashTableIter iter;
+  gpointer       id;
+  gpointer       path;
+  guint          n;
+
+  snapshot = index_mount_new (mount->filename);
+
+  if (mount->mapped != NULL)
+    {
+      snapshot->mapped = g_mapped_file_ref (mount->mapped);
+      snapshot->header = mount->header;
+      snapshot->roots = mount->roots;
+      snapshot->entries = mount->entries;
+      snapshot->trigrams = mount->trigrams;
+      snapshot->postings = mount->postings;
+      snapshot->strings = mount->strings;
+    }
+
+  g_hash_table_iter_init (&iter, mount->removed);
+  while (g_hash_table_iter_next (&iter, &id, NULL))
+    g_hash_table_add (snapshot->removed, id);
+
+  if (with_overlay)
+    {
+      g_hash_table_iter_init (&iter, mount->added);
+      while (g_hash_table_iter_next (&iter, &path, (gpointer *) &added))
+        {
+          copy = g_new0 (IndexAdded, 1);
+          copy->key = g_strdup (added->key);
+          copy->flags = added->flags;
+          g_hash_table_insert (snapshot->added, g_strdup (path), copy);
+        }
+
+      for (n = 0; n < mount->unindexed->len; n++)
+        g_ptr_array_add (snapshot->unindexed, g_strdup (g_ptr_array_index (mount->unindexed, n)));
+    }
+
+  return snapshot;
+}
+
+
+
+static void
+index_mount_swap_mapping (IndexMount *mount,
+                          IndexMount *other)
+{
+  IndexMount tmp = *mount;
+
+  mount->mapped = other->mapped;
+  mount->header = other->header;
+  mount->roots = other->roots;
+  mount->entries = other->entries;
+  mount->trigrams = other->trigrams;
+  mount->postings = other->postings;
+  mount->strings = other->strings;
+
+  other->mapped = tmp.mapped;
+  other->header = tmp.header;
+  other->roots = tmp.roots;
+  other->entries = tmp.entries;
+  other->trigrams = tmp.trigrams;
+  other->postings = tmp.postings;
+  other->strings = tmp.strings;
+}
+
+
+
+static void
+index_ensure_loaded (void)
+{
+  static gsize loaded = 0;
+  GHashTable  *mounts;
+  IndexMount  *mount;
+  const gchar *name;
+  gchar       *dirname;
+  gchar       *filename;
+  GDir        *dir;
+
+  if (!g_once_init_enter (&loaded))
+    return;
+
+  /* mapping validates every entry, which must not block the lock; other
+   * threads wait in g_once_init_enter() until the mounts are known */
+  mounts = g_hash_table_new (g_str_hash, g_str_equal);
+
+  dirname = index_cache_directory ();
+  dir = g_dir_open (dirname, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          if (!g_str_has_suffix (name, ".idx"))
+            continue;
+
+          filename = g_build_filename (dirname, name, NULL);
+          mount = index_mount_new (filename);
+
+          if (index_mount_map (mount))
+            {
+              mount->path = g_strdup (mount->strings + mount->header->mount);
+              if (!g_hash_table_contains (mounts, mount->path))
+                {
+                  g_hash_table_insert (mounts, mount->path, mount);
+                  mount = NULL;
+                }
+            }
+          else
+            {
+              /* outdated or broken, it would never be used again */
+              g_unlink (filename);
+            }
+
+          if (mount != NULL)
+            index_mount_free (mount);
+          g_free (filename);
+        }
+
+      g_dir_close (dir);
+    }
+
+  g_free (dirname);
+
+  index_mounts = mounts;
+
+  g_once_init_leave (&loaded, 1);
+}
+
+
+
+static gboolean
+index_root_is_valid (const IndexRoot *root,
+                     gint64           now)
+{
+  return now - root->timestamp < THUNAR_SEARCH_INDEX_MAX_AGE;
+}
+
+
+
+static gchar *
+index_mount_entry_path (IndexMount *mount,
+                        guint32     id)
+{
+  GPtrArray *names;
+  GString   *path;
+  guint      n;
+
+  names = g_ptr_array_new ();
+  for (; id != INDEX_NONE; id = mount->entries[id].parent)
+    g_ptr_array_add (names, (gpointer) INDEX_ENTRY_NAME (mount, id));
+
+  /* the name of a root entry is its absolute path */
+  path = g_string_new (g_ptr_array_index (names, names->len - 1));
+  for (n = names->len - 1; n-- > 0;)
+    {
+      if (path->len == 0 || path->str[path->len - 1] != '/')
+        g_string_append_c (path, '/');
+      g_string_append (path, g_ptr_array_index (names, n));
+    }
+
+  g_ptr_array_free (names, TRUE);
+
+  return g_string_free (path, FALSE);
+}
+
+
+
+static guint32
+index_mount_lookup_child (IndexMount  *mount,
+                          guint32      parent,
+                          const gchar *name)
+{
+  const IndexEntry *entry = &mount->entries[parent];
+  guint32           lower = entry->first_child;
+  guint32           upper = entry->first_child + entry->n_children;
+  guint32           mid;
+  gint              cmp;
+
+  /* children are sorted by name */
+  while (lower < upper)
+    {
+      mid = lower + (upper - lower) / 2;
+      cmp = strcmp (name, INDEX_ENTRY_NAME (mount, mid));
+      if (cmp == 0)
+        return mid;
+      else if (cmp < 0)
+        upper = mid;
+      else
+        lower = mid + 1;
+    }
+
+  return INDEX_NONE;
+}
+
+
+
+static guint32
+index_mount_resolve (IndexMount  *mount,
+                     guint        root,
+                     const gchar *path)
+{
+  const gchar *root_path;
+  guint32      id;
+  gchar      **components;
+  guint        n;
+
+  id = mount->roots[root].entry;
+  root_path = INDEX_ENTRY_NAME (mount, id);
+  if (!index_path_is_below (path, root_path))
+    return INDEX_NONE;
+
+  components = g_strsplit (path + strlen (root_path), "/", -1);
+  for (n = 0; id != INDEX_NONE && components[n] != NULL; n++)
+    if (*components[n] != '\0')
+      id = index_mount_lookup_child (mount, id, components[n]);
+  g_strfreev (components);
+
+  return id;
+}
+
+
+
+static IndexMount *
+index_find_root (const gchar *path,
+                 gboolean     show_hidden,
+                 guint       *root_return)
+{
+  GHashTableIter iter;
+  IndexMount    *mount;
+  IndexMount    *best_mount = NULL;
+  const gchar   *root_path;
+  gsize          best_len = 0;
+  gint64         now = g_get_real_time ();
+  guint          n;
+
+  /* the innermost root is the most recent one */
+  g_hash_table_iter_init (&iter, index_mounts);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &mount))
+    {
+      if (mount->header == NULL)
+        continue;
+
+      for (n = 0; n < mount->header->n_roots; n++)
+        {
+          if (!index_root_is_valid (&mount->roots[n], now))
+            continue;
+          if (show_hidden && (mount->roots[n].flags & INDEX_ROOT_WITH_HIDDEN) == 0)
+            continue;
+
+          root_path = INDEX_ENTRY_NAME (mount, mount->roots[n].entry);
+          if (index_path_is_below (path, root_path) && (best_mount == NULL || strlen (root_path) > best_len))
+            {
+              best_mount = mount;
+              best_len = strlen (root_path);
+              *root_return = n;
+            }
+        }
+    }
+
+  return best_mount;
+}
+
+
+
+static gboolean
+index_mount_entry_is_visible (IndexMount *mount,
+                              guint32     id,
+                              guint32     directory,
+                              gboolean    show_hidden)
+{
+  guint32 n;
+
+  /* the entry must be inside the directory, and neither the entry nor
+   * any folder in between may be removed or hidden */
+  for (n = id; n != INDEX_NONE; n = mount->entries[n].parent)
+    {
+      if (n == directory)
+        return n != id;
+      if (!show_hidden && (mount->entries[n].flags & INDEX_ENTRY_HIDDEN) != 0)
+        return FALSE;
+      if (INDEX_ENTRY_REMOVED (mount, n))
+        return FALSE;
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+index_mount_is_unindexed (IndexMount  *mount,
+                          const gchar *path,
+                          gboolean     strictly_below)
+{
+  const gchar *directory;
+  guint        n;
+
+  for (n = 0; n < mount->unindexed->len; n++)
+    {
+      directory = g_ptr_array_index (mount->unindexed, n);
+      if (index_path_is_below (path, directory) && (!strictly_below || strcmp (path, directory) != 0))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+index_mount_added_is_visible (IndexMount  *mount,
+                              guint        root,
+                              const gchar *path,
+                              guint32      directory,
+                              gboolean     show_hidden)
+{
+  IndexAdded *added;
+  gchar      *parent_path;
+  guint32     parent;
+
+  added = g_hash_table_lookup (mount->added, path);
+  if (added != NULL && !show_hidden && (added->flags & INDEX_ENTRY_HIDDEN) != 0)
+    return FALSE;
+
+  /* the parent folder is part of the index, otherwise the
+   * file would live inside of an unindexed directory */
+  parent_path = g_path_get_dirname (path);
+  parent = index_mount_resolve (mount, root, parent_path);
+  g_free (parent_path);
+
+  if (parent == INDEX_NONE || INDEX_ENTRY_REMOVED (mount, parent))
+    return FALSE;
+
+  return parent == directory || index_mount_entry_is_visible (mount, parent, directory, show_hidden);
+}
+
+
+
+static const IndexTrigram *
+index_mount_lookup_trigram (IndexMount *mount,
+                            guint32     trigram)
+{
+  guint32 lower = 0;
+  guint32 upper = mount->header->n_trigrams;
+  guint32 mid;
+
+  while (lower < upper)
+    {
+      mid = lower + (upper - lower) / 2;
+      if (mount->trigrams[mid].trigram == trigram)
+        return &mount->trigrams[mid];
+      else if (mount->trigrams[mid].trigram > trigram)
+        upper = mid;
+      else
+        lower = mid + 1;
+    }
+
+  return NULL;
+}
+
+
+
+/**
+ * thunar_search_index_lookup:
+ * @directory            : the folder to search in.
+ * @matcher              : the search terms, see thunar_util_search_matcher_new().
+ * @show_hidden          : whether hidden files should be part of the results.
+ * @files_return         : return location for the matching #GFile<!---->s.
+ * @unindexed_return     : return location for the #GFile<!---->s of folders
+ *                         below @directory which are not part of the index.
+ *
+ * Looks up all files below @directory whose names match the search terms,
+ * if @directory is covered by the search index. The folders returned in
+ * @unindexed_return have to be searched by walking them.
+ *
+ * Return value: %TRUE if @directory is indexed, %FALSE otherwise.
+ **/
+gboolean
+thunar_search_index_lookup (GFile                     *directory,
+                            const ThunarSearchMatcher *matcher,
+                            gboolean                   show_hidden,
+                            GList                    **files_return,
+                            GList                    **unindexed_return)
+{
+  const gchar *const *terms;
+  const IndexTrigram *best = NULL;
+  const IndexTrigram *trigram;
+  GHashTableIter      iter;
+  IndexMount         *indexed;
+  IndexMount         *mount = NULL;
+  IndexAdded         *added;
+  const gchar        *added_path;
+  const gchar        *unindexed_path;
+  gchar              *path;
+  gchar              *file_path;
+  guint32             dir_id;
+  guint32             id;
+  guint32             n, n_candidates;
+  guint               root;
+  gsize               len, i;
+
+  _thunar_return_val_if_fail (G_IS_FILE (directory), FALSE);
+  _thunar_return_val_if_fail (files_return != NULL && unindexed_return != NULL, FALSE);
+
+  *files_return = NULL;
+  *unindexed_return = NULL;
+
+  path = g_file_get_path (directory);
+  if (path == NULL)
+    return FALSE;
+
+  index_ensure_loaded ();
+
+  /* the lock is only held to copy the state of the mount, the matching
+   * runs on the copy, so searches do not wait for each other nor hold
+   * back the monitor events */
+  g_mutex_lock (&index_lock);
+
+  indexed = index_find_root (path, show_hidden, &root);
+  if (indexed != NULL)
+    mount = index_mount_snapshot (indexed, TRUE);
+
+  g_mutex_unlock (&index_lock);
+
+  if (indexed == NULL)
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* a folder which appeared or vanished after indexing is walked as a whole */
+  dir_id = index_mount_resolve (mount, root, path);
+  for (id = dir_id; id != INDEX_NONE; id = mount->entries[id].parent)
+    if (INDEX_ENTRY_REMOVED (mount, id))
+      {
+        dir_id = INDEX_NONE;
+        break;
+      }
+
+  if (dir_id == INDEX_NONE)
+    {
+      index_mount_free (mount);
+      g_free (path);
+      *unindexed_return = g_list_prepend (NULL, g_object_ref (directory));
+      return TRUE;
+    }
+
+  /* use the rarest trigram of all terms to preselect candidates */
+  terms = thunar_util_search_matcher_get_terms (matcher);
+  for (n = 0; terms[n] != NULL; n++)
+    {
+      len = strlen (terms[n]);
+      for (i = 0; i + 3 <= len; i++)
+        {
+          trigram = index_mount_lookup_trigram (mount, INDEX_TRIGRAM (terms[n] + i));
+          if (trigram == NULL)
+            {
+              /* no file name contains this term */
+              n_candidates = 0;
+              goto overlay;
+            }
+
+          if (best == NULL || trigram->count < best->count)
+            best = trigram;
+        }
+    }
+
+  /* entries are stored breadth-first, so only ids after the directory can be inside of it */
+  n_candidates = (best != NULL) ? best->count : mount->header->n_entries;
+  for (n = 0; n < n_candidates; n++)
+    {
+      id = (best != NULL) ? mount->postings[best->offset + n] : n;
+      if (id <= dir_id)
+        continue;
+
+      if (!thunar_util_search_matcher_match_normalized (matcher, INDEX_ENTRY_KEY (mount, id)))
+        continue;
+
+      if (!index_mount_entry_is_visible (mount, id, dir_id, show_hidden))
+        continue;
+
+      file_path = index_mount_entry_path (mount, id);
+      *files_return = g_list_prepend (*files_return, g_file_new_for_path (file_path));
+      g_free (file_path);
+    }
+
+overlay:
+  /* files created after the index was written */
+  g_hash_table_iter_init (&iter, mount->added);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &added_path, (gpointer *) &added))
+    {
+      if (!index_path_is_below (added_path, path) || strcmp (added_path, path) == 0)
+        continue;
+      if (index_mount_is_unindexed (mount, added_path, TRUE))
+        continue;
+      if (!thunar_util_search_matcher_match_normalized (matcher, added->key))
+        continue;
+      if (!index_mount_added_is_visible (mount, root, added_path, dir_id, show_hidden))
+        continue;
+
+      *files_return = g_list_prepend (*files_return, g_file_new_for_path (added_path));
+    }
+
+  /* folders created after the index was written */
+  for (n = 0; n < mount->unindexed->len; n++)
+    {
+      unindexed_path = g_ptr_array_index (mount->unindexed, n);
+      if (!index_path_is_below (unindexed_path, path) || strcmp (unindexed_path, path) == 0)
+        continue;
+      if (index_mount_is_unindexed (mount, unindexed_path, TRUE))
+        continue;
+      if (!index_mount_added_is_visible (mount, root, unindexed_path, dir_id, show_hidden))
+        continue;
+
+      *unindexed_return = g_list_prepend (*unindexed_return, g_file_new_for_path (unindexed_path));
+    }
+
+  index_mount_free (mount);
+  g_free (path);
+
+  return TRUE;
+}
+
+
+
+static void
+index_enabled_changed (ThunarPreferences *preferences,
+                       GParamSpec        *pspec,
+                       gpointer           user_data)
+{
+  g_object_get (G_OBJECT (preferences), "misc-search-index", &index_enabled, NULL);
+}
+
+
+
+/**
+ * thunar_search_index_is_enabled:
+ *
+ * Whether the "misc-search-index" setting is on, so folder monitors
+ * should report their changes. Only call this from the main thread.
+ *
+ * Return value: %TRUE if the search index is in use.
+ **/
+gboolean
+thunar_search_index_is_enabled (void)
+{
+  /* called for every monitor event, so the setting is cached */
+  if (G_UNLIKELY (index_preferences == NULL))
+    {
+      index_preferences = thunar_preferences_get ();
+      g_signal_connect (G_OBJECT (index_preferences), "notify::misc-search-index",
+                        G_CALLBACK (index_enabled_changed), NULL);
+      index_enabled_changed (index_preferences, NULL, NULL);
+    }
+
+  return index_enabled;
+}
+
+
+
+static void
+index_mount_add_path (IndexMount  *mount,
+                      const gchar *path,
+                      const gchar *key,
+                      guint32      flags,
+                      gint64       now)
+{
+  IndexAdded *added;
+  gboolean    covered = FALSE;
+  gboolean    known = FALSE;
+  guint32     id;
+  guint       n;
+
+  if (mount->header == NULL)
+    return;
+
+  for (n = 0; n < mount->header->n_roots; n++)
+    {
+      if (!index_root_is_valid (&mount->roots[n], now))
+        continue;
+      if (!index_path_is_below (path, INDEX_ENTRY_NAME (mount, mount->roots[n].entry)))
+        continue;
+
+      covered = TRUE;
+      id = index_mount_resolve (mount, n, path);
+      if (id != INDEX_NONE && !INDEX_ENTRY_REMOVED (mount, id))
+        known = TRUE;
+    }
+
+  if (!covered || known)
+    return;
+
+  added = g_new0 (IndexAdded, 1);
+  added->key = g_strdup (key);
+  added->flags = flags;
+  g_hash_table_replace (mount->added, g_strdup (path), added);
+
+  if ((flags & INDEX_ENTRY_DIRECTORY) != 0 && !index_mount_is_unindexed (mount, path, FALSE))
+    g_ptr_array_add (mount->unindexed, g_strdup (path));
+}
+
+
+
+static gboolean
+index_added_is_below (gpointer key,
+                      gpointer value,
+                      gpointer user_data)
+{
+  return index_path_is_below (key, user_data);
+}
+
+
+
+static void
+index_mount_remove_path (IndexMount  *mount,
+                         const gchar *path)
+{
+  guint32 id;
+  guint   n;
+
+  /* the entry ids change once the new index is in place */
+  if (mount->removed_meanwhile != NULL)
+    g_ptr_array_add (mount->removed_meanwhile, g_strdup (path));
+
+  if (mount->header == NULL)
+    return;
+
+  for (n = 0; n < mount->header->n_roots; n++)
+    {
+      id = index_mount_resolve (mount, n, path);
+      if (id != INDEX_NONE)
+        g_hash_table_add (mount->removed, GUINT_TO_POINTER (id + 1));
+    }
+
+  g_hash_table_foreach_remove (mount->added, index_added_is_below, (gpointer) path);
+
+  for (n = mount->unindexed->len; n-- > 0;)
+    if (index_path_is_below (g_ptr_array_index (mount->unindexed, n), path))
+      g_ptr_array_remove_index_fast (mount->unindexed, n);
+}
+
+
+
+static void
+index_event_free (IndexEvent *event)
+{
+  g_free (event->path);
+  g_free (event->key);
+  g_free (event);
+}
+
+
+
+static void
+index_event_process (gpointer data,
+                     gpointer user_data)
+{
+  IndexEvent    *event = data;
+  GHashTableIter iter;
+  IndexMount    *mount;
+  gint64         now = g_get_real_time ();
+
+  index_ensure_loaded ();
+
+  g_mutex_lock (&index_lock);
+
+  g_hash_table_iter_init (&iter, index_mounts);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &mount))
+    {
+      if (event->key != NULL)
+        index_mount_add_path (mount, event->path, event->key, event->flags, now);
+      else
+        index_mount_remove_path (mount, event->path);
+    }
+
+  g_mutex_unlock (&index_lock);
+
+  index_event_free (event);
+}
+
+
+
+static void
+index_event_push (gchar  *path,
+                  gchar  *key,
+                  guint32 flags)
+{
+  IndexEvent *event;
+
+  /* only the main thread pushes events */
+  if (G_UNLIKELY (index_events == NULL))
+    index_events = g_thread_pool_new (index_event_process, NULL, 1, FALSE, NULL);
+
+  event = g_new0 (IndexEvent, 1);
+  event->path = path;
+  event->key = key;
+  event->flags = flags;
+
+  g_thread_pool_push (index_events, event, NULL);
+}
+
+
+
+/**
+ * thunar_search_index_file_added:
+ * @file : a #ThunarFile which was created or moved into a folder.
+ *
+ * Records @file in the search index, if its location is indexed.
+ * If @file is a folder, its content will be walked by later searches.
+ * The index is updated in the background.
+ **/
+void
+thunar_search_index_file_added (ThunarFile *file)
+{
+  const gchar *display_name;
+  gchar       *path;
+  gchar       *key;
+  guint32      flags = 0;
+
+  _thunar_return_if_fail (THUNAR_IS_FILE (file));
+
+  path = g_file_get_path (thunar_file_get_file (file));
+  if (path == NULL)
+    return;
+
+  /* the file is not thread-safe, so take what is needed here */
+  display_name = thunar_file_get_display_name (file);
+  key = (display_name != NULL) ? thunar_g_utf8_normalize_for_search (display_name, TRUE, TRUE) : g_strdup ("");
+  if (thunar_file_is_directory (file))
+    flags |= INDEX_ENTRY_DIRECTORY;
+  if (thunar_file_is_hidden (file))
+    flags |= INDEX_ENTRY_HIDDEN;
+
+  index_event_push (path, key, flags);
+}
+
+
+
+/**
+ * thunar_search_index_file_removed:
+ * @file : a #GFile which was deleted or moved out of a folder.
+ *
+ * Drops @file and, if it was a folder, its content from the search index.
+ * The index is updated in the background.
+ **/
+void
+thunar_search_index_file_removed (GFile *file)
+{
+  gchar *path;
+
+  _thunar_return_if_fail (G_IS_FILE (file));
+
+  path = g_file_get_path (file);
+  if (path == NULL)
+    return;
+
+  index_event_push (path, NULL, 0);
+}
+
+
+
+/**
+ * thunar_search_index_builder_new:
+ * @root        : the folder which is about to be walked.
+ * @with_hidden : whether hidden files will be part of the walk.
+ *
+ * Creates a builder which collects the names of all files below
+ * @root. The @root itself has the id %THUNAR_SEARCH_INDEX_BUILDER_ROOT.
+ *
+ * Return value: a new builder, or %NULL if @root is not a local path.
+ **/
+ThunarSearchIndexBuilder *
+thunar_search_index_builder_new (GFile   *root,
+                                 gboolean with_hidden)
+{
+  ThunarSearchIndexBuilder *builder;
+  gchar                    *path;
+
+  _thunar_return_val_if_fail (G_IS_FILE (root), NULL);
+
+  path = g_file_get_path (root);
+  if (path == NULL)
+    return NULL;
+
+  builder = g_new0 (ThunarSearchIndexBuilder, 1);
+  g_mutex_init (&builder->lock);
+  builder->root = path;
+  builder->flags = with_hidden ? INDEX_ROOT_WITH_HIDDEN : 0;
+  builder->entries = g_array_new (FALSE, FALSE, sizeof (BuilderEntry));
+
+  /* root entries are named by their absolute path */
+  thunar_search_index_builder_add (builder, INDEX_NONE, path, NULL, TRUE, FALSE);
+
+  return builder;
+}
+
+
+
+/**
+ * thunar_search_index_builder_add:
+ * @builder      : a #ThunarSearchIndexBuilder.
+ * @parent       : the id of the folder containing the file.
+ * @name         : the file name within @parent.
+ * @key          : the display name, normalized for searching.
+ * @is_directory : whether the file is a folder.
+ * @is_hidden    : whether the file is hidden.
+ *
+ * Records a file found during the walk. May be called from any thread.
+ *
+ * Return value: the id of the new entry, to be used as @parent of its children.
+ **/
+guint32
+thunar_search_index_builder_add (ThunarSearchIndexBuilder *builder,
+                                 guint32                   parent,
+                                 const gchar              *name,
+                                 const gchar              *key,
+                                 gboolean                  is_directory,
+                                 gboolean                  is_hidden)
+{
+  BuilderEntry entry;
+  guint32      id;
+
+  entry.parent = parent;
+  entry.flags = (is_directory ? INDEX_ENTRY_DIRECTORY : 0) | (is_hidden ? INDEX_ENTRY_HIDDEN : 0);
+  entry.name = g_strdup (name);
+  entry.key = g_strdup (key != NULL ? key : "");
+
+  g_mutex_lock (&builder->lock);
+  id = builder->entries->len;
+  g_array_append_val (builder->entries, entry);
+  g_mutex_unlock (&builder->lock);
+
+  return id;
+}
+
+
+
+static gint
+index_node_compare (gconstpointer a,
+                    gconstpointer b,
+                    gpointer      user_data)
+{
+  const IndexNode *nodes = user_data;
+  const IndexNode *node_a = &nodes[*(const guint32 *) a];
+  const IndexNode *node_b = &nodes[*(const guint32 *) b];
+
+  if (node_a->parent != node_b->parent)
+    return (node_a->parent < node_b->parent) ? -1 : 1;
+
+  return strcmp (node_a->name, node_b->name);
+}
+
+
+
+static gint
+index_pair_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  guint64 pair_a = *(const guint64 *) a;
+  guint64 pair_b = *(const guint64 *) b;
+
+  return (pair_a < pair_b) ? -1 : (pair_a > pair_b);
+}
+
+
+
+static gint
+index_trigram_compare (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  guint32 trigram_a = *(const guint32 *) a;
+  guint32 trigram_b = *(const guint32 *) b;
+
+  return (trigram_a < trigram_b) ? -1 : (trigram_a > trigram_b);
+}
+
+
+
+static guint32
+index_intern_string (GString     *strings,
+                     GHashTable  *offsets,
+                     const gchar *str)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended (offsets, str, NULL, &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  offset = GUINT_TO_POINTER (strings->len);
+  g_hash_table_insert (offsets, (gpointer) str, offset);
+  g_string_append_len (strings, str, strlen (str) + 1);
+
+  return GPOINTER_TO_UINT (offset);
+}
+
+
+
+static GByteArray *
+index_serialize (const gchar *mount_path,
+                 GArray      *nodes,
+                 GArray      *roots)
+{
+  IndexHeader  header = { 0, };
+  IndexEntry  *entries;
+  IndexNode   *node;
+  IndexRoot   *root;
+  GByteArray  *data;
+  GHashTable  *offsets;
+  GString     *strings;
+  GArray      *pairs;
+  GArray      *trigrams;
+  GArray      *postings;
+  IndexTrigram trigram;
+  guint32     *order;
+  guint32     *first;
+  guint32     *n_children;
+  guint32     *new_id;
+  guint32     *bfs;
+  GArray      *key_trigrams;
+  guint32      key_trigram;
+  guint32      n, k, c, n_nodes;
+  guint64      pair;
+  gsize        len, i;
+
+  n_nodes = nodes->len;
+  node = (IndexNode *) (gpointer) nodes->data;
+
+  /* group the nodes by parent, ordered by name */
+  order = g_new (guint32, n_nodes);
+  for (n = 0; n < n_nodes; n++)
+    order[n] = n;
+  g_qsort_with_data (order, n_nodes, sizeof (guint32), index_node_compare, node);
+
+  first = g_new (guint32, n_nodes);
+  n_children = g_new0 (guint32, n_nodes);
+  for (n = 0; n < n_nodes; n++)
+    first[n] = INDEX_NONE;
+  for (n = 0; n < n_nodes; n++)
+    {
+      guint32 parent = node[order[n]].parent;
+      if (parent == INDEX_NONE)
+        continue;
+      if (first[parent] == INDEX_NONE)
+        first[parent] = n;
+      n_children[parent]++;
+    }
+
+  /* assign the final ids breadth-first, roots first */
+  new_id = g_new (guint32, n_nodes);
+  bfs = g_new (guint32, n_nodes);
+  k = 0;
+  for (n = 0; n < roots->len; n++)
+    {
+      root = &g_array_index (roots, IndexRoot, n);
+      bfs[k] = root->entry;
+      new_id[root->entry] = k++;
+    }
+  for (n = 0; n < k; n++)
+    for (c = 0; c < n_children[bfs[n]]; c++)
+      {
+        guint32 child = order[first[bfs[n]] + c];
+        bfs[k] = child;
+        new_id[child] = k++;
+      }
+
+  _thunar_assert (k == n_nodes);
+
+  strings = g_string_new (NULL);
+  offsets = g_hash_table_new (g_str_hash, g_str_equal);
+  index_intern_string (strings, offsets, "");
+  header.mount = index_intern_string (strings, offsets, mount_path);
+
+  entries = g_new (IndexEntry, n_nodes);
+  key_trigrams = g_array_new (FALSE, FALSE, sizeof (guint32));
+  pairs = g_array_new (FALSE, FALSE, sizeof (guint64));
+  for (k = 0; k < n_nodes; k++)
+    {
+      n = bfs[k];
+      entries[k].parent = (node[n].parent != INDEX_NONE) ? new_id[node[n].parent] : INDEX_NONE;
+      entries[k].flags = node[n].flags;
+      entries[k].name = index_intern_string (strings, offsets, node[n].name);
+      entries[k].key = index_intern_string (strings, offsets, node[n].key);
+      entries[k].n_children = n_children[n];
+      entries[k].first_child = (n_children[n] > 0) ? new_id[order[first[n]]] : 0;
+
+      /* collect the distinct trigrams of the search key */
+      len = strlen (node[n].key);
+      g_array_set_size (key_trigrams, 0);
+      for (i = 0; i + 3 <= len; i++)
+        {
+          key_trigram = INDEX_TRIGRAM (node[n].key + i);
+          g_array_append_val (key_trigrams, key_trigram);
+        }
+      g_array_sort_with_data (key_trigrams, index_trigram_compare, NULL);
+      for (i = 0; i < key_trigrams->len; i++)
+        {
+          key_trigram = g_array_index (key_trigrams, guint32, i);
+          if (i > 0 && key_trigram == g_array_index (key_trigrams, guint32, i - 1))
+            continue;
+
+          pair = ((guint64) key_trigram << 32) | k;
+          g_array_append_val (pairs, pair);
+        }
+    }
+
+  /* turn the sorted (trigram, id) pairs into posting lists */
+  g_array_sort (pairs, index_pair_compare);
+  trigrams = g_array_new (FALSE, FALSE, sizeof (IndexTrigram));
+  postings = g_array_sized_new (FALSE, FALSE, sizeof (guint32), pairs->len);
+  for (n = 0; n < pairs->len; n++)
+    {
+      pair = g_array_index (pairs, guint64, n);
+      if (trigrams->len == 0 || g_array_index (trigrams, IndexTrigram, trigrams->len - 1).trigram != (guint32) (pair >> 32))
+        {
+          trigram.trigram = pair >> 32;
+          trigram.offset = postings->len;
+          trigram.count = 0;
+          g_array_append_val (trigrams, trigram);
+        }
+
+      g_array_index (trigrams, IndexTrigram, trigrams->len - 1).count++;
+      k = (guint32) pair;
+      g_array_append_val (postings, k);
+    }
+
+  memcpy (header.magic, THUNAR_SEARCH_INDEX_MAGIC, sizeof (header.magic));
+  header.version = THUNAR_SEARCH_INDEX_VERSION;
+  header.glib_version = index_glib_version ();
+  header.n_roots = roots->len;
+  header.n_entries = n_nodes;
+  header.n_trigrams = trigrams->len;
+  header.n_postings = postings->len;
+  header.strings_size = strings->len;
+
+  data = g_byte_array_new ();
+  g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+  for (n = 0; n < roots->len; n++)
+    {
+      IndexRoot copy = g_array_index (roots, IndexRoot, n);
+      copy.entry = new_id[copy.entry];
+      g_byte_array_append (data, (const guint8 *) &copy, sizeof (copy));
+    }
+  g_byte_array_append (data, (const guint8 *) entries, n_nodes * sizeof (IndexEntry));
+  g_byte_array_append (data, (const guint8 *) trigrams->data, trigrams->len * sizeof (IndexTrigram));
+  g_byte_array_append (data, (const guint8 *) postings->data, postings->len * sizeof (guint32));
+  g_byte_array_append (data, (const guint8 *) strings->str, strings->len);
+
+  g_array_free (postings, TRUE);
+  g_array_free (trigrams, TRUE);
+  g_array_free (pairs, TRUE);
+  g_array_free (key_trigrams, TRUE);
+  g_hash_table_destroy (offsets);
+  g_string_free (strings, TRUE);
+  g_free (entries);
+  g_free (bfs);
+  g_free (new_id);
+  g_free (n_children);
+  g_free (first);
+  g_free (order);
+
+  return data;
+}
+
+
+
+/**
+ * thunar_search_index_builder_commit:
+ * @builder : a #ThunarSearchIndexBuilder.
+ *
+ * Merges the files collected by @builder into the index of its mount
+ * point and writes it to disk. Call this only if the walk was complete.
+ *
+ * The new index is built and written without holding the lock, which is
+ * only taken to look at the current index and to swap in the new one.
+ **/
+void
+thunar_search_index_builder_commit (ThunarSearchIndexBuilder *builder)
+{
+  IndexMount   *mount;
+  IndexMount   *snapshot;
+  IndexMount   *fresh;
+  IndexNode     node;
+  IndexRoot     root;
+  BuilderEntry *entry;
+  GByteArray   *data;
+  GPtrArray    *removed_meanwhile;
+  GArray       *nodes;
+  GArray       *roots;
+  GError       *error = NULL;
+  guint32      *old_ids;
+  guint32       offset;
+  gboolean      keep;
+  gchar        *mount_path;
+  gchar        *dirname;
+  gchar        *checksum;
+  gchar        *basename;
+  gint64        now;
+  guint32       n, r;
+
+  mount_path = index_mount_point (builder->root);
+  if (mount_path == NULL)
+    return;
+
+  index_ensure_loaded ();
+
+  g_mutex_lock (&index_commit_lock);
+
+  dirname = index_cache_directory ();
+
+  g_mutex_lock (&index_lock);
+
+  /* mounts are never dropped, so the pointer stays valid without the lock */
+  mount = g_hash_table_lookup (index_mounts, mount_path);
+  if (mount == NULL)
+    {
+      checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, mount_path, -1);
+      basename = g_strconcat (checksum, ".idx", NULL);
+      mount = index_mount_new (NULL);
+      mount->filename = g_build_filename (dirname, basename, NULL);
+      mount->path = g_strdup (mount_path);
+      g_hash_table_insert (index_mounts, mount->path, mount);
+      g_free (basename);
+      g_free (checksum);
+    }
+
+  snapshot = index_mount_snapshot (mount, FALSE);
+  mount->removed_meanwhile = g_ptr_array_new_with_free_func (g_free);
+
+  g_mutex_unlock (&index_lock);
+
+  now = g_get_real_time ();
+  nodes = g_array_new (FALSE, FALSE, sizeof (IndexNode));
+  roots = g_array_new (FALSE, FALSE, sizeof (IndexRoot));
+
+  /* keep everything of the existing index which is still valid and not
+   * replaced by the new walk; parents always precede their children */
+  if (snapshot->header != NULL)
+    {
+      old_ids = g_new (guint32, snapshot->header->n_entries);
+      for (n = 0; n < snapshot->header->n_entries; n++)
+        {
+          const IndexEntry *old = &snapshot->entries[n];
+
+          keep = FALSE;
+          if (old->parent == INDEX_NONE)
+            {
+              for (r = 0; r < snapshot->header->n_roots; r++)
+                if (snapshot->roots[r].entry == n)
+                  break;
+
+              if (r < snapshot->header->n_roots
+                  && index_root_is_valid (&snapshot->roots[r], now)
+                  && !index_path_is_below (INDEX_ENTRY_NAME (snapshot, n), builder->root))
+                {
+                  keep = TRUE;
+                  root = snapshot->roots[r];
+                  root.entry = nodes->len;
+                  g_array_append_val (roots, root);
+                }
+            }
+          else
+            keep = (old_ids[old->parent] != INDEX_NONE);
+
+          if (keep && INDEX_ENTRY_REMOVED (snapshot, n))
+            {
+              /* a removed root must not be listed anymore either */
+              if (old->parent == INDEX_NONE)
+                g_array_set_size (roots, roots->len - 1);
+              keep = FALSE;
+            }
+
+          old_ids[n] = keep ? nodes->len : INDEX_NONE;
+          if (!keep)
+            continue;
+
+          node.parent = (old->parent != INDEX_NONE) ? old_ids[old->parent] : INDEX_NONE;
+          node.flags = old->flags;
+          node.name = INDEX_ENTRY_NAME (snapshot, n);
+          node.key = INDEX_ENTRY_KEY (snapshot, n);
+          g_array_append_val (nodes, node);
+        }
+      g_free (old_ids);
+    }
+
+  offset = nodes->len;
+  for (n = 0; n < builder->entries->len; n++)
+    {
+      entry = &g_array_index (builder->entries, BuilderEntry, n);
+      node.parent = (entry->parent != INDEX_NONE) ? entry->parent + offset : INDEX_NONE;
+      node.flags = entry->flags;
+      node.name = entry->name;
+      node.key = entry->key;
+      g_array_append_val (nodes, node);
+    }
+
+  root.timestamp = now;
+  root.entry = offset + THUNAR_SEARCH_INDEX_BUILDER_ROOT;
+  root.flags = builder->flags;
+  g_array_append_val (roots, root);
+
+  data = index_serialize (mount_path, nodes, roots);
+
+  /* the new file is validated before it is used, like on startup */
+  fresh = index_mount_new (snapshot->filename);
+  if (g_mkdir_with_parents (dirname, 0700) == 0
+      && g_file_set_contents (fresh->filename, (const gchar *) data->data, data->len, &error))
+    index_mount_map (fresh);
+  else if (error != NULL)
+    {
+      g_warning ("Failed to write search index \"%s\": %s", fresh->filename, error->message);
+      g_error_free (error);
+    }
+
+  g_mutex_lock (&index_lock);
+
+  removed_meanwhile = mount->removed_meanwhile;
+  mount->removed_meanwhile = NULL;
+
+  if (fresh->mapped != NULL)
+    {
+      index_mount_swap_mapping (mount, fresh);
+
+      /* the entry ids changed and removed entries were dropped */
+      g_hash_table_remove_all (mount->removed);
+
+      /* the walk already saw everything below its root */
+      g_hash_table_foreach_remove (mount->added, index_added_is_below, builder->root);
+      for (n = mount->unindexed->len; n-- > 0;)
+        if (index_path_is_below (g_ptr_array_index (mount->unindexed, n), builder->root))
+          g_ptr_array_remove_index_fast (mount->unindexed, n);
+
+      /* files removed while writing the new index are still gone */
+      for (n = 0; n < removed_meanwhile->len; n++)
+        index_mount_remove_path (mount, g_ptr_array_index (removed_meanwhile, n));
+    }
+
+  g_mutex_unlock (&index_lock);
+
+  g_mutex_unlock (&index_commit_lock);
+
+  /* the nodes point into the old mapping, so only drop it now */
+  g_ptr_array_unref (removed_meanwhile);
+  g_byte_array_unref (data);
+  g_array_free (roots, TRUE);
+  g_array_free (nodes, TRUE);
+  index_mount_free (fresh);
+  index_mount_free (snapshot);
+  g_free (dirname);
+  g_free (mount_path);
+}
+
+
+
+/**
+ * thunar_search_index_builder_free:
+ * @builder : a #ThunarSearchIndexBuilder.
+ *
+ * Releases @builder and everything it collected.
+ **/
+void
+thunar_search_index_builder_free (ThunarSearchIndexBuilder *builder)
+{
+  BuilderEntry *entry;
+  guint         n;
+
+  for (n = 0; n < builder->entries->len; n++)
+    {
+      entry = &g_array_index (builder->entries, BuilderEntry, n);
+      g_free (entry->name);
+      g_free (entry->key);
+    }
+
+  g_array_free (builder->entries, TRUE);
+  g_mutex_clear (&builder->lock);
+  g_free (builder->root);
+  g_free (builder);
+}
@@ -0,0 +1,70 @@
+/* vi:set et ai sw=2 sts=2 ts=2: */
+/*-
+ * Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THUNAR_SEARCH_INDEX_H__
+#define __THUNAR_SEARCH_INDEX_H__
+
+#include "thunar/thunar-file.h"
+#include "thunar/thunar-util.h"
+
+G_BEGIN_DECLS
+
+/* entry id of the directory a #ThunarSearchIndexBuilder was created for */
+#define THUNAR_SEARCH_INDEX_BUILDER_ROOT (0)
+
+typedef struct _ThunarSearchIndexBuilder ThunarSearchIndexBuilder;
+
+gboolean
+thunar_search_index_lookup (GFile                     *directory,
+                            const ThunarSearchMatcher *matcher,
+                            gboolean                   show_hidden,
+                            GList                    **files_return,
+                            GList                    **unindexed_return);
+
+gboolean
+thunar_search_index_is_enabled (void);
+
+void
+thunar_search_index_file_added (ThunarFile *file);
+
+void
+thunar_search_index_file_removed (GFile *file);
+
+ThunarSearchIndexBuilder *
+thunar_search_index_builder_new (GFile   *root,
+                                 gboolean with_hidden);
+
+guint32
+thunar_search_index_builder_add (ThunarSearchIndexBuilder *builder,
+                                 guint32                   parent,
+                                 const gchar              *name,
+                                 const gchar              *key,
+                                 gboolean                  is_directory,
+                                 gboolean                  is_hidden);
+
+void
+thunar_search_index_builder_commit (ThunarSearchIndexBuilder *builder);
+
+void
+thunar_search_index_builder_free (ThunarSearchIndexBuilder *builder);
+
+G_END_DECLS
+
+#endif /* !__THUNAR_SEARCH_INDEX_H__ */
@@ -418,7 +418,7 @@ thunar_transfer_job_collect_node (ThunarTransferJob  *job,
       /* scan the directory for immediate children */
       file_list = thunar_io_scan_directory (THUNAR_JOB (job), node->source_file,
                                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                            FALSE, FALSE, FALSE, NULL, &err);
+                                            FALSE, FALSE, FALSE, NULL, 0, &err);
 
       /* append Children to number of total files */
       n_total_files = thunar_job_get_n_total_files (THUNAR_JOB (job)) + g_list_length (file_list);
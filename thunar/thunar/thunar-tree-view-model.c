@@ -69,6 +69,10 @@
  * expanded before the delay elapses the scheduled cleanup will be cancelled */
 #define CLEANUP_AFTER_COLLAPSE_DELAY 5000 /* in ms */
 
+/* Time spent at most on inserting files into a directory before the view
+ * gets painted; remaining files are merged in chunks of that length while idle */
+#define MERGE_FILES_BUDGET 8000 /* in us */
+
 /* Defintions & typedefs */
 typedef struct _Node Node;
 
@@ -264,6 +268,9 @@ thunar_tree_view_model_dir_add_file (Node       *node,
 static void
 thunar_tree_view_model_dir_remove_file (Node       *node,
                                         ThunarFile *file);
+static void
+thunar_tree_view_model_dir_queue_file (Node       *node,
+                                       ThunarFile *file);
 static Node *
 thunar_tree_view_model_locate_file (ThunarTreeViewModel *model,
                                     ThunarFile          *file);
@@ -342,7 +349,7 @@ struct _ThunarTreeViewModel
   gint n_visible_files;
   gint loading;
 
-  gchar **search_terms;
+  ThunarSearchMatcher *search_matcher;
 
   ThunarJob *search_job;
   GList     *search_files;
@@ -376,6 +383,10 @@ struct _Node
   ThunarTreeViewModel *model;
 
   guint scheduled_unload_id;
+
+  /* files of the directory which are not yet part of children; they are merged in while idle */
+  GHashTable *pending_files;
+  guint       pending_files_idle_id;
 };
 
 struct _MatchForeach
@@ -619,7 +630,7 @@ thunar_tree_view_model_init (ThunarTreeViewModel *model)
   model->search_job = NULL;
   model->update_search_results_timeout_id = 0;
 
-  model->search_terms = NULL;
+  model->search_matcher = NULL;
   model->search_files = NULL;
   g_mutex_init (&model->mutex_add_search_files);
 
@@ -697,7 +708,7 @@ thunar_tree_view_model_finalize (GObject *object)
   g_mutex_clear (&model->mutex_add_search_files);
 
   g_free (model->date_custom_style);
-  g_strfreev (model->search_terms);
+  thunar_util_search_matcher_free (model->search_matcher);
 
   g_hash_table_destroy (model->subdirs);
 
@@ -1782,6 +1793,7 @@ thunar_tree_view_model_set_folder (ThunarTreeViewModel *model,
 {
   ThunarTreeViewModel *_model;
   gchar               *search_query_normalized;
+  gchar              **search_terms;
 
   _thunar_return_if_fail (THUNAR_IS_TREE_VIEW_MODEL (model));
 
@@ -1825,9 +1837,11 @@ thunar_tree_view_model_set_folder (ThunarTreeViewModel *model,
       _model->root->loaded = TRUE;
 
       search_query_normalized = thunar_g_utf8_normalize_for_search (search_query, TRUE, TRUE);
-      g_strfreev (_model->search_terms);
-      _model->search_terms = thunar_util_split_search_query (search_query_normalized, NULL);
-      if (_model->search_terms != NULL)
+      search_terms = thunar_util_split_search_query (search_query_normalized, NULL);
+      thunar_util_search_matcher_free (_model->search_matcher);
+      _model->search_matcher = (search_terms != NULL) ? thunar_util_search_matcher_new (search_terms) : NULL;
+      g_strfreev (search_terms);
+      if (_model->search_matcher != NULL)
         {
           /* search the current folder
            * start a new recursive_search_job */
@@ -1871,7 +1885,13 @@ _thunar_tree_view_model_set_show_hidden (Node    *node,
       thunar_tree_view_model_dir_add_file (node, THUNAR_FILE (key));
   else
     while (g_hash_table_iter_next (&iter, &key, NULL))
-      thunar_tree_view_model_dir_remove_file (node, THUNAR_FILE (key));
+      {
+        /* the file was not merged in yet */
+        if (node->pending_files != NULL && g_hash_table_remove (node->pending_files, key))
+          continue;
+
+        thunar_tree_view_model_dir_remove_file (node, THUNAR_FILE (key));
+      }
 }
 
 
@@ -2201,6 +2221,9 @@ thunar_tree_view_model_new_node (ThunarFile *file)
 
   _node->scheduled_unload_id = 0;
 
+  _node->pending_files = NULL;
+  _node->pending_files_idle_id = 0;
+
   _node->file_watch_active = FALSE;
 
   return _node;
@@ -2232,6 +2255,9 @@ thunar_tree_view_model_new_dummy_node (void)
 
   _node->scheduled_unload_id = 0;
 
+  _node->pending_files = NULL;
+  _node->pending_files_idle_id = 0;
+
   return _node;
 }
 
@@ -2659,6 +2685,83 @@ _thunar_tree_view_model_folder_error (Node         *node,
 
 
 
+static gboolean
+_thunar_tree_view_model_dir_merge_pending_files (gpointer data)
+{
+  Node       *node = data;
+  ThunarFile *file;
+  GPtrArray  *batch;
+  gint64      deadline = g_get_monotonic_time () + MERGE_FILES_BUDGET;
+  guint       n;
+
+  batch = g_ptr_array_new_with_free_func (g_object_unref);
+
+  while (g_hash_table_size (node->pending_files) > 0 && g_get_monotonic_time () < deadline)
+    {
+      GHashTableIter iter;
+      gpointer       key;
+
+      /* take a few files out of the table first, since inserting them runs
+       * the handlers of the view, which may change the pending files */
+      g_hash_table_iter_init (&iter, node->pending_files);
+      while (batch->len < 64 && g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          g_ptr_array_add (batch, key);
+          g_hash_table_iter_steal (&iter);
+        }
+
+      for (n = 0; n < batch->len; n++)
+        {
+          file = g_ptr_array_index (batch, n);
+
+          /* the file might have turned hidden meanwhile */
+          if (thunar_file_is_hidden (file) && !node->model->show_hidden)
+            {
+              if (!g_hash_table_contains (node->hidden_files, file))
+                g_hash_table_add (node->hidden_files, g_object_ref (file));
+              continue;
+            }
+
+          thunar_tree_view_model_dir_add_file (node, file);
+        }
+
+      g_ptr_array_set_size (batch, 0);
+    }
+
+  g_ptr_array_unref (batch);
+
+  g_object_notify_by_pspec (G_OBJECT (node->model), tree_model_props[PROP_NUM_FILES]);
+
+  if (g_hash_table_size (node->pending_files) > 0)
+    return G_SOURCE_CONTINUE;
+
+  node->pending_files_idle_id = 0;
+
+  /* loading was only delayed by the pending files */
+  if (node->loaded)
+    thunar_tree_view_model_set_loading (node->model, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+thunar_tree_view_model_dir_queue_file (Node       *node,
+                                       ThunarFile *file)
+{
+  if (node->pending_files == NULL)
+    node->pending_files = g_hash_table_new_full (g_direct_hash, NULL, g_object_unref, NULL);
+
+  g_hash_table_add (node->pending_files, g_object_ref (file));
+
+  /* merge with low priority, so the view gets painted in between */
+  if (node->pending_files_idle_id == 0)
+    node->pending_files_idle_id = g_idle_add_full (G_PRIORITY_LOW, _thunar_tree_view_model_dir_merge_pending_files, node, NULL);
+}
+
+
+
 static void
 _thunar_tree_view_model_dir_files_added (Node       *node,
                                          GHashTable *files)
@@ -2666,6 +2769,7 @@ _thunar_tree_view_model_dir_files_added (Node       *node,
   ThunarFile    *file;
   GHashTableIter iter;
   gpointer       key;
+  gint64         deadline = g_get_monotonic_time () + MERGE_FILES_BUDGET;
 
   g_hash_table_iter_init (&iter, files);
   while (g_hash_table_iter_next (&iter, &key, NULL))
@@ -2680,7 +2784,14 @@ _thunar_tree_view_model_dir_files_added (Node       *node,
             continue;
         }
 
-      if (!g_hash_table_contains (node->set, file))
+      if (g_hash_table_contains (node->set, file))
+        continue;
+
+      /* insert the files which fit into the budget right away, so large folders
+       * get painted quickly; the remaining ones are merged in later on */
+      if (node->pending_files_idle_id != 0 || g_get_monotonic_time () >= deadline)
+        thunar_tree_view_model_dir_queue_file (node, file);
+      else
         thunar_tree_view_model_dir_add_file (node, file);
     }
 
@@ -2712,6 +2823,10 @@ _thunar_tree_view_model_dir_files_removed (Node       *node,
             continue;
         }
 
+      /* the file was not merged in yet */
+      if (node->pending_files != NULL && g_hash_table_remove (node->pending_files, file))
+        continue;
+
       thunar_tree_view_model_dir_remove_file (node, file);
     }
 
@@ -2732,8 +2847,9 @@ _thunar_tree_view_model_dir_notify_loading (Node         *node,
       if (thunar_tree_view_model_node_has_dummy_child (node))
         thunar_tree_view_model_node_drop_dummy_child (node);
 
-      /* signal model that this dir is done loading */
-      thunar_tree_view_model_set_loading (node->model, FALSE);
+      /* signal model that this dir is done loading, once all of its files are merged in */
+      if (node->pending_files_idle_id == 0)
+        thunar_tree_view_model_set_loading (node->model, FALSE);
     }
 }
 
@@ -2885,6 +3001,12 @@ thunar_tree_view_model_node_destroy (Node *node)
 
   THUNAR_WARN_VOID_RETURN (node->file == NULL);
 
+  if (node->pending_files_idle_id != 0)
+    g_source_remove (node->pending_files_idle_id);
+
+  if (node->pending_files != NULL)
+    g_hash_table_destroy (node->pending_files);
+
   if (node->dir != NULL)
     {
       g_signal_handlers_disconnect_by_data (G_OBJECT (node->dir), node);
@@ -3072,6 +3194,21 @@ _thunar_tree_view_model_dir_unload_timeout (Node *node)
 
   node->loaded = FALSE;
 
+  /* the pending files would be merged into the unloaded directory, and
+   * loading would never be finished */
+  if (node->pending_files_idle_id != 0)
+    {
+      g_source_remove (node->pending_files_idle_id);
+      node->pending_files_idle_id = 0;
+      thunar_tree_view_model_set_loading (node->model, FALSE);
+    }
+
+  if (node->pending_files != NULL)
+    {
+      g_hash_table_destroy (node->pending_files);
+      node->pending_files = NULL;
+    }
+
   if (node->dir != NULL)
     {
       g_signal_handlers_disconnect_by_data (G_OBJECT (node->dir), node);
@@ -3142,18 +3279,7 @@ static gboolean
 _thunar_tree_view_model_matches_search_terms (ThunarTreeViewModel *model,
                                               ThunarFile          *file)
 {
-  gboolean matched;
-  gchar   *name_n;
-
-  name_n = (gchar *) thunar_file_get_display_name (file);
-  if (name_n == NULL)
-    return FALSE;
-
-  name_n = thunar_g_utf8_normalize_for_search (name_n, TRUE, TRUE);
-  matched = thunar_util_search_terms_match (model->search_terms, name_n);
-  g_free (name_n);
-
-  return matched;
+  return thunar_util_search_matcher_match (model->search_matcher, thunar_file_get_display_name (file));
 }
 
 
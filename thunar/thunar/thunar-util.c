@@ -48,6 +48,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifdef G_PLATFORM_WIN32
 #include <direct.h>
 #include <glib/gwin32.h>
@@ -1110,28 +1114,277 @@ thunar_util_split_search_query (const gchar *search_query_normalized,
 
 
 
+/* terms are matched in groups of this size, one bit per term */
+#define SEARCH_MATCHER_GROUP_SIZE (64)
+
+struct _ThunarSearchMatcher
+{
+  gchar  **terms;     /* normalized, non-empty search terms */
+  gsize   *lengths;
+  guint    n_terms;
+  gboolean ascii;     /* whether all terms are pure ASCII */
+};
+
+
+
+static gboolean
+thunar_util_search_term_matches_at (const gchar *str,
+                                    gsize        len,
+                                    gsize        pos,
+                                    const gchar *term,
+                                    gsize        term_len,
+                                    gboolean     fold_case)
+{
+  gsize n;
+
+  if (pos + term_len > len)
+    return FALSE;
+
+  if (!fold_case)
+    return memcmp (str + pos, term, term_len) == 0;
+
+  for (n = 0; n < term_len; n++)
+    if (g_ascii_tolower (str[pos + n]) != term[n])
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+/* returns the terms of the group (as bits) which occur in @str */
+static guint64
+thunar_util_search_matcher_scan (const ThunarSearchMatcher *matcher,
+                                 guint                      first,
+                                 guint                      n_terms,
+                                 const gchar               *str,
+                                 gsize                      len,
+                                 gboolean                   fold_case)
+{
+  const guint64 all = (n_terms == 64) ? G_MAXUINT64 : ((G_GUINT64_CONSTANT (1) << n_terms) - 1);
+  guint64       matched = 0;
+  gsize         pos = 0;
+  guint         t;
+
+#ifdef __SSE2__
+  /* test 16 positions at once for the first byte of every pending
+   * term, and only compare the complete term where it fits */
+  for (; pos + 16 <= len && matched != all; pos += 16)
+    {
+      __m128i block = _mm_loadu_si128 ((const __m128i *) (str + pos));
+
+      for (t = 0; t < n_terms; t++)
+        {
+          const gchar *term = matcher->terms[first + t];
+          gchar        c = term[0];
+          guint        mask;
+
+          if ((matched & (G_GUINT64_CONSTANT (1) << t)) != 0)
+            continue;
+
+          mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 (c)));
+          if (fold_case && g_ascii_islower (c))
+            mask |= _mm_movemask_epi8 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 (g_ascii_toupper (c))));
+
+          for (; mask != 0; mask &= mask - 1)
+            if (thunar_util_search_term_matches_at (str, len, pos + g_bit_nth_lsf (mask, -1),
+                                                    term, matcher->lengths[first + t], fold_case))
+              {
+                matched |= G_GUINT64_CONSTANT (1) << t;
+                break;
+              }
+        }
+    }
+#endif
+
+  /* the remaining tail, or everything without SSE2 */
+  for (; pos < len && matched != all; pos++)
+    for (t = 0; t < n_terms; t++)
+      if ((matched & (G_GUINT64_CONSTANT (1) << t)) == 0
+          && thunar_util_search_term_matches_at (str, len, pos, matcher->terms[first + t],
+                                                 matcher->lengths[first + t], fold_case))
+        matched |= G_GUINT64_CONSTANT (1) << t;
+
+  return matched;
+}
+
+
+
+static gboolean
+thunar_util_search_matcher_match_len (const ThunarSearchMatcher *matcher,
+                                      const gchar               *str,
+                                      gsize                      len,
+                                      gboolean                   fold_case)
+{
+  guint first;
+  guint n_terms;
+
+  for (first = 0; first < matcher->n_terms; first += n_terms)
+    {
+      n_terms = MIN (matcher->n_terms - first, SEARCH_MATCHER_GROUP_SIZE);
+      if (thunar_util_search_matcher_scan (matcher, first, n_terms, str, len, fold_case)
+          != ((n_terms == 64) ? G_MAXUINT64 : ((G_GUINT64_CONSTANT (1) << n_terms) - 1)))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+thunar_util_str_is_ascii (const gchar *str,
+                          gsize       *len_return)
+{
+  const gchar *p;
+
+  for (p = str; *p != '\0'; p++)
+    if ((guchar) *p >= 0x80)
+      return FALSE;
+
+  *len_return = p - str;
+  return TRUE;
+}
+
+
+
 /**
- * thunar_util_search_terms_match:
+ * thunar_util_search_matcher_new:
  * @terms: The search terms to look for, prepared with thunar_util_split_search_query().
- * @str: The string which the search terms might be found in.
  *
- * All search terms must match. Thunar uses simple substring matching
- * for the broadest multilingual support. @str must be normalized before
- * passing to this function.
+ * Prepares @terms for matching many strings against them. All
+ * search terms must match. Thunar uses simple substring matching
+ * for the broadest multilingual support.
  *
- * See also: thunar_g_utf8_normalize_for_search().
+ * Return value: (transfer full): a matcher to be released with thunar_util_search_matcher_free().
+ **/
+ThunarSearchMatcher *
+thunar_util_search_matcher_new (gchar **terms)
+{
+  ThunarSearchMatcher *matcher;
+  gsize                len;
+  guint                n;
+
+  matcher = g_new0 (ThunarSearchMatcher, 1);
+  matcher->terms = g_new0 (gchar *, g_strv_length (terms) + 1);
+  matcher->lengths = g_new0 (gsize, g_strv_length (terms) + 1);
+  matcher->ascii = TRUE;
+
+  for (n = 0; terms[n] != NULL; n++)
+    {
+      /* empty terms match everything */
+      if (*terms[n] == '\0' || g_strv_contains ((const gchar *const *) matcher->terms, terms[n]))
+        continue;
+
+      if (!thunar_util_str_is_ascii (terms[n], &len))
+        {
+          matcher->ascii = FALSE;
+          len = strlen (terms[n]);
+        }
+
+      matcher->terms[matcher->n_terms] = g_strdup (terms[n]);
+      matcher->lengths[matcher->n_terms] = len;
+      matcher->n_terms++;
+    }
+
+  return matcher;
+}
+
+
+
+/**
+ * thunar_util_search_matcher_match:
+ * @matcher: a #ThunarSearchMatcher.
+ * @str: The display name which the search terms might be found in.
+ *
+ * Checks whether all search terms occur in @str after normalizing it
+ * with thunar_g_utf8_normalize_for_search(). Pure ASCII strings are
+ * matched directly, without normalizing them.
  *
  * Return value: TRUE if all terms matched, FALSE otherwise.
  **/
+gboolean
+thunar_util_search_matcher_match (const ThunarSearchMatcher *matcher,
+                                  const gchar               *str)
+{
+  gboolean matched;
+  gchar   *normalized;
+  gsize    len;
+
+  if (str == NULL)
+    return FALSE;
+
+  if (matcher->n_terms == 0)
+    return TRUE;
+
+  /* for ASCII, the normalization boils down to lowering the case,
+   * and a term with other characters can never match */
+  if (thunar_util_str_is_ascii (str, &len))
+    return matcher->ascii && thunar_util_search_matcher_match_len (matcher, str, len, TRUE);
+
+  normalized = thunar_g_utf8_normalize_for_search (str, TRUE, TRUE);
+  if (normalized == NULL)
+    return FALSE;
+
+  matched = thunar_util_search_matcher_match_len (matcher, normalized, strlen (normalized), FALSE);
+  g_free (normalized);
+
+  return matched;
+}
+
 
+
+/**
+ * thunar_util_search_matcher_match_normalized:
+ * @matcher: a #ThunarSearchMatcher.
+ * @str: The string which the search terms might be found in.
+ *
+ * Like thunar_util_search_matcher_match(), but @str must already be
+ * normalized with thunar_g_utf8_normalize_for_search().
+ *
+ * Return value: TRUE if all terms matched, FALSE otherwise.
+ **/
 gboolean
-thunar_util_search_terms_match (gchar **terms,
-                                gchar  *str)
+thunar_util_search_matcher_match_normalized (const ThunarSearchMatcher *matcher,
+                                             const gchar               *str)
 {
-  for (gint i = 0; terms[i] != NULL; i++)
-    if (g_strrstr (str, terms[i]) == NULL)
-      return FALSE;
-  return TRUE;
+  if (str == NULL)
+    return FALSE;
+
+  return thunar_util_search_matcher_match_len (matcher, str, strlen (str), FALSE);
+}
+
+
+
+/**
+ * thunar_util_search_matcher_get_terms:
+ * @matcher: a #ThunarSearchMatcher.
+ *
+ * Return value: (transfer none): the distinct, non-empty search terms of @matcher.
+ **/
+const gchar *const *
+thunar_util_search_matcher_get_terms (const ThunarSearchMatcher *matcher)
+{
+  return (const gchar *const *) matcher->terms;
+}
+
+
+
+/**
+ * thunar_util_search_matcher_free:
+ * @matcher: a #ThunarSearchMatcher.
+ *
+ * Releases @matcher.
+ **/
+void
+thunar_util_search_matcher_free (ThunarSearchMatcher *matcher)
+{
+  if (matcher == NULL)
+    return;
+
+  g_strfreev (matcher->terms);
+  g_free (matcher->lengths);
+  g_free (matcher);
 }
 
 
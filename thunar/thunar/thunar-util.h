@@ -45,6 +45,8 @@ typedef enum
   THUNAR_NEXT_FILE_NAME_MODE_LINK,
 } ThunarNextFileNameMode;
 
+typedef struct _ThunarSearchMatcher ThunarSearchMatcher;
+
 typedef void (*ThunarBookmarksFunc) (GFile       *file,
                                      const gchar *name,
                                      gint         row_num,
@@ -114,9 +116,18 @@ thunar_util_clip_view_background (GtkCellRenderer     *cell,
 gchar **
 thunar_util_split_search_query (const gchar *search_query_normalized,
                                 GError     **error);
+ThunarSearchMatcher *
+thunar_util_search_matcher_new (gchar **terms);
+gboolean
+thunar_util_search_matcher_match (const ThunarSearchMatcher *matcher,
+                                  const gchar               *str);
 gboolean
-thunar_util_search_terms_match (gchar **terms,
-                                gchar  *str);
+thunar_util_search_matcher_match_normalized (const ThunarSearchMatcher *matcher,
+                                             const gchar               *str);
+const gchar *const *
+thunar_util_search_matcher_get_terms (const ThunarSearchMatcher *matcher);
+void
+thunar_util_search_matcher_free (ThunarSearchMatcher *matcher);
 gboolean
 thunar_util_save_geometry_timer (gpointer user_data);
 gchar *
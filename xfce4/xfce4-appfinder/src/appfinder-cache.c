@@ -0,0 +1,839 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include <src/appfinder-cache.h>
+#include <src/appfinder-private.h>
+
+
+
+/*
+ * The menu cache holds the parsed desktop entries and categories from the
+ * last time the menu was loaded, so the first window can be filled before
+ * garcon has loaded the menu. It is a single mapped file:
+ *
+ *   CacheHeader
+ *   CacheDir[n_dirs]            directories and their mtimes when the
+ *                               cache was built
+ *   CacheCategory[n_categories]
+ *   CacheItem[n_items]
+ *   guint32[n_refs]             category indices of the items
+ *   gchar[strings_size]         nul-terminated strings, referenced by
+ *                               offset from the tables above
+ *
+ * The cache is out of date when one of the directories changed, or when
+ * the list of application and menu directories or the locale differs.
+ */
+#define CACHE_PATH       "xfce4/appfinder/menu-cache"
+#define CACHE_MAGIC      (0x43414658) /* XFAC */
+#define CACHE_VERSION    (1)
+#define STRING_NONE      (G_MAXUINT32)
+#define MAX_SUBDIR_DEPTH (4)
+
+/* number of string offsets at the start of the table entries */
+#define CATEGORY_N_STRINGS (sizeof (CacheCategory) / sizeof (guint32))
+#define ITEM_N_STRINGS     (G_STRUCT_OFFSET (CacheItem, flags) / sizeof (guint32))
+
+
+
+typedef struct
+{
+  guint32 magic;
+  guint32 version;
+  guint32 n_dirs;
+  guint32 n_categories;
+  guint32 n_items;
+  guint32 n_refs;
+  guint32 strings_size;
+  guint32 context;
+  gint64  ctime;
+}
+CacheHeader;
+
+enum
+{
+  DIR_TOP_LEVEL = 1 << 0,
+};
+
+typedef struct
+{
+  guint32 path;
+  guint32 flags;
+  gint64  mtime;
+}
+CacheDir;
+
+typedef struct
+{
+  guint32 file;
+  guint32 name;
+  guint32 comment;
+  guint32 icon_name;
+}
+CacheCategory;
+
+enum
+{
+  ITEM_REQUIRES_TERMINAL       = 1 << 0,
+  ITEM_STARTUP_NOTIFY          = 1 << 1,
+  ITEM_PREFERS_NON_DEFAULT_GPU = 1 << 2,
+  ITEM_NOT_VISIBLE             = 1 << 3,
+};
+
+typedef struct
+{
+  guint32 file;
+  guint32 desktop_id;
+  guint32 name;
+  guint32 generic_name;
+  guint32 comment;
+  guint32 icon_name;
+  guint32 command;
+  guint32 path;
+  guint32 categories; /* desktop entry categories, ; separated */
+  guint32 keywords;   /* ; separated */
+  guint32 key_basic;
+  guint32 key_extended;
+  guint32 flags;
+  guint32 first_ref;
+  guint32 n_refs;
+  guint32 padding;
+}
+CacheItem;
+
+struct _XfceAppfinderCache
+{
+  GMappedFile         *mmap;
+
+  const CacheCategory *categories;
+  guint32              n_categories;
+
+  const CacheItem     *items;
+  guint32              n_items;
+
+  const guint32       *refs;
+  guint32              n_refs;
+
+  const gchar         *strings;
+  guint32              strings_size;
+};
+
+struct _XfceAppfinderCacheBuilder
+{
+  GByteArray *strings;
+  GHashTable *string_offsets;
+  GArray     *dirs;
+  GArray     *categories;
+  GHashTable *category_indices;
+  GArray     *items;
+  GArray     *refs;
+  gint64      ctime;
+};
+
+
+
+static gchar *
+xfce_appfinder_cache_get_context (void)
+{
+  const gchar *prefix = g_getenv ("XDG_MENU_PREFIX");
+  const gchar *desktop = g_getenv ("XDG_CURRENT_DESKTOP");
+
+  /* the names are translated and the menu and visibility of the items
+   * depend on the desktop environment */
+  return g_strdup_printf ("%s|%s|%s", g_get_language_names ()[0],
+                          prefix != NULL ? prefix : "",
+                          desktop != NULL ? desktop : "");
+}
+
+
+
+static GPtrArray *
+xfce_appfinder_cache_get_directories (void)
+{
+  GPtrArray           *directories;
+  const gchar * const *dirs;
+
+  directories = g_ptr_array_new_with_free_func (g_free);
+
+  g_ptr_array_add (directories, g_build_filename (g_get_user_data_dir (), "applications", NULL));
+  g_ptr_array_add (directories, g_build_filename (g_get_user_data_dir (), "desktop-directories", NULL));
+  for (dirs = g_get_system_data_dirs (); *dirs != NULL; dirs++)
+    {
+      g_ptr_array_add (directories, g_build_filename (*dirs, "applications", NULL));
+      g_ptr_array_add (directories, g_build_filename (*dirs, "desktop-directories", NULL));
+    }
+
+  g_ptr_array_add (directories, g_build_filename (g_get_user_config_dir (), "menus", NULL));
+  for (dirs = g_get_system_config_dirs (); *dirs != NULL; dirs++)
+    g_ptr_array_add (directories, g_build_filename (*dirs, "menus", NULL));
+
+  return directories;
+}
+
+
+
+static gint64
+xfce_appfinder_cache_get_mtime (const gchar *path)
+{
+  GStatBuf st;
+
+  /* 0 for directories that do not exist */
+  if (g_stat (path, &st) != 0)
+    return 0;
+
+  return st.st_mtime;
+}
+
+
+
+static inline const gchar *
+xfce_appfinder_cache_string (const XfceAppfinderCache *cache,
+                             guint32                   offset)
+{
+  return offset == STRING_NONE ? NULL : cache->strings + offset;
+}
+
+
+
+static gboolean
+xfce_appfinder_cache_check_strings (const XfceAppfinderCache *cache,
+                                    const guint32            *offsets,
+                                    guint                     n_offsets)
+{
+  guint i;
+
+  for (i = 0; i < n_offsets; i++)
+    if (offsets[i] != STRING_NONE && offsets[i] >= cache->strings_size)
+      return FALSE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+xfce_appfinder_cache_check (XfceAppfinderCache *cache)
+{
+  const gchar       *contents;
+  gsize              length;
+  const CacheHeader *header;
+  const CacheDir    *dirs;
+  const CacheItem   *item;
+  GPtrArray         *directories;
+  const gchar       *path;
+  guint64            size;
+  gint64             mtime;
+  gchar             *context;
+  guint32            i;
+  guint              n_top_level = 0;
+  gboolean           is_current;
+
+  contents = g_mapped_file_get_contents (cache->mmap);
+  length = g_mapped_file_get_length (cache->mmap);
+  if (contents == NULL || length < sizeof (CacheHeader))
+    return FALSE;
+
+  header = (const CacheHeader *) contents;
+  if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION)
+    return FALSE;
+
+  size = sizeof (CacheHeader)
+         + (guint64) header->n_dirs * sizeof (CacheDir)
+         + (guint64) header->n_categories * sizeof (CacheCategory)
+         + (guint64) header->n_items * sizeof (CacheItem)
+         + (guint64) header->n_refs * sizeof (guint32)
+         + header->strings_size;
+  if (size != length || header->strings_size == 0)
+    return FALSE;
+
+  dirs = (const CacheDir *) (header + 1);
+  cache->categories = (const CacheCategory *) (dirs + header->n_dirs);
+  cache->n_categories = header->n_categories;
+  cache->items = (const CacheItem *) (cache->categories + header->n_categories);
+  cache->n_items = header->n_items;
+  cache->refs = (const guint32 *) (cache->items + header->n_items);
+  cache->n_refs = header->n_refs;
+  cache->strings = (const gchar *) (cache->refs + header->n_refs);
+  cache->strings_size = header->strings_size;
+
+  /* make sure nothing points outside the file */
+  if (cache->strings[cache->strings_size - 1] != '\0'
+      || !xfce_appfinder_cache_check_strings (cache, &header->context, 1))
+    return FALSE;
+
+  for (i = 0; i < header->n_dirs; i++)
+    if (dirs[i].path == STRING_NONE
+        || !xfce_appfinder_cache_check_strings (cache, &dirs[i].path, 1))
+      return FALSE;
+
+  for (i = 0; i < cache->n_categories; i++)
+    if (cache->categories[i].file == STRING_NONE
+        || !xfce_appfinder_cache_check_strings (cache, (const guint32 *) &cache->categories[i], CATEGORY_N_STRINGS))
+      return FALSE;
+
+  for (i = 0; i < cache->n_items; i++)
+    {
+      item = &cache->items[i];
+      if (item->file == STRING_NONE
+          || item->desktop_id == STRING_NONE
+          || item->name == STRING_NONE
+          || !xfce_appfinder_cache_check_strings (cache, (const guint32 *) item, ITEM_N_STRINGS)
+          || (guint64) item->first_ref + item->n_refs > cache->n_refs)
+        return FALSE;
+    }
+
+  for (i = 0; i < cache->n_refs; i++)
+    if (cache->refs[i] >= cache->n_categories)
+      return FALSE;
+
+  /* check if the cache was built for this environment */
+  context = xfce_appfinder_cache_get_context ();
+  is_current = g_strcmp0 (xfce_appfinder_cache_string (cache, header->context), context) == 0;
+  g_free (context);
+
+  directories = xfce_appfinder_cache_get_directories ();
+  for (i = 0; is_current && i < header->n_dirs; i++)
+    {
+      path = xfce_appfinder_cache_string (cache, dirs[i].path);
+
+      if ((dirs[i].flags & DIR_TOP_LEVEL) != 0)
+        {
+          if (n_top_level >= directories->len
+              || strcmp (g_ptr_array_index (directories, n_top_level), path) != 0)
+            is_current = FALSE;
+          n_top_level++;
+        }
+
+      /* a directory changed in the second the cache was built might
+       * have changed after it was scanned */
+      mtime = xfce_appfinder_cache_get_mtime (path);
+      if (mtime != dirs[i].mtime || mtime >= header->ctime)
+        {
+          APPFINDER_DEBUG ("menu cache: %s changed", path);
+          is_current = FALSE;
+        }
+    }
+
+  if (n_top_level != directories->len)
+    is_current = FALSE;
+  g_ptr_array_unref (directories);
+
+  return is_current;
+}
+
+
+
+XfceAppfinderCache *
+xfce_appfinder_cache_load (void)
+{
+  XfceAppfinderCache *cache;
+  GMappedFile        *mmap;
+  gchar              *filename;
+  GError             *error = NULL;
+
+  filename = xfce_resource_lookup (XFCE_RESOURCE_CACHE, CACHE_PATH);
+  if (filename == NULL)
+    return NULL;
+
+  mmap = g_mapped_file_new (filename, FALSE, &error);
+  if (G_UNLIKELY (mmap == NULL))
+    {
+      g_warning ("Failed to open menu cache: %s", error->message);
+      g_error_free (error);
+      g_free (filename);
+      return NULL;
+    }
+
+  cache = g_slice_new0 (XfceAppfinderCache);
+  cache->mmap = mmap;
+
+  if (!xfce_appfinder_cache_check (cache))
+    {
+      APPFINDER_DEBUG ("menu cache %s is out of date", filename);
+      xfce_appfinder_cache_free (cache);
+      cache = NULL;
+    }
+
+  g_free (filename);
+
+  return cache;
+}
+
+
+
+void
+xfce_appfinder_cache_free (XfceAppfinderCache *cache)
+{
+  if (cache == NULL)
+    return;
+
+  g_mapped_file_unref (cache->mmap);
+  g_slice_free (XfceAppfinderCache, cache);
+}
+
+
+
+guint
+xfce_appfinder_cache_get_n_categories (const XfceAppfinderCache *cache)
+{
+  appfinder_return_val_if_fail (cache != NULL, 0);
+  return cache->n_categories;
+}
+
+
+
+GarconMenuDirectory *
+xfce_appfinder_cache_get_category (const XfceAppfinderCache *cache,
+                                   guint                     n)
+{
+  const CacheCategory *category;
+  GarconMenuDirectory *directory;
+  GFile               *file;
+  const gchar         *value;
+
+  appfinder_return_val_if_fail (cache != NULL, NULL);
+  appfinder_return_val_if_fail (n < cache->n_categories, NULL);
+
+  category = &cache->categories[n];
+
+  file = g_file_new_for_uri (xfce_appfinder_cache_string (cache, category->file));
+  directory = g_object_new (GARCON_TYPE_MENU_DIRECTORY, "file", file, NULL);
+  g_object_unref (G_OBJECT (file));
+
+  value = xfce_appfinder_cache_string (cache, category->name);
+  if (value != NULL)
+    garcon_menu_directory_set_name (directory, value);
+
+  value = xfce_appfinder_cache_string (cache, category->comment);
+  if (value != NULL)
+    garcon_menu_directory_set_comment (directory, value);
+
+  value = xfce_appfinder_cache_string (cache, category->icon_name);
+  if (value != NULL)
+    garcon_menu_directory_set_icon_name (directory, value);
+
+  return directory;
+}
+
+
+
+guint
+xfce_appfinder_cache_get_n_items (const XfceAppfinderCache *cache)
+{
+  appfinder_return_val_if_fail (cache != NULL, 0);
+  return cache->n_items;
+}
+
+
+
+static GList *
+xfce_appfinder_cache_split (const gchar *value)
+{
+  gchar **strings;
+  GList  *list = NULL;
+  guint   i;
+
+  if (value == NULL)
+    return NULL;
+
+  strings = g_strsplit (value, ";", -1);
+  for (i = 0; strings[i] != NULL; i++)
+    list = g_list_prepend (list, strings[i]);
+  g_free (strings);
+
+  return g_list_reverse (list);
+}
+
+
+
+GarconMenuItem *
+xfce_appfinder_cache_get_item (const XfceAppfinderCache  *cache,
+                               guint                      n,
+                               const gchar              **key_basic,
+                               const gchar              **key_extended,
+                               const guint32            **categories,
+                               guint                     *n_categories)
+{
+  const CacheItem *item;
+  GarconMenuItem  *menu_item;
+  GFile           *file;
+  const gchar     *value;
+
+  appfinder_return_val_if_fail (cache != NULL, NULL);
+  appfinder_return_val_if_fail (n < cache->n_items, NULL);
+
+  item = &cache->items[n];
+
+  /* build the item from the cached values instead of parsing the file */
+  file = g_file_new_for_uri (xfce_appfinder_cache_string (cache, item->file));
+  menu_item = g_object_new (GARCON_TYPE_MENU_ITEM, "file", file, NULL);
+  g_object_unref (G_OBJECT (file));
+
+  garcon_menu_item_set_desktop_id (menu_item, xfce_appfinder_cache_string (cache, item->desktop_id));
+  garcon_menu_item_set_name (menu_item, xfce_appfinder_cache_string (cache, item->name));
+
+  value = xfce_appfinder_cache_string (cache, item->generic_name);
+  if (value != NULL)
+    garcon_menu_item_set_generic_name (menu_item, value);
+
+  value = xfce_appfinder_cache_string (cache, item->comment);
+  if (value != NULL)
+    garcon_menu_item_set_comment (menu_item, value);
+
+  value = xfce_appfinder_cache_string (cache, item->icon_name);
+  if (value != NULL)
+    garcon_menu_item_set_icon_name (menu_item, value);
+
+  value = xfce_appfinder_cache_string (cache, item->command);
+  if (value != NULL)
+    garcon_menu_item_set_command (menu_item, value);
+
+  value = xfce_appfinder_cache_string (cache, item->path);
+  if (value != NULL)
+    garcon_menu_item_set_path (menu_item, value);
+
+  /* the lists are owned by the item */
+  garcon_menu_item_set_categories (menu_item,
+      xfce_appfinder_cache_split (xfce_appfinder_cache_string (cache, item->categories)));
+  garcon_menu_item_set_keywords (menu_item,
+      xfce_appfinder_cache_split (xfce_appfinder_cache_string (cache, item->keywords)));
+
+  garcon_menu_item_set_requires_terminal (menu_item, (item->flags & ITEM_REQUIRES_TERMINAL) != 0);
+  garcon_menu_item_set_supports_startup_notification (menu_item, (item->flags & ITEM_STARTUP_NOTIFY) != 0);
+  garcon_menu_item_set_prefers_non_default_gpu (menu_item, (item->flags & ITEM_PREFERS_NON_DEFAULT_GPU) != 0);
+
+  /* OnlyShowIn, TryExec and friends are not cached, only the outcome */
+  garcon_menu_item_set_no_display (menu_item, (item->flags & ITEM_NOT_VISIBLE) != 0);
+
+  if (key_basic != NULL)
+    *key_basic = xfce_appfinder_cache_string (cache, item->key_basic);
+  if (key_extended != NULL)
+    *key_extended = xfce_appfinder_cache_string (cache, item->key_extended);
+  if (categories != NULL)
+    *categories = cache->refs + item->first_ref;
+  if (n_categories != NULL)
+    *n_categories = item->n_refs;
+
+  return menu_item;
+}
+
+
+
+static guint32
+xfce_appfinder_cache_builder_string (XfceAppfinderCacheBuilder *builder,
+                                     const gchar               *string)
+{
+  gpointer offset;
+
+  if (string == NULL)
+    return STRING_NONE;
+
+  /* offsets are stored + 1 in the table to tell them from NULL */
+  offset = g_hash_table_lookup (builder->string_offsets, string);
+  if (offset == NULL)
+    {
+      offset = GUINT_TO_POINTER (builder->strings->len + 1);
+      g_byte_array_append (builder->strings, (const guint8 *) string, strlen (string) + 1);
+      g_hash_table_insert (builder->string_offsets, g_strdup (string), offset);
+    }
+
+  return GPOINTER_TO_UINT (offset) - 1;
+}
+
+
+
+static gchar *
+xfce_appfinder_cache_builder_join (GList *list)
+{
+  GString *str;
+  GList   *li;
+
+  if (list == NULL)
+    return NULL;
+
+  str = g_string_new (NULL);
+  for (li = list; li != NULL; li = li->next)
+    {
+      if (li != list)
+        g_string_append_c (str, ';');
+      g_string_append (str, li->data);
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+
+
+static void
+xfce_appfinder_cache_builder_add_directory (XfceAppfinderCacheBuilder *builder,
+                                            const gchar               *path,
+                                            guint32                    flags,
+                                            guint                      depth)
+{
+  CacheDir     dir;
+  GDir        *gdir;
+  const gchar *name;
+  gchar       *subdir;
+
+  dir.path = xfce_appfinder_cache_builder_string (builder, path);
+  dir.flags = flags;
+  dir.mtime = xfce_appfinder_cache_get_mtime (path);
+  g_array_append_val (builder->dirs, dir);
+
+  if (dir.mtime == 0 || depth >= MAX_SUBDIR_DEPTH)
+    return;
+
+  /* desktop files in subdirectories are found by garcon too, and adding
+   * or removing them only changes the mtime of the subdirectory */
+  gdir = g_dir_open (path, 0, NULL);
+  if (gdir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (gdir)) != NULL)
+    {
+      /* don't stat all the files */
+      if (g_str_has_suffix (name, ".desktop")
+          || g_str_has_suffix (name, ".directory")
+          || g_str_has_suffix (name, ".menu"))
+        continue;
+
+      subdir = g_build_filename (path, name, NULL);
+      if (g_file_test (subdir, G_FILE_TEST_IS_DIR))
+        xfce_appfinder_cache_builder_add_directory (builder, subdir, 0, depth + 1);
+      g_free (subdir);
+    }
+
+  g_dir_close (gdir);
+}
+
+
+
+/* call this before loading the menu, so changes made while the menu
+ * is loaded make the cache out of date */
+XfceAppfinderCacheBuilder *
+xfce_appfinder_cache_builder_new (void)
+{
+  XfceAppfinderCacheBuilder *builder;
+  GPtrArray                 *directories;
+  guint                      i;
+
+  builder = g_slice_new0 (XfceAppfinderCacheBuilder);
+  builder->strings = g_byte_array_sized_new (64 * 1024);
+  builder->string_offsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  builder->dirs = g_array_new (FALSE, FALSE, sizeof (CacheDir));
+  builder->categories = g_array_new (FALSE, FALSE, sizeof (CacheCategory));
+  builder->category_indices = g_hash_table_new (g_direct_hash, g_direct_equal);
+  builder->items = g_array_new (FALSE, FALSE, sizeof (CacheItem));
+  builder->refs = g_array_new (FALSE, FALSE, sizeof (guint32));
+  builder->ctime = g_get_real_time () / G_USEC_PER_SEC;
+
+  directories = xfce_appfinder_cache_get_directories ();
+  for (i = 0; i < directories->len; i++)
+    xfce_appfinder_cache_builder_add_directory (builder, g_ptr_array_index (directories, i),
+                                                DIR_TOP_LEVEL, 0);
+  g_ptr_array_unref (directories);
+
+  return builder;
+}
+
+
+
+guint
+xfce_appfinder_cache_builder_add_category (XfceAppfinderCacheBuilder *builder,
+                                           GarconMenuDirectory       *directory)
+{
+  CacheCategory  category;
+  gpointer       idx;
+  GFile         *file;
+  gchar         *uri;
+
+  appfinder_return_val_if_fail (builder != NULL, 0);
+  appfinder_return_val_if_fail (GARCON_IS_MENU_DIRECTORY (directory), 0);
+
+  idx = g_hash_table_lookup (builder->category_indices, directory);
+  if (idx != NULL)
+    return GPOINTER_TO_UINT (idx) - 1;
+
+  file = garcon_menu_directory_get_file (directory);
+  uri = g_file_get_uri (file);
+  g_object_unref (G_OBJECT (file));
+
+  category.file = xfce_appfinder_cache_builder_string (builder, uri);
+  category.name = xfce_appfinder_cache_builder_string (builder, garcon_menu_directory_get_name (directory));
+  category.comment = xfce_appfinder_cache_builder_string (builder, garcon_menu_directory_get_comment (directory));
+  category.icon_name = xfce_appfinder_cache_builder_string (builder, garcon_menu_directory_get_icon_name (directory));
+  g_array_append_val (builder->categories, category);
+  g_free (uri);
+
+  g_hash_table_insert (builder->category_indices, directory,
+                       GUINT_TO_POINTER (builder->categories->len));
+
+  return builder->categories->len - 1;
+}
+
+
+
+void
+xfce_appfinder_cache_builder_add_item (XfceAppfinderCacheBuilder *builder,
+                                       GarconMenuItem            *item,
+                                       const gchar               *key_basic,
+                                       const gchar               *key_extended,
+                                       const guint               *categories,
+                                       guint                      n_categories)
+{
+  CacheItem  cache_item = { 0, };
+  GFile     *file;
+  gchar     *value;
+  guint32    ref;
+  guint      i;
+
+  appfinder_return_if_fail (builder != NULL);
+  appfinder_return_if_fail (GARCON_IS_MENU_ITEM (item));
+
+  if (garcon_menu_item_get_desktop_id (item) == NULL
+      || garcon_menu_item_get_name (item) == NULL)
+    return;
+
+  file = garcon_menu_item_get_file (item);
+  value = g_file_get_uri (file);
+  cache_item.file = xfce_appfinder_cache_builder_string (builder, value);
+  g_object_unref (G_OBJECT (file));
+  g_free (value);
+
+  cache_item.desktop_id = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_desktop_id (item));
+  cache_item.name = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_name (item));
+  cache_item.generic_name = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_generic_name (item));
+  cache_item.comment = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_comment (item));
+  cache_item.icon_name = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_icon_name (item));
+  cache_item.command = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_command (item));
+  cache_item.path = xfce_appfinder_cache_builder_string (builder, garcon_menu_item_get_path (item));
+  cache_item.key_basic = xfce_appfinder_cache_builder_string (builder, key_basic);
+  cache_item.key_extended = xfce_appfinder_cache_builder_string (builder, key_extended);
+
+  value = xfce_appfinder_cache_builder_join (garcon_menu_item_get_categories (item));
+  cache_item.categories = xfce_appfinder_cache_builder_string (builder, value);
+  g_free (value);
+
+  value = xfce_appfinder_cache_builder_join (garcon_menu_item_get_keywords (item));
+  cache_item.keywords = xfce_appfinder_cache_builder_string (builder, value);
+  g_free (value);
+
+  if (garcon_menu_item_requires_terminal (item))
+    cache_item.flags |= ITEM_REQUIRES_TERMINAL;
+  if (garcon_menu_item_supports_startup_notification (item))
+    cache_item.flags |= ITEM_STARTUP_NOTIFY;
+  if (garcon_menu_item_get_prefers_non_default_gpu (item))
+    cache_item.flags |= ITEM_PREFERS_NON_DEFAULT_GPU;
+  if (!garcon_menu_element_get_visible (GARCON_MENU_ELEMENT (item)))
+    cache_item.flags |= ITEM_NOT_VISIBLE;
+
+  cache_item.first_ref = builder->refs->len;
+  cache_item.n_refs = n_categories;
+  for (i = 0; i < n_categories; i++)
+    {
+      ref = categories[i];
+      g_array_append_val (builder->refs, ref);
+    }
+
+  g_array_append_val (builder->items, cache_item);
+}
+
+
+
+gboolean
+xfce_appfinder_cache_builder_save (XfceAppfinderCacheBuilder  *builder,
+                                   GError                    **error)
+{
+  CacheHeader  header = { 0, };
+  GByteArray  *contents;
+  gchar       *context;
+  gchar       *filename;
+  gboolean     succeed;
+
+  appfinder_return_val_if_fail (builder != NULL, FALSE);
+  appfinder_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  filename = xfce_resource_save_location (XFCE_RESOURCE_CACHE, CACHE_PATH, TRUE);
+  if (G_UNLIKELY (filename == NULL))
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "Unable to create cache location %s", CACHE_PATH);
+      return FALSE;
+    }
+
+  context = xfce_appfinder_cache_get_context ();
+
+  header.magic = CACHE_MAGIC;
+  header.version = CACHE_VERSION;
+  header.n_dirs = builder->dirs->len;
+  header.n_categories = builder->categories->len;
+  header.n_items = builder->items->len;
+  header.n_refs = builder->refs->len;
+  header.context = xfce_appfinder_cache_builder_string (builder, context);
+  header.strings_size = builder->strings->len;
+  header.ctime = builder->ctime;
+
+  contents = g_byte_array_sized_new (sizeof (header)
+                                     + builder->dirs->len * sizeof (CacheDir)
+                                     + builder->categories->len * sizeof (CacheCategory)
+                                     + builder->items->len * sizeof (CacheItem)
+                                     + builder->refs->len * sizeof (guint32)
+                                     + builder->strings->len);
+  g_byte_array_append (contents, (const guint8 *) &header, sizeof (header));
+  g_byte_array_append (contents, (const guint8 *) builder->dirs->data, builder->dirs->len * sizeof (CacheDir));
+  g_byte_array_append (contents, (const guint8 *) builder->categories->data, builder->categories->len * sizeof (CacheCategory));
+  g_byte_array_append (contents, (const guint8 *) builder->items->data, builder->items->len * sizeof (CacheItem));
+  g_byte_array_append (contents, (const guint8 *) builder->refs->data, builder->refs->len * sizeof (guint32));
+  g_byte_array_append (contents, builder->strings->data, builder->strings->len);
+
+  /* written to a temporary file and renamed, a running appfinder
+   * may have the old cache mapped */
+  succeed = g_file_set_contents (filename, (const gchar *) contents->data, contents->len, error);
+
+  APPFINDER_DEBUG ("saved %u items in menu cache %s", header.n_items, filename);
+
+  g_byte_array_unref (contents);
+  g_free (context);
+  g_free (filename);
+
+  return succeed;
+}
+
+
+
+void
+xfce_appfinder_cache_builder_free (XfceAppfinderCacheBuilder *builder)
+{
+  if (builder == NULL)
+    return;
+
+  g_byte_array_unref (builder->strings);
+  g_hash_table_destroy (builder->string_offsets);
+  g_array_free (builder->dirs, TRUE);
+  g_array_free (builder->categories, TRUE);
+  g_hash_table_destroy (builder->category_indices);
+  g_array_free (builder->items, TRUE);
+  g_array_free (builder->refs, TRUE);
+  g_slice_free (XfceAppfinderCacheBuilder, builder);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __XFCE_APPFINDER_CACHE_H__
+#define __XFCE_APPFINDER_CACHE_H__
+
+#include <garcon/garcon.h>
+
+G_BEGIN_DECLS
+
+typedef struct _XfceAppfinderCache        XfceAppfinderCache;
+typedef struct _XfceAppfinderCacheBuilder XfceAppfinderCacheBuilder;
+
+
+
+XfceAppfinderCache        *xfce_appfinder_cache_load                 (void);
+
+void                       xfce_appfinder_cache_free                 (XfceAppfinderCache         *cache);
+
+guint                      xfce_appfinder_cache_get_n_categories     (const XfceAppfinderCache   *cache);
+
+GarconMenuDirectory       *xfce_appfinder_cache_get_category         (const XfceAppfinderCache   *cache,
+                                                                      guint                       n);
+
+guint                      xfce_appfinder_cache_get_n_items          (const XfceAppfinderCache   *cache);
+
+GarconMenuItem            *xfce_appfinder_cache_get_item             (const XfceAppfinderCache   *cache,
+                                                                      guint                       n,
+                                                                      const gchar               **key_basic,
+                                                                      const gchar               **key_extended,
+                                                                      const guint32             **categories,
+                                                                      guint                      *n_categories);
+
+XfceAppfinderCacheBuilder *xfce_appfinder_cache_builder_new          (void);
+
+guint                      xfce_appfinder_cache_builder_add_category (XfceAppfinderCacheBuilder  *builder,
+                                                                      GarconMenuDirectory        *directory);
+
+void                       xfce_appfinder_cache_builder_add_item     (XfceAppfinderCacheBuilder  *builder,
+                                                                      GarconMenuItem             *item,
+                                                                      const gchar                *key_basic,
+                                                                      const gchar                *key_extended,
+                                                                      const guint                *categories,
+                                                                      guint                       n_categories);
+
+gboolean                   xfce_appfinder_cache_builder_save         (XfceAppfinderCacheBuilder  *builder,
+                                                                      GError                    **error);
+
+void                       xfce_appfinder_cache_builder_free         (XfceAppfinderCacheBuilder  *builder);
+
+G_END_DECLS
+
+#endif /* !__XFCE_APPFINDER_CACHE_H__ */
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <src/appfinder-matcher.h>
+#include <src/appfinder-private.h>
+
+
+
+struct _XfceAppfinderMatcher
+{
+  gchar  *token;
+  gsize   length;
+
+  /* index of the last ascii uppercase character in the token, the tail of
+   * a fuzzy split is compared caseless if it does not contain any */
+  gssize  last_upper;
+};
+
+
+
+static const gchar *
+xfce_appfinder_matcher_find (const gchar *haystack,
+                             const gchar *needle,
+                             gsize        length,
+                             gboolean     caseless)
+{
+  const gchar *p;
+
+  if (G_UNLIKELY (length == 0))
+    return haystack;
+
+  if (!caseless)
+    {
+      for (p = strchr (haystack, *needle); p != NULL; p = strchr (p + 1, *needle))
+        if (strncmp (p, needle, length) == 0)
+          return p;
+
+      return NULL;
+    }
+
+  for (p = haystack; *p != '\0'; p++)
+    if (g_ascii_tolower (*p) == g_ascii_tolower (*needle)
+        && g_ascii_strncasecmp (p, needle, length) == 0)
+      return p;
+
+  return NULL;
+}
+
+
+
+static inline gboolean
+xfce_appfinder_matcher_is_word_start (const gchar *source,
+                                      const gchar *p)
+{
+  return p == source || ((guchar) p[-1] < 0x80 && !g_ascii_isalnum (p[-1]));
+}
+
+
+
+XfceAppfinderMatcher *
+xfce_appfinder_matcher_new (const gchar *token)
+{
+  XfceAppfinderMatcher *matcher;
+  gsize                 i;
+
+  appfinder_return_val_if_fail (token != NULL, NULL);
+
+  matcher = g_slice_new (XfceAppfinderMatcher);
+  matcher->token = g_strdup (token);
+  matcher->length = strlen (token);
+  matcher->last_upper = -1;
+
+  for (i = 0; i < matcher->length; i++)
+    if (g_ascii_isupper (token[i]))
+      matcher->last_upper = i;
+
+  APPFINDER_DEBUG ("matcher compiled for \"%s\"", token);
+
+  return matcher;
+}
+
+
+
+void
+xfce_appfinder_matcher_free (XfceAppfinderMatcher *matcher)
+{
+  if (matcher == NULL)
+    return;
+
+  g_free (matcher->token);
+  g_slice_free (XfceAppfinderMatcher, matcher);
+}
+
+
+
+const gchar *
+xfce_appfinder_matcher_get_token (const XfceAppfinderMatcher *matcher)
+{
+  appfinder_return_val_if_fail (matcher != NULL, NULL);
+  return matcher->token;
+}
+
+
+
+/*
+ * Scores source against the token, higher is better. A substring match
+ * ranks above any fuzzy match, better at the start of source or of a
+ * word, and the earlier the better.
+ *
+ * For fuzzy matching the token is split in a head and a tail, and the
+ * tail is looked up anywhere after the head, so "xterm" finds
+ * "xfce4-terminal". The head is matched case sensitive, the tail caseless
+ * unless it contains uppercase characters. Longer heads and shorter gaps
+ * score better.
+ */
+gint
+xfce_appfinder_matcher_score (const XfceAppfinderMatcher *matcher,
+                              const gchar                *source,
+                              gboolean                    fuzzy)
+{
+  const gchar *found;
+  const gchar *head;
+  const gchar *tail;
+  gsize        i;
+  gint         gap;
+  gint         score = XFCE_APPFINDER_MATCHER_NO_MATCH;
+
+  appfinder_return_val_if_fail (matcher != NULL, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  appfinder_return_val_if_fail (source != NULL, XFCE_APPFINDER_MATCHER_NO_MATCH);
+
+  if (matcher->length == 0)
+    return 0;
+
+  found = strstr (source, matcher->token);
+  if (found != NULL)
+    {
+      if (found == source)
+        return XFCE_APPFINDER_MATCHER_SCORE_MAX;
+
+      score = 512 - MIN (found - source, 255);
+      if (xfce_appfinder_matcher_is_word_start (source, found))
+        score += 256;
+
+      return score;
+    }
+
+  if (!fuzzy)
+    return XFCE_APPFINDER_MATCHER_NO_MATCH;
+
+  head = source;
+  for (i = 1; i < matcher->length; i++)
+    {
+      /* the first match of a longer head can't be before that of a shorter one */
+      head = xfce_appfinder_matcher_find (head, matcher->token, i, FALSE);
+      if (head == NULL)
+        break;
+
+      tail = xfce_appfinder_matcher_find (head + i, matcher->token + i,
+                                          matcher->length - i,
+                                          (gssize) i > matcher->last_upper);
+      if (tail != NULL)
+        {
+          gap = MIN (tail - (head + i), 127);
+          score = MAX (score, (gint) (128 * i / matcher->length) + 127 - gap);
+        }
+    }
+
+  return score;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __XFCE_APPFINDER_MATCHER_H__
+#define __XFCE_APPFINDER_MATCHER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _XfceAppfinderMatcher XfceAppfinderMatcher;
+
+/* substring matches score from 256 up to 1023, fuzzy matches below 256 */
+#define XFCE_APPFINDER_MATCHER_NO_MATCH  (-1)
+#define XFCE_APPFINDER_MATCHER_SCORE_MAX (1023)
+
+
+
+XfceAppfinderMatcher *xfce_appfinder_matcher_new       (const gchar                *token) G_GNUC_MALLOC;
+
+void                  xfce_appfinder_matcher_free      (XfceAppfinderMatcher       *matcher);
+
+const gchar          *xfce_appfinder_matcher_get_token (const XfceAppfinderMatcher *matcher);
+
+gint                  xfce_appfinder_matcher_score     (const XfceAppfinderMatcher *matcher,
+                                                        const gchar                *source,
+                                                        gboolean                    fuzzy);
+
+G_END_DECLS
+
+#endif /* !__XFCE_APPFINDER_MATCHER_H__ */
@@ -25,6 +25,8 @@
 #include <libxfce4util/libxfce4util.h>
 #include <libxfce4ui/libxfce4ui.h>
 
+#include <src/appfinder-cache.h>
+#include <src/appfinder-matcher.h>
 #include <src/appfinder-model.h>
 #include <src/appfinder-private.h>
 
@@ -99,11 +101,11 @@ static void               xfce_appfinder_model_bookmarks_monitor_stop (XfceAppfi
 static void               xfce_appfinder_model_bookmarks_monitor      (XfceAppfinderModel       *model,
                                                                        const gchar              *path);
 
-static gboolean           xfce_appfinder_model_fuzzy_match            (const gchar              *source,
-                                                                       const gchar              *token);
-static gboolean           xfce_appfinder_model_regular_match          (const gchar              *source1,
-                                                                       const gchar              *source2,
+static const XfceAppfinderMatcher *xfce_appfinder_model_get_matcher (XfceAppfinderMatcher    **matcher,
                                                                        const gchar              *token);
+static void               xfce_appfinder_model_filter_update          (XfceAppfinderModel       *model,
+                                                                       const gchar              *string,
+                                                                       const gchar              *string_casefold);
 static gint               xfce_appfinder_model_item_compare_frecency  (gconstpointer             a,
                                                                        gconstpointer             b,
                                                                        gpointer                  data);
@@ -150,6 +152,11 @@ struct _XfceAppfinderModel
   GThread               *collect_thread;
   GCancellable          *collect_cancelled;
 
+  /* menu loaded after the items from the cache were shown */
+  guint                  reload_idle_id;
+  GSList                *reload_items;
+  GSList                *reload_categories;
+
   GFileMonitor          *history_monitor;
   GFile                 *history_file;
   guint64                history_mtime;
@@ -161,6 +168,15 @@ struct _XfceAppfinderModel
   gint                   scale_factor;
 
   gboolean               generic_names;
+
+  /* compiled for the last filter string and its casefolded version */
+  XfceAppfinderMatcher  *matcher;
+  XfceAppfinderMatcher  *matcher_casefold;
+
+  /* last filter strings, the serial changes unless they are only extended */
+  gchar                 *filter_string;
+  gchar                 *filter_string_casefold;
+  guint                  filter_serial;
 };
 
 typedef struct
@@ -175,12 +191,17 @@ typedef struct
   GarconMenuItem  *item;
   gchar           *key_basic; /* app name and command, used for regular string and fuzzy matching */
   gchar           *key_extended; /* comments, generic name and keywords, used only for regular string matching */
+  gchar           *sort_key; /* title normalized and casefolded, built on the first sort */
   gchar           *abstract;
   GPtrArray       *categories;
   gchar           *command;
   gchar           *tooltip;
   guint            not_visible : 1;
   guint            is_bookmark : 1;
+  guint            from_cache : 1;
+  guint            needs_update : 1;
+  gint             match_score; /* rank of the last visibility check against the filter */
+  guint            filter_serial; /* model filter serial the filter string did not match in */
 
   Frecency        *frecency; /* owned by frecencies_hash */
 
@@ -284,6 +305,7 @@ xfce_appfinder_model_init (XfceAppfinderModel *model)
   model->command_category = xfce_appfinder_model_get_command_category ();
   model->collect_cancelled = g_cancellable_new ();
   model->generic_names = FALSE;
+  model->filter_serial = 1;
 
   model->menu = garcon_menu_new_applications ();
   appfinder_refcount_debug_add (G_OBJECT (model->menu), "main menu");
@@ -416,6 +438,13 @@ xfce_appfinder_model_finalize (GObject *object)
   if (G_UNLIKELY (model->menu_changed_idle_id != 0))
     g_source_remove (model->menu_changed_idle_id);
 
+  if (G_UNLIKELY (model->reload_idle_id != 0))
+    g_source_remove (model->reload_idle_id);
+  g_slist_foreach (model->reload_items, (GFunc) xfce_appfinder_model_item_free, NULL);
+  g_slist_free (model->reload_items);
+  g_slist_foreach (model->reload_categories, (GFunc) (void (*)(void)) g_object_unref, NULL);
+  g_slist_free (model->reload_categories);
+
   /* stop history file monitoring */
   xfce_appfinder_model_history_monitor_stop (model);
 
@@ -444,6 +473,11 @@ xfce_appfinder_model_finalize (GObject *object)
   cairo_surface_destroy (model->command_surface_large);
   g_object_unref (G_OBJECT (model->command_category));
 
+  xfce_appfinder_matcher_free (model->matcher);
+  xfce_appfinder_matcher_free (model->matcher_casefold);
+  g_free (model->filter_string);
+  g_free (model->filter_string_casefold);
+
   APPFINDER_DEBUG ("model finalized");
 
   (*G_OBJECT_CLASS (xfce_appfinder_model_parent_class)->finalize) (object);
@@ -478,6 +512,7 @@ xfce_appfinder_model_get_column_type (GtkTreeModel *tree_model,
     case XFCE_APPFINDER_MODEL_COLUMN_URI:
     case XFCE_APPFINDER_MODEL_COLUMN_COMMAND:
     case XFCE_APPFINDER_MODEL_COLUMN_TOOLTIP:
+    case XFCE_APPFINDER_MODEL_COLUMN_SORT_KEY:
       return G_TYPE_STRING;
 
     case XFCE_APPFINDER_MODEL_COLUMN_ICON:
@@ -493,6 +528,9 @@ xfce_appfinder_model_get_column_type (GtkTreeModel *tree_model,
     case XFCE_APPFINDER_MODEL_COLUMN_FREQUENCY:
       return G_TYPE_UINT;
 
+    case XFCE_APPFINDER_MODEL_COLUMN_SCORE:
+      return G_TYPE_INT;
+
     case XFCE_APPFINDER_MODEL_COLUMN_RECENCY:
       return G_TYPE_UINT64;
 
@@ -577,6 +615,7 @@ xfce_appfinder_model_get_value (GtkTreeModel *tree_model,
   GList               *categories, *li;
   gchar              **cat_arr;
   gchar               *cat_str;
+  gchar               *normalized;
   guint                i;
   GdkPixbuf           *pixbuf;
 
@@ -739,6 +778,31 @@ xfce_appfinder_model_get_value (GtkTreeModel *tree_model,
       g_value_set_pointer (value, garcon_menu_item_get_actions (item->item));
       break;
 
+    case XFCE_APPFINDER_MODEL_COLUMN_SCORE:
+      g_value_init (value, G_TYPE_INT);
+      g_value_set_int (value, item->match_score);
+      break;
+
+    case XFCE_APPFINDER_MODEL_COLUMN_SORT_KEY:
+      if (item->sort_key == NULL)
+        {
+          if (item->item != NULL)
+            name = xfce_appfinder_model_get_menu_item_name (model, item->item);
+          else
+            name = item->command;
+
+          if (name != NULL)
+            {
+              normalized = g_utf8_normalize (name, -1, G_NORMALIZE_ALL);
+              item->sort_key = g_utf8_casefold (normalized, -1);
+              g_free (normalized);
+            }
+        }
+
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_static_string (value, item->sort_key);
+      break;
+
     default:
       g_assert_not_reached ();
       break;
@@ -1061,7 +1125,9 @@ xfce_appfinder_model_item_key (GarconMenuItem *item,
 
 
 static ModelItem *
-xfce_appfinder_model_item_new (GarconMenuItem *menu_item)
+xfce_appfinder_model_item_new (GarconMenuItem *menu_item,
+                               const gchar    *key_basic,
+                               const gchar    *key_extended)
 {
   ModelItem   *item;
   const gchar *command, *p;
@@ -1084,8 +1150,17 @@ xfce_appfinder_model_item_new (GarconMenuItem *menu_item)
         item->command = g_strdup (command);
     }
 
-  item->key_basic = xfce_appfinder_model_item_key (menu_item, FALSE);
-  item->key_extended = xfce_appfinder_model_item_key (menu_item, TRUE);
+  /* the keys are stored in the menu cache */
+  if (key_basic != NULL && key_extended != NULL)
+    {
+      item->key_basic = g_strdup (key_basic);
+      item->key_extended = g_strdup (key_extended);
+    }
+  else
+    {
+      item->key_basic = xfce_appfinder_model_item_key (menu_item, FALSE);
+      item->key_extended = xfce_appfinder_model_item_key (menu_item, TRUE);
+    }
   item->not_visible = !garcon_menu_element_get_visible (GARCON_MENU_ELEMENT (menu_item));
 
   return item;
@@ -1112,7 +1187,7 @@ xfce_appfinder_model_item_changed (GarconMenuItem     *menu_item,
       item = li->data;
       if (item->item == menu_item)
         {
-          item_new = xfce_appfinder_model_item_new (menu_item);
+          item_new = xfce_appfinder_model_item_new (menu_item, NULL, NULL);
           if (item_new == NULL)
             {
               g_warning ("Failed to create new model item");
@@ -1193,6 +1268,7 @@ xfce_appfinder_model_item_free (gpointer            data,
   g_free (item->abstract);
   g_free (item->key_basic);
   g_free (item->key_extended);
+  g_free (item->sort_key);
   g_free (item->command);
   g_free (item->tooltip);
   g_slice_free (ModelItem, item);
@@ -1758,7 +1834,7 @@ xfce_appfinder_model_collect_item (const gchar    *desktop_id,
       if (garcon_menu_item_get_name (menu_item) == NULL)
         return;
 
-      item = xfce_appfinder_model_item_new (menu_item);
+      item = xfce_appfinder_model_item_new (menu_item, NULL, NULL);
       if (item == NULL)
         {
           g_warning ("Failed to create new model item");
@@ -1913,6 +1989,90 @@ xfce_appfinder_model_collect_menu (GarconMenu    *menu,
 
 
 
+static void
+xfce_appfinder_model_collect_cache (XfceAppfinderModel *model,
+                                    XfceAppfinderCache *cache)
+{
+  GPtrArray      *categories;
+  GarconMenuItem *menu_item;
+  ModelItem      *item;
+  const gchar    *key_basic, *key_extended;
+  const guint32  *refs;
+  guint           n_refs;
+  guint           i, j;
+
+  categories = g_ptr_array_new_with_free_func (g_object_unref);
+  for (i = 0; i < xfce_appfinder_cache_get_n_categories (cache); i++)
+    {
+      g_ptr_array_add (categories, xfce_appfinder_cache_get_category (cache, i));
+      model->collect_categories = g_slist_prepend (model->collect_categories,
+                                                   g_object_ref (g_ptr_array_index (categories, i)));
+    }
+
+  for (i = 0; i < xfce_appfinder_cache_get_n_items (cache); i++)
+    {
+      if (g_cancellable_is_cancelled (model->collect_cancelled))
+        break;
+
+      menu_item = xfce_appfinder_cache_get_item (cache, i, &key_basic, &key_extended, &refs, &n_refs);
+      item = xfce_appfinder_model_item_new (menu_item, key_basic, key_extended);
+      g_object_unref (G_OBJECT (menu_item));
+
+      item->from_cache = TRUE;
+      item->categories = g_ptr_array_new_with_free_func (g_object_unref);
+      for (j = 0; j < n_refs; j++)
+        g_ptr_array_add (item->categories, g_object_ref (g_ptr_array_index (categories, refs[j])));
+
+      model->collect_items = g_slist_prepend (model->collect_items, item);
+    }
+
+  g_ptr_array_unref (categories);
+}
+
+
+
+static void
+xfce_appfinder_model_cache_save (XfceAppfinderCacheBuilder *builder,
+                                 GSList                    *items,
+                                 GSList                    *categories)
+{
+  GArray    *indices;
+  GSList    *li;
+  ModelItem *item;
+  guint      i, idx;
+  GError    *error = NULL;
+
+  for (li = categories; li != NULL; li = li->next)
+    xfce_appfinder_cache_builder_add_category (builder, li->data);
+
+  indices = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (li = items; li != NULL; li = li->next)
+    {
+      item = li->data;
+      if (item->item == NULL)
+        continue;
+
+      g_array_set_size (indices, 0);
+      for (i = 0; item->categories != NULL && i < item->categories->len; i++)
+        {
+          idx = xfce_appfinder_cache_builder_add_category (builder, g_ptr_array_index (item->categories, i));
+          g_array_append_val (indices, idx);
+        }
+
+      xfce_appfinder_cache_builder_add_item (builder, item->item, item->key_basic, item->key_extended,
+                                             (const guint *) (gpointer) indices->data, indices->len);
+    }
+  g_array_free (indices, TRUE);
+
+  if (!xfce_appfinder_cache_builder_save (builder, &error))
+    {
+      g_warning ("Failed to save the menu cache: %s", error->message);
+      g_error_free (error);
+    }
+}
+
+
+
 static void
 xfce_appfinder_model_menu_changed_remove (gpointer key,
                                           gpointer value,
@@ -1936,29 +2096,52 @@ xfce_appfinder_model_menu_changed_remove (gpointer key,
 
 
 
-static gboolean
-xfce_appfinder_model_menu_changed_idle (gpointer data)
+static void
+xfce_appfinder_model_item_swap (XfceAppfinderModel *model,
+                                ModelItem          *item,
+                                ModelItem          *item_new)
+{
+  ModelItem tmp;
+
+  if (item->command != NULL)
+    g_hash_table_remove (model->items_hash, item->command);
+  g_signal_handlers_disconnect_by_func (G_OBJECT (item->item),
+      G_CALLBACK (xfce_appfinder_model_item_changed), model);
+
+  /* keep the state that does not come from the menu */
+  item_new->is_bookmark = item->is_bookmark;
+  item_new->frecency = item->frecency;
+
+  /* swap the contents, so the list link and iters stay valid */
+  tmp = *item;
+  *item = *item_new;
+  *item_new = tmp;
+  item->needs_update = TRUE;
+
+  if (G_LIKELY (item->command != NULL))
+    g_hash_table_insert (model->items_hash, item->command, item);
+  g_signal_connect (G_OBJECT (item->item), "changed",
+      G_CALLBACK (xfce_appfinder_model_item_changed), model);
+}
+
+
+
+static void
+xfce_appfinder_model_menu_merge (XfceAppfinderModel *model,
+                                 GSList             *collect_items,
+                                 GSList             *collect_categories)
 {
-  XfceAppfinderModel *model = XFCE_APPFINDER_MODEL (data);
-  GarconMenu         *menu = model->menu;
   GSList             *li, *lp;
   GHashTable         *old_items;
   ModelItem          *item;
   ModelItem          *old_item;
   const gchar        *desktop_id;
-  GSList             *collect_items = NULL;
-  GSList             *collect_categories = NULL;
   GSList             *tmp;
   guint               idx;
   GtkTreeIter         iter;
   GtkTreePath        *path;
   GSList             *old_li;
-  GError             *error = NULL;
-
-  appfinder_return_val_if_fail (GARCON_IS_MENU (menu), FALSE);
-  appfinder_return_val_if_fail (XFCE_IS_APPFINDER_MODEL (model), FALSE);
-
-  APPFINDER_DEBUG ("menu changed");
+  guint               n_updated = 0;
 
   /* add all the old items in a garcon database */
   old_items = g_hash_table_new (g_str_hash, g_str_equal);
@@ -1972,18 +2155,6 @@ xfce_appfinder_model_menu_changed_idle (gpointer data)
         }
     }
 
-  if (!garcon_menu_load (model->menu, NULL, &error))
-    {
-      g_warning ("Failed to reload the root menu: %s", error->message);
-      g_error_free (error);
-
-      model->menu_changed_idle_id = 0;
-
-      return FALSE;
-    }
-
-  xfce_appfinder_model_collect_menu (menu, NULL, &collect_items, &collect_categories);
-
   for (li = collect_items; li != NULL; li = li->next)
     {
       item = li->data;
@@ -2010,10 +2181,20 @@ xfce_appfinder_model_menu_changed_idle (gpointer data)
           /* remove from the table */
           g_hash_table_remove (old_items, desktop_id);
 
-          /* steal the categories */
-          g_ptr_array_unref (old_item->categories);
-          old_item->categories = item->categories;
-          item->categories = NULL;
+          if (old_item->from_cache)
+            {
+              /* replace the item built from the menu cache with the
+               * loaded one, the row changed signal is emitted below */
+              xfce_appfinder_model_item_swap (model, old_item, item);
+              n_updated++;
+            }
+          else
+            {
+              /* steal the categories */
+              g_ptr_array_unref (old_item->categories);
+              old_item->categories = item->categories;
+              item->categories = NULL;
+            }
 
           /* this is not interesting, since those items are also updated
            * by the GarconMenuItem::changed signal, so don't touch the
@@ -2056,6 +2237,23 @@ xfce_appfinder_model_menu_changed_idle (gpointer data)
   g_hash_table_foreach (old_items, xfce_appfinder_model_menu_changed_remove, model);
   g_hash_table_destroy (old_items);
 
+  if (n_updated > 0)
+    {
+      for (li = model->items, idx = 0; li != NULL; li = li->next, idx++)
+        {
+          item = li->data;
+          if (item->needs_update)
+            {
+              item->needs_update = FALSE;
+
+              path = gtk_tree_path_new_from_indices (idx, -1);
+              ITER_INIT (iter, model->stamp, li);
+              gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+              gtk_tree_path_free (path);
+            }
+        }
+    }
+
   /* update the new categories */
   collect_categories = g_slist_sort (collect_categories, xfce_appfinder_model_category_compare);
 
@@ -2068,6 +2266,43 @@ xfce_appfinder_model_menu_changed_idle (gpointer data)
 
   g_slist_foreach (tmp, (GFunc) (void (*)(void)) g_object_unref, NULL);
   g_slist_free (tmp);
+}
+
+
+
+static gboolean
+xfce_appfinder_model_menu_changed_idle (gpointer data)
+{
+  XfceAppfinderModel        *model = XFCE_APPFINDER_MODEL (data);
+  GarconMenu                *menu = model->menu;
+  GSList                    *collect_items = NULL;
+  GSList                    *collect_categories = NULL;
+  XfceAppfinderCacheBuilder *builder;
+  GError                    *error = NULL;
+
+  appfinder_return_val_if_fail (GARCON_IS_MENU (menu), FALSE);
+  appfinder_return_val_if_fail (XFCE_IS_APPFINDER_MODEL (model), FALSE);
+
+  APPFINDER_DEBUG ("menu changed");
+
+  builder = xfce_appfinder_cache_builder_new ();
+
+  if (!garcon_menu_load (model->menu, NULL, &error))
+    {
+      g_warning ("Failed to reload the root menu: %s", error->message);
+      g_error_free (error);
+
+      xfce_appfinder_cache_builder_free (builder);
+      model->menu_changed_idle_id = 0;
+
+      return FALSE;
+    }
+
+  xfce_appfinder_model_collect_menu (menu, NULL, &collect_items, &collect_categories);
+  xfce_appfinder_model_cache_save (builder, collect_items, collect_categories);
+  xfce_appfinder_cache_builder_free (builder);
+
+  xfce_appfinder_model_menu_merge (model, collect_items, collect_categories);
 
   model->menu_changed_idle_id = 0;
 
@@ -2076,6 +2311,36 @@ xfce_appfinder_model_menu_changed_idle (gpointer data)
 
 
 
+static gboolean
+xfce_appfinder_model_reload_idle (gpointer data)
+{
+  XfceAppfinderModel *model = XFCE_APPFINDER_MODEL (data);
+
+  appfinder_return_val_if_fail (XFCE_IS_APPFINDER_MODEL (model), FALSE);
+
+  /* the cached items have to be in the model first */
+  if (model->collect_idle_id != 0)
+    return TRUE;
+
+  APPFINDER_DEBUG ("replace the items from the menu cache");
+
+  xfce_appfinder_model_menu_merge (model, model->reload_items, model->reload_categories);
+  model->reload_items = NULL;
+  model->reload_categories = NULL;
+
+  return FALSE;
+}
+
+
+
+static void
+xfce_appfinder_model_reload_idle_destroy (gpointer user_data)
+{
+  XFCE_APPFINDER_MODEL (user_data)->reload_idle_id = 0;
+}
+
+
+
 static void
 xfce_appfinder_model_menu_changed (GarconMenu         *menu,
                                    XfceAppfinderModel *model)
@@ -2093,10 +2358,15 @@ xfce_appfinder_model_menu_changed (GarconMenu         *menu,
 static gpointer
 xfce_appfinder_model_collect_thread (gpointer user_data)
 {
-  XfceAppfinderModel *model = XFCE_APPFINDER_MODEL (user_data);
-  GError             *error = NULL;
-  gchar              *filename;
-  GMappedFile        *mmap;
+  XfceAppfinderModel        *model = XFCE_APPFINDER_MODEL (user_data);
+  GError                    *error = NULL;
+  gchar                     *filename;
+  GMappedFile               *mmap;
+  XfceAppfinderCache        *cache;
+  XfceAppfinderCacheBuilder *builder;
+  GSList                    *items = NULL;
+  GSList                    *categories = NULL;
+  gboolean                   from_cache = FALSE;
 
   appfinder_return_val_if_fail (GARCON_IS_MENU (model->menu), NULL);
   appfinder_return_val_if_fail (model->collect_items == NULL, NULL);
@@ -2104,21 +2374,38 @@ xfce_appfinder_model_collect_thread (gpointer user_data)
 
   APPFINDER_DEBUG ("collect thread start");
 
-  /* load menu data */
-  if (G_LIKELY (model->menu != NULL))
+  /* show the items from the menu cache while the menu is loaded, loading
+   * the menu means parsing all menu and desktop files */
+  cache = xfce_appfinder_cache_load ();
+  if (cache != NULL)
+    {
+      APPFINDER_DEBUG ("load items from the menu cache");
+
+      xfce_appfinder_model_collect_cache (model, cache);
+      xfce_appfinder_cache_free (cache);
+      from_cache = TRUE;
+    }
+  else if (G_LIKELY (model->menu != NULL))
     {
+      builder = xfce_appfinder_cache_builder_new ();
+
       if (garcon_menu_load (model->menu, model->collect_cancelled, &error))
         {
           xfce_appfinder_model_collect_menu (model->menu,
                                              model->collect_cancelled,
                                              &model->collect_items,
                                              &model->collect_categories);
+
+          if (!g_cancellable_is_cancelled (model->collect_cancelled))
+            xfce_appfinder_model_cache_save (builder, model->collect_items, model->collect_categories);
         }
       else
         {
           g_warning ("Failed to load the root menu: %s", error->message);
           g_clear_error (&error);
         }
+
+      xfce_appfinder_cache_builder_free (builder);
     }
 
   /* load command history */
@@ -2204,6 +2491,36 @@ xfce_appfinder_model_collect_thread (gpointer user_data)
                                                 model, xfce_appfinder_model_collect_idle_destroy);
     }
 
+  /* now load the menu, the items from the cache are replaced in the
+   * reload idle and the cache is updated for the next start */
+  if (from_cache
+      && G_LIKELY (model->menu != NULL)
+      && !g_cancellable_is_cancelled (model->collect_cancelled))
+    {
+      builder = xfce_appfinder_cache_builder_new ();
+
+      if (garcon_menu_load (model->menu, model->collect_cancelled, &error))
+        {
+          xfce_appfinder_model_collect_menu (model->menu, model->collect_cancelled,
+                                             &items, &categories);
+
+          if (!g_cancellable_is_cancelled (model->collect_cancelled))
+            xfce_appfinder_model_cache_save (builder, items, categories);
+
+          model->reload_items = items;
+          model->reload_categories = categories;
+          model->reload_idle_id = gdk_threads_add_idle_full (G_PRIORITY_LOW, xfce_appfinder_model_reload_idle,
+                                                             model, xfce_appfinder_model_reload_idle_destroy);
+        }
+      else
+        {
+          g_warning ("Failed to load the root menu: %s", error->message);
+          g_clear_error (&error);
+        }
+
+      xfce_appfinder_cache_builder_free (builder);
+    }
+
   if (G_LIKELY (model->menu != NULL))
     {
       g_signal_connect (G_OBJECT (model->menu), "reload-required",
@@ -2532,9 +2849,10 @@ xfce_appfinder_model_get_visible (XfceAppfinderModel        *model,
                                   const gchar               *string,
                                   const gchar               *string_casefold)
 {
-  ModelItem *item;
-  GarconMenuDirectory *bookmarks;
-  gboolean             in_category;
+  ModelItem                  *item;
+  GarconMenuDirectory        *bookmarks;
+  gboolean                    in_category;
+  const XfceAppfinderMatcher *matcher;
 
   appfinder_return_val_if_fail (XFCE_IS_APPFINDER_MODEL (model), FALSE);
   appfinder_return_val_if_fail (iter->stamp == model->stamp, FALSE);
@@ -2543,6 +2861,8 @@ xfce_appfinder_model_get_visible (XfceAppfinderModel        *model,
 
   item = ITER_GET_DATA (iter);
 
+  xfce_appfinder_model_filter_update (model, string, string_casefold);
+
   if (item->item != NULL)
     {
       appfinder_return_val_if_fail (GARCON_IS_MENU_ITEM (item->item), FALSE);
@@ -2567,9 +2887,37 @@ xfce_appfinder_model_get_visible (XfceAppfinderModel        *model,
             }
         }
 
+      item->match_score = 0;
       if (string_casefold == NULL || item->key_basic == NULL || item->key_extended == NULL)
         return TRUE;
-      return xfce_appfinder_model_regular_match (item->key_basic, item->key_extended, string_casefold) || xfce_appfinder_model_fuzzy_match (item->key_basic, string_casefold);
+
+      /* did not match a shorter version of the filter string */
+      if (item->filter_serial == model->filter_serial)
+        return FALSE;
+
+      /* substring matches in the name or command rank above those in the
+       * other keys, which rank above fuzzy matches of the name or command */
+      matcher = xfce_appfinder_model_get_matcher (&model->matcher_casefold, string_casefold);
+      item->match_score = xfce_appfinder_matcher_score (matcher, item->key_basic, FALSE);
+      if (item->match_score != XFCE_APPFINDER_MATCHER_NO_MATCH)
+        {
+          item->match_score += 2 * (XFCE_APPFINDER_MATCHER_SCORE_MAX + 1);
+          return TRUE;
+        }
+
+      item->match_score = xfce_appfinder_matcher_score (matcher, item->key_extended, FALSE);
+      if (item->match_score != XFCE_APPFINDER_MATCHER_NO_MATCH)
+        {
+          item->match_score += XFCE_APPFINDER_MATCHER_SCORE_MAX + 1;
+          return TRUE;
+        }
+
+      item->match_score = xfce_appfinder_matcher_score (matcher, item->key_basic, TRUE);
+      if (item->match_score != XFCE_APPFINDER_MATCHER_NO_MATCH)
+        return TRUE;
+
+      item->filter_serial = model->filter_serial;
+      return FALSE;
     }
   else /* command item */
     {
@@ -2578,8 +2926,20 @@ xfce_appfinder_model_get_visible (XfceAppfinderModel        *model,
       if (category != model->command_category)
         return FALSE;
 
+      item->match_score = 0;
       if (string != NULL)
-        return xfce_appfinder_model_fuzzy_match (item->command, string);
+        {
+          if (item->filter_serial == model->filter_serial)
+            return FALSE;
+
+          matcher = xfce_appfinder_model_get_matcher (&model->matcher, string);
+          item->match_score = xfce_appfinder_matcher_score (matcher, item->command, TRUE);
+          if (item->match_score != XFCE_APPFINDER_MATCHER_NO_MATCH)
+            return TRUE;
+
+          item->filter_serial = model->filter_serial;
+          return FALSE;
+        }
     }
 
   return TRUE;
@@ -2592,7 +2952,8 @@ xfce_appfinder_model_get_visible_command (XfceAppfinderModel *model,
                                           const GtkTreeIter  *iter,
                                           const gchar        *string)
 {
-  ModelItem *item;
+  ModelItem                  *item;
+  const XfceAppfinderMatcher *matcher;
 
   appfinder_return_val_if_fail (XFCE_IS_APPFINDER_MODEL (model), FALSE);
   appfinder_return_val_if_fail (iter->stamp == model->stamp, FALSE);
@@ -2608,7 +2969,11 @@ xfce_appfinder_model_get_visible_command (XfceAppfinderModel *model,
     return FALSE;
 
   if (item->command != NULL && string != NULL)
-    return xfce_appfinder_model_fuzzy_match (item->command, string);
+    {
+      /* the score is left alone, it belongs to the filter of the window */
+      matcher = xfce_appfinder_model_get_matcher (&model->matcher, string);
+      return xfce_appfinder_matcher_score (matcher, item->command, TRUE) != XFCE_APPFINDER_MATCHER_NO_MATCH;
+    }
 
   return FALSE;
 }
@@ -3017,6 +3382,8 @@ xfce_appfinder_model_generic_names_changed (XfceAppfinderModel *model)
         {
           g_free (item->abstract);
           item->abstract = NULL;
+          g_free (item->sort_key);
+          item->sort_key = NULL;
 
           path = gtk_tree_path_new_from_indices (idx, -1);
           ITER_INIT (iter, model->stamp, li);
@@ -3208,92 +3575,51 @@ xfce_appfinder_model_get_bookmarks_category (void)
 
 
 
-gboolean
-xfce_appfinder_model_fuzzy_match (const gchar *source,
-                                  const gchar *token)
+static const XfceAppfinderMatcher *
+xfce_appfinder_model_get_matcher (XfceAppfinderMatcher **matcher,
+                                  const gchar           *token)
 {
-    static gchar *previous_token = NULL;
-    static GSList *patterns = NULL;
-    const guint token_size = strlen (token);
-    GSList *li;
-
-    if (token_size == 0)
-        return TRUE;
-
-    /* if the token has changed, recreate the patterns */
-    if (g_strcmp0 (token, previous_token) != 0)
-      {
-        guint index;
-        // length is 14 because of ".*<part1> *.*(?i)<part2>.*" pattern format
-        // "(?i)" is an optional part
-        gchar pattern [token_size + 14];
-        const guint cmd_part_size = token_size + 1;
-        gchar cmd_part [cmd_part_size];
-        gchar *param_part;
-        gboolean contain_uppercase = FALSE;
-
-        APPFINDER_DEBUG ("Fuzzy match: token changed, recreating patterns");
-
-        g_free (previous_token);
-        previous_token = g_strdup (token);
-        g_slist_free_full (patterns, g_free);
-        patterns = NULL;
-
-        for (index = 1; index <= token_size; index++)
-          {
-            memset (cmd_part, 0, cmd_part_size);
-            strncpy (cmd_part, token, index);
-            cmd_part [index] = '\0';
-
-            contain_uppercase = FALSE;
-            param_part = (gchar*) token + index;
-
-            while (!contain_uppercase && (*param_part != '\0'))
-              {
-                contain_uppercase = g_ascii_isupper (*param_part);
-                param_part++;
-              }
-
-            memset (pattern, 0, sizeof (pattern));
-            g_sprintf (pattern, ".*%s *.*%s%s.*", cmd_part,
-                       (contain_uppercase) ? "(?-i)" : "(?i)",
-                       token + index);
-            patterns = g_slist_append (patterns, g_strdup (pattern));
-          APPFINDER_DEBUG ("    %s", pattern);
-          }
-      }
-
-    for (li = patterns; li != NULL; li = li->next)
-      {
-        gchar *pattern = li->data;
-        if (g_regex_match_simple (pattern, source, 0, 0))
-        {
-          APPFINDER_DEBUG ("Fuzzy match: regexp=%s ; source=%s", pattern, source);
-          return TRUE;
-        }
-      }
+  /* the filter func runs for every item with the same token, so only
+   * compile a new matcher when the token has changed */
+  if (*matcher == NULL
+      || strcmp (xfce_appfinder_matcher_get_token (*matcher), token) != 0)
+    {
+      xfce_appfinder_matcher_free (*matcher);
+      *matcher = xfce_appfinder_matcher_new (token);
+    }
 
-    return FALSE;
+  return *matcher;
 }
 
 
 
-gboolean
-xfce_appfinder_model_regular_match (const gchar *source1,
-                                    const gchar *source2,
-                                    const gchar *token)
+static void
+xfce_appfinder_model_filter_update (XfceAppfinderModel *model,
+                                    const gchar        *string,
+                                    const gchar        *string_casefold)
 {
-  if (g_strrstr (source1, token) != NULL)
-    {
-      APPFINDER_DEBUG ("Regular match: token=%s ; source=%s", token, source1);
-      return TRUE;
-    }
+  if (g_strcmp0 (model->filter_string, string) == 0
+      && g_strcmp0 (model->filter_string_casefold, string_casefold) == 0)
+    return;
 
-  if (g_strrstr (source2, token) != NULL)
+  /*
+   * an item that did not match a filter string can't match that string
+   * with more characters appended, neither as substring nor fuzzy, so
+   * while the user types on, only the items that were visible before are
+   * matched again. Everything is matched again when the string is edited
+   * in any other way.
+   */
+  if (model->filter_string == NULL || string == NULL
+      || model->filter_string_casefold == NULL || string_casefold == NULL
+      || !g_str_has_prefix (string, model->filter_string)
+      || !g_str_has_prefix (string_casefold, model->filter_string_casefold))
     {
-      APPFINDER_DEBUG ("Regular match: token=%s ; source=%s", token, source2);
-      return TRUE;
+      APPFINDER_DEBUG ("filter string changed, matching all items");
+      model->filter_serial++;
     }
 
-  return FALSE;
+  g_free (model->filter_string);
+  model->filter_string = g_strdup (string);
+  g_free (model->filter_string_casefold);
+  model->filter_string_casefold = g_strdup (string_casefold);
 }
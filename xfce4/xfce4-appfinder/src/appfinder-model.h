@@ -48,6 +48,8 @@ enum
   XFCE_APPFINDER_MODEL_COLUMN_RECENCY,
   XFCE_APPFINDER_MODEL_COLUMN_TOOLTIP,
   XFCE_APPFINDER_MODEL_COLUMN_ACTION_ITEMS,
+  XFCE_APPFINDER_MODEL_COLUMN_SCORE,
+  XFCE_APPFINDER_MODEL_COLUMN_SORT_KEY,
   XFCE_APPFINDER_MODEL_N_COLUMNS,
 };
 
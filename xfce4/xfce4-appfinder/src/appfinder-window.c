@@ -123,6 +123,7 @@ static gint       xfce_appfinder_window_sort_items_frecency           (GtkTreeMo
                                                                        GtkTreeIter                 *a,
                                                                        GtkTreeIter                 *b,
                                                                        gpointer                     data);
+static void       xfce_appfinder_window_sort_model_update             (XfceAppfinderWindow         *window);
 static gchar    **xfce_appfinder_parse_envp                           (gchar                      **cmd);
 static guint      xfce_appfinder_get_navigation_key                   (GdkEventKey                 *event);
 
@@ -819,10 +820,7 @@ xfce_appfinder_window_view (XfceAppfinderWindow *window)
   if (window->sort_model == NULL)
     {
       window->sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (window->filter_model));
-      if (xfconf_channel_get_bool (window->channel, "/sort-by-frecency", FALSE))
-        gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (window->sort_model), xfce_appfinder_window_sort_items_frecency, window->entry, NULL);
-      else
-        gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (window->sort_model), xfce_appfinder_window_sort_items, window->entry, NULL);
+      xfce_appfinder_window_sort_model_update (window);
     }
 
   if (icon_view)
@@ -1439,6 +1437,10 @@ xfce_appfinder_window_entry_changed_idle (gpointer data)
       APPFINDER_DEBUG ("refilter entry");
 
       gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (window->filter_model));
+
+      /* the match scores changed, also for the rows that stayed visible */
+      xfce_appfinder_window_sort_model_update (window);
+
       APPFINDER_DEBUG ("FILTER TEXT: %s\n", window->filter_text);
 
       if (GTK_IS_TREE_VIEW (window->view))
@@ -2310,44 +2312,25 @@ xfce_appfinder_window_sort_items (GtkTreeModel *model,
                                   GtkTreeIter  *b,
                                   gpointer      data)
 {
-  gchar        *normalized, *casefold, *title_a, *title_b, *found;
-  GtkWidget    *entry = GTK_WIDGET (data);
-  gint          result = -1;
-
-  appfinder_return_val_if_fail (GTK_IS_ENTRY (entry), 0);
-
-  normalized = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (entry)), -1, G_NORMALIZE_ALL);
-  casefold = g_utf8_casefold (normalized, -1);
-  g_free (normalized);
-
-  gtk_tree_model_get (model, a, XFCE_APPFINDER_MODEL_COLUMN_TITLE, &title_a, -1);
-  normalized = g_utf8_normalize (title_a, -1, G_NORMALIZE_ALL);
-  g_free (title_a);
-  title_a = g_utf8_casefold (normalized, -1);
-  g_free (normalized);
-
-  gtk_tree_model_get (model, b, XFCE_APPFINDER_MODEL_COLUMN_TITLE, &title_b, -1);
-  normalized = g_utf8_normalize (title_b, -1, G_NORMALIZE_ALL);
-  g_free (title_b);
-  title_b = g_utf8_casefold (normalized, -1);
-  g_free (normalized);
-
-  if (g_strcmp0 (casefold, "") == 0)
-    result = g_strcmp0 (title_a, title_b);
-  else
-    {
-      found = g_strrstr (title_a, casefold);
-      if (found)
-        result -= (G_MAXINT - (found - title_a));
+  GValue        key_a = G_VALUE_INIT;
+  GValue        key_b = G_VALUE_INIT;
+  gint          score_a, score_b;
+  gint          result;
 
-      found = g_strrstr (title_b, casefold);
-      if (found)
-        result += (G_MAXINT - (found - title_b));
-    }
+  /* best match of the filter text first, all scores are 0 without one */
+  gtk_tree_model_get (model, a, XFCE_APPFINDER_MODEL_COLUMN_SCORE, &score_a, -1);
+  gtk_tree_model_get (model, b, XFCE_APPFINDER_MODEL_COLUMN_SCORE, &score_b, -1);
+  if (score_a != score_b)
+    return score_b - score_a;
+
+  /* the model keeps the casefolded titles, so don't copy them */
+  gtk_tree_model_get_value (model, a, XFCE_APPFINDER_MODEL_COLUMN_SORT_KEY, &key_a);
+  gtk_tree_model_get_value (model, b, XFCE_APPFINDER_MODEL_COLUMN_SORT_KEY, &key_b);
 
-  g_free (casefold);
-  g_free (title_a);
-  g_free (title_b);
+  result = g_strcmp0 (g_value_get_string (&key_a), g_value_get_string (&key_b));
+
+  g_value_unset (&key_a);
+  g_value_unset (&key_b);
   return result;
 }
 
@@ -2382,6 +2365,24 @@ xfce_appfinder_window_sort_items_frecency  (GtkTreeModel *model,
 
 
 
+static void
+xfce_appfinder_window_sort_model_update (XfceAppfinderWindow *window)
+{
+  GtkTreeIterCompareFunc sort_func;
+
+  if (xfconf_channel_get_bool (window->channel, "/sort-by-frecency", FALSE))
+    sort_func = xfce_appfinder_window_sort_items_frecency;
+  else
+    sort_func = xfce_appfinder_window_sort_items;
+
+  /* setting the default sort func resorts the whole model, the sort model
+   * only moves rows on insertion or row-changed otherwise */
+  gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (window->sort_model),
+                                           sort_func, NULL, NULL);
+}
+
+
+
 static gchar**
 xfce_appfinder_parse_envp (gchar **cmd)
 {
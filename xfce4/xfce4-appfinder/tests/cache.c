@@ -0,0 +1,479 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Checks that the menu cache gives back the items of the menu it was built
+ * from and that it goes out of date when the menu changes, and in perf mode
+ * (-m perf) times filling the window from the cache against loading the
+ * menu with garcon, which is what a cold start did before.
+ *
+ * The XDG directories point to a temporary directory with a generated menu,
+ * so neither the menu nor the cache of the user are touched.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include <src/appfinder-cache.h>
+
+
+
+#define N_TEST_ITEMS  (50)
+#define N_PERF_ITEMS  (1000)
+#define N_PERF_RUNS   (5)
+#define COLD_START_MS (50.0)
+
+
+
+static gchar *root_dir = NULL;
+
+
+
+static const gchar *nouns[] = {
+  "Terminal", "Editor", "Browser", "Player", "Manager", "Viewer", "Settings",
+  "Calculator", "Mail", "Music", "Image", "Office", "Monitor", "Archive",
+};
+
+static const gchar *categories[] = {
+  "System", "Development", "Network", "AudioVideo", "Graphics", "Office", "Utility",
+};
+
+
+
+static gchar *
+test_path (const gchar *first_element,
+           ...)
+{
+  va_list  args;
+  gchar   *relative;
+  gchar   *path;
+
+  va_start (args, first_element);
+  relative = g_build_filename_valist (first_element, &args);
+  va_end (args);
+
+  path = g_build_filename (root_dir, relative, NULL);
+  g_free (relative);
+
+  return path;
+}
+
+
+
+static void
+remove_recursive (const gchar *path)
+{
+  GDir        *dir;
+  const gchar *name;
+  gchar       *child;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir != NULL)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          child = g_build_filename (path, name, NULL);
+          remove_recursive (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+
+
+/* the cache takes directories changed in the second it was built as
+ * changed, so move them to the past once the menu is written */
+static void
+age_directory (const gchar *path)
+{
+  GFile  *file;
+  GError *error = NULL;
+
+  file = g_file_new_for_path (path);
+  g_file_set_attribute_uint64 (file, G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                               g_get_real_time () / G_USEC_PER_SEC - 10,
+                               G_FILE_QUERY_INFO_NONE, NULL, &error);
+  g_assert_no_error (error);
+  g_object_unref (G_OBJECT (file));
+}
+
+
+
+static void
+create_menu (const gchar *prefix,
+             guint        n_items)
+{
+  gchar   *applications;
+  gchar   *menus;
+  gchar   *filename;
+  gchar   *contents;
+  guint    n;
+  GError  *error = NULL;
+
+  applications = test_path ("data", "applications", NULL);
+  menus = test_path ("config", "menus", NULL);
+
+  remove_recursive (applications);
+  g_assert_cmpint (g_mkdir_with_parents (applications, 0755), ==, 0);
+  g_assert_cmpint (g_mkdir_with_parents (menus, 0755), ==, 0);
+
+  filename = g_build_filename (menus, "applications.menu", NULL);
+  g_file_set_contents (filename,
+                       "<!DOCTYPE Menu PUBLIC \"-//freedesktop//DTD Menu 1.0//EN\"\n"
+                       "  \"http://www.freedesktop.org/standards/menu-spec/1.0/menu.dtd\">\n"
+                       "<Menu>\n"
+                       "  <Name>Applications</Name>\n"
+                       "  <DefaultAppDirs/>\n"
+                       "  <DefaultDirectoryDirs/>\n"
+                       "  <Include><All/></Include>\n"
+                       "</Menu>\n",
+                       -1, &error);
+  g_assert_no_error (error);
+  g_free (filename);
+
+  /* a new prefix for every menu, so garcon does not hand out the
+   * items it still has from a previous one */
+  for (n = 0; n < n_items; n++)
+    {
+      filename = g_strdup_printf ("%s/%s-%u.desktop", applications, prefix, n);
+      contents = g_strdup_printf ("[Desktop Entry]\n"
+                                  "Type=Application\n"
+                                  "Name=%s %u\n"
+                                  "GenericName=%s\n"
+                                  "Comment=Generated %s number %u\n"
+                                  "Exec=%s-%u %%F\n"
+                                  "Icon=%s-%u\n"
+                                  "Terminal=%s\n"
+                                  "Categories=%s;\n"
+                                  "Keywords=generated;%s;\n",
+                                  nouns[n % G_N_ELEMENTS (nouns)], n,
+                                  nouns[n % G_N_ELEMENTS (nouns)],
+                                  nouns[n % G_N_ELEMENTS (nouns)], n,
+                                  prefix, n,
+                                  prefix, n,
+                                  n % 7 == 0 ? "true" : "false",
+                                  categories[n % G_N_ELEMENTS (categories)],
+                                  prefix);
+      g_file_set_contents (filename, contents, -1, &error);
+      g_assert_no_error (error);
+      g_free (contents);
+      g_free (filename);
+    }
+
+  age_directory (applications);
+  age_directory (menus);
+
+  g_free (applications);
+  g_free (menus);
+}
+
+
+
+static GarconMenu *
+load_menu (void)
+{
+  GarconMenu *menu;
+  GError     *error = NULL;
+
+  menu = garcon_menu_new_applications ();
+  garcon_menu_load (menu, NULL, &error);
+  g_assert_no_error (error);
+
+  return menu;
+}
+
+
+
+static gchar *
+item_key (const gchar *first,
+          const gchar *second)
+{
+  gchar *joined;
+  gchar *key;
+
+  joined = g_strjoin (" ", first != NULL ? first : "", second != NULL ? second : "", NULL);
+  key = g_utf8_casefold (joined, -1);
+  g_free (joined);
+
+  return key;
+}
+
+
+
+/* what the model stores after loading the menu, with keys built
+ * like the ones of the model */
+static void
+save_cache (GarconMenu *menu)
+{
+  XfceAppfinderCacheBuilder *builder;
+  GList                     *items, *li;
+  gchar                     *key_basic, *key_extended;
+  GError                    *error = NULL;
+
+  builder = xfce_appfinder_cache_builder_new ();
+
+  items = garcon_menu_get_items (menu);
+  for (li = items; li != NULL; li = li->next)
+    {
+      key_basic = item_key (garcon_menu_item_get_name (li->data),
+                            garcon_menu_item_get_command (li->data));
+      key_extended = item_key (garcon_menu_item_get_comment (li->data),
+                               garcon_menu_item_get_generic_name (li->data));
+      xfce_appfinder_cache_builder_add_item (builder, li->data, key_basic, key_extended, NULL, 0);
+      g_free (key_basic);
+      g_free (key_extended);
+    }
+  g_list_free (items);
+
+  xfce_appfinder_cache_builder_save (builder, &error);
+  g_assert_no_error (error);
+  xfce_appfinder_cache_builder_free (builder);
+}
+
+
+
+static void
+test_round_trip (void)
+{
+  XfceAppfinderCache *cache;
+  GarconMenu         *menu;
+  GarconMenuItem     *cached;
+  GHashTable         *items;
+  GList              *list, *li;
+  GarconMenuItem     *item;
+  const gchar        *key_basic, *key_extended;
+  gchar              *expected;
+  guint               n;
+
+  create_menu ("round-trip", N_TEST_ITEMS);
+
+  menu = load_menu ();
+  save_cache (menu);
+
+  items = g_hash_table_new (g_str_hash, g_str_equal);
+  list = garcon_menu_get_items (menu);
+  for (li = list; li != NULL; li = li->next)
+    g_hash_table_insert (items, (gpointer) garcon_menu_item_get_desktop_id (li->data), li->data);
+  g_list_free (list);
+  g_assert_cmpuint (g_hash_table_size (items), ==, N_TEST_ITEMS);
+
+  cache = xfce_appfinder_cache_load ();
+  g_assert_nonnull (cache);
+  g_assert_cmpuint (xfce_appfinder_cache_get_n_items (cache), ==, N_TEST_ITEMS);
+
+  for (n = 0; n < xfce_appfinder_cache_get_n_items (cache); n++)
+    {
+      cached = xfce_appfinder_cache_get_item (cache, n, &key_basic, &key_extended, NULL, NULL);
+      item = g_hash_table_lookup (items, garcon_menu_item_get_desktop_id (cached));
+      g_assert_nonnull (item);
+
+      g_assert_cmpstr (garcon_menu_item_get_name (cached), ==, garcon_menu_item_get_name (item));
+      g_assert_cmpstr (garcon_menu_item_get_generic_name (cached), ==, garcon_menu_item_get_generic_name (item));
+      g_assert_cmpstr (garcon_menu_item_get_comment (cached), ==, garcon_menu_item_get_comment (item));
+      g_assert_cmpstr (garcon_menu_item_get_command (cached), ==, garcon_menu_item_get_command (item));
+      g_assert_cmpstr (garcon_menu_item_get_icon_name (cached), ==, garcon_menu_item_get_icon_name (item));
+      g_assert_true (garcon_menu_item_requires_terminal (cached) == garcon_menu_item_requires_terminal (item));
+      g_assert_true (garcon_menu_item_has_category (cached, garcon_menu_item_get_categories (item)->data));
+
+      expected = item_key (garcon_menu_item_get_name (item), garcon_menu_item_get_command (item));
+      g_assert_cmpstr (key_basic, ==, expected);
+      g_free (expected);
+
+      expected = item_key (garcon_menu_item_get_comment (item), garcon_menu_item_get_generic_name (item));
+      g_assert_cmpstr (key_extended, ==, expected);
+      g_free (expected);
+
+      g_object_unref (G_OBJECT (cached));
+    }
+
+  xfce_appfinder_cache_free (cache);
+  g_hash_table_destroy (items);
+  g_object_unref (G_OBJECT (menu));
+}
+
+
+
+static void
+test_out_of_date (void)
+{
+  XfceAppfinderCache *cache;
+  GarconMenu         *menu;
+  gchar              *filename;
+  gchar              *applications;
+  GError             *error = NULL;
+
+  create_menu ("out-of-date", N_TEST_ITEMS);
+
+  menu = load_menu ();
+  save_cache (menu);
+  g_object_unref (G_OBJECT (menu));
+
+  cache = xfce_appfinder_cache_load ();
+  g_assert_nonnull (cache);
+  xfce_appfinder_cache_free (cache);
+
+  /* another desktop environment sees another menu */
+  g_setenv ("XDG_CURRENT_DESKTOP", "OTHER", TRUE);
+  g_assert_null (xfce_appfinder_cache_load ());
+  g_setenv ("XDG_CURRENT_DESKTOP", "XFCE", TRUE);
+  cache = xfce_appfinder_cache_load ();
+  g_assert_nonnull (cache);
+  xfce_appfinder_cache_free (cache);
+
+  /* installing an application changes the directory */
+  filename = test_path ("data", "applications", "installed.desktop", NULL);
+  g_file_set_contents (filename, "[Desktop Entry]\nType=Application\nName=Installed\nExec=installed\n", -1, &error);
+  g_assert_no_error (error);
+  g_assert_null (xfce_appfinder_cache_load ());
+
+  /* and so does removing it again, even in the same second */
+  applications = test_path ("data", "applications", NULL);
+  age_directory (applications);
+  menu = load_menu ();
+  save_cache (menu);
+  g_object_unref (G_OBJECT (menu));
+  g_assert_cmpint (g_remove (filename), ==, 0);
+  g_assert_null (xfce_appfinder_cache_load ());
+
+  g_free (applications);
+  g_free (filename);
+}
+
+
+
+static void
+test_performance (void)
+{
+  XfceAppfinderCache *cache;
+  GarconMenu         *menu;
+  GarconMenuItem     *item;
+  GList              *items, *li;
+  gchar              *prefix;
+  gchar              *key;
+  gdouble             menu_time = 0.0;
+  gdouble             cache_time = 0.0;
+  gdouble             elapsed;
+  guint               run, n;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  for (run = 0; run < N_PERF_RUNS; run++)
+    {
+      /* new files every run, so garcon has to parse them like it
+       * does when the window starts */
+      prefix = g_strdup_printf ("perf-%u", run);
+      create_menu (prefix, N_PERF_ITEMS);
+      g_free (prefix);
+
+      g_test_timer_start ();
+      menu = load_menu ();
+      items = garcon_menu_get_items (menu);
+      for (li = items; li != NULL; li = li->next)
+        {
+          key = item_key (garcon_menu_item_get_name (li->data),
+                          garcon_menu_item_get_command (li->data));
+          g_free (key);
+        }
+      elapsed = g_test_timer_elapsed ();
+      menu_time += elapsed;
+      g_assert_cmpuint (g_list_length (items), ==, N_PERF_ITEMS);
+      g_list_free (items);
+
+      save_cache (menu);
+      g_object_unref (G_OBJECT (menu));
+
+      g_test_timer_start ();
+      cache = xfce_appfinder_cache_load ();
+      g_assert_nonnull (cache);
+      for (n = 0; n < xfce_appfinder_cache_get_n_items (cache); n++)
+        {
+          item = xfce_appfinder_cache_get_item (cache, n, NULL, NULL, NULL, NULL);
+          g_object_unref (G_OBJECT (item));
+        }
+      elapsed = g_test_timer_elapsed ();
+      cache_time += elapsed;
+      g_assert_cmpuint (xfce_appfinder_cache_get_n_items (cache), ==, N_PERF_ITEMS);
+      xfce_appfinder_cache_free (cache);
+    }
+
+  menu_time = menu_time * 1000.0 / N_PERF_RUNS;
+  cache_time = cache_time * 1000.0 / N_PERF_RUNS;
+
+  g_test_message ("%u items: menu %.2f ms, cache %.2f ms (target %.0f ms for the cold start)",
+                  N_PERF_ITEMS, menu_time, cache_time, COLD_START_MS);
+  g_test_minimized_result (cache_time / 1000.0, "load %u items from the cache", N_PERF_ITEMS);
+
+  if (cache_time > COLD_START_MS)
+    g_test_message ("loading the cache alone takes longer than the cold start target");
+}
+
+
+
+int
+main (int    argc,
+      char **argv)
+{
+  gchar *path;
+  gint   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  /* before anything looks up the XDG directories, they are cached */
+  root_dir = g_dir_make_tmp ("xfce4-appfinder-cache-XXXXXX", NULL);
+  g_assert_nonnull (root_dir);
+
+  path = test_path ("data", NULL);
+  g_setenv ("XDG_DATA_HOME", path, TRUE);
+  g_free (path);
+  path = test_path ("data-dirs", NULL);
+  g_setenv ("XDG_DATA_DIRS", path, TRUE);
+  g_free (path);
+  path = test_path ("config", NULL);
+  g_setenv ("XDG_CONFIG_HOME", path, TRUE);
+  g_free (path);
+  path = test_path ("config-dirs", NULL);
+  g_setenv ("XDG_CONFIG_DIRS", path, TRUE);
+  g_free (path);
+  path = test_path ("cache", NULL);
+  g_setenv ("XDG_CACHE_HOME", path, TRUE);
+  g_free (path);
+  g_unsetenv ("XDG_MENU_PREFIX");
+  g_setenv ("XDG_CURRENT_DESKTOP", "XFCE", TRUE);
+
+  g_test_add_func ("/cache/round-trip", test_round_trip);
+  g_test_add_func ("/cache/out-of-date", test_out_of_date);
+  g_test_add_func ("/cache/performance", test_performance);
+
+  result = g_test_run ();
+
+  remove_recursive (root_dir);
+  g_free (root_dir);
+
+  return result;
+}
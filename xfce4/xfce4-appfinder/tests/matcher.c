@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Checks the filter of the window, XfceAppfinderMatcher, against the regex
+ * patterns it replaced on 10000 generated menu items, and times both for
+ * every keystroke of a few queries in perf mode (-m perf). It also checks
+ * that an item the model skips while the user types on, because it did
+ * not match a shorter string, does not match the longer one either.
+ */
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <libxfce4util/libxfce4util.h>
+
+#include <src/appfinder-matcher.h>
+
+
+
+#define N_ITEMS (10000)
+
+
+
+typedef struct
+{
+  gchar *key_basic;     /* name and command, casefolded */
+  gchar *key_extended;  /* comment, generic name and keywords, casefolded */
+  gchar *command;
+}
+Item;
+
+
+
+static const gchar *vendors[] = {
+  "Xfce", "GNOME", "KDE", "Libre", "Open", "Super", "Tiny", "Web", "Net", "Free",
+};
+
+static const gchar *nouns[] = {
+  "Terminal", "Editor", "Browser", "Player", "Manager", "Viewer", "Settings",
+  "Calculator", "Mail", "Music", "Image", "Office", "Monitor", "Archive",
+  "Disk", "Printer", "Clock", "Notes", "Maps", "Camera", "VirtualBox",
+};
+
+/* queries as they are typed, without regex metacharacters so that the
+ * former patterns mean the same as the plain text */
+static const gchar *queries[] = {
+  "terminal",
+  "xterm",
+  "web browser",
+  "libre off",
+  "mgr",
+  "settings",
+  "disk-m",
+  "VBox",
+  "vboxm",
+  "zzz",
+};
+
+
+
+/*
+ * The filter before XfceAppfinderMatcher, from xfce_appfinder_model_get_visible(),
+ * which tried a substring match on both keys and then regular expressions
+ * built for each split of the token in a head and a tail.
+ */
+static GSList *
+reference_patterns (const gchar *token)
+{
+  GSList   *patterns = NULL;
+  gsize     size = strlen (token);
+  gsize     index;
+  gchar    *head;
+  gboolean  contain_uppercase;
+  const gchar *p;
+
+  for (index = 1; index <= size; index++)
+    {
+      head = g_strndup (token, index);
+
+      contain_uppercase = FALSE;
+      for (p = token + index; !contain_uppercase && *p != '\0'; p++)
+        contain_uppercase = g_ascii_isupper (*p);
+
+      patterns = g_slist_append (patterns, g_strdup_printf (".*%s *.*%s%s.*", head,
+                                                            contain_uppercase ? "(?-i)" : "(?i)",
+                                                            token + index));
+      g_free (head);
+    }
+
+  return patterns;
+}
+
+
+
+static gboolean
+reference_fuzzy_match (GSList      *patterns,
+                       const gchar *source)
+{
+  GSList *li;
+
+  for (li = patterns; li != NULL; li = li->next)
+    if (g_regex_match_simple (li->data, source, 0, 0))
+      return TRUE;
+
+  return FALSE;
+}
+
+
+
+static gboolean
+reference_visible (const Item  *item,
+                   const gchar *token,
+                   GSList      *patterns)
+{
+  return g_strrstr (item->key_basic, token) != NULL
+         || g_strrstr (item->key_extended, token) != NULL
+         || reference_fuzzy_match (patterns, item->key_basic);
+}
+
+
+
+static gboolean
+matcher_visible (const Item                 *item,
+                 const XfceAppfinderMatcher *matcher)
+{
+  return xfce_appfinder_matcher_score (matcher, item->key_basic, FALSE) != XFCE_APPFINDER_MATCHER_NO_MATCH
+         || xfce_appfinder_matcher_score (matcher, item->key_extended, FALSE) != XFCE_APPFINDER_MATCHER_NO_MATCH
+         || xfce_appfinder_matcher_score (matcher, item->key_basic, TRUE) != XFCE_APPFINDER_MATCHER_NO_MATCH;
+}
+
+
+
+static Item *
+create_items (guint n_items)
+{
+  GRand       *rand;
+  Item        *items;
+  const gchar *vendor, *noun, *other;
+  gchar       *name, *command, *comment, *basic;
+  guint        n;
+
+  rand = g_rand_new_with_seed (21);
+  items = g_new0 (Item, n_items);
+
+  for (n = 0; n < n_items; n++)
+    {
+      vendor = vendors[g_rand_int_range (rand, 0, G_N_ELEMENTS (vendors))];
+      noun = nouns[g_rand_int_range (rand, 0, G_N_ELEMENTS (nouns))];
+      other = nouns[g_rand_int_range (rand, 0, G_N_ELEMENTS (nouns))];
+
+      name = g_strdup_printf ("%s %s %u", vendor, noun, n);
+      command = g_strdup_printf ("%s%u-%s --%s", vendor, n % 10, noun, other);
+      comment = g_strdup_printf ("Use the %s %s with your %s;%s;%s;", noun, vendor, other, vendor, noun);
+
+      basic = g_strdup_printf ("%s %s", name, command);
+
+      /* the model casefolds the keys, this is all ascii */
+      items[n].key_basic = g_ascii_strdown (basic, -1);
+      items[n].key_extended = g_ascii_strdown (comment, -1);
+      items[n].command = command;
+
+      g_free (basic);
+      g_free (comment);
+      g_free (name);
+    }
+
+  g_rand_free (rand);
+
+  return items;
+}
+
+
+
+static void
+free_items (Item  *items,
+            guint  n_items)
+{
+  guint n;
+
+  for (n = 0; n < n_items; n++)
+    {
+      g_free (items[n].key_basic);
+      g_free (items[n].key_extended);
+      g_free (items[n].command);
+    }
+
+  g_free (items);
+}
+
+
+
+static void
+test_equivalence (void)
+{
+  XfceAppfinderMatcher *matcher;
+  XfceAppfinderMatcher *matcher_casefold;
+  GSList               *patterns;
+  GSList               *patterns_casefold;
+  Item                 *items;
+  gchar                *token;
+  gchar                *token_casefold;
+  guint                 n, len, i;
+
+  /* the regular expressions are slow, a tenth of the items is plenty here */
+  items = create_items (N_ITEMS / 10);
+
+  for (n = 0; n < G_N_ELEMENTS (queries); n++)
+    for (len = 1; len <= strlen (queries[n]); len++)
+      {
+        token = g_strndup (queries[n], len);
+        token_casefold = g_ascii_strdown (token, -1);
+        matcher = xfce_appfinder_matcher_new (token);
+        matcher_casefold = xfce_appfinder_matcher_new (token_casefold);
+        patterns = reference_patterns (token);
+        patterns_casefold = reference_patterns (token_casefold);
+
+        for (i = 0; i < N_ITEMS / 10; i++)
+          {
+            /* menu items, on the casefolded keys */
+            g_assert_cmpint (matcher_visible (&items[i], matcher_casefold), ==,
+                             reference_visible (&items[i], token_casefold, patterns_casefold));
+
+            /* command items, fuzzy on the command as typed */
+            g_assert_cmpint (xfce_appfinder_matcher_score (matcher, items[i].command, TRUE) != XFCE_APPFINDER_MATCHER_NO_MATCH, ==,
+                             reference_fuzzy_match (patterns, items[i].command));
+          }
+
+        g_slist_free_full (patterns, g_free);
+        g_slist_free_full (patterns_casefold, g_free);
+        xfce_appfinder_matcher_free (matcher);
+        xfce_appfinder_matcher_free (matcher_casefold);
+        g_free (token_casefold);
+        g_free (token);
+      }
+
+  free_items (items, N_ITEMS / 10);
+}
+
+
+
+static void
+test_scores (void)
+{
+  XfceAppfinderMatcher *matcher;
+  gint                  start, word, inside, fuzzy;
+
+  matcher = xfce_appfinder_matcher_new ("term");
+  start = xfce_appfinder_matcher_score (matcher, "terminal", FALSE);
+  word = xfce_appfinder_matcher_score (matcher, "xfce4 terminal", FALSE);
+  inside = xfce_appfinder_matcher_score (matcher, "xterm", FALSE);
+  fuzzy = xfce_appfinder_matcher_score (matcher, "ter emulator", TRUE);
+  g_assert_cmpint (start, ==, XFCE_APPFINDER_MATCHER_SCORE_MAX);
+  g_assert_cmpint (start, >, word);
+  g_assert_cmpint (word, >, inside);
+  g_assert_cmpint (inside, >, fuzzy);
+  g_assert_cmpint (fuzzy, >, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "ter emulator", FALSE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  xfce_appfinder_matcher_free (matcher);
+
+  /* the token is plain text, not a pattern */
+  matcher = xfce_appfinder_matcher_new ("c++");
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "c++ ide", TRUE), ==, XFCE_APPFINDER_MATCHER_SCORE_MAX);
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "cc ide", TRUE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  xfce_appfinder_matcher_free (matcher);
+
+  matcher = xfce_appfinder_matcher_new ("a.b");
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "axb", TRUE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  xfce_appfinder_matcher_free (matcher);
+
+  /* an uppercase tail is matched case sensitive */
+  matcher = xfce_appfinder_matcher_new ("vM");
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "VBoxManage", TRUE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "vboxManage", TRUE), !=, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  g_assert_cmpint (xfce_appfinder_matcher_score (matcher, "vboxmanage", TRUE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+  xfce_appfinder_matcher_free (matcher);
+}
+
+
+
+/*
+ * Types each query one key at a time, and skips the items which did not
+ * match a prefix of the string, like xfce_appfinder_model_filter_update()
+ * and the filter_serial checks of xfce_appfinder_model_get_visible() do.
+ * Every skipped item must also fail the full match.
+ */
+static void
+test_narrowing (void)
+{
+  XfceAppfinderMatcher *matcher;
+  XfceAppfinderMatcher *matcher_casefold;
+  Item                 *items;
+  guint                *serials;
+  guint                *serials_command;
+  guint                 filter_serial = 1;
+  gchar                *filter_string = NULL;
+  gchar                *token;
+  gchar                *token_casefold;
+  guint                 n_skipped = 0;
+  guint                 n, len, i;
+
+  items = create_items (N_ITEMS);
+  serials = g_new0 (guint, N_ITEMS);
+  serials_command = g_new0 (guint, N_ITEMS);
+
+  for (n = 0; n < G_N_ELEMENTS (queries); n++)
+    for (len = 1; len <= strlen (queries[n]); len++)
+      {
+        token = g_strndup (queries[n], len);
+        token_casefold = g_ascii_strdown (token, -1);
+
+        /* the casefolded string is a prefix whenever the string is */
+        if (filter_string == NULL || !g_str_has_prefix (token, filter_string))
+          filter_serial++;
+        g_free (filter_string);
+        filter_string = g_strdup (token);
+
+        matcher = xfce_appfinder_matcher_new (token);
+        matcher_casefold = xfce_appfinder_matcher_new (token_casefold);
+
+        for (i = 0; i < N_ITEMS; i++)
+          {
+            /* menu items, on the casefolded keys */
+            if (serials[i] == filter_serial)
+              {
+                g_assert_false (matcher_visible (&items[i], matcher_casefold));
+                n_skipped++;
+              }
+            else if (!matcher_visible (&items[i], matcher_casefold))
+              {
+                serials[i] = filter_serial;
+              }
+
+            /* command items, fuzzy on the command as typed */
+            if (serials_command[i] == filter_serial)
+              {
+                g_assert_cmpint (xfce_appfinder_matcher_score (matcher, items[i].command, TRUE), ==, XFCE_APPFINDER_MATCHER_NO_MATCH);
+                n_skipped++;
+              }
+            else if (xfce_appfinder_matcher_score (matcher, items[i].command, TRUE) == XFCE_APPFINDER_MATCHER_NO_MATCH)
+              {
+                serials_command[i] = filter_serial;
+              }
+          }
+
+        xfce_appfinder_matcher_free (matcher);
+        xfce_appfinder_matcher_free (matcher_casefold);
+        g_free (token_casefold);
+        g_free (token);
+      }
+
+  /* the queries narrow down far enough for items to be skipped */
+  g_assert_cmpuint (n_skipped, >, 0);
+
+  g_free (filter_string);
+  g_free (serials);
+  g_free (serials_command);
+  free_items (items, N_ITEMS);
+}
+
+
+
+static void
+test_performance (void)
+{
+  XfceAppfinderMatcher *matcher;
+  GSList               *patterns;
+  Item                 *items;
+  gchar                *token;
+  gdouble               reference_time = 0.0;
+  gdouble               matcher_time = 0.0;
+  guint                 n_keystrokes = 0;
+  guint                 n, len, i;
+  guint                 visible;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  items = create_items (N_ITEMS);
+
+  for (n = 0; n < G_N_ELEMENTS (queries); n++)
+    for (len = 1; len <= strlen (queries[n]); len++, n_keystrokes++)
+      {
+        token = g_ascii_strdown (queries[n], len);
+
+        /* the former filter, which built its patterns once per token */
+        g_test_timer_start ();
+        patterns = reference_patterns (token);
+        for (i = 0, visible = 0; i < N_ITEMS; i++)
+          visible += reference_visible (&items[i], token, patterns);
+        reference_time += g_test_timer_elapsed ();
+        g_slist_free_full (patterns, g_free);
+
+        g_test_timer_start ();
+        matcher = xfce_appfinder_matcher_new (token);
+        for (i = 0; i < N_ITEMS; i++)
+          visible -= matcher_visible (&items[i], matcher);
+        matcher_time += g_test_timer_elapsed ();
+        xfce_appfinder_matcher_free (matcher);
+
+        g_assert_cmpuint (visible, ==, 0);
+        g_free (token);
+      }
+
+  g_test_message ("%u items, per keystroke: regular expressions %.2f ms, matcher %.2f ms",
+                  N_ITEMS, reference_time * 1000.0 / n_keystrokes, matcher_time * 1000.0 / n_keystrokes);
+  g_test_minimized_result (matcher_time / n_keystrokes, "filter %u items", N_ITEMS);
+
+  free_items (items, N_ITEMS);
+}
+
+
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/matcher/equivalence", test_equivalence);
+  g_test_add_func ("/matcher/scores", test_scores);
+  g_test_add_func ("/matcher/narrowing", test_narrowing);
+  g_test_add_func ("/matcher/performance", test_performance);
+
+  return g_test_run ();
+}
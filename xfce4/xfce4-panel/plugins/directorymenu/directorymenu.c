@@ -32,6 +32,9 @@
 #define DIALOG_RESPONSE_CREATE 0
 #define DIALOG_RESPONSE_OPEN 1
 
+#define N_FILES_PER_REQUEST 100
+#define MAX_CACHED_DIRECTORIES 32
+
 struct _DirectoryMenuPlugin
 {
   XfcePanelPlugin __parent__;
@@ -50,8 +53,44 @@ struct _DirectoryMenuPlugin
   guint hidden_files : 1;
 
   GSList *patterns;
+
+  /* directory contents by GFile, least recently used last */
+  GHashTable *caches;
+  GQueue caches_lru;
 };
 
+/* filtered and sorted contents of a directory, dropped when
+ * the monitor reports a change */
+typedef struct
+{
+  DirectoryMenuPlugin *plugin;
+  GFile *file;
+  GFileMonitor *monitor;
+
+  /* sorted list of GFileInfo, complete if loaded is set */
+  GList *infos;
+  guint loaded : 1;
+
+  /* set when the directory changed during the enumeration */
+  guint stale : 1;
+
+  /* running enumeration and the menus waiting for it */
+  GCancellable *cancellable;
+  GSList *menus;
+
+  GList lru_link;
+} DirectoryMenuCache;
+
+/* a running enumeration, the cache is only valid while
+ * the cancellable is not cancelled */
+typedef struct
+{
+  DirectoryMenuCache *cache;
+  GCancellable *cancellable;
+  GFileEnumerator *enumerator;
+  GList *infos;
+} DirectoryMenuLoad;
+
 enum
 {
   PROP_0,
@@ -83,6 +122,8 @@ static void
 directory_menu_plugin_free_file_patterns (DirectoryMenuPlugin *plugin);
 static void
 directory_menu_plugin_free_data (XfcePanelPlugin *panel_plugin);
+static void
+directory_menu_plugin_cache_free (gpointer data);
 static gboolean
 directory_menu_plugin_size_changed (XfcePanelPlugin *panel_plugin,
                                     gint size);
@@ -93,6 +134,11 @@ directory_menu_plugin_remote_event (XfcePanelPlugin *panel_plugin,
                                     const gchar *name,
                                     const GValue *value);
 static void
+directory_menu_plugin_menu_load (GtkWidget *menu,
+                                 DirectoryMenuPlugin *plugin);
+static void
+directory_menu_plugin_menu_unload (GtkWidget *menu);
+static void
 directory_menu_plugin_menu (GtkWidget *button,
                             DirectoryMenuPlugin *plugin);
 
@@ -104,6 +150,9 @@ XFCE_PANEL_DEFINE_PLUGIN (DirectoryMenuPlugin, directory_menu_plugin)
 
 
 static GQuark menu_file = 0;
+static GQuark menu_cache = 0;
+static GQuark menu_placeholder = 0;
+static GQuark menu_sort_key = 0;
 
 
 static void
@@ -180,6 +229,9 @@ directory_menu_plugin_class_init (DirectoryMenuPluginClass *klass)
                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   menu_file = g_quark_from_static_string ("dir-menu-file");
+  menu_cache = g_quark_from_static_string ("dir-menu-cache");
+  menu_placeholder = g_quark_from_static_string ("dir-menu-placeholder");
+  menu_sort_key = g_quark_from_static_string ("dir-menu-sort-key");
 }
 
 
@@ -204,6 +256,10 @@ directory_menu_plugin_init (DirectoryMenuPlugin *plugin)
   plugin->open_in_terminal = TRUE;
   plugin->new_folder = TRUE;
   plugin->new_document = TRUE;
+
+  plugin->caches = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                          NULL, directory_menu_plugin_cache_free);
+  g_queue_init (&plugin->caches_lru);
 }
 
 
@@ -334,10 +390,14 @@ directory_menu_plugin_set_property (GObject *object,
 
           g_strfreev (array);
         }
+
+      /* the cached contents are filtered */
+      g_hash_table_remove_all (plugin->caches);
       break;
 
     case PROP_HIDDEN_FILES:
       plugin->hidden_files = g_value_get_boolean (value);
+      g_hash_table_remove_all (plugin->caches);
       break;
 
     default:
@@ -402,6 +462,9 @@ directory_menu_plugin_free_data (XfcePanelPlugin *panel_plugin)
 {
   DirectoryMenuPlugin *plugin = DIRECTORY_MENU_PLUGIN (panel_plugin);
 
+  /* cancels the running enumerations */
+  g_hash_table_destroy (plugin->caches);
+
   if (plugin->base_directory != NULL)
     g_object_unref (G_OBJECT (plugin->base_directory));
   g_free (plugin->icon_name);
@@ -643,9 +706,6 @@ directory_menu_plugin_menu_sort (gconstpointer a,
   GFileType type_a = g_file_info_get_file_type (G_FILE_INFO (a));
   GFileType type_b = g_file_info_get_file_type (G_FILE_INFO (b));
   gboolean hidden_a, hidden_b;
-  const gchar *display_name_a, *display_name_b;
-  gchar *sort_display_name_a, *sort_display_name_b;
-  gint sort_value;
 
   if (type_a != type_b)
     {
@@ -663,15 +723,9 @@ directory_menu_plugin_menu_sort (gconstpointer a,
   if (hidden_a != hidden_b)
     return hidden_a ? -1 : 1;
 
-  display_name_a = g_file_info_get_display_name (G_FILE_INFO (a));
-  display_name_b = g_file_info_get_display_name (G_FILE_INFO (b));
-  sort_display_name_a = g_utf8_collate_key_for_filename (display_name_a, -1);
-  sort_display_name_b = g_utf8_collate_key_for_filename (display_name_b, -1);
-  sort_value = strcmp (sort_display_name_a,
-                       sort_display_name_b);
-  g_free (sort_display_name_a);
-  g_free (sort_display_name_b);
-  return sort_value;
+  /* collate keys are set when collecting the infos */
+  return strcmp (g_object_get_qdata (G_OBJECT (a), menu_sort_key),
+                 g_object_get_qdata (G_OBJECT (b), menu_sort_key));
 }
 
 
@@ -1036,31 +1090,50 @@ directory_menu_plugin_menu_new_document (GtkWidget *mi,
 
 
 
-static void
-directory_menu_plugin_menu_unload (GtkWidget *menu)
+static gboolean
+directory_menu_plugin_cache_filter (DirectoryMenuPlugin *plugin,
+                                    GFileInfo *info)
 {
-  /* delay destruction so we can handle the activate event first */
-  gtk_container_foreach (GTK_CONTAINER (menu),
-                         (GtkCallback) (void (*) (void)) panel_utils_destroy_later, NULL);
+  const gchar *display_name;
+  GSList *li;
+
+  display_name = g_file_info_get_display_name (info);
+  if (G_UNLIKELY (display_name == NULL))
+    return FALSE;
+
+  /* skip hidden files if disabled by the user */
+  if (!plugin->hidden_files
+      && g_file_info_get_is_hidden (info))
+    return FALSE;
+
+  /* if the file is not a directory, check the file patterns */
+  if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
+    {
+      for (li = plugin->patterns; li != NULL; li = li->next)
+        if (g_pattern_spec_match_string (li->data, display_name))
+          return TRUE;
+
+      return FALSE;
+    }
+
+  return TRUE;
 }
 
 
 
 static void
-directory_menu_plugin_menu_load (GtkWidget *menu,
-                                 DirectoryMenuPlugin *plugin)
+directory_menu_plugin_menu_fill (GtkWidget *menu,
+                                 DirectoryMenuCache *cache)
 {
-  GFileEnumerator *iter;
+  DirectoryMenuPlugin *plugin = cache->plugin;
   GFileInfo *info;
   GtkWidget *mi;
   const gchar *display_name;
-  GSList *li, *infos = NULL;
+  GList *li;
   GIcon *icon;
   GtkWidget *image;
   GtkWidget *submenu;
   GFile *file;
-  GFile *dir;
-  gboolean visible;
   GFileType file_type;
   GDesktopAppInfo *desktopinfo;
   const gchar *description;
@@ -1068,6 +1141,376 @@ directory_menu_plugin_menu_load (GtkWidget *menu,
   panel_return_if_fail (DIRECTORY_MENU_IS_PLUGIN (plugin));
   panel_return_if_fail (GTK_IS_MENU (menu));
 
+  /* remove the loading item */
+  mi = g_object_get_qdata (G_OBJECT (menu), menu_placeholder);
+  if (mi != NULL)
+    {
+      g_object_set_qdata (G_OBJECT (menu), menu_placeholder, NULL);
+      gtk_widget_destroy (mi);
+    }
+
+  if (G_LIKELY (cache->infos != NULL
+                && (plugin->open_folder || plugin->open_in_terminal)))
+    {
+      mi = gtk_separator_menu_item_new ();
+      gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
+      gtk_widget_show (mi);
+    }
+
+  for (li = cache->infos; li != NULL; li = li->next)
+    {
+      info = G_FILE_INFO (li->data);
+      file_type = g_file_info_get_file_type (info);
+      display_name = g_file_info_get_display_name (info);
+
+      file = g_file_get_child (cache->file, g_file_info_get_name (info));
+      icon = NULL;
+
+      /* for native desktop files we make an exception and try
+       * to load them like a normal menu */
+      desktopinfo = NULL;
+      if (G_UNLIKELY (file_type != G_FILE_TYPE_DIRECTORY
+                      && g_file_is_native (file)
+                      && g_str_has_suffix (display_name, ".desktop")))
+        {
+          desktopinfo = g_desktop_app_info_new_from_filename (g_file_peek_path (file));
+          if (G_LIKELY (desktopinfo != NULL))
+            {
+              display_name = g_app_info_get_name (G_APP_INFO (desktopinfo));
+              icon = g_app_info_get_icon (G_APP_INFO (desktopinfo));
+
+              /* ignore invalid or hidden files */
+              if (xfce_str_is_empty (display_name)
+                  || g_desktop_app_info_get_is_hidden (desktopinfo))
+                {
+                  g_object_unref (G_OBJECT (desktopinfo));
+                  g_object_unref (G_OBJECT (file));
+                  continue;
+                }
+            }
+        }
+
+      mi = panel_image_menu_item_new_with_label (display_name);
+      gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
+      gtk_widget_show (mi);
+
+      if (G_LIKELY (icon == NULL))
+        icon = g_file_info_get_icon (info);
+      if (G_LIKELY (icon != NULL))
+        {
+          image = gtk_image_new_from_gicon (icon, GTK_ICON_SIZE_MENU);
+          panel_image_menu_item_set_image (mi, image);
+          gtk_widget_show (image);
+        }
+
+      /* set a submenu for directories, loaded when it is shown */
+      if (G_LIKELY (file_type == G_FILE_TYPE_DIRECTORY))
+        {
+          submenu = gtk_menu_new ();
+          gtk_menu_item_set_submenu (GTK_MENU_ITEM (mi), submenu);
+          g_object_set_qdata_full (G_OBJECT (submenu), menu_file, file, g_object_unref);
+
+          g_signal_connect (G_OBJECT (submenu), "show",
+                            G_CALLBACK (directory_menu_plugin_menu_load), plugin);
+          g_signal_connect_after (G_OBJECT (submenu), "hide",
+                                  G_CALLBACK (directory_menu_plugin_menu_unload), NULL);
+        }
+      else if (G_UNLIKELY (desktopinfo != NULL))
+        {
+          description = g_app_info_get_description (G_APP_INFO (desktopinfo));
+          if (!xfce_str_is_empty (description))
+            gtk_widget_set_tooltip_text (mi, description);
+
+          g_signal_connect_data (G_OBJECT (mi), "activate",
+                                 G_CALLBACK (directory_menu_plugin_menu_launch_desktop_file),
+                                 desktopinfo, (GClosureNotify) (void (*) (void)) g_object_unref, 0);
+
+          g_object_unref (G_OBJECT (file));
+        }
+      else
+        {
+          g_signal_connect_data (G_OBJECT (mi), "activate",
+                                 G_CALLBACK (directory_menu_plugin_menu_launch), file,
+                                 (GClosureNotify) (void (*) (void)) g_object_unref, 0);
+        }
+    }
+}
+
+
+
+static void
+directory_menu_plugin_cache_menu_destroyed (gpointer data,
+                                            GObject *where_the_object_was)
+{
+  DirectoryMenuCache *cache = data;
+
+  cache->menus = g_slist_remove (cache->menus, where_the_object_was);
+}
+
+
+
+static void
+directory_menu_plugin_cache_remove_menu (DirectoryMenuCache *cache,
+                                         GtkWidget *menu)
+{
+  g_object_weak_unref (G_OBJECT (menu), directory_menu_plugin_cache_menu_destroyed, cache);
+  g_object_set_qdata (G_OBJECT (menu), menu_cache, NULL);
+  cache->menus = g_slist_remove (cache->menus, menu);
+}
+
+
+
+static void
+directory_menu_plugin_cache_load_finish (DirectoryMenuLoad *load,
+                                         gboolean succeeded)
+{
+  DirectoryMenuCache *cache = load->cache;
+  GtkWidget *menu;
+
+  /* the cache is gone or invalidated, ignore the result */
+  if (!g_cancellable_is_cancelled (load->cancellable))
+    {
+      g_clear_object (&cache->cancellable);
+
+      /* a merge sort, in one go, once everything is collected */
+      cache->infos = g_list_sort (load->infos, directory_menu_plugin_menu_sort);
+      load->infos = NULL;
+
+      while (cache->menus != NULL)
+        {
+          menu = cache->menus->data;
+          directory_menu_plugin_cache_remove_menu (cache, menu);
+          directory_menu_plugin_menu_fill (menu, cache);
+
+          /* the menu grew while it was already shown */
+          if (gtk_widget_get_visible (menu))
+            gtk_menu_reposition (GTK_MENU (menu));
+        }
+
+      /* only keep the result if we will notice when it becomes outdated */
+      if (!succeeded || cache->stale || cache->monitor == NULL)
+        g_hash_table_remove (cache->plugin->caches, cache->file);
+      else
+        cache->loaded = TRUE;
+    }
+
+  if (load->enumerator != NULL)
+    {
+      g_file_enumerator_close_async (load->enumerator, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+      g_object_unref (G_OBJECT (load->enumerator));
+    }
+
+  g_list_free_full (load->infos, g_object_unref);
+  g_object_unref (G_OBJECT (load->cancellable));
+  g_slice_free (DirectoryMenuLoad, load);
+}
+
+
+
+static void
+directory_menu_plugin_cache_next_files (GObject *source_object,
+                                        GAsyncResult *result,
+                                        gpointer user_data)
+{
+  DirectoryMenuLoad *load = user_data;
+  GFileInfo *info;
+  GList *infos, *li;
+  GError *error = NULL;
+
+  infos = g_file_enumerator_next_files_finish (G_FILE_ENUMERATOR (source_object), result, &error);
+  if (infos == NULL || g_cancellable_is_cancelled (load->cancellable))
+    {
+      g_list_free_full (infos, g_object_unref);
+      directory_menu_plugin_cache_load_finish (load, error == NULL);
+      if (error != NULL)
+        g_error_free (error);
+      return;
+    }
+
+  for (li = infos; li != NULL; li = li->next)
+    {
+      info = G_FILE_INFO (li->data);
+      if (directory_menu_plugin_cache_filter (load->cache->plugin, info))
+        {
+          /* collate once instead of on every comparison */
+          g_object_set_qdata_full (G_OBJECT (info), menu_sort_key,
+                                   g_utf8_collate_key_for_filename (g_file_info_get_display_name (info), -1),
+                                   g_free);
+          load->infos = g_list_prepend (load->infos, info);
+        }
+      else
+        {
+          g_object_unref (G_OBJECT (info));
+        }
+    }
+
+  g_list_free (infos);
+
+  g_file_enumerator_next_files_async (load->enumerator, N_FILES_PER_REQUEST, G_PRIORITY_DEFAULT,
+                                      load->cancellable, directory_menu_plugin_cache_next_files, load);
+}
+
+
+
+static void
+directory_menu_plugin_cache_enumerated (GObject *source_object,
+                                        GAsyncResult *result,
+                                        gpointer user_data)
+{
+  DirectoryMenuLoad *load = user_data;
+
+  load->enumerator = g_file_enumerate_children_finish (G_FILE (source_object), result, NULL);
+  if (load->enumerator == NULL)
+    {
+      directory_menu_plugin_cache_load_finish (load, FALSE);
+      return;
+    }
+
+  g_file_enumerator_next_files_async (load->enumerator, N_FILES_PER_REQUEST, G_PRIORITY_DEFAULT,
+                                      load->cancellable, directory_menu_plugin_cache_next_files, load);
+}
+
+
+
+static void
+directory_menu_plugin_cache_changed (GFileMonitor *monitor,
+                                     GFile *file,
+                                     GFile *other_file,
+                                     GFileMonitorEvent event_type,
+                                     DirectoryMenuCache *cache)
+{
+  /* only the list of files is cached, not their contents */
+  if (event_type == G_FILE_MONITOR_EVENT_CHANGED
+      || event_type == G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT)
+    return;
+
+  /* let a running enumeration fill its menus, but not the cache */
+  if (cache->cancellable != NULL)
+    cache->stale = TRUE;
+  else
+    g_hash_table_remove (cache->plugin->caches, cache->file);
+}
+
+
+
+static void
+directory_menu_plugin_cache_free (gpointer data)
+{
+  DirectoryMenuCache *cache = data;
+
+  if (cache->cancellable != NULL)
+    {
+      g_cancellable_cancel (cache->cancellable);
+      g_object_unref (G_OBJECT (cache->cancellable));
+    }
+
+  while (cache->menus != NULL)
+    directory_menu_plugin_cache_remove_menu (cache, cache->menus->data);
+
+  if (cache->monitor != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (G_OBJECT (cache->monitor),
+                                            directory_menu_plugin_cache_changed, cache);
+      g_file_monitor_cancel (cache->monitor);
+      g_object_unref (G_OBJECT (cache->monitor));
+    }
+
+  g_queue_unlink (&cache->plugin->caches_lru, &cache->lru_link);
+  g_list_free_full (cache->infos, g_object_unref);
+  g_object_unref (G_OBJECT (cache->file));
+  g_slice_free (DirectoryMenuCache, cache);
+}
+
+
+
+static DirectoryMenuCache *
+directory_menu_plugin_cache_get (DirectoryMenuPlugin *plugin,
+                                 GFile *dir)
+{
+  DirectoryMenuCache *cache;
+  DirectoryMenuLoad *load;
+  GList *li, *prev;
+
+  cache = g_hash_table_lookup (plugin->caches, dir);
+  if (cache != NULL)
+    {
+      /* move to the front of the lru list */
+      g_queue_unlink (&plugin->caches_lru, &cache->lru_link);
+      g_queue_push_head_link (&plugin->caches_lru, &cache->lru_link);
+      return cache;
+    }
+
+  /* drop the least recently used directories nobody is waiting for */
+  for (li = plugin->caches_lru.tail;
+       li != NULL && plugin->caches_lru.length >= MAX_CACHED_DIRECTORIES;
+       li = prev)
+    {
+      prev = li->prev;
+      if (((DirectoryMenuCache *) li->data)->menus == NULL)
+        g_hash_table_remove (plugin->caches, ((DirectoryMenuCache *) li->data)->file);
+    }
+
+  cache = g_slice_new0 (DirectoryMenuCache);
+  cache->plugin = plugin;
+  cache->file = g_object_ref (dir);
+  cache->lru_link.data = cache;
+  g_queue_push_head_link (&plugin->caches_lru, &cache->lru_link);
+  g_hash_table_insert (plugin->caches, cache->file, cache);
+
+  cache->monitor = g_file_monitor_directory (dir, G_FILE_MONITOR_WATCH_MOVES, NULL, NULL);
+  if (G_LIKELY (cache->monitor != NULL))
+    g_signal_connect (G_OBJECT (cache->monitor), "changed",
+                      G_CALLBACK (directory_menu_plugin_cache_changed), cache);
+
+  /* start enumerating, the result is cached even if the menu is closed meanwhile */
+  cache->cancellable = g_cancellable_new ();
+  load = g_slice_new0 (DirectoryMenuLoad);
+  load->cache = cache;
+  load->cancellable = g_object_ref (cache->cancellable);
+  g_file_enumerate_children_async (dir,
+                                   G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME
+                                   "," G_FILE_ATTRIBUTE_STANDARD_NAME
+                                   "," G_FILE_ATTRIBUTE_STANDARD_TYPE
+                                   "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN
+                                   "," G_FILE_ATTRIBUTE_STANDARD_ICON,
+                                   G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT, load->cancellable,
+                                   directory_menu_plugin_cache_enumerated, load);
+
+  return cache;
+}
+
+
+
+static void
+directory_menu_plugin_menu_unload (GtkWidget *menu)
+{
+  DirectoryMenuCache *cache;
+
+  /* no need to fill the menu anymore */
+  cache = g_object_get_qdata (G_OBJECT (menu), menu_cache);
+  if (cache != NULL)
+    directory_menu_plugin_cache_remove_menu (cache, menu);
+  g_object_set_qdata (G_OBJECT (menu), menu_placeholder, NULL);
+
+  /* delay destruction so we can handle the activate event first */
+  gtk_container_foreach (GTK_CONTAINER (menu),
+                         (GtkCallback) (void (*) (void)) panel_utils_destroy_later, NULL);
+}
+
+
+
+static void
+directory_menu_plugin_menu_load (GtkWidget *menu,
+                                 DirectoryMenuPlugin *plugin)
+{
+  DirectoryMenuCache *cache;
+  GtkWidget *mi;
+  GtkWidget *image;
+  GFile *dir;
+
+  panel_return_if_fail (DIRECTORY_MENU_IS_PLUGIN (plugin));
+  panel_return_if_fail (GTK_IS_MENU (menu));
+
   dir = g_object_get_qdata (G_OBJECT (menu), menu_file);
   panel_return_if_fail (G_IS_FILE (dir));
   if (G_UNLIKELY (dir == NULL))
@@ -1129,153 +1572,23 @@ directory_menu_plugin_menu_load (GtkWidget *menu,
       gtk_widget_show (image);
     }
 
-  iter = g_file_enumerate_children (dir,
-                                    G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME
-                                    "," G_FILE_ATTRIBUTE_STANDARD_NAME
-                                    "," G_FILE_ATTRIBUTE_STANDARD_TYPE
-                                    "," G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN
-                                    "," G_FILE_ATTRIBUTE_STANDARD_ICON,
-                                    G_FILE_QUERY_INFO_NONE, NULL, NULL);
-  if (G_LIKELY (iter != NULL))
+  cache = directory_menu_plugin_cache_get (plugin, dir);
+  if (cache->loaded)
     {
-      for (;;)
-        {
-          info = g_file_enumerator_next_file (iter, NULL, NULL);
-          if (G_UNLIKELY (info == NULL))
-            break;
-
-          /* skip hidden files if disabled by the user */
-          if (!plugin->hidden_files
-              && g_file_info_get_is_hidden (info))
-            {
-              g_object_unref (G_OBJECT (info));
-              continue;
-            }
-
-          /* if the file is not a directory, check the file patterns */
-          if (g_file_info_get_file_type (info) != G_FILE_TYPE_DIRECTORY)
-            {
-              if (plugin->patterns == NULL)
-                {
-                  g_object_unref (G_OBJECT (info));
-                  continue;
-                }
-
-              visible = FALSE;
-              display_name = g_file_info_get_display_name (info);
-              if (G_LIKELY (display_name != NULL))
-                for (li = plugin->patterns; !visible && li != NULL; li = li->next)
-                  if (g_pattern_spec_match_string (li->data, display_name))
-                    visible = TRUE;
-
-              if (!visible)
-                {
-                  g_object_unref (G_OBJECT (info));
-                  continue;
-                }
-            }
-
-          infos = g_slist_insert_sorted (infos, info, directory_menu_plugin_menu_sort);
-        }
-
-      g_object_unref (G_OBJECT (iter));
-
-      if (G_LIKELY (infos != NULL
-                    && (plugin->open_folder || plugin->open_in_terminal)))
-        {
-          mi = gtk_separator_menu_item_new ();
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
-          gtk_widget_show (mi);
-        }
-
-      for (li = infos; li != NULL; li = li->next)
-        {
-          info = G_FILE_INFO (li->data);
-          file_type = g_file_info_get_file_type (info);
-
-          display_name = g_file_info_get_display_name (info);
-          if (G_UNLIKELY (display_name == NULL))
-            {
-              g_object_unref (G_OBJECT (info));
-              continue;
-            }
-
-          file = g_file_get_child (dir, g_file_info_get_name (info));
-          icon = NULL;
-
-          /* for native desktop files we make an exception and try
-           * to load them like a normal menu */
-          desktopinfo = NULL;
-          if (G_UNLIKELY (file_type != G_FILE_TYPE_DIRECTORY
-                          && g_file_is_native (file)
-                          && g_str_has_suffix (display_name, ".desktop")))
-            {
-              desktopinfo = g_desktop_app_info_new_from_filename (g_file_peek_path (file));
-              if (G_LIKELY (desktopinfo != NULL))
-                {
-                  display_name = g_app_info_get_name (G_APP_INFO (desktopinfo));
-                  icon = g_app_info_get_icon (G_APP_INFO (desktopinfo));
-
-                  /* ignore invalid or hidden files */
-                  if (xfce_str_is_empty (display_name)
-                      || g_desktop_app_info_get_is_hidden (desktopinfo))
-                    {
-                      g_object_unref (G_OBJECT (desktopinfo));
-                      g_object_unref (G_OBJECT (info));
-                      g_object_unref (G_OBJECT (file));
-                      continue;
-                    }
-                }
-            }
-
-          mi = panel_image_menu_item_new_with_label (display_name);
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
-          gtk_widget_show (mi);
-
-          if (G_LIKELY (icon == NULL))
-            icon = g_file_info_get_icon (info);
-          if (G_LIKELY (icon != NULL))
-            {
-              image = gtk_image_new_from_gicon (icon, GTK_ICON_SIZE_MENU);
-              panel_image_menu_item_set_image (mi, image);
-              gtk_widget_show (image);
-            }
-
-          /* set a submenu for directories */
-          if (G_LIKELY (file_type == G_FILE_TYPE_DIRECTORY))
-            {
-              submenu = gtk_menu_new ();
-              gtk_menu_item_set_submenu (GTK_MENU_ITEM (mi), submenu);
-              g_object_set_qdata_full (G_OBJECT (submenu), menu_file, file, g_object_unref);
-
-              g_signal_connect (G_OBJECT (submenu), "show",
-                                G_CALLBACK (directory_menu_plugin_menu_load), plugin);
-              g_signal_connect_after (G_OBJECT (submenu), "hide",
-                                      G_CALLBACK (directory_menu_plugin_menu_unload), NULL);
-            }
-          else if (G_UNLIKELY (desktopinfo != NULL))
-            {
-              description = g_app_info_get_description (G_APP_INFO (desktopinfo));
-              if (!xfce_str_is_empty (description))
-                gtk_widget_set_tooltip_text (mi, description);
-
-              g_signal_connect_data (G_OBJECT (mi), "activate",
-                                     G_CALLBACK (directory_menu_plugin_menu_launch_desktop_file),
-                                     desktopinfo, (GClosureNotify) (void (*) (void)) g_object_unref, 0);
-
-              g_object_unref (G_OBJECT (file));
-            }
-          else
-            {
-              g_signal_connect_data (G_OBJECT (mi), "activate",
-                                     G_CALLBACK (directory_menu_plugin_menu_launch), file,
-                                     (GClosureNotify) (void (*) (void)) g_object_unref, 0);
-            }
-
-          g_object_unref (G_OBJECT (info));
-        }
+      directory_menu_plugin_menu_fill (menu, cache);
+    }
+  else
+    {
+      /* show a placeholder until the enumeration finishes */
+      mi = gtk_menu_item_new_with_label (_("Loading..."));
+      gtk_widget_set_sensitive (mi, FALSE);
+      gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
+      gtk_widget_show (mi);
+      g_object_set_qdata (G_OBJECT (menu), menu_placeholder, mi);
 
-      g_slist_free (infos);
+      g_object_set_qdata (G_OBJECT (menu), menu_cache, cache);
+      g_object_weak_ref (G_OBJECT (menu), directory_menu_plugin_cache_menu_destroyed, cache);
+      cache->menus = g_slist_prepend (cache->menus, menu);
     }
 }
 
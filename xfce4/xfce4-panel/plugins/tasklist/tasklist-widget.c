@@ -72,6 +72,7 @@
 #define ARROW_BUTTON_SIZE (20)
 #define WIREFRAME_SIZE (5) /* same as xfwm4 */
 #define DRAG_ACTIVATE_TIMEOUT (500)
+#define RECENT_FILES_MAX_ITEMS (10)
 
 
 /* locking helpers for tasklist->locked */
@@ -154,6 +155,13 @@ enum
   PROP_SHOW_WINDOW_PREVIEWS
 };
 
+/* bounded list of recently used files, newest first */
+typedef struct _XfceTasklistRecentFiles
+{
+  GtkRecentInfo *infos[RECENT_FILES_MAX_ITEMS];
+  guint n_infos;
+} XfceTasklistRecentFiles;
+
 struct _XfceTasklist
 {
   GtkContainer __parent__;
@@ -250,6 +258,13 @@ struct _XfceTasklist
   guint show_recent_files : 1;
   GtkRecentManager *recent_manager;
 
+  /* lowercased application name -> XfceTasklistRecentFiles and the
+   * files of all applications, rebuilt in an idle when the recent
+   * manager changes so the menu only has to merge a few lists */
+  GHashTable *recent_index;
+  XfceTasklistRecentFiles recent_all;
+  guint recent_index_id;
+
   /* window preview feature */
   guint show_window_previews : 1;
   GtkWidget *preview_window;
@@ -486,6 +501,13 @@ static void
 xfce_tasklist_window_button_menu_regroup (XfceTasklistChild *window_child);
 
 /* recent files functions */
+static void
+xfce_tasklist_set_show_recent_files (XfceTasklist *tasklist,
+                                     gboolean show_recent_files);
+static void
+xfce_tasklist_recent_index_queue_rebuild (XfceTasklist *tasklist);
+static void
+xfce_tasklist_recent_index_clear (XfceTasklist *tasklist);
 static GList *
 xfce_tasklist_get_recent_files_for_app (XfceTasklist *tasklist,
                                         XfwApplication *app);
@@ -782,6 +804,8 @@ xfce_tasklist_init (XfceTasklist *tasklist)
   tasklist->menu_max_width_chars = DEFAULT_MENU_MAX_WIDTH_CHARS;
   tasklist->show_recent_files = FALSE;
   tasklist->recent_manager = gtk_recent_manager_get_default ();
+  tasklist->recent_index = NULL;
+  tasklist->recent_index_id = 0;
 
   tasklist->show_window_previews = TRUE;
   tasklist->preview_window = NULL;
@@ -976,7 +1000,7 @@ xfce_tasklist_set_property (GObject *object,
       break;
 
     case PROP_SHOW_RECENT_FILES:
-      tasklist->show_recent_files = g_value_get_boolean (value);
+      xfce_tasklist_set_show_recent_files (tasklist, g_value_get_boolean (value));
       break;
 
     case PROP_SHOW_WINDOW_PREVIEWS:
@@ -1007,6 +1031,12 @@ xfce_tasklist_finalize (GObject *object)
   if (tasklist->update_monitor_geometry_id != 0)
     g_source_remove (tasklist->update_monitor_geometry_id);
 
+  /* stop watching the recently used files */
+  if (tasklist->recent_manager != NULL)
+    g_signal_handlers_disconnect_by_func (tasklist->recent_manager,
+                                          xfce_tasklist_recent_index_queue_rebuild, tasklist);
+  xfce_tasklist_recent_index_clear (tasklist);
+
 #ifdef ENABLE_X11
   /* destroy the wireframe window */
   xfce_tasklist_wireframe_destroy (tasklist);
@@ -5364,57 +5394,79 @@ xfce_tasklist_monitors_to_include_changed (GtkComboBox *combobox,
  * Recent Files Implementation
  **/
 
-/* Comparison function to sort recent files by timestamp (most recent first) */
-static gint
-xfce_tasklist_recent_files_sort_by_time (gconstpointer a,
-                                         gconstpointer b)
-{
-  GtkRecentInfo *info_a = (GtkRecentInfo *) a;
-  GtkRecentInfo *info_b = (GtkRecentInfo *) b;
-  time_t time_a = gtk_recent_info_get_modified (info_a);
-  time_t time_b = gtk_recent_info_get_modified (info_b);
-
-  if (time_a > time_b)
-    return -1;
-  else if (time_a < time_b)
-    return 1;
-  else
-    return 0;
+static void
+xfce_tasklist_recent_files_insert (XfceTasklistRecentFiles *files,
+                                   GtkRecentInfo *info)
+{
+  time_t modified = gtk_recent_info_get_modified (info);
+  guint n;
+
+  /* older than all the files in a full list */
+  if (files->n_infos == RECENT_FILES_MAX_ITEMS
+      && modified <= gtk_recent_info_get_modified (files->infos[RECENT_FILES_MAX_ITEMS - 1]))
+    return;
+
+  /* the same file can be reached through several application names */
+  for (n = 0; n < files->n_infos; n++)
+    if (files->infos[n] == info)
+      return;
+
+  /* make room by dropping the oldest file */
+  if (files->n_infos == RECENT_FILES_MAX_ITEMS)
+    gtk_recent_info_unref (files->infos[--files->n_infos]);
+
+  /* insert behind files with the same time, so those keep their order */
+  for (n = files->n_infos; n > 0 && gtk_recent_info_get_modified (files->infos[n - 1]) < modified; n--)
+    files->infos[n] = files->infos[n - 1];
+
+  files->infos[n] = gtk_recent_info_ref (info);
+  files->n_infos++;
 }
 
 
 
-static GList *
-xfce_tasklist_get_recent_files_for_app (XfceTasklist *tasklist,
-                                        XfwApplication *app)
+static void
+xfce_tasklist_recent_files_clear (XfceTasklistRecentFiles *files)
 {
-  GList *all_items, *filtered_items = NULL;
-  GList *li;
-  GtkRecentInfo *info;
-  const gchar *app_name = NULL;
-  const gchar *app_class_id = NULL;
-  gint count = 0;
-  const gint max_items = 10;
+  while (files->n_infos > 0)
+    gtk_recent_info_unref (files->infos[--files->n_infos]);
+}
 
-  panel_return_val_if_fail (XFCE_IS_TASKLIST (tasklist), NULL);
 
-  if (tasklist->recent_manager == NULL)
-    return NULL;
 
-  if (app != NULL)
-    {
-      app_name = xfw_application_get_name (app);
-      app_class_id = xfw_application_get_class_id (app);
-    }
+static void
+xfce_tasklist_recent_files_free (gpointer data)
+{
+  xfce_tasklist_recent_files_clear (data);
+  g_slice_free (XfceTasklistRecentFiles, data);
+}
+
+
 
-  all_items = gtk_recent_manager_get_items (tasklist->recent_manager);
+static void
+xfce_tasklist_recent_index_rebuild (XfceTasklist *tasklist)
+{
+  GList *items, *li;
+  GtkRecentInfo *info;
+  XfceTasklistRecentFiles *files;
+  gchar **apps;
+  gchar *key;
+  guint i;
+
+  panel_return_if_fail (GTK_IS_RECENT_MANAGER (tasklist->recent_manager));
+
+  if (tasklist->recent_index == NULL)
+    tasklist->recent_index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                    xfce_tasklist_recent_files_free);
+  else
+    g_hash_table_remove_all (tasklist->recent_index);
 
-  /* Sort by modification time */
-  all_items = g_list_sort (all_items, xfce_tasklist_recent_files_sort_by_time);
+  xfce_tasklist_recent_files_clear (&tasklist->recent_all);
 
-  for (li = all_items; li != NULL && count < max_items; li = li->next)
+  items = gtk_recent_manager_get_items (tasklist->recent_manager);
+  for (li = items; li != NULL; li = li->next)
     {
-      info = (GtkRecentInfo *) li->data;
+      info = li->data;
 
       /* Skip if not local file */
       if (!gtk_recent_info_is_local (info))
@@ -5424,72 +5476,187 @@ xfce_tasklist_get_recent_files_for_app (XfceTasklist *tasklist,
        * for files on mounted drives or network shares. Let the user see
        * the recent file and handle errors when opening. */
 
-      /* If we have an app, try to filter by it */
-      if (app != NULL)
-        {
-          gboolean matches = FALSE;
-          gchar **apps = gtk_recent_info_get_applications (info, NULL);
+      xfce_tasklist_recent_files_insert (&tasklist->recent_all, info);
+
+      apps = gtk_recent_info_get_applications (info, NULL);
+      if (apps == NULL)
+        continue;
 
-          if (apps != NULL)
+      for (i = 0; apps[i] != NULL; i++)
+        {
+          key = g_ascii_strdown (apps[i], -1);
+          files = g_hash_table_lookup (tasklist->recent_index, key);
+          if (files == NULL)
             {
-              for (gint i = 0; apps[i] != NULL; i++)
-                {
-                  /* Check if app name or class id is in the list */
-                  if ((app_name != NULL && g_ascii_strcasecmp (apps[i], app_name) == 0)
-                      || (app_class_id != NULL && g_ascii_strcasecmp (apps[i], app_class_id) == 0))
-                    {
-                      matches = TRUE;
-                      break;
-                    }
-                  /* Also try to match by exe name (e.g., "firefox" in "Firefox") */
-                  if (app_class_id != NULL)
-                    {
-                      gchar *lower_app = g_ascii_strdown (apps[i], -1);
-                      gchar *lower_class = g_ascii_strdown (app_class_id, -1);
-                      if (g_str_has_prefix (lower_app, lower_class) || g_str_has_prefix (lower_class, lower_app))
-                        matches = TRUE;
-                      g_free (lower_app);
-                      g_free (lower_class);
-                      if (matches)
-                        break;
-                    }
-                }
-              g_strfreev (apps);
+              files = g_slice_new0 (XfceTasklistRecentFiles);
+              g_hash_table_insert (tasklist->recent_index, key, files);
             }
+          else
+            g_free (key);
 
-          if (!matches)
-            continue;
+          xfce_tasklist_recent_files_insert (files, info);
         }
 
-      /* Add to filtered list */
-      filtered_items = g_list_append (filtered_items, gtk_recent_info_ref (info));
-      count++;
+      g_strfreev (apps);
     }
 
-  /* Free all items */
-  g_list_free_full (all_items, (GDestroyNotify) gtk_recent_info_unref);
+  g_list_free_full (items, (GDestroyNotify) gtk_recent_info_unref);
+}
 
-  /* If no app-specific items found, return generic recent files as fallback */
-  if (filtered_items == NULL)
+
+
+static gboolean
+xfce_tasklist_recent_index_idle (gpointer data)
+{
+  XfceTasklist *tasklist = XFCE_TASKLIST (data);
+
+  panel_return_val_if_fail (XFCE_IS_TASKLIST (tasklist), FALSE);
+
+  xfce_tasklist_recent_index_rebuild (tasklist);
+
+  return FALSE;
+}
+
+
+
+static void
+xfce_tasklist_recent_index_idle_destroy (gpointer data)
+{
+  XFCE_TASKLIST (data)->recent_index_id = 0;
+}
+
+
+
+static void
+xfce_tasklist_recent_index_queue_rebuild (XfceTasklist *tasklist)
+{
+  panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+
+  /* the changed signal has no details, so collapse a burst of
+   * changes into a single rebuild */
+  if (tasklist->recent_index_id == 0)
     {
-      all_items = gtk_recent_manager_get_items (tasklist->recent_manager);
-      all_items = g_list_sort (all_items, xfce_tasklist_recent_files_sort_by_time);
+      tasklist->recent_index_id =
+        gdk_threads_add_idle_full (G_PRIORITY_LOW, xfce_tasklist_recent_index_idle,
+                                   tasklist, xfce_tasklist_recent_index_idle_destroy);
+    }
+}
+
+
+
+static void
+xfce_tasklist_recent_index_clear (XfceTasklist *tasklist)
+{
+  if (tasklist->recent_index_id != 0)
+    g_source_remove (tasklist->recent_index_id);
+
+  if (tasklist->recent_index != NULL)
+    {
+      g_hash_table_destroy (tasklist->recent_index);
+      tasklist->recent_index = NULL;
+    }
+
+  xfce_tasklist_recent_files_clear (&tasklist->recent_all);
+}
+
+
+
+static void
+xfce_tasklist_set_show_recent_files (XfceTasklist *tasklist,
+                                     gboolean show_recent_files)
+{
+  panel_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+
+  show_recent_files = !!show_recent_files;
+
+  if (tasklist->show_recent_files != show_recent_files)
+    {
+      tasklist->show_recent_files = show_recent_files;
+
+      if (tasklist->recent_manager == NULL)
+        return;
 
-      for (li = all_items; li != NULL && count < max_items; li = li->next)
+      /* only keep the index around while the menu can be shown */
+      if (show_recent_files)
         {
-          info = (GtkRecentInfo *) li->data;
+          g_signal_connect_swapped (G_OBJECT (tasklist->recent_manager), "changed",
+                                    G_CALLBACK (xfce_tasklist_recent_index_queue_rebuild), tasklist);
+          xfce_tasklist_recent_index_queue_rebuild (tasklist);
+        }
+      else
+        {
+          g_signal_handlers_disconnect_by_func (tasklist->recent_manager,
+                                                xfce_tasklist_recent_index_queue_rebuild, tasklist);
+          xfce_tasklist_recent_index_clear (tasklist);
+        }
+    }
+}
 
-          if (!gtk_recent_info_is_local (info))
-            continue;
 
-          filtered_items = g_list_append (filtered_items, gtk_recent_info_ref (info));
-          count++;
+
+static GList *
+xfce_tasklist_get_recent_files_for_app (XfceTasklist *tasklist,
+                                        XfwApplication *app)
+{
+  XfceTasklistRecentFiles result = { { NULL }, 0 };
+  XfceTasklistRecentFiles *files;
+  GHashTableIter iter;
+  const gchar *key;
+  gchar *app_name = NULL;
+  gchar *app_class_id = NULL;
+  GList *items = NULL;
+  guint n;
+
+  panel_return_val_if_fail (XFCE_IS_TASKLIST (tasklist), NULL);
+
+  if (tasklist->recent_manager == NULL)
+    return NULL;
+
+  /* don't show stale files if a rebuild is still pending */
+  if (tasklist->recent_index == NULL || tasklist->recent_index_id != 0)
+    {
+      if (tasklist->recent_index_id != 0)
+        g_source_remove (tasklist->recent_index_id);
+      xfce_tasklist_recent_index_rebuild (tasklist);
+    }
+
+  /* If we have an app, merge the files of the matching application names */
+  if (app != NULL)
+    {
+      if (xfw_application_get_name (app) != NULL)
+        app_name = g_ascii_strdown (xfw_application_get_name (app), -1);
+      if (xfw_application_get_class_id (app) != NULL)
+        app_class_id = g_ascii_strdown (xfw_application_get_class_id (app), -1);
+
+      g_hash_table_iter_init (&iter, tasklist->recent_index);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &files))
+        {
+          /* Match the app name or class id, also by exe name (e.g., "firefox" in "Firefox") */
+          if (g_strcmp0 (key, app_name) == 0
+              || (app_class_id != NULL
+                  && (g_str_has_prefix (key, app_class_id) || g_str_has_prefix (app_class_id, key))))
+            {
+              for (n = 0; n < files->n_infos; n++)
+                xfce_tasklist_recent_files_insert (&result, files->infos[n]);
+            }
         }
 
-      g_list_free_full (all_items, (GDestroyNotify) gtk_recent_info_unref);
+      g_free (app_name);
+      g_free (app_class_id);
+    }
+
+  /* If no app-specific items found, return generic recent files as fallback */
+  if (result.n_infos == 0)
+    {
+      for (n = 0; n < tasklist->recent_all.n_infos; n++)
+        xfce_tasklist_recent_files_insert (&result, tasklist->recent_all.infos[n]);
     }
 
-  return filtered_items;
+  /* the list takes over the references */
+  for (n = result.n_infos; n > 0; n--)
+    items = g_list_prepend (items, result.infos[n - 1]);
+
+  return items;
 }
 
 
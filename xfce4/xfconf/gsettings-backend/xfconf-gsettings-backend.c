@@ -225,7 +225,10 @@ xfconf_gsettings_backend_write_tree(GSettingsBackend *backend,
 
     self->nhandled_tree_node = 0;
 
+    /* send the whole tree to xfconfd in one go */
+    xfconf_channel_begin_transaction(self->channel);
     g_tree_foreach(tree, (GTraverseFunc)xfconf_gsettings_backend_tree_traverse, self);
+    xfconf_channel_commit_transaction(self->channel);
 
     /* If we manage to handle all Tree nodes, send the changed signal */
     if (self->nhandled_tree_node == g_tree_nnodes(tree)) {
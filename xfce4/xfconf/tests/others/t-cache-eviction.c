@@ -0,0 +1,97 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+/* the client side cache of a large channel stays within max-entries,
+ * and evicted properties are fetched again on demand */
+#define EVICTION_CHANNEL_NAME "test-cache-eviction"
+#define N_PROPERTIES 2000
+#define MAX_ENTRIES 100
+
+int
+main(int argc, char **argv)
+{
+    XfconfChannel *channel;
+    gchar property[64];
+    guint64 hits, misses, evictions;
+    guint n_entries, max_n_entries = 0;
+    gsize n_bytes, max_n_bytes = 0;
+    gint i;
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    channel = xfconf_channel_new(EVICTION_CHANNEL_NAME);
+    xfconf_channel_set_cache_limits(channel, MAX_ENTRIES, 0);
+
+    for (i = 0; i < N_PROPERTIES; i++) {
+        g_snprintf(property, sizeof(property), "/group-%d/item-%d", i / 100, i);
+        TEST_OPERATION(xfconf_channel_set_int(channel, property, i));
+    }
+
+    /* the replies to all the set calls are queued once this returns,
+     * and values with a call in flight are never evicted */
+    TEST_OPERATION(xfconf_channel_get_int(channel, "/group-0/item-0", -1) == 0);
+    while (g_main_context_pending(NULL)) {
+        g_main_context_iteration(NULL, FALSE);
+    }
+
+    /* read everything back twice, oldest first, so each lookup misses */
+    for (i = 0; i < 2 * N_PROPERTIES; i++) {
+        g_snprintf(property, sizeof(property), "/group-%d/item-%d",
+                   (i % N_PROPERTIES) / 100, i % N_PROPERTIES);
+        TEST_OPERATION(xfconf_channel_get_int(channel, property, -1) == i % N_PROPERTIES);
+
+        xfconf_channel_get_cache_stats(channel, NULL, NULL, NULL, &n_entries, &n_bytes);
+        max_n_entries = MAX(max_n_entries, n_entries);
+        max_n_bytes = MAX(max_n_bytes, n_bytes);
+    }
+
+    /* the most recently used property is still cached */
+    TEST_OPERATION(xfconf_channel_get_int(channel, property, -1) == N_PROPERTIES - 1);
+    xfconf_channel_get_cache_stats(channel, &hits, &misses, &evictions, &n_entries, &n_bytes);
+
+    g_print("entries: %u (max %u), bytes: %" G_GSIZE_FORMAT " (max %" G_GSIZE_FORMAT ")\n",
+            n_entries, max_n_entries, n_bytes, max_n_bytes);
+    g_print("hits: %" G_GUINT64_FORMAT ", misses: %" G_GUINT64_FORMAT ", evictions: %" G_GUINT64_FORMAT "\n",
+            hits, misses, evictions);
+
+    TEST_OPERATION(max_n_entries <= MAX_ENTRIES);
+    TEST_OPERATION(misses >= 2 * N_PROPERTIES - MAX_ENTRIES);
+    TEST_OPERATION(evictions >= 2 * N_PROPERTIES - MAX_ENTRIES);
+    TEST_OPERATION(hits > 0);
+
+    /* no limit: the cache holds everything again */
+    xfconf_channel_set_cache_limits(channel, -1, 0);
+    for (i = 0; i < N_PROPERTIES; i++) {
+        g_snprintf(property, sizeof(property), "/group-%d/item-%d", i / 100, i);
+        TEST_OPERATION(xfconf_channel_get_int(channel, property, -1) == i);
+    }
+    xfconf_channel_get_cache_stats(channel, NULL, NULL, NULL, &n_entries, NULL);
+    TEST_OPERATION(n_entries >= N_PROPERTIES);
+
+    xfconf_channel_reset_property(channel, "/", TRUE);
+    g_object_unref(G_OBJECT(channel));
+
+    xfconf_tests_end();
+
+    return 0;
+}
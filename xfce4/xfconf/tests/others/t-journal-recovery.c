@@ -0,0 +1,326 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "tests-common.h"
+
+/* kills xfconfd after it appended changes to the journal of a channel,
+ * cuts the last record short like a crash while appending would, and
+ * checks what a restarted xfconfd makes of it, before and after it
+ * compacted the journal into the xml file */
+
+#define JOURNAL_CHANNEL "test-journal"
+#define JOURNAL_BASE "/journal"
+#define TRUNCATED_RECORD "S\t" JOURNAL_BASE "/truncated\t7"
+
+static GDBusConnection *conn = NULL;
+
+static GVariant *
+test_call(const gchar *method,
+          GVariant *parameters,
+          const GVariantType *reply_type)
+{
+    return g_dbus_connection_call_sync(conn,
+                                       XFCONF_SERVICE_NAME_PREFIX ".XfconfTest",
+                                       XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                                       XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                                       method, parameters, reply_type,
+                                       G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+}
+
+static gboolean
+test_set(const gchar *property,
+         GVariant *value)
+{
+    GVariant *ret;
+
+    ret = test_call("SetProperty",
+                    g_variant_new("(ssv)", JOURNAL_CHANNEL, property, value),
+                    NULL);
+    if (ret) {
+        g_variant_unref(ret);
+    }
+
+    return ret != NULL;
+}
+
+static gboolean
+test_reset(const gchar *property,
+           gboolean recursive)
+{
+    GVariant *ret;
+
+    ret = test_call("ResetProperty",
+                    g_variant_new("(ssb)", JOURNAL_CHANNEL, property, recursive),
+                    NULL);
+    if (ret) {
+        g_variant_unref(ret);
+    }
+
+    return ret != NULL;
+}
+
+/* NULL if the property does not exist */
+static GVariant *
+test_get(const gchar *property)
+{
+    GVariant *ret, *value = NULL;
+
+    ret = test_call("GetProperty",
+                    g_variant_new("(ss)", JOURNAL_CHANNEL, property),
+                    G_VARIANT_TYPE("(v)"));
+    if (ret) {
+        g_variant_get(ret, "(v)", &value);
+        g_variant_unref(ret);
+    }
+
+    return value;
+}
+
+static gboolean
+test_get_int(const gchar *property,
+             gint32 expected)
+{
+    GVariant *value = test_get(property);
+    gboolean ret;
+
+    ret = value && g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)
+          && g_variant_get_int32(value) == expected;
+    if (value) {
+        g_variant_unref(value);
+    }
+
+    return ret;
+}
+
+static gboolean
+test_get_string(const gchar *property,
+                const gchar *expected)
+{
+    GVariant *value = test_get(property);
+    gboolean ret;
+
+    ret = value && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)
+          && !strcmp(g_variant_get_string(value, NULL), expected);
+    if (value) {
+        g_variant_unref(value);
+    }
+
+    return ret;
+}
+
+static gboolean
+test_exists(const gchar *property)
+{
+    GVariant *value = test_get(property);
+
+    if (value) {
+        g_variant_unref(value);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+test_daemon_running(void)
+{
+    GVariant *ret;
+    gboolean has_owner = FALSE;
+
+    ret = g_dbus_connection_call_sync(conn,
+                                      "org.freedesktop.DBus",
+                                      "/org/freedesktop/DBus",
+                                      "org.freedesktop.DBus",
+                                      "NameHasOwner",
+                                      g_variant_new("(s)", XFCONF_SERVICE_NAME_PREFIX ".XfconfTest"),
+                                      G_VARIANT_TYPE("(b)"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (ret) {
+        g_variant_get(ret, "(b)", &has_owner);
+        g_variant_unref(ret);
+    }
+
+    return has_owner;
+}
+
+static gboolean
+test_wait_for_daemon(gboolean running)
+{
+    gint64 start = g_get_monotonic_time();
+
+    while (test_daemon_running() != running) {
+        if (g_get_monotonic_time() - start > WAIT_TIMEOUT * G_USEC_PER_SEC) {
+            return FALSE;
+        }
+        g_usleep(10000);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+test_kill_daemon(gint signum)
+{
+    GVariant *ret;
+    guint32 pid;
+
+    ret = g_dbus_connection_call_sync(conn,
+                                      "org.freedesktop.DBus",
+                                      "/org/freedesktop/DBus",
+                                      "org.freedesktop.DBus",
+                                      "GetConnectionUnixProcessID",
+                                      g_variant_new("(s)", XFCONF_SERVICE_NAME_PREFIX ".XfconfTest"),
+                                      G_VARIANT_TYPE("(u)"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (!ret) {
+        return FALSE;
+    }
+    g_variant_get(ret, "(u)", &pid);
+    g_variant_unref(ret);
+
+    return kill(pid, signum) == 0 && test_wait_for_daemon(FALSE);
+}
+
+static gboolean
+test_start_daemon(void)
+{
+    gchar *argv[] = { (gchar *)g_getenv("XFCONFD"), NULL };
+    GError *error = NULL;
+
+    if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_DEFAULT, NULL, NULL, NULL, &error)) {
+        g_critical("Failed to restart xfconfd: %s", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    return test_wait_for_daemon(TRUE);
+}
+
+/* waits for the next write of the channel, which happens a few seconds
+ * after a change */
+static gboolean
+test_wait_for_file(const gchar *filename,
+                   const gchar *contains,
+                   gboolean exists)
+{
+    gint64 start = g_get_monotonic_time();
+    gchar *contents = NULL;
+    gboolean found;
+
+    for (;;) {
+        found = g_file_get_contents(filename, &contents, NULL, NULL);
+        if (found && contains) {
+            found = strstr(contents, contains) != NULL;
+        }
+        if (contents) {
+            g_free(contents);
+            contents = NULL;
+        }
+
+        if (found == exists) {
+            return TRUE;
+        }
+        if (g_get_monotonic_time() - start > 2 * WAIT_TIMEOUT * G_USEC_PER_SEC) {
+            return FALSE;
+        }
+        g_usleep(100000);
+    }
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    gchar *journal_file, *xml_file;
+    FILE *fp;
+
+    if (!g_getenv("XFCONFD")) {
+        /* needs the driver to restart xfconfd */
+        return 77;
+    }
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    TEST_OPERATION(conn != NULL);
+
+    journal_file = g_build_filename(g_get_user_config_dir(),
+                                    "xfce4", "xfconf", "xfce-perchannel-xml",
+                                    JOURNAL_CHANNEL ".journal", NULL);
+    xml_file = g_build_filename(g_get_user_config_dir(),
+                                "xfce4", "xfconf", "xfce-perchannel-xml",
+                                JOURNAL_CHANNEL ".xml", NULL);
+
+    /* start from an empty channel, fails if there is nothing to remove */
+    test_reset("/", TRUE);
+
+    /* set, overwrite and reset, so the journal holds each kind of record */
+    TEST_OPERATION(test_set(JOURNAL_BASE "/int", g_variant_new_int32(1)));
+    TEST_OPERATION(test_set(JOURNAL_BASE "/string", g_variant_new_string(test_string)));
+    TEST_OPERATION(test_set(JOURNAL_BASE "/int", g_variant_new_int32(2)));
+    TEST_OPERATION(test_set(JOURNAL_BASE "/bool", g_variant_new_boolean(TRUE)));
+    TEST_OPERATION(test_reset(JOURNAL_BASE "/bool", FALSE));
+    TEST_OPERATION(test_wait_for_file(journal_file, "U\t" JOURNAL_BASE "/bool\n", TRUE));
+
+    /* crash after the append, and in the middle of the next one */
+    TEST_OPERATION(test_kill_daemon(SIGKILL));
+    fp = fopen(journal_file, "a");
+    TEST_OPERATION(fp != NULL);
+    TEST_OPERATION(fputs(TRUNCATED_RECORD, fp) >= 0);
+    TEST_OPERATION(fclose(fp) == 0);
+
+    /* the complete records are replayed, the truncated one is dropped */
+    TEST_OPERATION(test_start_daemon());
+    TEST_OPERATION(test_get_int(JOURNAL_BASE "/int", 2));
+    TEST_OPERATION(test_get_string(JOURNAL_BASE "/string", test_string));
+    TEST_OPERATION(!test_exists(JOURNAL_BASE "/bool"));
+    TEST_OPERATION(!test_exists(JOURNAL_BASE "/truncated"));
+
+    /* nothing gets appended after a truncated record, the next change
+     * compacts the journal into the xml file instead */
+    TEST_OPERATION(test_set(JOURNAL_BASE "/after", g_variant_new_int32(3)));
+    TEST_OPERATION(test_wait_for_file(journal_file, NULL, FALSE));
+    TEST_OPERATION(g_file_test(xml_file, G_FILE_TEST_IS_REGULAR));
+
+    /* and it all comes back from the xml file alone */
+    TEST_OPERATION(test_kill_daemon(SIGKILL));
+    TEST_OPERATION(test_start_daemon());
+    TEST_OPERATION(test_get_int(JOURNAL_BASE "/int", 2));
+    TEST_OPERATION(test_get_string(JOURNAL_BASE "/string", test_string));
+    TEST_OPERATION(test_get_int(JOURNAL_BASE "/after", 3));
+    TEST_OPERATION(!test_exists(JOURNAL_BASE "/bool"));
+    TEST_OPERATION(!test_exists(JOURNAL_BASE "/truncated"));
+
+    TEST_OPERATION(test_reset("/", TRUE));
+
+    /* the driver only knows the xfconfd it started */
+    TEST_OPERATION(test_kill_daemon(SIGTERM));
+
+    g_free(journal_file);
+    g_free(xml_file);
+    g_object_unref(conn);
+
+    xfconf_tests_end();
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "tests-common.h"
+
+/* get/set throughput of xfconfd on a channel with a lot of properties,
+ * spread over wide sibling lists like in real world panel configs */
+#define LARGE_CHANNEL_NAME "test-large-channel"
+#define N_GROUPS 100
+#define N_ITEMS 500
+
+typedef struct
+{
+    guint pending;
+    guint failed;
+} CallData;
+
+typedef struct
+{
+    CallData *data;
+    gint expected;
+} Call;
+
+static void
+call_done(GObject *source,
+          GAsyncResult *res,
+          gpointer user_data)
+{
+    Call *call = user_data;
+    CallData *data = call->data;
+    GVariant *ret, *value;
+    GError *error = NULL;
+
+    ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+    if (!ret) {
+        g_critical("D-Bus call failed: %s", error->message);
+        g_error_free(error);
+        data->failed++;
+    } else {
+        if (g_variant_is_of_type(ret, G_VARIANT_TYPE("(v)"))) {
+            g_variant_get(ret, "(v)", &value);
+            if (!g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)
+                || g_variant_get_int32(value) != call->expected)
+            {
+                data->failed++;
+            }
+            g_variant_unref(value);
+        }
+        g_variant_unref(ret);
+    }
+
+    data->pending--;
+    g_free(call);
+}
+
+static void
+call_daemon(GDBusConnection *conn,
+            const gchar *method,
+            GVariant *parameters,
+            gint expected,
+            CallData *data)
+{
+    Call *call = g_new(Call, 1);
+
+    call->data = data;
+    call->expected = expected;
+    data->pending++;
+    g_dbus_connection_call(conn,
+                           XFCONF_SERVICE_NAME_PREFIX ".XfconfTest",
+                           XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                           XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                           method, parameters, NULL,
+                           G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+                           call_done, call);
+}
+
+/* sets every property to its number plus |offset|, or checks it has that value */
+static gdouble
+run_all(GDBusConnection *conn,
+        const gchar *method,
+        gint offset,
+        CallData *data)
+{
+    gchar property[64];
+    gint64 start;
+    gint i, j;
+
+    start = g_get_monotonic_time();
+
+    for (i = 0; i < N_GROUPS; i++) {
+        for (j = 0; j < N_ITEMS; j++) {
+            g_snprintf(property, sizeof(property), "/group-%d/item-%d", i, j);
+            if (g_strcmp0(method, "SetProperty") == 0) {
+                call_daemon(conn, method,
+                            g_variant_new("(ssv)", LARGE_CHANNEL_NAME, property,
+                                          g_variant_new_int32(i * N_ITEMS + j + offset)),
+                            0, data);
+            } else {
+                call_daemon(conn, method,
+                            g_variant_new("(ss)", LARGE_CHANNEL_NAME, property),
+                            i * N_ITEMS + j + offset, data);
+            }
+        }
+
+        /* don't queue everything at once */
+        while (data->pending > 1000) {
+            g_main_context_iteration(NULL, TRUE);
+        }
+    }
+
+    while (data->pending > 0) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+
+    return (gdouble)(N_GROUPS * N_ITEMS) * G_USEC_PER_SEC / MAX(g_get_monotonic_time() - start, 1);
+}
+
+int
+main(int argc, char **argv)
+{
+    GDBusConnection *conn;
+    XfconfChannel *channel;
+    CallData data = { 0, 0 };
+    gchar property[64];
+    gdouble rate;
+    gint i;
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    TEST_OPERATION(conn != NULL);
+
+    rate = run_all(conn, "SetProperty", 0, &data);
+    g_print("set (new): %.0f properties/s\n", rate);
+    TEST_OPERATION(data.failed == 0);
+
+    rate = run_all(conn, "SetProperty", 1, &data);
+    g_print("set (existing): %.0f properties/s\n", rate);
+    TEST_OPERATION(data.failed == 0);
+
+    channel = xfconf_channel_new(LARGE_CHANNEL_NAME);
+    for (i = 0; i < N_GROUPS; i += N_GROUPS / 4) {
+        g_snprintf(property, sizeof(property), "/group-%d/item-%d", i, N_ITEMS - 1);
+        TEST_OPERATION(xfconf_channel_get_int(channel, property, -1) == (i + 1) * N_ITEMS);
+    }
+
+    rate = run_all(conn, "GetProperty", 1, &data);
+    g_print("get: %.0f properties/s\n", rate);
+    TEST_OPERATION(data.failed == 0);
+
+    xfconf_channel_reset_property(channel, "/", TRUE);
+    TEST_OPERATION(!xfconf_channel_has_property(channel, "/group-0/item-0"));
+    g_object_unref(G_OBJECT(channel));
+    g_object_unref(conn);
+
+    xfconf_tests_end();
+
+    return 0;
+}
@@ -0,0 +1,461 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "tests-common.h"
+
+/* restarts xfconfd on a channel read from a system and a user xml file,
+ * checks that a current snapshot gives back the same properties as the
+ * xml files and that changing one of the files or the journal makes it
+ * read them again, and times loading the channel from xml and from the
+ * snapshot */
+
+#define SNAPSHOT_CHANNEL "test-snapshot"
+#define SNAPSHOT_BASE "/snapshot"
+#define N_PROPERTIES 20000
+
+static GDBusConnection *conn = NULL;
+
+static GVariant *
+test_call(const gchar *method,
+          GVariant *parameters,
+          const GVariantType *reply_type)
+{
+    return g_dbus_connection_call_sync(conn,
+                                       XFCONF_SERVICE_NAME_PREFIX ".XfconfTest",
+                                       XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                                       XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                                       method, parameters, reply_type,
+                                       G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+}
+
+static gboolean
+test_set(const gchar *property,
+         GVariant *value)
+{
+    GVariant *ret;
+
+    ret = test_call("SetProperty",
+                    g_variant_new("(ssv)", SNAPSHOT_CHANNEL, property, value),
+                    NULL);
+    if (ret) {
+        g_variant_unref(ret);
+    }
+
+    return ret != NULL;
+}
+
+/* NULL if the property does not exist */
+static GVariant *
+test_get(const gchar *property)
+{
+    GVariant *ret, *value = NULL;
+
+    ret = test_call("GetProperty",
+                    g_variant_new("(ss)", SNAPSHOT_CHANNEL, property),
+                    G_VARIANT_TYPE("(v)"));
+    if (ret) {
+        g_variant_get(ret, "(v)", &value);
+        g_variant_unref(ret);
+    }
+
+    return value;
+}
+
+static gboolean
+test_get_int(const gchar *property,
+             gint32 expected)
+{
+    GVariant *value = test_get(property);
+    gboolean ret;
+
+    ret = value && g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)
+          && g_variant_get_int32(value) == expected;
+    if (value) {
+        g_variant_unref(value);
+    }
+
+    return ret;
+}
+
+static gboolean
+test_get_string(const gchar *property,
+                const gchar *expected)
+{
+    GVariant *value = test_get(property);
+    gboolean ret;
+
+    ret = value && g_variant_is_of_type(value, G_VARIANT_TYPE_STRING)
+          && !strcmp(g_variant_get_string(value, NULL), expected);
+    if (value) {
+        g_variant_unref(value);
+    }
+
+    return ret;
+}
+
+/* the whole channel, to compare what xml and snapshot gave */
+static GVariant *
+test_get_all(void)
+{
+    GVariant *ret, *properties = NULL;
+
+    ret = test_call("GetAllProperties",
+                    g_variant_new("(ss)", SNAPSHOT_CHANNEL, "/"),
+                    G_VARIANT_TYPE("(a{sv})"));
+    if (ret) {
+        g_variant_get(ret, "(@a{sv})", &properties);
+        g_variant_unref(ret);
+    }
+
+    return properties;
+}
+
+static gboolean
+test_daemon_running(void)
+{
+    GVariant *ret;
+    gboolean has_owner = FALSE;
+
+    ret = g_dbus_connection_call_sync(conn,
+                                      "org.freedesktop.DBus",
+                                      "/org/freedesktop/DBus",
+                                      "org.freedesktop.DBus",
+                                      "NameHasOwner",
+                                      g_variant_new("(s)", XFCONF_SERVICE_NAME_PREFIX ".XfconfTest"),
+                                      G_VARIANT_TYPE("(b)"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (ret) {
+        g_variant_get(ret, "(b)", &has_owner);
+        g_variant_unref(ret);
+    }
+
+    return has_owner;
+}
+
+static gboolean
+test_wait_for_daemon(gboolean running)
+{
+    gint64 start = g_get_monotonic_time();
+
+    while (test_daemon_running() != running) {
+        if (g_get_monotonic_time() - start > WAIT_TIMEOUT * G_USEC_PER_SEC) {
+            return FALSE;
+        }
+        g_usleep(10000);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+test_kill_daemon(gint signum)
+{
+    GVariant *ret;
+    guint32 pid;
+
+    ret = g_dbus_connection_call_sync(conn,
+                                      "org.freedesktop.DBus",
+                                      "/org/freedesktop/DBus",
+                                      "org.freedesktop.DBus",
+                                      "GetConnectionUnixProcessID",
+                                      g_variant_new("(s)", XFCONF_SERVICE_NAME_PREFIX ".XfconfTest"),
+                                      G_VARIANT_TYPE("(u)"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (!ret) {
+        return FALSE;
+    }
+    g_variant_get(ret, "(u)", &pid);
+    g_variant_unref(ret);
+
+    return kill(pid, signum) == 0 && test_wait_for_daemon(FALSE);
+}
+
+/* xfconfd inherits XDG_CONFIG_DIRS, so it finds the system file */
+static gboolean
+test_restart_daemon(void)
+{
+    gchar *argv[] = { (gchar *)g_getenv("XFCONFD"), NULL };
+    GError *error = NULL;
+
+    if (!test_kill_daemon(SIGKILL)) {
+        return FALSE;
+    }
+
+    if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_DEFAULT, NULL, NULL, NULL, &error)) {
+        g_critical("Failed to restart xfconfd: %s", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+
+    return test_wait_for_daemon(TRUE);
+}
+
+/* the channel is loaded by the first call after a restart */
+static gboolean
+test_load_channel(gdouble *elapsed_ms)
+{
+    gint64 start = g_get_monotonic_time();
+    gboolean ret;
+
+    ret = test_get_int(SNAPSHOT_BASE "/large/p0", 0);
+    *elapsed_ms = (g_get_monotonic_time() - start) / 1000.0;
+
+    return ret;
+}
+
+static gboolean
+test_wait_for_file(const gchar *filename,
+                   const gchar *contains)
+{
+    gint64 start = g_get_monotonic_time();
+    gchar *contents = NULL;
+    gboolean found;
+
+    for (;;) {
+        found = g_file_get_contents(filename, &contents, NULL, NULL);
+        if (found && contains) {
+            found = strstr(contents, contains) != NULL;
+        }
+        if (contents) {
+            g_free(contents);
+            contents = NULL;
+        }
+
+        if (found) {
+            return TRUE;
+        }
+        if (g_get_monotonic_time() - start > WAIT_TIMEOUT * G_USEC_PER_SEC) {
+            return FALSE;
+        }
+        g_usleep(10000);
+    }
+}
+
+/* the snapshot is replaced by a new file when it is written again */
+static guint64
+test_file_inode(const gchar *filename)
+{
+    GStatBuf st;
+
+    if (g_stat(filename, &st) != 0) {
+        return 0;
+    }
+
+    return st.st_ino;
+}
+
+static gboolean
+test_wait_for_rewrite(const gchar *filename,
+                      guint64 old_inode)
+{
+    gint64 start = g_get_monotonic_time();
+    guint64 inode;
+
+    while ((inode = test_file_inode(filename)) == 0 || inode == old_inode) {
+        if (g_get_monotonic_time() - start > WAIT_TIMEOUT * G_USEC_PER_SEC) {
+            return FALSE;
+        }
+        g_usleep(10000);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+test_write_system_file(const gchar *filename,
+                       const gchar *system_value)
+{
+    gchar *contents;
+    gboolean ret;
+
+    contents = g_strdup_printf("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                               "<channel name=\"" SNAPSHOT_CHANNEL "\" version=\"1.0\">\n"
+                               "  <property name=\"snapshot\" type=\"empty\">\n"
+                               "    <property name=\"system\" type=\"string\" value=\"%s\"/>\n"
+                               "    <property name=\"shadowed\" type=\"int\" value=\"1\"/>\n"
+                               "  </property>\n"
+                               "</channel>\n",
+                               system_value);
+    ret = g_file_set_contents(filename, contents, -1, NULL);
+    g_free(contents);
+
+    return ret;
+}
+
+static gboolean
+test_write_user_file(const gchar *filename,
+                     gint user_value)
+{
+    GString *contents;
+    gboolean ret;
+    gint i;
+
+    contents = g_string_new("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                            "<channel name=\"" SNAPSHOT_CHANNEL "\" version=\"1.0\">\n"
+                            "  <property name=\"snapshot\" type=\"empty\">\n");
+    g_string_append_printf(contents,
+                           "    <property name=\"user\" type=\"int\" value=\"%d\"/>\n"
+                           "    <property name=\"shadowed\" type=\"int\" value=\"2\"/>\n"
+                           "    <property name=\"large\" type=\"empty\">\n",
+                           user_value);
+    for (i = 0; i < N_PROPERTIES; i++) {
+        g_string_append_printf(contents,
+                               "      <property name=\"p%d\" type=\"int\" value=\"%d\"/>\n",
+                               i, i);
+    }
+    g_string_append(contents,
+                    "    </property>\n"
+                    "  </property>\n"
+                    "</channel>\n");
+
+    ret = g_file_set_contents(filename, contents->str, contents->len, NULL);
+    g_string_free(contents, TRUE);
+
+    return ret;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    gchar *system_dir, *system_xml_dir, *system_file;
+    gchar *user_file, *journal_file, *snapshot_file, *property;
+    GVariant *from_xml, *from_snapshot;
+    gdouble xml_ms, snapshot_ms;
+    guint64 inode;
+
+    if (!g_getenv("XFCONFD")) {
+        /* needs the driver to restart xfconfd */
+        return 77;
+    }
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    TEST_OPERATION(conn != NULL);
+
+    system_dir = g_dir_make_tmp("xfconf-snapshot-XXXXXX", NULL);
+    TEST_OPERATION(system_dir != NULL);
+    system_xml_dir = g_build_filename(system_dir, "xfce4", "xfconf", "xfce-perchannel-xml", NULL);
+    TEST_OPERATION(g_mkdir_with_parents(system_xml_dir, 0700) == 0);
+    system_file = g_build_filename(system_xml_dir, SNAPSHOT_CHANNEL ".xml", NULL);
+    user_file = g_build_filename(g_get_user_config_dir(),
+                                 "xfce4", "xfconf", "xfce-perchannel-xml",
+                                 SNAPSHOT_CHANNEL ".xml", NULL);
+    journal_file = g_build_filename(g_get_user_config_dir(),
+                                    "xfce4", "xfconf", "xfce-perchannel-xml",
+                                    SNAPSHOT_CHANNEL ".journal", NULL);
+    snapshot_file = g_build_filename(g_get_user_cache_dir(),
+                                     "xfconf", SNAPSHOT_CHANNEL ".snapshot", NULL);
+    g_setenv("XDG_CONFIG_DIRS", system_dir, TRUE);
+
+    TEST_OPERATION(test_write_system_file(system_file, "system-1"));
+    TEST_OPERATION(test_write_user_file(user_file, 1));
+    g_unlink(journal_file);
+    g_unlink(snapshot_file);
+
+    /* no snapshot yet, the channel comes from the xml files */
+    TEST_OPERATION(test_restart_daemon());
+    TEST_OPERATION(test_load_channel(&xml_ms));
+    TEST_OPERATION(test_get_string(SNAPSHOT_BASE "/system", "system-1"));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/shadowed", 2));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/user", 1));
+    property = g_strdup_printf(SNAPSHOT_BASE "/large/p%d", N_PROPERTIES - 1);
+    TEST_OPERATION(test_get_int(property, N_PROPERTIES - 1));
+    from_xml = test_get_all();
+    TEST_OPERATION(from_xml != NULL);
+    TEST_OPERATION(test_wait_for_rewrite(snapshot_file, 0));
+    inode = test_file_inode(snapshot_file);
+
+    /* nothing changed, the snapshot gives back the same channel and is
+     * not written again */
+    TEST_OPERATION(test_restart_daemon());
+    TEST_OPERATION(test_load_channel(&snapshot_ms));
+    from_snapshot = test_get_all();
+    TEST_OPERATION(from_snapshot != NULL);
+    TEST_OPERATION(g_variant_equal(from_xml, from_snapshot));
+    g_usleep(G_USEC_PER_SEC);
+    TEST_OPERATION(test_file_inode(snapshot_file) == inode);
+    g_variant_unref(from_snapshot);
+    g_variant_unref(from_xml);
+
+    g_print("%d properties: loaded from xml in %.1f ms, from the snapshot in %.1f ms\n",
+            N_PROPERTIES + 3, xml_ms, snapshot_ms);
+
+    /* a changed system file makes the snapshot stale */
+    TEST_OPERATION(test_write_system_file(system_file, "system-2"));
+    TEST_OPERATION(test_restart_daemon());
+    TEST_OPERATION(test_load_channel(&xml_ms));
+    TEST_OPERATION(test_get_string(SNAPSHOT_BASE "/system", "system-2"));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/shadowed", 2));
+    TEST_OPERATION(test_wait_for_rewrite(snapshot_file, inode));
+    inode = test_file_inode(snapshot_file);
+
+    /* so does a changed user file */
+    TEST_OPERATION(test_write_user_file(user_file, 3));
+    TEST_OPERATION(test_restart_daemon());
+    TEST_OPERATION(test_load_channel(&xml_ms));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/user", 3));
+    TEST_OPERATION(test_get_string(SNAPSHOT_BASE "/system", "system-2"));
+    TEST_OPERATION(test_wait_for_rewrite(snapshot_file, inode));
+
+    /* and a change appended to the journal */
+    TEST_OPERATION(test_set(SNAPSHOT_BASE "/journal", g_variant_new_int32(4)));
+    TEST_OPERATION(test_wait_for_file(journal_file, SNAPSHOT_BASE "/journal"));
+    TEST_OPERATION(test_restart_daemon());
+    TEST_OPERATION(test_load_channel(&xml_ms));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/journal", 4));
+    TEST_OPERATION(test_get_int(SNAPSHOT_BASE "/user", 3));
+
+    /* SIGTERM would write the channel back after the files are gone */
+    TEST_OPERATION(test_kill_daemon(SIGKILL));
+
+    g_unsetenv("XDG_CONFIG_DIRS");
+    g_unlink(system_file);
+    g_rmdir(system_xml_dir);
+    g_free(system_xml_dir);
+    system_xml_dir = g_build_filename(system_dir, "xfce4", "xfconf", NULL);
+    g_rmdir(system_xml_dir);
+    g_free(system_xml_dir);
+    system_xml_dir = g_build_filename(system_dir, "xfce4", NULL);
+    g_rmdir(system_xml_dir);
+    g_rmdir(system_dir);
+    g_unlink(user_file);
+    g_unlink(journal_file);
+    g_unlink(snapshot_file);
+
+    g_free(system_xml_dir);
+    g_free(system_dir);
+    g_free(system_file);
+    g_free(user_file);
+    g_free(journal_file);
+    g_free(snapshot_file);
+    g_free(property);
+    g_object_unref(conn);
+
+    xfconf_tests_end();
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "tests-common.h"
+
+#define ROLLBACK_BASE "/rollback"
+
+/* talk to xfconfd directly, the channel cache would hide what it did */
+static GVariant *
+test_call(GDBusConnection *conn,
+          const gchar *method,
+          GVariant *parameters,
+          const GVariantType *reply_type,
+          GError **error)
+{
+    return g_dbus_connection_call_sync(conn,
+                                       XFCONF_SERVICE_NAME_PREFIX ".XfconfTest",
+                                       XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                                       XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                                       method, parameters, reply_type,
+                                       G_DBUS_CALL_FLAGS_NONE, -1, NULL, error);
+}
+
+static gboolean
+test_property_exists(GDBusConnection *conn,
+                     const gchar *property)
+{
+    GVariant *ret;
+    gboolean exists = FALSE;
+
+    ret = test_call(conn, "PropertyExists",
+                    g_variant_new("(ss)", TEST_CHANNEL_NAME, property),
+                    G_VARIANT_TYPE("(b)"), NULL);
+    if (ret) {
+        g_variant_get(ret, "(b)", &exists);
+        g_variant_unref(ret);
+    }
+
+    return exists;
+}
+
+static gint32
+test_get_int(GDBusConnection *conn,
+             const gchar *property)
+{
+    GVariant *ret, *value;
+    gint32 v_int = -1;
+
+    ret = test_call(conn, "GetProperty",
+                    g_variant_new("(ss)", TEST_CHANNEL_NAME, property),
+                    G_VARIANT_TYPE("(v)"), NULL);
+    if (ret) {
+        g_variant_get(ret, "(v)", &value);
+        if (g_variant_is_of_type(value, G_VARIANT_TYPE_INT32)) {
+            v_int = g_variant_get_int32(value);
+        }
+        g_variant_unref(value);
+        g_variant_unref(ret);
+    }
+
+    return v_int;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    const gchar *existing_property = ROLLBACK_BASE "/existing";
+    const gchar *new_property = ROLLBACK_BASE "/new";
+    const gchar *twice_property = ROLLBACK_BASE "/twice";
+    GDBusConnection *conn;
+    GVariantBuilder builder;
+    GVariant *ret;
+    GError *error = NULL;
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    TEST_OPERATION(conn != NULL);
+
+    /* one property the user already set, one that does not exist and one
+     * that gets set twice in the batch without existing before */
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", existing_property, g_variant_new_int32(test_int));
+    ret = test_call(conn, "SetProperties",
+                    g_variant_new("(sa{sv})", TEST_CHANNEL_NAME, &builder),
+                    NULL, NULL);
+    TEST_OPERATION(ret != NULL);
+    g_variant_unref(ret);
+    TEST_OPERATION(!test_property_exists(conn, new_property));
+    TEST_OPERATION(!test_property_exists(conn, twice_property));
+
+    /* the property name at the end is invalid, so the backend fails after
+     * the others were written, like it does for a locked property */
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+    g_variant_builder_add(&builder, "{sv}", existing_property, g_variant_new_int32(test_int + 1));
+    g_variant_builder_add(&builder, "{sv}", new_property, g_variant_new_int32(test_int + 2));
+    g_variant_builder_add(&builder, "{sv}", twice_property, g_variant_new_int32(test_int + 3));
+    g_variant_builder_add(&builder, "{sv}", twice_property, g_variant_new_int32(test_int + 4));
+    g_variant_builder_add(&builder, "{sv}", "invalid", g_variant_new_int32(test_int + 5));
+    ret = test_call(conn, "SetProperties",
+                    g_variant_new("(sa{sv})", TEST_CHANNEL_NAME, &builder),
+                    NULL, &error);
+    TEST_OPERATION(ret == NULL);
+    TEST_OPERATION(error != NULL);
+    g_clear_error(&error);
+
+    /* the value the user had is back, and the properties that had no
+     * user value were reset rather than set to what was there before */
+    TEST_OPERATION(test_get_int(conn, existing_property) == test_int);
+    TEST_OPERATION(!test_property_exists(conn, new_property));
+    TEST_OPERATION(!test_property_exists(conn, twice_property));
+
+    ret = test_call(conn, "ResetProperty",
+                    g_variant_new("(ssb)", TEST_CHANNEL_NAME, ROLLBACK_BASE, TRUE),
+                    NULL, NULL);
+    TEST_OPERATION(ret != NULL);
+    g_variant_unref(ret);
+
+    g_object_unref(conn);
+
+    xfconf_tests_end();
+
+    return 0;
+}
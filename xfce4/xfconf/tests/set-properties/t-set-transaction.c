@@ -0,0 +1,153 @@
+/*
+ *  xfconf
+ *
+ *  Copyright (c) 2026 Xfce Development Team <xfce4-dev@xfce.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; version 2 of the License ONLY.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Library General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "tests-common.h"
+
+#define TRANSACTION_BASE "/transaction"
+
+typedef struct
+{
+    GMainLoop *mloop;
+    guint n_property_changed;
+    guint n_properties_changed;
+    guint n_changed;
+} SignalTestData;
+
+static void
+test_signal_received(GDBusConnection *conn,
+                     const gchar *sender_name,
+                     const gchar *object_path,
+                     const gchar *interface_name,
+                     const gchar *signal_name,
+                     GVariant *parameters,
+                     gpointer user_data)
+{
+    SignalTestData *std = user_data;
+    const gchar *property;
+    GVariant *changed;
+
+    if (!strcmp(signal_name, "PropertyChanged")) {
+        g_variant_get(parameters, "(&s&sv)", NULL, &property, NULL);
+        if (g_str_has_prefix(property, TRANSACTION_BASE "/")) {
+            std->n_property_changed++;
+        }
+    } else if (!strcmp(signal_name, "PropertiesChanged")) {
+        g_variant_get(parameters, "(&s@a{sv}as)", NULL, &changed, NULL);
+        std->n_properties_changed++;
+        std->n_changed += g_variant_n_children(changed);
+        g_variant_unref(changed);
+        g_main_loop_quit(std->mloop);
+    }
+}
+
+static gboolean
+test_watchdog(gpointer data)
+{
+    SignalTestData *std = data;
+    g_main_loop_quit(std->mloop);
+    return FALSE;
+}
+
+int
+main(int argc,
+     char **argv)
+{
+    const gchar *properties[] = {
+        TRANSACTION_BASE "/int",
+        TRANSACTION_BASE "/string",
+        TRANSACTION_BASE "/bool",
+        NULL
+    };
+    GDBusConnection *conn;
+    XfconfChannel *channel;
+    SignalTestData std = { NULL, 0, 0, 0 };
+    GVariant *ret, *values;
+    gint32 v_int;
+    const gchar *v_string;
+    gboolean v_bool;
+    guint watch_id;
+
+    if (!xfconf_tests_start()) {
+        return 1;
+    }
+
+    std.mloop = g_main_loop_new(NULL, FALSE);
+
+    conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    TEST_OPERATION(conn != NULL);
+
+    watch_id = g_dbus_connection_signal_subscribe(conn, NULL,
+                                                  XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                                                  NULL,
+                                                  XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                                                  TEST_CHANNEL_NAME,
+                                                  G_DBUS_SIGNAL_FLAGS_NONE,
+                                                  test_signal_received, &std, NULL);
+
+    channel = xfconf_channel_new(TEST_CHANNEL_NAME);
+
+    xfconf_channel_begin_transaction(channel);
+    TEST_OPERATION(xfconf_channel_set_int(channel, properties[0], test_int));
+    TEST_OPERATION(xfconf_channel_set_string(channel, properties[1], test_string));
+    TEST_OPERATION(xfconf_channel_set_bool(channel, properties[2], test_bool));
+
+    /* the new values are visible locally before the commit */
+    TEST_OPERATION(xfconf_channel_get_int(channel, properties[0], -1) == test_int);
+
+    xfconf_channel_commit_transaction(channel);
+
+    g_timeout_add(1500, test_watchdog, &std);
+    g_main_loop_run(std.mloop);
+
+    /* one signal for the whole transaction */
+    TEST_OPERATION(std.n_properties_changed == 1);
+    TEST_OPERATION(std.n_changed == G_N_ELEMENTS(properties) - 1);
+    TEST_OPERATION(std.n_property_changed == 0);
+
+    /* ask xfconfd directly, bypassing the cache */
+    ret = g_dbus_connection_call_sync(conn,
+                                      XFCONF_SERVICE_NAME_PREFIX ".XfconfTest",
+                                      XFCONF_SERVICE_PATH_PREFIX "/Xfconf",
+                                      XFCONF_SERVICE_NAME_PREFIX ".Xfconf",
+                                      "GetProperties",
+                                      g_variant_new("(s^as)", TEST_CHANNEL_NAME, properties),
+                                      G_VARIANT_TYPE("(a{sv})"),
+                                      G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    TEST_OPERATION(ret != NULL);
+    g_variant_get(ret, "(@a{sv})", &values);
+    TEST_OPERATION(g_variant_lookup(values, properties[0], "i", &v_int) && v_int == test_int);
+    TEST_OPERATION(g_variant_lookup(values, properties[1], "&s", &v_string)
+                   && !strcmp(v_string, test_string));
+    TEST_OPERATION(g_variant_lookup(values, properties[2], "b", &v_bool) && v_bool == test_bool);
+    g_variant_unref(values);
+    g_variant_unref(ret);
+
+    xfconf_channel_reset_property(channel, TRANSACTION_BASE, TRUE);
+
+    g_dbus_connection_signal_unsubscribe(conn, watch_id);
+    g_object_unref(G_OBJECT(channel));
+    g_object_unref(conn);
+    g_main_loop_unref(std.mloop);
+
+    xfconf_tests_end();
+
+    return 0;
+}
@@ -16,7 +16,7 @@
 
 XFCONFD_DIR=$1
 TEST=$2
-XFCONFD=$XFCONFD_DIR/xfconfd
+XFCONFD=$XFCONFD_DIR/xfconfd; export XFCONFD; # for tests that restart it
 
 XFCONF_RUN_IN_TEST_MODE=1; export XFCONF_RUN_IN_TEST_MODE;
 
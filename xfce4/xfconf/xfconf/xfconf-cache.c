@@ -41,10 +41,12 @@
 #include "xfconf.h"
 #endif
 
-#if 0
 #define DEFAULT_MAX_ENTRIES -1 /* no limit */
 #define DEFAULT_MAX_AGE (60 * 60) /* 1 hour */
-#endif
+
+/* when over max-entries, evict this many more entries so we don't
+ * have to walk the tree again on the next insertion */
+#define EVICT_SLACK(max_entries) ((max_entries) / 8)
 
 #define ALIGN_VAL(val, align) (((val) + ((align) - 1)) & ~((align) - 1))
 
@@ -58,9 +60,7 @@
 
 typedef struct
 {
-#if 0
     gint64 last_used;
-#endif
     GValue *value;
 } XfconfCacheItem;
 
@@ -71,9 +71,7 @@ xfconf_cache_item_new(const GValue *value,
     XfconfCacheItem *item;
 
     item = g_slice_new0(XfconfCacheItem);
-#if 0
-    item->last_used = g_get_monotonic_time ();
-#endif
+    item->last_used = g_get_monotonic_time();
 
     if (G_LIKELY(steal) || value == NULL) {
         item->value = (GValue *)value;
@@ -101,9 +99,7 @@ xfconf_cache_item_update(XfconfCacheItem *item,
         return FALSE;
     }
 
-#if 0
-    item->last_used = g_get_monotonic_time ();
-#endif
+    item->last_used = g_get_monotonic_time();
 
     if (value) {
         if (item->value == NULL) {
@@ -237,6 +233,11 @@ xfconf_cache_old_item_end_call(gpointer key,
         g_error_free(error);
     }
 
+    /* values of an uncommitted batch have no call to wait for */
+    if (old_item->pending_calls_count == 0) {
+        xfconf_cache_old_item_free(old_item);
+    }
+
     return TRUE;
 }
 
@@ -255,16 +256,23 @@ struct _XfconfCache
 
     gchar *channel_name;
 
-#if 0
     gint max_entries;
     gint max_age;
-#endif
+    gint64 next_age_check;
+    gint size_check_floor;
+
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
 
     GTree *properties;
 
     GHashTable *pending_calls;
     GHashTable *old_properties;
 
+    /* old items of the properties set since xfconf_cache_begin_batch() */
+    GHashTable *batch;
+
     gint g_signal_id;
 
     GMutex cache_lock;
@@ -290,10 +298,8 @@ enum
 {
     PROP0 = 0,
     PROP_CHANNEL_NAME,
-#if 0
     PROP_MAX_ENTRIES,
     PROP_MAX_AGE,
-#endif
 };
 
 static void xfconf_cache_set_g_property(GObject *object,
@@ -352,7 +358,7 @@ xfconf_cache_class_init(XfconfCacheClass *klass)
                                                             | G_PARAM_STATIC_NAME
                                                             | G_PARAM_STATIC_NICK
                                                             | G_PARAM_STATIC_BLURB));
-#if 0
+
     g_object_class_install_property(object_class, PROP_MAX_ENTRIES,
                                     g_param_spec_int("max-entries",
                                                      "Maximum entries",
@@ -360,23 +366,22 @@ xfconf_cache_class_init(XfconfCacheClass *klass)
                                                      -1, G_MAXINT,
                                                      DEFAULT_MAX_ENTRIES,
                                                      G_PARAM_READWRITE
-                                                     | G_PARAM_CONSTRUCT
-                                                     | G_PARAM_STATIC_NAME
-                                                     | G_PARAM_STATIC_NICK
-                                                     | G_PARAM_STATIC_BLURB));
+                                                         | G_PARAM_CONSTRUCT
+                                                         | G_PARAM_STATIC_NAME
+                                                         | G_PARAM_STATIC_NICK
+                                                         | G_PARAM_STATIC_BLURB));
 
     g_object_class_install_property(object_class, PROP_MAX_AGE,
                                     g_param_spec_int("max-age",
                                                      "Maximum age",
-                                                     "Maximum age (in seconds) before an entry gets evicted from the cache",
+                                                     "Maximum age (in seconds) before an unused entry gets evicted from the cache, or 0 to keep entries forever",
                                                      0, G_MAXINT,
                                                      DEFAULT_MAX_AGE,
                                                      G_PARAM_READWRITE
-                                                     | G_PARAM_CONSTRUCT
-                                                     | G_PARAM_STATIC_NAME
-                                                     | G_PARAM_STATIC_NICK
-                                                     | G_PARAM_STATIC_BLURB));
-#endif
+                                                         | G_PARAM_CONSTRUCT
+                                                         | G_PARAM_STATIC_NAME
+                                                         | G_PARAM_STATIC_NICK
+                                                         | G_PARAM_STATIC_BLURB));
 }
 
 static void
@@ -412,7 +417,6 @@ xfconf_cache_set_g_property(GObject *object,
             g_free(cache->channel_name);
             cache->channel_name = g_value_dup_string(value);
             break;
-#if 0
         case PROP_MAX_ENTRIES:
             xfconf_cache_set_max_entries(cache, g_value_get_int(value));
             break;
@@ -420,7 +424,6 @@ xfconf_cache_set_g_property(GObject *object,
         case PROP_MAX_AGE:
             xfconf_cache_set_max_age(cache, g_value_get_int(value));
             break;
-#endif
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
             break;
@@ -439,7 +442,6 @@ xfconf_cache_get_g_property(GObject *object,
         case PROP_CHANNEL_NAME:
             g_value_set_string(value, cache->channel_name);
             break;
-#if 0
         case PROP_MAX_ENTRIES:
             g_value_set_int(value, cache->max_entries);
             break;
@@ -447,7 +449,6 @@ xfconf_cache_get_g_property(GObject *object,
         case PROP_MAX_AGE:
             g_value_set_int(value, cache->max_age);
             break;
-#endif
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
             break;
@@ -464,6 +465,19 @@ xfconf_cache_finalize(GObject *obj)
 
     g_signal_handler_disconnect(proxy, cache->g_signal_id);
 
+    /* a batch that was never committed is written out with the other
+     * pending values below */
+    if (cache->batch) {
+        GHashTableIter iter;
+        XfconfCacheOldItem *old_item;
+
+        g_hash_table_iter_init(&iter, cache->batch);
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer)&old_item)) {
+            old_item->pending_calls_count--;
+        }
+        g_hash_table_destroy(cache->batch);
+    }
+
     /* Finish pending calls with synchronous requests (without emitting
      * signals, therefore we cancel the cancellable on old_item).
      * Beware: even that we cancel cancellable objects for unfinished
@@ -487,49 +501,180 @@ xfconf_cache_finalize(GObject *obj)
 }
 
 
+typedef struct
+{
+    const gchar *property;
+    gint64 last_used;
+} XfconfCacheEvictEntry;
+
+typedef struct
+{
+    XfconfCache *cache;
+    GArray *entries;
+} XfconfCacheEvictData;
+
+static gboolean
+xfconf_cache_collect_evictable(gpointer key,
+                               gpointer value,
+                               gpointer user_data)
+{
+    XfconfCacheItem *item = value;
+    XfconfCacheEvictData *edata = user_data;
+    XfconfCacheEvictEntry entry = { key, item->last_used };
+
+    /* the reply handler of a pending set call needs the item */
+    if (!g_hash_table_contains(edata->cache->old_properties, key)) {
+        g_array_append_val(edata->entries, entry);
+    }
+
+    return FALSE;
+}
+
+static gint
+xfconf_cache_compare_last_used(gconstpointer a,
+                               gconstpointer b)
+{
+    const XfconfCacheEvictEntry *entry_a = a;
+    const XfconfCacheEvictEntry *entry_b = b;
+
+    if (entry_a->last_used < entry_b->last_used) {
+        return -1;
+    }
+
+    return entry_a->last_used > entry_b->last_used ? 1 : 0;
+}
+
+/* drops entries unused for longer than max-age, then the least recently
+ * used ones if there are more than max-entries; they are fetched again
+ * from xfconfd on the next lookup */
 static void
-xfconf_cache_handle_property_changed(XfconfCache *cache, GVariant *parameters)
+xfconf_cache_maybe_evict_locked(XfconfCache *cache)
 {
+    gint64 now = g_get_monotonic_time();
+    gboolean check_age, check_size;
+    XfconfCacheEvictData edata;
+    GArray *entries;
+    gint n_nodes;
+    guint i, n_evict = 0;
+
+    n_nodes = g_tree_nnodes(cache->properties);
+    check_age = cache->max_age > 0 && now >= cache->next_age_check;
+    check_size = cache->max_entries >= 0
+                 && n_nodes > MAX(cache->max_entries, cache->size_check_floor);
+    if (!check_age && !check_size) {
+        return;
+    }
+
+    entries = g_array_sized_new(FALSE, FALSE, sizeof(XfconfCacheEvictEntry), n_nodes);
+    edata.cache = cache;
+    edata.entries = entries;
+    g_tree_foreach(cache->properties, xfconf_cache_collect_evictable, &edata);
+    g_array_sort(entries, xfconf_cache_compare_last_used);
+
+    if (cache->max_age > 0) {
+        gint64 expired = now - (gint64)cache->max_age * G_USEC_PER_SEC;
+
+        while (n_evict < entries->len
+               && g_array_index(entries, XfconfCacheEvictEntry, n_evict).last_used < expired)
+        {
+            n_evict++;
+        }
+
+        cache->next_age_check = now + (gint64)cache->max_age * G_USEC_PER_SEC / 4;
+    }
+
+    if (check_size) {
+        gint excess = n_nodes - (cache->max_entries - EVICT_SLACK(cache->max_entries));
+        n_evict = MAX(n_evict, MIN((guint)excess, entries->len));
+    }
+
+    for (i = 0; i < n_evict; ++i) {
+        g_tree_remove(cache->properties, g_array_index(entries, XfconfCacheEvictEntry, i).property);
+    }
+    cache->evictions += n_evict;
+
+    /* entries with pending calls can't go; don't walk the tree again
+     * for each of them until the calls return */
+    if (cache->max_entries >= 0) {
+        cache->size_check_floor = g_tree_nnodes(cache->properties) + EVICT_SLACK(cache->max_entries);
+    }
+
+    g_array_free(entries, TRUE);
+}
 
+
+static void
+xfconf_cache_property_changed(XfconfCache *cache,
+                              const gchar *property,
+                              GVariant *prop_variant)
+{
     XfconfCacheItem *item;
-    const gchar *channel_name, *property;
-    GVariant *prop_variant;
     GValue *prop_value;
     gboolean changed = TRUE;
-    if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(ssv)"))) {
-        g_variant_get(parameters, "(&s&sv)", &channel_name, &property, &prop_variant);
 
-        if (strcmp(channel_name, cache->channel_name)) {
-            g_variant_unref(prop_variant);
-            return;
-        }
+    /* if a call was cancelled, we still receive a property-changed from
+     * that value, in that case, abort the emission of the signal. we can
+     * detect this because the new reply is not processed yet and thus
+     * there is still an old_prop in the hash table */
+    if (g_hash_table_lookup(cache->old_properties, property)) {
+        return;
+    }
 
-        /* if a call was cancelled, we still receive a property-changed from
-         * that value, in that case, abort the emission of the signal. we can
-         * detect this because the new reply is not processed yet and thus
-         * there is still an old_prop in the hash table */
-        if (g_hash_table_lookup(cache->old_properties, property)) {
-            g_variant_unref(prop_variant);
-            return;
-        }
+    prop_value = xfconf_gvariant_to_gvalue(prop_variant);
 
-        prop_value = xfconf_gvariant_to_gvalue(prop_variant);
+    item = g_tree_lookup(cache->properties, property);
+    if (item) {
+        changed = xfconf_cache_item_update(item, prop_value);
+    } else {
+        item = xfconf_cache_item_new(prop_value, FALSE);
+        g_tree_insert(cache->properties, g_strdup(property), item);
 
-        item = g_tree_lookup(cache->properties, property);
-        if (item) {
-            changed = xfconf_cache_item_update(item, prop_value);
-        } else {
-            item = xfconf_cache_item_new(prop_value, FALSE);
-            g_tree_insert(cache->properties, g_strdup(property), item);
-        }
+        xfconf_cache_mutex_lock(cache);
+        xfconf_cache_maybe_evict_locked(cache);
+        xfconf_cache_mutex_unlock(cache);
+    }
+
+    if (changed) {
+        g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
+                      cache->channel_name, property, prop_value);
+    }
+    g_value_unset(prop_value);
+    g_free(prop_value);
+}
+
+
+static void
+xfconf_cache_property_removed(XfconfCache *cache,
+                              const gchar *property)
+{
+    XfconfCacheItem *item;
+    GValue value = G_VALUE_INIT;
 
-        if (changed) {
-            g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
-                          cache->channel_name, property, prop_value);
+    item = g_tree_lookup(cache->properties, property);
+    if (item != NULL && item->value != NULL) {
+        g_value_unset(item->value);
+        g_free(item->value);
+        item->value = NULL;
+    }
+
+    g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
+                  cache->channel_name, property, &value);
+}
+
+
+static void
+xfconf_cache_handle_property_changed(XfconfCache *cache, GVariant *parameters)
+{
+
+    const gchar *channel_name, *property;
+    GVariant *prop_variant;
+    if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(ssv)"))) {
+        g_variant_get(parameters, "(&s&sv)", &channel_name, &property, &prop_variant);
+
+        if (strcmp(channel_name, cache->channel_name) == 0) {
+            xfconf_cache_property_changed(cache, property, prop_variant);
         }
         g_variant_unref(prop_variant);
-        g_value_unset(prop_value);
-        g_free(prop_value);
     } else {
         g_warning("property changed handler expects (ssv) type, but %s received",
                   g_variant_get_type_string(parameters));
@@ -542,28 +687,44 @@ xfconf_cache_handle_property_removed(XfconfCache *cache, GVariant *parameters)
 {
 
     const gchar *channel_name, *property;
-    GValue value = G_VALUE_INIT;
     if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(ss)"))) {
-        XfconfCacheItem *item;
-
         g_variant_get(parameters, "(&s&s)", &channel_name, &property);
 
-        if (strcmp(channel_name, cache->channel_name)) {
-            return;
+        if (strcmp(channel_name, cache->channel_name) == 0) {
+            xfconf_cache_property_removed(cache, property);
         }
+    } else {
+        g_warning("property removed handler expects (ss) type, but %s received",
+                  g_variant_get_type_string(parameters));
+    }
+}
 
-        item = g_tree_lookup(cache->properties, property);
-        if (item != NULL && item->value != NULL) {
-            g_value_unset(item->value);
-            g_free(item->value);
-            item->value = NULL;
-        }
 
-        g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
-                      cache->channel_name, property, &value);
+static void
+xfconf_cache_handle_properties_changed(XfconfCache *cache, GVariant *parameters)
+{
+    const gchar *channel_name, *property;
+    GVariantIter *changed_iter, *removed_iter;
+    GVariant *prop_variant;
+
+    if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(sa{sv}as)"))) {
+        g_variant_get(parameters, "(&sa{sv}as)", &channel_name, &changed_iter, &removed_iter);
 
+        if (strcmp(channel_name, cache->channel_name) == 0) {
+            while (g_variant_iter_next(changed_iter, "{&sv}", &property, &prop_variant)) {
+                xfconf_cache_property_changed(cache, property, prop_variant);
+                g_variant_unref(prop_variant);
+            }
+
+            while (g_variant_iter_next(removed_iter, "&s", &property)) {
+                xfconf_cache_property_removed(cache, property);
+            }
+        }
+
+        g_variant_iter_free(changed_iter);
+        g_variant_iter_free(removed_iter);
     } else {
-        g_warning("property removed handler expects (ss) type, but %s received",
+        g_warning("properties changed handler expects (sa{sv}as) type, but %s received",
                   g_variant_get_type_string(parameters));
     }
 }
@@ -584,6 +745,8 @@ xfconf_cache_proxy_signal_received_cb(GDBusProxy *proxy,
         xfconf_cache_handle_property_changed(cache, parameters);
     } else if (g_strcmp0(signal_name, "PropertyRemoved") == 0) {
         xfconf_cache_handle_property_removed(cache, parameters);
+    } else if (g_strcmp0(signal_name, "PropertiesChanged") == 0) {
+        xfconf_cache_handle_properties_changed(cache, parameters);
     } else {
         g_warning("Unhandled signal name :%s\n", signal_name);
     }
@@ -591,15 +754,11 @@ xfconf_cache_proxy_signal_received_cb(GDBusProxy *proxy,
 
 
 static void
-xfconf_cache_set_property_reply_handler(GDBusProxy *proxy,
-                                        GAsyncResult *res,
-                                        gpointer user_data)
+xfconf_cache_old_item_call_done(XfconfCacheOldItem *old_item,
+                                const GError *error)
 {
     XfconfCache *cache;
-    XfconfCacheOldItem *old_item = (XfconfCacheOldItem *)user_data;
     XfconfCacheItem *item;
-    GError *error = NULL;
-    gboolean result;
 
     old_item->pending_calls_count--;
     if (old_item->pending_calls_count > 0) {
@@ -628,6 +787,7 @@ xfconf_cache_set_property_reply_handler(GDBusProxy *proxy,
     */
     g_hash_table_remove(cache->old_properties, old_item->property);
     g_hash_table_remove(cache->pending_calls, old_item->cancellable);
+    cache->size_check_floor = 0;
     item = g_tree_lookup(cache->properties, old_item->property);
     if (G_UNLIKELY(!item)) {
 #ifndef NDEBUG
@@ -636,12 +796,10 @@ xfconf_cache_set_property_reply_handler(GDBusProxy *proxy,
         goto out;
     }
 
-    result = xfconf_exported_call_set_property_finish((XfconfExported *)proxy, res, &error);
-    if (!result) {
+    if (error) {
         GValue empty_val = G_VALUE_INIT;
         g_warning("Failed to set property \"%s::%s\": %s",
                   cache->channel_name, old_item->property, error->message);
-        g_error_free(error);
         if (old_item->item) {
             xfconf_cache_item_update(item, old_item->item->value);
         } else {
@@ -666,6 +824,45 @@ out:
 }
 
 
+static void
+xfconf_cache_set_property_reply_handler(GDBusProxy *proxy,
+                                        GAsyncResult *res,
+                                        gpointer user_data)
+{
+    XfconfCacheOldItem *old_item = (XfconfCacheOldItem *)user_data;
+    GError *error = NULL;
+
+    xfconf_exported_call_set_property_finish((XfconfExported *)proxy, res, &error);
+    xfconf_cache_old_item_call_done(old_item, error);
+
+    if (error) {
+        g_error_free(error);
+    }
+}
+
+
+static void
+xfconf_cache_set_properties_reply_handler(GDBusProxy *proxy,
+                                          GAsyncResult *res,
+                                          gpointer user_data)
+{
+    GPtrArray *old_items = user_data;
+    GError *error = NULL;
+    guint i;
+
+    /* the daemon applies all the values or none of them */
+    xfconf_exported_call_set_properties_finish((XfconfExported *)proxy, res, &error);
+    for (i = 0; i < old_items->len; ++i) {
+        xfconf_cache_old_item_call_done(g_ptr_array_index(old_items, i), error);
+    }
+
+    if (error) {
+        g_error_free(error);
+    }
+    g_ptr_array_free(old_items, TRUE);
+}
+
+
 #if 0
 static void
 xfconf_cache_reset_property_reply_handler(DBusGProxy *proxy,
@@ -737,7 +934,7 @@ xfconf_cache_prefetch(XfconfCache *cache,
             g_tree_insert(cache->properties, key, item);
             g_variant_unref(value);
         }
-        /* TODO: honor max entries */
+        xfconf_cache_maybe_evict_locked(cache);
         ret = TRUE;
         g_variant_iter_free(iter);
         g_variant_unref(props_variant);
@@ -759,10 +956,16 @@ xfconf_cache_lookup_locked(XfconfCache *cache,
     XfconfCacheItem *item = NULL;
     item = g_tree_lookup(cache->properties, property);
 
-    if (!item) {
+    if (item) {
+        cache->hits++;
+        item->last_used = g_get_monotonic_time();
+    } else {
         GVariant *variant;
         GDBusProxy *proxy = _xfconf_get_gdbus_proxy();
         GError *tmp_error = NULL;
+
+        cache->misses++;
+
         /* blocking, ugh */
         if (xfconf_exported_call_get_property_sync((XfconfExported *)proxy, cache->channel_name,
                                                    property, &variant, NULL, &tmp_error))
@@ -772,7 +975,6 @@ xfconf_cache_lookup_locked(XfconfCache *cache,
             item = xfconf_cache_item_new(tmpval, TRUE);
             g_tree_insert(cache->properties, g_strdup(property), item);
             g_variant_unref(variant);
-            /* TODO: check tree for evictions */
         } else {
             if (g_dbus_error_is_remote_error(tmp_error)) {
                 gchar *error_name = g_dbus_error_get_remote_error(tmp_error);
@@ -830,10 +1032,6 @@ xfconf_cache_lookup_locked(XfconfCache *cache,
                 }
             }
         }
-#if 0
-        if(item)
-            xfconf_cache_item_update(item, NULL);
-#endif
     }
 
     return item != NULL && item->value != NULL;
@@ -851,6 +1049,7 @@ xfconf_cache_lookup(XfconfCache *cache,
 
     xfconf_cache_mutex_lock(cache);
     ret = xfconf_cache_lookup_locked(cache, property, value, error);
+    xfconf_cache_maybe_evict_locked(cache);
     xfconf_cache_mutex_unlock(cache);
 
     return ret;
@@ -935,18 +1134,27 @@ xfconf_cache_set(XfconfCache *cache,
 
     val = xfconf_gvalue_to_gvariant(value);
     if (val) {
-        variant = g_variant_new_variant(val);
-
-        xfconf_exported_call_set_property((XfconfExported *)proxy,
-                                          cache->channel_name,
-                                          property,
-                                          variant,
-                                          old_item->cancellable,
-                                          (GAsyncReadyCallback)xfconf_cache_set_property_reply_handler,
-                                          old_item);
+        if (cache->batch) {
+            /* sent by xfconf_cache_commit_batch(); the call is counted
+             * as pending from now on so the item stays alive until then */
+            if (!g_hash_table_contains(cache->batch, old_item->property)) {
+                g_hash_table_insert(cache->batch, old_item->property, old_item);
+                old_item->pending_calls_count++;
+            }
+        } else {
+            variant = g_variant_new_variant(val);
+
+            xfconf_exported_call_set_property((XfconfExported *)proxy,
+                                              cache->channel_name,
+                                              property,
+                                              variant,
+                                              old_item->cancellable,
+                                              (GAsyncReadyCallback)xfconf_cache_set_property_reply_handler,
+                                              old_item);
+            old_item->pending_calls_count++;
+        }
 
         old_item->variant = val;
-        old_item->pending_calls_count++;
 
         g_hash_table_insert(cache->pending_calls, old_item->cancellable, old_item);
 
@@ -957,6 +1165,7 @@ xfconf_cache_set(XfconfCache *cache,
             g_tree_insert(cache->properties, g_strdup(property), item);
         }
 
+        xfconf_cache_maybe_evict_locked(cache);
         xfconf_cache_mutex_unlock(cache);
         g_signal_emit(G_OBJECT(cache), signals[SIG_PROPERTY_CHANGED], 0,
                       cache->channel_name, property, value);
@@ -967,6 +1176,65 @@ xfconf_cache_set(XfconfCache *cache,
     return FALSE;
 }
 
+void
+xfconf_cache_begin_batch(XfconfCache *cache)
+{
+    g_return_if_fail(XFCONF_IS_CACHE(cache));
+
+    xfconf_cache_mutex_lock(cache);
+
+    if (G_LIKELY(!cache->batch)) {
+        cache->batch = g_hash_table_new(g_str_hash, g_str_equal);
+    } else {
+        g_warning("A batch is already in progress on channel \"%s\"", cache->channel_name);
+    }
+
+    xfconf_cache_mutex_unlock(cache);
+}
+
+void
+xfconf_cache_commit_batch(XfconfCache *cache)
+{
+    GDBusProxy *proxy = _xfconf_get_gdbus_proxy();
+    GHashTableIter iter;
+    XfconfCacheOldItem *old_item;
+    GVariantBuilder builder;
+    GPtrArray *old_items;
+
+    g_return_if_fail(XFCONF_IS_CACHE(cache));
+
+    xfconf_cache_mutex_lock(cache);
+
+    if (G_UNLIKELY(!cache->batch)) {
+        g_warning("No batch in progress on channel \"%s\"", cache->channel_name);
+        xfconf_cache_mutex_unlock(cache);
+        return;
+    }
+
+    if (g_hash_table_size(cache->batch) > 0) {
+        g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+        old_items = g_ptr_array_sized_new(g_hash_table_size(cache->batch));
+
+        g_hash_table_iter_init(&iter, cache->batch);
+        while (g_hash_table_iter_next(&iter, NULL, (gpointer)&old_item)) {
+            g_variant_builder_add(&builder, "{sv}", old_item->property, old_item->variant);
+            g_ptr_array_add(old_items, old_item);
+        }
+
+        xfconf_exported_call_set_properties((XfconfExported *)proxy,
+                                            cache->channel_name,
+                                            g_variant_builder_end(&builder),
+                                            NULL,
+                                            (GAsyncReadyCallback)xfconf_cache_set_properties_reply_handler,
+                                            old_items);
+    }
+
+    g_hash_table_destroy(cache->batch);
+    cache->batch = NULL;
+
+    xfconf_cache_mutex_unlock(cache);
+}
+
 typedef struct
 {
     gchar *property_base;
@@ -1071,14 +1339,14 @@ xfconf_cache_reset(XfconfCache *cache,
     return ret;
 }
 
-#if 0
 void
 xfconf_cache_set_max_entries(XfconfCache *cache,
                              gint max_entries)
 {
     xfconf_cache_mutex_lock(cache);
     cache->max_entries = max_entries;
-    /* TODO: check tree for eviction */
+    cache->size_check_floor = 0;
+    xfconf_cache_maybe_evict_locked(cache);
     xfconf_cache_mutex_unlock(cache);
 }
 
@@ -1094,7 +1362,8 @@ xfconf_cache_set_max_age(XfconfCache *cache,
 {
     xfconf_cache_mutex_lock(cache);
     cache->max_age = max_age;
-    /* TODO: check tree for eviction */
+    cache->next_age_check = 0;
+    xfconf_cache_maybe_evict_locked(cache);
     xfconf_cache_mutex_unlock(cache);
 }
 
@@ -1103,4 +1372,97 @@ xfconf_cache_get_max_age(XfconfCache *cache)
 {
     return cache->max_age;
 }
-#endif
+
+typedef struct
+{
+    guint n_entries;
+    gsize n_bytes;
+} XfconfCacheSizeData;
+
+static gsize
+xfconf_cache_value_size(const GValue *value)
+{
+    gsize size = sizeof(GValue);
+
+    if (G_VALUE_HOLDS_STRING(value)) {
+        const gchar *str = g_value_get_string(value);
+        if (str) {
+            size += strlen(str) + 1;
+        }
+    } else if (G_VALUE_TYPE(value) == G_TYPE_STRV) {
+        gchar **strv = g_value_get_boxed(value);
+        if (strv) {
+            for (; *strv; ++strv) {
+                size += sizeof(gchar *) + strlen(*strv) + 1;
+            }
+            size += sizeof(gchar *);
+        }
+    } else if (G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY) {
+        GPtrArray *arr = g_value_get_boxed(value);
+        if (arr) {
+            guint i;
+
+            size += sizeof(GPtrArray) + arr->len * sizeof(gpointer);
+            for (i = 0; i < arr->len; ++i) {
+                size += xfconf_cache_value_size(g_ptr_array_index(arr, i));
+            }
+        }
+    }
+
+    return size;
+}
+
+static gboolean
+xfconf_cache_sum_size(gpointer key,
+                      gpointer value,
+                      gpointer user_data)
+{
+    XfconfCacheItem *item = value;
+    XfconfCacheSizeData *sdata = user_data;
+
+    sdata->n_entries++;
+    sdata->n_bytes += strlen(key) + 1 + sizeof(XfconfCacheItem);
+    if (item->value) {
+        sdata->n_bytes += xfconf_cache_value_size(item->value);
+    }
+
+    return FALSE;
+}
+
+void
+xfconf_cache_get_stats(XfconfCache *cache,
+                       guint64 *hits,
+                       guint64 *misses,
+                       guint64 *evictions,
+                       guint *n_entries,
+                       gsize *n_bytes)
+{
+    XfconfCacheSizeData sdata = { 0, 0 };
+
+    g_return_if_fail(XFCONF_IS_CACHE(cache));
+
+    xfconf_cache_mutex_lock(cache);
+
+    if (hits) {
+        *hits = cache->hits;
+    }
+    if (misses) {
+        *misses = cache->misses;
+    }
+    if (evictions) {
+        *evictions = cache->evictions;
+    }
+
+    if (n_entries || n_bytes) {
+        g_tree_foreach(cache->properties, xfconf_cache_sum_size, &sdata);
+        if (n_entries) {
+            *n_entries = sdata.n_entries;
+        }
+        if (n_bytes) {
+            *n_bytes = sdata.n_bytes;
+        }
+    }
+
+    xfconf_cache_mutex_unlock(cache);
+}
+
@@ -57,12 +57,18 @@ gboolean xfconf_cache_set(XfconfCache *cache,
                           const GValue *value,
                           GError **error);
 
+G_GNUC_INTERNAL
+void xfconf_cache_begin_batch(XfconfCache *cache);
+
+G_GNUC_INTERNAL
+void xfconf_cache_commit_batch(XfconfCache *cache);
+
 G_GNUC_INTERNAL
 gboolean xfconf_cache_reset(XfconfCache *cache,
                             const gchar *property_base,
                             gboolean recursive,
                             GError **error);
-#if 0
+
 G_GNUC_INTERNAL
 void xfconf_cache_set_max_entries(XfconfCache *cache,
                                   gint max_entries);
@@ -74,7 +80,15 @@ void xfconf_cache_set_max_age(XfconfCache *cache,
                               gint max_age);
 G_GNUC_INTERNAL
 gint xfconf_cache_get_max_age(XfconfCache *cache);
-#endif
+
+G_GNUC_INTERNAL
+void xfconf_cache_get_stats(XfconfCache *cache,
+                            guint64 *hits,
+                            guint64 *misses,
+                            guint64 *evictions,
+                            guint *n_entries,
+                            gsize *n_bytes);
+
 G_END_DECLS
 
 #endif /* __XFCONF_CACHE_H__ */
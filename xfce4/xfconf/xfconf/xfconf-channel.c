@@ -759,6 +759,114 @@ xfconf_channel_get_properties(XfconfChannel *channel,
     return properties;
 }
 
+/**
+ * xfconf_channel_begin_transaction:
+ * @channel: An #XfconfChannel.
+ *
+ * Starts collecting the properties set on @channel, so they can be
+ * sent to the configuration store together by
+ * xfconf_channel_commit_transaction().  The new values are visible
+ * through @channel (and #XfconfChannel::property-changed is emitted
+ * for them) right away, as usual.
+ *
+ * The changes are then applied all at once: if any of them fails,
+ * for example because a property is locked, none of them is applied
+ * and the old values are restored.  Other applications are notified
+ * of all the changes in a single message.
+ *
+ * Resetting properties is not part of a transaction and happens
+ * immediately.  Transactions cannot be nested.
+ *
+ * Since: 4.21.0
+ **/
+void
+xfconf_channel_begin_transaction(XfconfChannel *channel)
+{
+    g_return_if_fail(XFCONF_IS_CHANNEL(channel));
+
+    xfconf_cache_begin_batch(channel->cache);
+}
+
+/**
+ * xfconf_channel_commit_transaction:
+ * @channel: An #XfconfChannel.
+ *
+ * Sends the properties set on @channel since
+ * xfconf_channel_begin_transaction() to the configuration store,
+ * in one message.  Like the xfconf_channel_set_*() functions, this
+ * does not wait for the changes to be applied.
+ *
+ * Since: 4.21.0
+ **/
+void
+xfconf_channel_commit_transaction(XfconfChannel *channel)
+{
+    g_return_if_fail(XFCONF_IS_CHANNEL(channel));
+
+    xfconf_cache_commit_batch(channel->cache);
+}
+
+/**
+ * xfconf_channel_set_cache_limits:
+ * @channel: An #XfconfChannel.
+ * @max_entries: The maximum number of properties to keep in the
+ *               cache, or -1 for no limit.
+ * @max_age: The number of seconds after which a property that was
+ *           not used is dropped from the cache, or 0 to keep
+ *           properties until they are removed.
+ *
+ * Limits the memory used by the local cache of @channel.  Properties
+ * dropped from the cache are fetched again from the configuration
+ * store the next time they are needed.  By default the number of
+ * properties is not limited and unused properties are dropped after
+ * an hour.
+ *
+ * Since: 4.21.0
+ **/
+void
+xfconf_channel_set_cache_limits(XfconfChannel *channel,
+                                gint max_entries,
+                                gint max_age)
+{
+    g_return_if_fail(XFCONF_IS_CHANNEL(channel));
+    g_return_if_fail(max_entries >= -1 && max_age >= 0);
+
+    xfconf_cache_set_max_entries(channel->cache, max_entries);
+    xfconf_cache_set_max_age(channel->cache, max_age);
+}
+
+/**
+ * xfconf_channel_get_cache_stats:
+ * @channel: An #XfconfChannel.
+ * @hits: (out) (optional): Return location for the number of lookups
+ *        answered from the cache.
+ * @misses: (out) (optional): Return location for the number of lookups
+ *          that had to ask the configuration store.
+ * @evictions: (out) (optional): Return location for the number of
+ *             properties dropped from the cache.
+ * @n_entries: (out) (optional): Return location for the number of
+ *             properties currently in the cache.
+ * @n_bytes: (out) (optional): Return location for an estimate of the
+ *           memory used by the cached properties.
+ *
+ * Retrieves statistics about the local cache of @channel, see
+ * xfconf_channel_set_cache_limits().
+ *
+ * Since: 4.21.0
+ **/
+void
+xfconf_channel_get_cache_stats(XfconfChannel *channel,
+                               guint64 *hits,
+                               guint64 *misses,
+                               guint64 *evictions,
+                               guint *n_entries,
+                               gsize *n_bytes)
+{
+    g_return_if_fail(XFCONF_IS_CHANNEL(channel));
+
+    xfconf_cache_get_stats(channel->cache, hits, misses, evictions, n_entries, n_bytes);
+}
+
 /**
  * xfconf_channel_get_string:
  * @channel: An #XfconfChannel.
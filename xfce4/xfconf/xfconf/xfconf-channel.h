@@ -60,6 +60,19 @@ void xfconf_channel_reset_property(XfconfChannel *channel,
 GHashTable *xfconf_channel_get_properties(XfconfChannel *channel,
                                           const gchar *property_base) G_GNUC_WARN_UNUSED_RESULT;
 
+void xfconf_channel_begin_transaction(XfconfChannel *channel);
+void xfconf_channel_commit_transaction(XfconfChannel *channel);
+
+void xfconf_channel_set_cache_limits(XfconfChannel *channel,
+                                     gint max_entries,
+                                     gint max_age);
+void xfconf_channel_get_cache_stats(XfconfChannel *channel,
+                                    guint64 *hits,
+                                    guint64 *misses,
+                                    guint64 *evictions,
+                                    guint *n_entries,
+                                    gsize *n_bytes);
+
 /* basic types */
 
 gchar *xfconf_channel_get_string(XfconfChannel *channel,
@@ -45,6 +45,8 @@
 #include <fcntl.h>
 #endif
 
+#include <gio/gio.h>
+#include <glib/gstdio.h>
 #include <libxfce4util/libxfce4util.h>
 #include <stdio.h>
 
@@ -65,6 +67,10 @@
 #define CONFIG_FILE_FMT CONFIG_DIR_STEM "%s.xml"
 #define CACHE_TIMEOUT (20 * 60 * 1000) /* 20 minutes */
 #define WRITE_TIMEOUT (5) /* 5 seconds */
+#define COMPACT_TIMEOUT (60) /* 1 minute without changes */
+#define JOURNAL_MAX_SIZE (256 * 1024) /* compact once the journal is bigger */
+#define SNAPSHOT_VERSION (2)
+#define SNAPSHOT_TYPE "(ubba(sttx)a(smvmvb))" /* version, locked, compact, sources, properties */
 #define MAX_PROP_PATH (4096)
 
 struct _XfconfBackendPerchannelXml
@@ -76,6 +82,7 @@ struct _XfconfBackendPerchannelXml
     GHashTable *channels;
 
     guint save_id;
+    guint compact_id;
 
     XfconfPropertyChangedFunc prop_changed_func;
     gpointer prop_changed_data;
@@ -89,13 +96,18 @@ typedef struct _XfconfBackendPerchannelXmlClass
 typedef struct
 {
     GNode *properties;
+    GHashTable *index; /* full property path -> GNode in properties */
     gboolean locked;
     gboolean dirty;
+    GString *journal; /* records not yet appended to the journal file */
+    gsize journal_size; /* what the journal file holds */
+    gboolean compact; /* the journal can't be appended to, rewrite the xml */
 } XfconfChannel;
 
 typedef struct
 {
     gchar *name;
+    gchar *path; /* NULL for the root node */
     GValue value;
     GValue system_value;
     gboolean locked;
@@ -141,6 +153,11 @@ static gboolean xfconf_backend_perchannel_xml_get(XfconfBackend *backend,
                                                   const gchar *property,
                                                   GValue *value,
                                                   GError **error);
+static gboolean xfconf_backend_perchannel_xml_get_user_value(XfconfBackend *backend,
+                                                             const gchar *channel_name,
+                                                             const gchar *property,
+                                                             GValue *value,
+                                                             GError **error);
 static gboolean xfconf_backend_perchannel_xml_get_all(XfconfBackend *backend,
                                                       const gchar *channel_name,
                                                       const gchar *property_base,
@@ -181,23 +198,36 @@ static XfconfChannel *xfconf_backend_perchannel_xml_load_channel(XfconfBackendPe
 static gboolean xfconf_backend_perchannel_xml_flush_channel(XfconfBackendPerchannelXml *xbpx,
                                                             const gchar *channel_name,
                                                             GError **error);
+static void xfconf_backend_perchannel_xml_replay_journal(XfconfChannel *channel,
+                                                         const gchar *filename);
+static gboolean xfconf_backend_perchannel_xml_append_journal(XfconfBackendPerchannelXml *xbpx,
+                                                             const gchar *channel_name,
+                                                             GError **error);
 
-static GNode *xfconf_proptree_add_property(GNode *proptree,
+static GNode *xfconf_proptree_add_property(XfconfChannel *channel,
                                            const gchar *name,
                                            const GValue *value,
                                            const GValue *system_value,
                                            gboolean locked);
-static XfconfProperty *xfconf_proptree_lookup(GNode *proptree,
+static XfconfProperty *xfconf_proptree_lookup(XfconfChannel *channel,
                                               const gchar *name);
-static GNode *xfconf_proptree_lookup_node(GNode *proptree,
+static GNode *xfconf_proptree_lookup_node(XfconfChannel *channel,
                                           const gchar *name);
-static gboolean xfconf_proptree_reset(GNode *proptree,
+static gboolean xfconf_proptree_reset(XfconfChannel *channel,
                                       const gchar *name);
-static void xfconf_proptree_destroy(GNode *proptree);
+static void xfconf_proptree_destroy(XfconfChannel *channel,
+                                    GNode *proptree);
 static gchar *xfconf_proptree_build_propname(GNode *prop_node,
                                              gchar *buf,
                                              gsize buflen);
 
+static void xfconf_channel_init_properties(XfconfChannel *channel);
+static void xfconf_channel_journal_set(XfconfChannel *channel,
+                                       const gchar *property,
+                                       const GValue *value);
+static void xfconf_channel_journal_reset(XfconfChannel *channel,
+                                         const gchar *property,
+                                         gboolean recursive);
 static void xfconf_channel_destroy(XfconfChannel *channel);
 static void xfconf_property_free(XfconfProperty *property);
 
@@ -228,9 +258,15 @@ xfconf_backend_perchannel_xml_finalize(GObject *obj)
 {
     XfconfBackendPerchannelXml *xbpx = XFCONF_BACKEND_PERCHANNEL_XML(obj);
 
-    if (xbpx->save_id) {
-        g_source_remove(xbpx->save_id);
-        xbpx->save_id = 0;
+    if (xbpx->save_id || xbpx->compact_id) {
+        if (xbpx->save_id) {
+            g_source_remove(xbpx->save_id);
+            xbpx->save_id = 0;
+        }
+        if (xbpx->compact_id) {
+            g_source_remove(xbpx->compact_id);
+            xbpx->compact_id = 0;
+        }
         xfconf_backend_perchannel_xml_flush(XFCONF_BACKEND(xbpx), NULL);
     }
 
@@ -254,6 +290,7 @@ xfconf_backend_perchannel_xml_backend_init(XfconfBackendInterface *iface)
     iface->is_property_locked = xfconf_backend_perchannel_xml_is_property_locked;
     iface->flush = xfconf_backend_perchannel_xml_flush;
     iface->register_property_changed_func = xfconf_backend_perchannel_xml_register_property_changed_func;
+    iface->get_user_value = xfconf_backend_perchannel_xml_get_user_value;
 }
 
 static gboolean
@@ -308,7 +345,7 @@ xfconf_backend_perchannel_xml_set(XfconfBackend *backend,
         }
     }
 
-    cur_prop = xfconf_proptree_lookup(channel->properties, property);
+    cur_prop = xfconf_proptree_lookup(channel, property);
     if (cur_prop) {
         if (cur_prop->locked) {
             if (error) {
@@ -338,13 +375,14 @@ xfconf_backend_perchannel_xml_set(XfconfBackend *backend,
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
         }
     } else {
-        xfconf_proptree_add_property(channel->properties, property, value,
+        xfconf_proptree_add_property(channel, property, value,
                                      NULL, FALSE);
         if (xbpx->prop_changed_func) {
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
         }
     }
 
+    xfconf_channel_journal_set(channel, property, value);
     xfconf_backend_perchannel_xml_schedule_save(xbpx, channel);
 
     return TRUE;
@@ -372,7 +410,7 @@ xfconf_backend_perchannel_xml_get(XfconfBackend *backend,
         }
     }
 
-    cur_prop = xfconf_proptree_lookup(channel->properties, property);
+    cur_prop = xfconf_proptree_lookup(channel, property);
     if (cur_prop) {
         if (G_VALUE_TYPE(&cur_prop->value)) {
             value_to_get = &cur_prop->value;
@@ -396,6 +434,42 @@ xfconf_backend_perchannel_xml_get(XfconfBackend *backend,
     return TRUE;
 }
 
+static gboolean
+xfconf_backend_perchannel_xml_get_user_value(XfconfBackend *backend,
+                                             const gchar *channel_name,
+                                             const gchar *property,
+                                             GValue *value,
+                                             GError **error)
+{
+    XfconfBackendPerchannelXml *xbpx = XFCONF_BACKEND_PERCHANNEL_XML(backend);
+    XfconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    XfconfProperty *cur_prop;
+
+    if (!channel) {
+        channel = xfconf_backend_perchannel_xml_load_channel(xbpx, channel_name,
+                                                             error);
+        if (!channel) {
+            return FALSE;
+        }
+    }
+
+    /* leave out the system value, resetting the property brings it back */
+    cur_prop = xfconf_proptree_lookup(channel, property);
+    if (!cur_prop || !G_VALUE_TYPE(&cur_prop->value)) {
+        if (error) {
+            g_set_error(error, XFCONF_ERROR,
+                        XFCONF_ERROR_PROPERTY_NOT_FOUND,
+                        _("Property \"%s\" does not exist on channel \"%s\""),
+                        property, channel_name);
+        }
+        return FALSE;
+    }
+
+    g_value_copy(&cur_prop->value, g_value_init(value, G_VALUE_TYPE(&cur_prop->value)));
+
+    return TRUE;
+}
+
 static void
 xfconf_proptree_node_to_hash_table(GNode *node,
                                    GHashTable *props_hash,
@@ -465,7 +539,7 @@ xfconf_backend_perchannel_xml_get_all(XfconfBackend *backend,
 
     if (property_base[0] && property_base[1]) {
         /* it's not "" or "/" */
-        props_tree = xfconf_proptree_lookup_node(channel->properties,
+        props_tree = xfconf_proptree_lookup_node(channel,
                                                  property_base);
         if (!props_tree) {
             if (error) {
@@ -517,7 +591,7 @@ xfconf_backend_perchannel_xml_exists(XfconfBackend *backend,
         }
     }
 
-    prop = xfconf_proptree_lookup(channel->properties, property);
+    prop = xfconf_proptree_lookup(channel, property);
     *exists = (prop && (G_VALUE_TYPE(&prop->value) || G_VALUE_TYPE(&prop->system_value)));
 
     return TRUE;
@@ -542,7 +616,7 @@ nodes_do_prop_reset(GNode *node,
      * because we're not actually changing anything by definition */
     if (G_VALUE_TYPE(&prop->value)) {
         g_value_unset(&prop->value);
-        if (pdata->xbpx->prop_changed_func) {
+        if (pdata->xbpx && pdata->xbpx->prop_changed_func) {
             pdata->xbpx->prop_changed_func(XFCONF_BACKEND(pdata->xbpx),
                                            pdata->channel_name,
                                            xfconf_proptree_build_propname(node,
@@ -559,6 +633,7 @@ static gboolean
 nodes_clean_up(GNode *node,
                gpointer data)
 {
+    XfconfChannel *channel = data;
     XfconfProperty *prop = node->data;
 
     /* clean up dangling nodes in tree without system defaults */
@@ -567,7 +642,7 @@ nodes_clean_up(GNode *node,
         && !G_VALUE_TYPE(&prop->system_value)
         && !prop->locked) {
         g_node_unlink(node);
-        xfconf_proptree_destroy(node);
+        xfconf_proptree_destroy(channel, node);
     }
 
     return FALSE;
@@ -593,6 +668,11 @@ do_reset_channel(XfconfBackend *backend,
      * from the system file (if any) if needed. */
     g_hash_table_remove(xbpx->channels, channel_name);
 
+    /* the journal only holds changes on top of the user file */
+    filename = g_strdup_printf("%s/%s.journal", xbpx->config_save_path, channel_name);
+    unlink(filename);
+    g_free(filename);
+
     /* regardless of whether or not we have a system file, we don't need
      * the user file anymore */
     filename = g_strdup_printf("%s/%s.xml", xbpx->config_save_path, channel_name);
@@ -630,7 +710,7 @@ xfconf_backend_perchannel_xml_reset(XfconfBackend *backend,
     }
 
     if (!recursive) {
-        if (!xfconf_proptree_reset(channel->properties, property)) {
+        if (!xfconf_proptree_reset(channel, property)) {
             if (error) {
                 g_set_error(error, XFCONF_ERROR,
                             XFCONF_ERROR_PROPERTY_NOT_FOUND,
@@ -644,6 +724,8 @@ xfconf_backend_perchannel_xml_reset(XfconfBackend *backend,
         {
             xbpx->prop_changed_func(backend, channel_name, property, xbpx->prop_changed_data);
         }
+
+        xfconf_channel_journal_reset(channel, property, FALSE);
     } else {
         GNode *top;
 
@@ -651,7 +733,7 @@ xfconf_backend_perchannel_xml_reset(XfconfBackend *backend,
             PropChangeData pdata;
 
             /* it's not "" or "/" */
-            top = xfconf_proptree_lookup_node(channel->properties, property);
+            top = xfconf_proptree_lookup_node(channel, property);
             if (!top) {
                 if (error) {
                     g_set_error(error, XFCONF_ERROR,
@@ -669,7 +751,9 @@ xfconf_backend_perchannel_xml_reset(XfconfBackend *backend,
 
             /* clean up dangling nodes in tree without system defaults */
             g_node_traverse(top, G_POST_ORDER, G_TRAVERSE_ALL, -1,
-                            nodes_clean_up, NULL);
+                            nodes_clean_up, channel);
+
+            xfconf_channel_journal_reset(channel, property, TRUE);
         } else {
             /* remove the entire channel */
             return do_reset_channel(backend, channel_name,
@@ -739,7 +823,7 @@ xfconf_backend_perchannel_xml_is_property_locked(XfconfBackend *backend,
     }
 
     if (!channel->locked) {
-        prop = xfconf_proptree_lookup(channel->properties, property);
+        prop = xfconf_proptree_lookup(channel, property);
     }
     *locked = (channel->locked || (prop ? prop->locked : FALSE));
     return TRUE;
@@ -752,7 +836,7 @@ xfconf_backend_perchannel_xml_flush_get_dirty(gpointer key,
 {
     XfconfChannel *channel = value;
     GSList **dirty = user_data;
-    if (channel->dirty) {
+    if (channel->dirty || channel->journal_size > 0) {
         *dirty = g_slist_prepend(*dirty, key);
     }
 }
@@ -789,52 +873,22 @@ xfconf_backend_perchannel_xml_register_property_changed_func(XfconfBackend *back
 
 
 static GNode *
-xfconf_proptree_lookup_node(GNode *proptree,
+xfconf_proptree_lookup_node(XfconfChannel *channel,
                             const gchar *name)
 {
-    GNode *found_node = NULL;
-    gchar **parts;
-    GNode *parent, *node;
-    gint i;
-
     g_return_val_if_fail(PROP_NAME_IS_VALID(name), NULL);
 
-    parts = g_strsplit(name + 1, "/", -1);
-    parent = proptree;
-
-    for (i = 0; parts[i]; ++i) {
-        for (node = g_node_first_child(parent);
-             node;
-             node = g_node_next_sibling(node))
-        {
-            if (!strcmp(((XfconfProperty *)node->data)->name, parts[i])) {
-                if (!parts[i + 1]) {
-                    found_node = node;
-                } else {
-                    parent = node;
-                }
-                break;
-            }
-        }
-
-        if (found_node || !node) {
-            break;
-        }
-    }
-
-    g_strfreev(parts);
-
-    return found_node;
+    return g_hash_table_lookup(channel->index, name);
 }
 
 static XfconfProperty *
-xfconf_proptree_lookup(GNode *proptree,
+xfconf_proptree_lookup(XfconfChannel *channel,
                        const gchar *name)
 {
     GNode *node;
     XfconfProperty *prop = NULL;
 
-    node = xfconf_proptree_lookup_node(proptree, name);
+    node = xfconf_proptree_lookup_node(channel, name);
     if (node) {
         prop = node->data;
     }
@@ -844,13 +898,14 @@ xfconf_proptree_lookup(GNode *proptree,
 
 /* here we assume the entry does not already exist */
 static GNode *
-xfconf_proptree_add_property(GNode *proptree,
+xfconf_proptree_add_property(XfconfChannel *channel,
                              const gchar *name,
                              const GValue *value,
                              const GValue *system_value,
                              gboolean locked)
 {
     GNode *parent = NULL;
+    GNode *node;
     gchar tmp[MAX_PROP_PATH];
     gchar *p;
     XfconfProperty *prop;
@@ -860,31 +915,35 @@ xfconf_proptree_add_property(GNode *proptree,
     g_strlcpy(tmp, name, MAX_PROP_PATH);
     p = g_strrstr(tmp, "/");
     if (p == tmp) {
-        parent = proptree;
+        parent = channel->properties;
     } else {
         *p = 0;
-        parent = xfconf_proptree_lookup_node(proptree, tmp);
+        parent = xfconf_proptree_lookup_node(channel, tmp);
         if (!parent) {
-            parent = xfconf_proptree_add_property(proptree, tmp, NULL, NULL, FALSE);
+            parent = xfconf_proptree_add_property(channel, tmp, NULL, NULL, FALSE);
         }
     }
 
     prop = g_slice_new0(XfconfProperty);
     prop->name = g_strdup(strrchr(name, '/') + 1);
+    prop->path = g_strdup(name);
     if (value) {
         g_value_init(&prop->value, G_VALUE_TYPE(value));
         g_value_copy(value, &prop->value);
     }
     prop->locked = locked;
 
-    return g_node_append_data(parent, prop);
+    node = g_node_append_data(parent, prop);
+    g_hash_table_insert(channel->index, prop->path, node);
+
+    return node;
 }
 
 static gboolean
-xfconf_proptree_reset(GNode *proptree,
+xfconf_proptree_reset(XfconfChannel *channel,
                       const gchar *name)
 {
-    GNode *node = xfconf_proptree_lookup_node(proptree, name);
+    GNode *node = xfconf_proptree_lookup_node(channel, name);
 
     if (node) {
         XfconfProperty *prop = node->data;
@@ -898,7 +957,7 @@ xfconf_proptree_reset(GNode *proptree,
                 GNode *parent = node->parent;
 
                 g_node_unlink(node);
-                xfconf_proptree_destroy(node);
+                xfconf_proptree_destroy(channel, node);
 
                 /* remove parents without values until we find the root node or
                  * a parent with a value or any children */
@@ -914,7 +973,7 @@ xfconf_proptree_reset(GNode *proptree,
                         DBG("unlinking node at \"%s\"", prop->name);
 
                         g_node_unlink(tmp);
-                        xfconf_proptree_destroy(tmp);
+                        xfconf_proptree_destroy(channel, tmp);
                     } else {
                         parent = NULL;
                     }
@@ -932,16 +991,24 @@ static gboolean
 proptree_free_node_data(GNode *node,
                         gpointer data)
 {
-    xfconf_property_free((XfconfProperty *)node->data);
+    XfconfChannel *channel = data;
+    XfconfProperty *prop = node->data;
+
+    if (channel && prop->path) {
+        g_hash_table_remove(channel->index, prop->path);
+    }
+    xfconf_property_free(prop);
     return FALSE;
 }
 
+/* |channel| may be NULL if the whole tree goes away along with its index */
 static void
-xfconf_proptree_destroy(GNode *proptree)
+xfconf_proptree_destroy(XfconfChannel *channel,
+                        GNode *proptree)
 {
     if (G_LIKELY(proptree)) {
         g_node_traverse(proptree, G_IN_ORDER, G_TRAVERSE_ALL, -1,
-                        proptree_free_node_data, NULL);
+                        proptree_free_node_data, channel);
         g_node_destroy(proptree);
     }
 }
@@ -951,34 +1018,93 @@ xfconf_proptree_build_propname(GNode *prop_node,
                                gchar *buf,
                                gsize buflen)
 {
-    GSList *components = NULL, *lp;
-    GNode *cur;
+    XfconfProperty *prop = prop_node->data;
 
-    for (cur = prop_node; cur; cur = cur->parent) {
-        XfconfProperty *prop = cur->data;
-        if (prop->name[0] == '/') {
-            break;
-        }
-        components = g_slist_prepend(components, prop->name);
+    g_strlcpy(buf, prop->path ? prop->path : "", buflen);
+
+    return buf;
+}
+
+
+static void
+xfconf_channel_init_properties(XfconfChannel *channel)
+{
+    XfconfProperty *prop;
+
+    if (channel->index) {
+        g_hash_table_destroy(channel->index);
+    }
+    xfconf_proptree_destroy(NULL, channel->properties);
+
+    prop = g_slice_new0(XfconfProperty);
+    prop->name = g_strdup("/");
+    channel->properties = g_node_new(prop);
+    channel->index = g_hash_table_new(g_str_hash, g_str_equal);
+}
+
+/* changes are appended to the journal as one line each, the property
+ * name escaped and the value in GVariant text format:
+ *   S <property> <value>   set
+ *   U <property>           reset
+ *   R <property>           reset recursively
+ * separated by tabs. */
+static void
+xfconf_channel_journal_append(XfconfChannel *channel,
+                              gchar op,
+                              const gchar *property,
+                              const gchar *value_str)
+{
+    gchar *escaped = g_strescape(property, NULL);
+
+    if (!channel->journal) {
+        channel->journal = g_string_sized_new(256);
     }
 
-    /* FIXME: optimise */
-    buf[0] = 0;
-    for (lp = components; lp; lp = lp->next) {
-        g_strlcat(buf, "/", buflen);
-        g_strlcat(buf, (gchar *)lp->data, buflen);
+    g_string_append_printf(channel->journal, "%c\t%s", op, escaped);
+    if (value_str) {
+        g_string_append_printf(channel->journal, "\t%s", value_str);
     }
+    g_string_append_c(channel->journal, '\n');
 
-    g_slist_free(components);
+    g_free(escaped);
+}
 
-    return buf;
+static void
+xfconf_channel_journal_set(XfconfChannel *channel,
+                           const gchar *property,
+                           const GValue *value)
+{
+    GVariant *variant = xfconf_gvalue_to_gvariant(value);
+    gchar *value_str;
+
+    if (!variant) {
+        /* can't be journaled, write out the whole channel */
+        channel->compact = TRUE;
+        return;
+    }
+
+    value_str = g_variant_print(variant, TRUE);
+    xfconf_channel_journal_append(channel, 'S', property, value_str);
+    g_free(value_str);
+    g_variant_unref(variant);
 }
 
+static void
+xfconf_channel_journal_reset(XfconfChannel *channel,
+                             const gchar *property,
+                             gboolean recursive)
+{
+    xfconf_channel_journal_append(channel, recursive ? 'R' : 'U', property, NULL);
+}
 
 static void
 xfconf_channel_destroy(XfconfChannel *channel)
 {
-    xfconf_proptree_destroy(channel->properties);
+    if (channel->journal) {
+        g_string_free(channel->journal, TRUE);
+    }
+    g_hash_table_destroy(channel->index);
+    xfconf_proptree_destroy(NULL, channel->properties);
     g_slice_free(XfconfChannel, channel);
 }
 
@@ -986,6 +1112,7 @@ static void
 xfconf_property_free(XfconfProperty *property)
 {
     g_free(property->name);
+    g_free(property->path);
     if (G_VALUE_TYPE(&property->value)) {
         g_value_unset(&property->value);
     }
@@ -998,8 +1125,42 @@ xfconf_property_free(XfconfProperty *property)
 static gboolean
 xfconf_backend_perchannel_xml_save_timeout(gpointer data)
 {
-    XFCONF_BACKEND_PERCHANNEL_XML(data)->save_id = 0;
-    xfconf_backend_perchannel_xml_flush(XFCONF_BACKEND(data), NULL);
+    XfconfBackendPerchannelXml *xbpx = XFCONF_BACKEND_PERCHANNEL_XML(data);
+    GSList *dirty = NULL, *l;
+
+    xbpx->save_id = 0;
+
+    g_hash_table_foreach(xbpx->channels, xfconf_backend_perchannel_xml_flush_get_dirty, &dirty);
+
+    for (l = dirty; l; l = l->next) {
+        XfconfChannel *channel = g_hash_table_lookup(xbpx->channels, l->data);
+
+        if (!channel->dirty) {
+            /* only its journal is left to compact, that's done on idle */
+            continue;
+        }
+
+        /* append the changes to the journal, unless it grew too big or
+         * can't hold them, then rewrite the whole channel instead */
+        if (channel->compact
+            || channel->journal_size + (channel->journal ? channel->journal->len : 0) > JOURNAL_MAX_SIZE
+            || !xfconf_backend_perchannel_xml_append_journal(xbpx, l->data, NULL))
+        {
+            xfconf_backend_perchannel_xml_flush_channel(xbpx, l->data, NULL);
+        }
+    }
+    g_slist_free(dirty);
+
+    return FALSE;
+}
+
+static gboolean
+xfconf_backend_perchannel_xml_compact_timeout(gpointer data)
+{
+    XfconfBackendPerchannelXml *xbpx = XFCONF_BACKEND_PERCHANNEL_XML(data);
+
+    xbpx->compact_id = 0;
+    xfconf_backend_perchannel_xml_flush(XFCONF_BACKEND(xbpx), NULL);
 
     return FALSE;
 }
@@ -1015,6 +1176,14 @@ xfconf_backend_perchannel_xml_schedule_save(XfconfBackendPerchannelXml *xbpx,
                                               xfconf_backend_perchannel_xml_save_timeout,
                                               xbpx);
     }
+
+    /* the journals get compacted into the xml files once things calm down */
+    if (xbpx->compact_id != 0) {
+        g_source_remove(xbpx->compact_id);
+    }
+    xbpx->compact_id = g_timeout_add_seconds(COMPACT_TIMEOUT,
+                                             xfconf_backend_perchannel_xml_compact_timeout,
+                                             xbpx);
 }
 
 static XfconfChannel *
@@ -1022,7 +1191,6 @@ xfconf_backend_perchannel_xml_create_channel(XfconfBackendPerchannelXml *xbpx,
                                              const gchar *channel_name)
 {
     XfconfChannel *channel;
-    XfconfProperty *prop;
 
     channel = g_hash_table_lookup(xbpx->channels, channel_name);
     if (channel) {
@@ -1031,9 +1199,7 @@ xfconf_backend_perchannel_xml_create_channel(XfconfBackendPerchannelXml *xbpx,
     }
 
     channel = g_slice_new0(XfconfChannel);
-    prop = g_slice_new0(XfconfProperty);
-    prop->name = g_strdup("/");
-    channel->properties = g_node_new(prop);
+    xfconf_channel_init_properties(channel);
     g_hash_table_insert(xbpx->channels, g_strdup(channel_name), channel);
 
     return channel;
@@ -1137,13 +1303,7 @@ xfconf_xml_handle_channel(XmlParserState *state,
             }
             return FALSE;
         } else if (!state->channel->locked && locked_state) {
-            XfconfProperty *prop;
-
-            xfconf_proptree_destroy(state->channel->properties);
-
-            prop = g_slice_new0(XfconfProperty);
-            prop->name = g_strdup("/");
-            state->channel->properties = g_node_new(prop);
+            xfconf_channel_init_properties(state->channel);
 
             state->channel->locked = TRUE;
         }
@@ -1225,7 +1385,7 @@ xfconf_xml_handle_property(XmlParserState *state,
         g_assert_not_reached();
     }
 
-    prop = xfconf_proptree_lookup(state->channel->properties, fullpath);
+    prop = xfconf_proptree_lookup(state->channel, fullpath);
 
     if (state->channel->locked) {
         /* we must still be in a system file, otherwise we'd never get here */
@@ -1239,7 +1399,7 @@ xfconf_xml_handle_property(XmlParserState *state,
                 g_value_unset(&prop->system_value);
             }
         } else {
-            GNode *pnode = xfconf_proptree_add_property(state->channel->properties,
+            GNode *pnode = xfconf_proptree_add_property(state->channel,
                                                         fullpath, NULL, NULL,
                                                         TRUE);
             if (pnode != NULL) {
@@ -1268,7 +1428,7 @@ xfconf_xml_handle_property(XmlParserState *state,
                 }
             }
         } else {
-            GNode *pnode = xfconf_proptree_add_property(state->channel->properties,
+            GNode *pnode = xfconf_proptree_add_property(state->channel,
                                                         fullpath, NULL, NULL,
                                                         FALSE);
             if (pnode != NULL) {
@@ -1291,7 +1451,7 @@ xfconf_xml_handle_property(XmlParserState *state,
                             "Attribute \"locked\" not allowed in <property> for non-system files");
             }
 
-            xfconf_proptree_reset(state->channel->properties, fullpath);
+            xfconf_proptree_reset(state->channel, fullpath);
             return FALSE;
         }
 
@@ -1661,15 +1821,327 @@ xfconf_backend_perchannel_xml_merge_file(XfconfBackendPerchannelXml *xbpx,
     return ret;
 }
 
+/*
+ * Snapshots are the merged property tree of a channel, serialized as a
+ * GVariant of SNAPSHOT_TYPE in the user cache directory, so that the next
+ * start can map it instead of parsing all the xml files again. They are
+ * valid as long as the size, inode and mtime (in nanoseconds, as far as the
+ * file system has them) of every file the channel is read from are unchanged,
+ * and written again from a worker thread otherwise. Whether the journal
+ * ended in an incomplete record is part of the snapshot too.
+ */
+static gchar *
+xfconf_snapshot_filename(const gchar *channel_name)
+{
+    return g_strdup_printf("%s/xfconf/%s.snapshot", g_get_user_cache_dir(), channel_name);
+}
+
+static GVariant *
+xfconf_snapshot_sources(gchar **filenames,
+                        const gchar *user_file,
+                        const gchar *journal_file,
+                        gsize *journal_size)
+{
+    GVariantBuilder builder;
+    const gchar *filename;
+    GStatBuf st;
+    gint64 mtime;
+    gint i, length;
+
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sttx)"));
+
+    *journal_size = 0;
+    length = filenames ? g_strv_length(filenames) : 0;
+    for (i = 0; i < length + 2; ++i) {
+        if (i < length) {
+            filename = filenames[i];
+        } else if (i == length) {
+            filename = user_file;
+        } else {
+            filename = journal_file;
+        }
+
+        if (!filename) {
+            continue;
+        }
+
+        if (g_stat(filename, &st) == 0) {
+            /* a file rewritten within the same second must not match */
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+            mtime = (gint64)st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+#else
+            mtime = (gint64)st.st_mtime * G_GINT64_CONSTANT(1000000000);
+#endif
+            g_variant_builder_add(&builder, "(sttx)", filename,
+                                  (guint64)st.st_size, (guint64)st.st_ino, mtime);
+            if (filename == journal_file) {
+                *journal_size = st.st_size;
+            }
+        } else {
+            g_variant_builder_add(&builder, "(sttx)", filename,
+                                  (guint64)0, (guint64)0, (gint64)-1);
+        }
+    }
+
+    return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+static gboolean
+xfconf_snapshot_value_is_supported(const GValue *value)
+{
+    if (G_VALUE_TYPE(value) == G_TYPE_PTR_ARRAY) {
+        GPtrArray *arr = g_value_get_boxed(value);
+        guint i;
+
+        if (!arr) {
+            return FALSE;
+        }
+        for (i = 0; i < arr->len; ++i) {
+            if (!xfconf_snapshot_value_is_supported(g_ptr_array_index(arr, i))) {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+
+    /* these would come back with another type */
+    return G_VALUE_TYPE(value) != G_TYPE_CHAR && G_VALUE_TYPE(value) != G_TYPE_FLOAT;
+}
+
+/* returns a floating "mv", or NULL if |value| can't be stored */
+static GVariant *
+xfconf_snapshot_value(const GValue *value)
+{
+    GVariant *variant, *maybe;
+
+    if (!G_VALUE_TYPE(value)) {
+        return g_variant_new_maybe(G_VARIANT_TYPE_VARIANT, NULL);
+    }
+
+    if (!xfconf_snapshot_value_is_supported(value)) {
+        return NULL;
+    }
+
+    variant = xfconf_gvalue_to_gvariant(value);
+    if (!variant) {
+        return NULL;
+    }
+
+    maybe = g_variant_new_maybe(G_VARIANT_TYPE_VARIANT, g_variant_new_variant(variant));
+    g_variant_unref(variant);
+
+    return maybe;
+}
+
+/* pre-order, so parents come before their children and siblings keep
+ * their order when the tree is built again */
+static gboolean
+xfconf_snapshot_add_nodes(GVariantBuilder *builder,
+                          GNode *node)
+{
+    XfconfProperty *prop = node->data;
+    GNode *child;
+
+    if (prop->path) {
+        GVariant *value, *system_value;
+
+        value = xfconf_snapshot_value(&prop->value);
+        system_value = xfconf_snapshot_value(&prop->system_value);
+        if (!value || !system_value) {
+            if (value) {
+                g_variant_unref(g_variant_ref_sink(value));
+            }
+            if (system_value) {
+                g_variant_unref(g_variant_ref_sink(system_value));
+            }
+            return FALSE;
+        }
+
+        g_variant_builder_add(builder, "(s@mv@mvb)", prop->path,
+                              value, system_value, prop->locked);
+    }
+
+    for (child = g_node_first_child(node); child; child = g_node_next_sibling(child)) {
+        if (!xfconf_snapshot_add_nodes(builder, child)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static GVariant *
+xfconf_snapshot_build(XfconfChannel *channel,
+                      GVariant *sources)
+{
+    GVariantBuilder nodes;
+
+    g_variant_builder_init(&nodes, G_VARIANT_TYPE("a(smvmvb)"));
+    if (!xfconf_snapshot_add_nodes(&nodes, channel->properties)) {
+        g_variant_builder_clear(&nodes);
+        return NULL;
+    }
+
+    return g_variant_ref_sink(g_variant_new("(ubb@a(sttx)@a(smvmvb))",
+                                            SNAPSHOT_VERSION, channel->locked,
+                                            channel->compact, sources,
+                                            g_variant_builder_end(&nodes)));
+}
+
+typedef struct
+{
+    gchar *filename;
+    GVariant *snapshot;
+} SnapshotWriteData;
+
+static void
+xfconf_snapshot_write_data_free(SnapshotWriteData *data)
+{
+    g_free(data->filename);
+    g_variant_unref(data->snapshot);
+    g_slice_free(SnapshotWriteData, data);
+}
+
+static void
+xfconf_snapshot_write_thread(GTask *task,
+                             gpointer source_object,
+                             gpointer task_data,
+                             GCancellable *cancellable)
+{
+    SnapshotWriteData *data = task_data;
+    gchar *dirname = g_path_get_dirname(data->filename);
+    GError *error = NULL;
+
+    if (g_mkdir_with_parents(dirname, 0700) != 0) {
+        g_warning("Unable to create directory \"%s\": %s", dirname, strerror(errno));
+    } else if (!g_file_set_contents(data->filename, g_variant_get_data(data->snapshot),
+                                    g_variant_get_size(data->snapshot), &error))
+    {
+        g_warning("Unable to write xfconf snapshot: %s", error->message);
+        g_error_free(error);
+    }
+
+    g_free(dirname);
+}
+
+static void
+xfconf_snapshot_write(const gchar *filename,
+                      GVariant *snapshot)
+{
+    SnapshotWriteData *data = g_slice_new(SnapshotWriteData);
+    GTask *task = g_task_new(NULL, NULL, NULL, NULL);
+
+    data->filename = g_strdup(filename);
+    data->snapshot = g_variant_ref(snapshot);
+    g_task_set_task_data(task, data, (GDestroyNotify)xfconf_snapshot_write_data_free);
+    g_task_run_in_thread(task, xfconf_snapshot_write_thread);
+    g_object_unref(task);
+}
+
+static gboolean
+xfconf_snapshot_load(XfconfChannel *channel,
+                     const gchar *filename,
+                     GVariant *sources)
+{
+    GMappedFile *mapped;
+    GBytes *bytes;
+    GVariant *snapshot, *snapshot_sources, *nodes, *value, *system_value;
+    GVariantIter iter;
+    const gchar *path;
+    gboolean locked, compact, ret = FALSE;
+    guint32 version;
+
+    mapped = g_mapped_file_new(filename, FALSE, NULL);
+    if (!mapped) {
+        return FALSE;
+    }
+
+    bytes = g_mapped_file_get_bytes(mapped);
+    g_mapped_file_unref(mapped);
+    snapshot = g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE(SNAPSHOT_TYPE), bytes, FALSE));
+    g_bytes_unref(bytes);
+
+    g_variant_get(snapshot, "(ubb@a(sttx)@a(smvmvb))", &version, &locked,
+                  &compact, &snapshot_sources, &nodes);
+
+    if (version == SNAPSHOT_VERSION && g_variant_equal(sources, snapshot_sources)) {
+        ret = TRUE;
+        channel->locked = locked;
+        /* the journal ends in an incomplete record, don't append to it */
+        channel->compact = compact;
+
+        g_variant_iter_init(&iter, nodes);
+        while (ret && g_variant_iter_next(&iter, "(&s@mv@mvb)", &path, &value,
+                                          &system_value, &locked))
+        {
+            GNode *node = NULL;
+            GVariant *child;
+
+            if (PROP_NAME_IS_VALID(path) && !xfconf_proptree_lookup_node(channel, path)) {
+                node = xfconf_proptree_add_property(channel, path, NULL, NULL, locked);
+            }
+
+            if (!node) {
+                ret = FALSE;
+            } else {
+                XfconfProperty *prop = node->data;
+                GValue *gvalue;
+
+                if ((child = g_variant_get_maybe(value))) {
+                    gvalue = xfconf_gvariant_to_gvalue(child);
+                    if (gvalue) {
+                        g_value_copy(gvalue, g_value_init(&prop->value, G_VALUE_TYPE(gvalue)));
+                        _xfconf_gvalue_free(gvalue);
+                    } else {
+                        ret = FALSE;
+                    }
+                    g_variant_unref(child);
+                }
+
+                if ((child = g_variant_get_maybe(system_value))) {
+                    gvalue = xfconf_gvariant_to_gvalue(child);
+                    if (gvalue) {
+                        g_value_copy(gvalue, g_value_init(&prop->system_value, G_VALUE_TYPE(gvalue)));
+                        _xfconf_gvalue_free(gvalue);
+                    } else {
+                        ret = FALSE;
+                    }
+                    g_variant_unref(child);
+                }
+            }
+
+            g_variant_unref(value);
+            g_variant_unref(system_value);
+        }
+
+        if (!ret) {
+            g_warning("Ignoring invalid xfconf snapshot \"%s\"", filename);
+            xfconf_channel_init_properties(channel);
+            channel->locked = FALSE;
+            channel->compact = FALSE;
+        }
+    }
+
+    g_variant_unref(snapshot_sources);
+    g_variant_unref(nodes);
+    g_variant_unref(snapshot);
+
+    return ret;
+}
+
 static XfconfChannel *
 xfconf_backend_perchannel_xml_load_channel(XfconfBackendPerchannelXml *xbpx,
                                            const gchar *channel_name,
                                            GError **error)
 {
     XfconfChannel *channel = NULL;
-    gchar *filename_stem, **filenames, *user_file;
+    gchar *filename_stem, **filenames, *user_file, *journal_file;
+    gchar *snapshot_file;
+    GVariant *sources, *snapshot;
+    gsize journal_size;
     gint i, length;
-    XfconfProperty *prop;
+    gint64 start;
 
     TRACE("entering");
 
@@ -1678,8 +2150,11 @@ xfconf_backend_perchannel_xml_load_channel(XfconfBackendPerchannelXml *xbpx,
     user_file = xfce_resource_save_location(XFCE_RESOURCE_CONFIG,
                                             filename_stem, FALSE);
     g_free(filename_stem);
+    journal_file = g_strdup_printf("%s/%s.journal", xbpx->config_save_path, channel_name);
 
-    if ((!filenames || !filenames[0]) && !user_file) {
+    if ((!filenames || !filenames[0]) && !user_file
+        && !g_file_test(journal_file, G_FILE_TEST_IS_REGULAR))
+    {
         if (error) {
             g_set_error(error, XFCONF_ERROR,
                         XFCONF_ERROR_CHANNEL_NOT_FOUND,
@@ -1689,32 +2164,68 @@ xfconf_backend_perchannel_xml_load_channel(XfconfBackendPerchannelXml *xbpx,
     }
 
     channel = g_slice_new0(XfconfChannel);
-    prop = g_slice_new0(XfconfProperty);
-    prop->name = g_strdup("/");
-    channel->properties = g_node_new(prop);
+    xfconf_channel_init_properties(channel);
 
-    /* read in system files, we do this in reversed order to properly
-     * follow the xdg spec, see bug #6079 for more information */
-    length = filenames ? g_strv_length(filenames) : 0;
-    for (i = length - 1; i >= 0; --i) {
-        if (!g_strcmp0(user_file, filenames[i])) {
-            continue;
+    start = g_get_monotonic_time();
+    snapshot_file = xfconf_snapshot_filename(channel_name);
+    sources = xfconf_snapshot_sources(filenames, user_file, journal_file, &journal_size);
+
+    if (xfconf_snapshot_load(channel, snapshot_file, sources)) {
+        if (!channel->locked) {
+            channel->journal_size = journal_size;
+        }
+
+        DBG("loaded channel \"%s\" from snapshot in %" G_GINT64_FORMAT "us",
+            channel_name, g_get_monotonic_time() - start);
+    } else {
+        /* read in system files, we do this in reversed order to properly
+         * follow the xdg spec, see bug #6079 for more information */
+        length = filenames ? g_strv_length(filenames) : 0;
+        for (i = length - 1; i >= 0; --i) {
+            if (!g_strcmp0(user_file, filenames[i])) {
+                continue;
+            }
+            xfconf_backend_perchannel_xml_merge_file(xbpx, filenames[i], TRUE,
+                                                     channel, NULL);
+        }
+
+        if (!channel->locked && user_file) {
+            /* read in user file */
+            xfconf_backend_perchannel_xml_merge_file(xbpx, user_file, FALSE,
+                                                     channel, NULL);
         }
-        xfconf_backend_perchannel_xml_merge_file(xbpx, filenames[i], TRUE,
-                                                 channel, NULL);
-    }
 
-    if (!channel->locked && user_file) {
-        /* read in user file */
-        xfconf_backend_perchannel_xml_merge_file(xbpx, user_file, FALSE,
-                                                 channel, NULL);
+        if (!channel->locked) {
+            /* and the changes made since it was written */
+            xfconf_backend_perchannel_xml_replay_journal(channel, journal_file);
+        }
+
+        DBG("loaded channel \"%s\" from xml in %" G_GINT64_FORMAT "us",
+            channel_name, g_get_monotonic_time() - start);
+
+        /* the files were stat()ed before they were read, if they changed
+         * meanwhile the snapshot will just be out of date */
+        snapshot = xfconf_snapshot_build(channel, sources);
+        if (snapshot) {
+            xfconf_snapshot_write(snapshot_file, snapshot);
+            g_variant_unref(snapshot);
+        }
     }
 
+    g_variant_unref(sources);
+    g_free(snapshot_file);
+
     g_hash_table_insert(xbpx->channels, g_strdup(channel_name), channel);
 
+    if (channel->journal_size > 0) {
+        /* to compact the journal eventually */
+        xfconf_backend_perchannel_xml_schedule_save(xbpx, channel);
+    }
+
 out:
     g_strfreev(filenames);
     g_free(user_file);
+    g_free(journal_file);
 
     return channel;
 }
@@ -1923,6 +2434,28 @@ xfconf_backend_perchannel_xml_write_node(XfconfBackendPerchannelXml *xbpx,
     return TRUE;
 }
 
+static gboolean
+xfconf_sync_file(FILE *fp)
+{
+    if (fflush(fp)) {
+        return FALSE;
+    }
+
+#if defined(HAVE_FDATASYNC)
+    if (fdatasync(fileno(fp))) {
+        return FALSE;
+    }
+#elif defined(HAVE_FSYNC)
+    if (fsync(fileno(fp))) {
+        return FALSE;
+    }
+#else
+    sync();
+#endif
+
+    return TRUE;
+}
+
 static gboolean
 xfconf_backend_perchannel_xml_flush_channel(XfconfBackendPerchannelXml *xbpx,
                                             const gchar *channel_name,
@@ -1979,21 +2512,9 @@ xfconf_backend_perchannel_xml_flush_channel(XfconfBackendPerchannelXml *xbpx,
         goto out;
     }
 
-    if (fflush(fp)) {
-        goto out;
-    }
-
-#if defined(HAVE_FDATASYNC)
-    if (fdatasync(fileno(fp))) {
+    if (!xfconf_sync_file(fp)) {
         goto out;
     }
-#elif defined(HAVE_FSYNC)
-    if (fsync(fileno(fp))) {
-        goto out;
-    }
-#else
-    sync();
-#endif
 
     if (fclose(fp)) {
         fp = NULL;
@@ -2005,6 +2526,18 @@ xfconf_backend_perchannel_xml_flush_channel(XfconfBackendPerchannelXml *xbpx,
         goto out;
     }
 
+    /* everything in the journal is in the xml file now */
+    g_free(filename);
+    filename = g_strdup_printf("%s/%s.journal", xbpx->config_save_path, channel_name);
+    if (unlink(filename) && errno != ENOENT) {
+        g_warning("Unable to remove journal \"%s\": %s", filename, strerror(errno));
+    }
+    if (channel->journal) {
+        g_string_truncate(channel->journal, 0);
+    }
+    channel->journal_size = 0;
+    channel->compact = FALSE;
+
     ret = TRUE;
 
 out:
@@ -2026,3 +2559,194 @@ out:
 
     return ret;
 }
+
+static gboolean
+xfconf_backend_perchannel_xml_append_journal(XfconfBackendPerchannelXml *xbpx,
+                                             const gchar *channel_name,
+                                             GError **error)
+{
+    gboolean ret = FALSE;
+    XfconfChannel *channel = g_hash_table_lookup(xbpx->channels, channel_name);
+    gchar *filename;
+    FILE *fp = NULL;
+
+    DBG("Appending changes of channel \"%s\" to its journal", channel_name);
+
+    if (!channel) {
+        if (error) {
+            g_set_error(error, XFCONF_ERROR,
+                        XFCONF_ERROR_CHANNEL_NOT_FOUND,
+                        _("Channel \"%s\" does not exist"), channel_name);
+        }
+        return FALSE;
+    }
+
+    if (!channel->journal || channel->journal->len == 0) {
+        channel->dirty = FALSE;
+        return TRUE;
+    }
+
+    filename = g_strdup_printf("%s/%s.journal", xbpx->config_save_path, channel_name);
+
+    if (g_mkdir_with_parents(xbpx->config_save_path, 0755) != 0) {
+        goto out;
+    }
+
+    fp = fopen(filename, "a");
+    if (!fp) {
+        goto out;
+    }
+
+    if (fwrite(channel->journal->str, 1, channel->journal->len, fp) != channel->journal->len) {
+        goto out;
+    }
+
+    if (!xfconf_sync_file(fp)) {
+        goto out;
+    }
+
+    if (fclose(fp)) {
+        fp = NULL;
+        goto out;
+    }
+    fp = NULL;
+
+    channel->journal_size += channel->journal->len;
+    g_string_truncate(channel->journal, 0);
+    channel->dirty = FALSE;
+
+    ret = TRUE;
+
+out:
+    if (!ret) {
+        if (error) {
+            g_set_error(error, XFCONF_ERROR,
+                        XFCONF_ERROR_WRITE_FAILURE,
+                        _("Unable to write channel \"%s\": %s"),
+                        channel_name, strerror(errno));
+        }
+
+        /* the journal may end with a partial record now */
+        channel->compact = TRUE;
+    }
+
+    if (fp) {
+        fclose(fp);
+    }
+
+    g_free(filename);
+
+    return ret;
+}
+
+static gboolean
+xfconf_backend_perchannel_xml_replay_record(XfconfChannel *channel,
+                                            const gchar *record)
+{
+    gchar **fields;
+    gchar *property = NULL;
+    gboolean ret = FALSE;
+
+    fields = g_strsplit(record, "\t", 3);
+    if (!fields[0] || !fields[1] || fields[0][0] == 0 || fields[0][1] != 0) {
+        goto out;
+    }
+
+    property = g_strcompress(fields[1]);
+    if (!PROP_NAME_IS_VALID(property)) {
+        goto out;
+    }
+
+    switch (fields[0][0]) {
+        case 'S': {
+            GVariant *variant;
+            GValue *value;
+            XfconfProperty *prop;
+
+            if (!fields[2]) {
+                goto out;
+            }
+
+            variant = g_variant_parse(NULL, fields[2], NULL, NULL, NULL);
+            if (!variant) {
+                goto out;
+            }
+            value = xfconf_gvariant_to_gvalue(variant);
+            g_variant_unref(variant);
+            if (!value) {
+                goto out;
+            }
+
+            prop = xfconf_proptree_lookup(channel, property);
+            if (!prop) {
+                xfconf_proptree_add_property(channel, property, value, NULL, FALSE);
+            } else if (!prop->locked) {
+                if (G_VALUE_TYPE(&prop->value)) {
+                    g_value_unset(&prop->value);
+                }
+                g_value_copy(value, g_value_init(&prop->value, G_VALUE_TYPE(value)));
+            }
+            _xfconf_gvalue_free(value);
+        } break;
+
+        case 'U':
+            xfconf_proptree_reset(channel, property);
+            break;
+
+        case 'R': {
+            GNode *top = xfconf_proptree_lookup_node(channel, property);
+
+            if (top) {
+                PropChangeData pdata = { NULL, NULL };
+
+                g_node_traverse(top, G_POST_ORDER, G_TRAVERSE_ALL, -1,
+                                nodes_do_prop_reset, &pdata);
+                g_node_traverse(top, G_POST_ORDER, G_TRAVERSE_ALL, -1,
+                                nodes_clean_up, channel);
+            }
+        } break;
+
+        default:
+            goto out;
+    }
+
+    ret = TRUE;
+
+out:
+    g_free(property);
+    g_strfreev(fields);
+
+    return ret;
+}
+
+static void
+xfconf_backend_perchannel_xml_replay_journal(XfconfChannel *channel,
+                                             const gchar *filename)
+{
+    gchar *contents, *record, *end;
+    gsize length;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL)) {
+        return;
+    }
+
+    TRACE("replaying journal %s", filename);
+
+    for (record = contents; (end = strchr(record, '\n')) != NULL; record = end + 1) {
+        *end = 0;
+        if (!xfconf_backend_perchannel_xml_replay_record(channel, record)) {
+            g_warning("Ignoring the rest of xfconf journal \"%s\" after an invalid record",
+                      filename);
+            break;
+        }
+    }
+
+    channel->journal_size = length;
+    if (record != contents + length) {
+        /* an invalid or incomplete (crash while appending) record, don't
+         * append anything after it but rewrite the xml file soon */
+        channel->compact = TRUE;
+    }
+
+    g_free(contents);
+}
@@ -51,7 +51,7 @@ static gboolean xfconf_channel_is_valid(const gchar *channel,
  * @is_property_locked: See xfconf_backend_is_property_locked().
  * @flush: See xfconf_backend_flush().
  * @register_property_changed_func: See xfconf_backend_register_property_changed_func().
- * @_xb_reserved0: Reserved for future expansion.
+ * @get_user_value: See xfconf_backend_get_user_value().
  * @_xb_reserved1: Reserved for future expansion.
  * @_xb_reserved2: Reserved for future expansion.
  * @_xb_reserved3: Reserved for future expansion.
@@ -301,6 +301,49 @@ xfconf_backend_get(XfconfBackend *backend,
     return iface->get(backend, channel, property, value, error);
 }
 
+/**
+ * xfconf_backend_get_user_value:
+ * @backend: The #XfconfBackend.
+ * @channel: A channel name.
+ * @property: A property name.
+ * @value: A #GValue return.
+ * @error: An error return.
+ *
+ * Like xfconf_backend_get(), but only gets a value the user has set,
+ * not a system-wide default.  Backends that don't implement this are
+ * asked for the value with xfconf_backend_get().
+ *
+ * Return value: The backend should return %TRUE if the operation
+ *               was successful, or %FALSE otherwise.  On %FALSE,
+ *               @error should be set to a description of the failure.
+ **/
+gboolean
+xfconf_backend_get_user_value(XfconfBackend *backend,
+                              const gchar *channel,
+                              const gchar *property,
+                              GValue *value,
+                              GError **error)
+{
+    XfconfBackendInterface *iface = XFCONF_BACKEND_GET_INTERFACE(backend);
+
+    xfconf_backend_return_val_if_fail(iface && iface->get && channel && *channel
+                                          && property && *property
+                                          && value && (!error || !*error),
+                                      FALSE);
+    if (!xfconf_channel_is_valid(channel, error)) {
+        return FALSE;
+    }
+    if (!xfconf_property_is_valid(property, error)) {
+        return FALSE;
+    }
+
+    if (!iface->get_user_value) {
+        return iface->get(backend, channel, property, value, error);
+    }
+
+    return iface->get_user_value(backend, channel, property, value, error);
+}
+
 /**
  * xfconf_backend_get_all:
  * @backend: The #XfconfBackend.
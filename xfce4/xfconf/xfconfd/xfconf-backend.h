@@ -116,8 +116,13 @@ struct _XfconfBackendInterface
                                            XfconfPropertyChangedFunc func,
                                            gpointer user_data);
 
+    gboolean (*get_user_value)(XfconfBackend *backend,
+                               const gchar *channel,
+                               const gchar *property,
+                               GValue *value,
+                               GError **error);
+
     /*< reserved for future expansion >*/
-    void (*_xb_reserved0)();
     void (*_xb_reserved1)();
     void (*_xb_reserved2)();
     void (*_xb_reserved3)();
@@ -140,6 +145,12 @@ gboolean xfconf_backend_get(XfconfBackend *backend,
                             GValue *value,
                             GError **error);
 
+gboolean xfconf_backend_get_user_value(XfconfBackend *backend,
+                                       const gchar *channel,
+                                       const gchar *property,
+                                       GValue *value,
+                                       GError **error);
+
 gboolean xfconf_backend_get_all(XfconfBackend *backend,
                                 const gchar *channel,
                                 const gchar *property_base,
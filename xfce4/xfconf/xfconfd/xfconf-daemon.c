@@ -40,6 +40,10 @@ struct _XfconfDaemon
     GDBusConnection *conn;
 
     GList *backends;
+
+    /* properties changed by the SetProperties call in progress */
+    const gchar *batch_channel;
+    GHashTable *batch_properties;
 };
 
 typedef struct _XfconfDaemonClass
@@ -122,14 +126,78 @@ xfconf_daemon_emit_property_changed_idled(gpointer data)
     return FALSE;
 }
 
+typedef struct
+{
+    XfconfDaemon *xfconfd;
+    XfconfBackend *backend;
+    gchar *channel;
+    GHashTable *properties;
+} XfconfPropsChangedData;
+
+static gboolean
+xfconf_daemon_emit_properties_changed_idled(gpointer data)
+{
+    XfconfPropsChangedData *pdata = data;
+    GVariantBuilder changed;
+    GPtrArray *removed;
+    GHashTableIter iter;
+    const gchar *property;
+
+    g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+    removed = g_ptr_array_new();
+
+    g_hash_table_iter_init(&iter, pdata->properties);
+    while (g_hash_table_iter_next(&iter, (gpointer)&property, NULL)) {
+        GValue value = G_VALUE_INIT;
+
+        xfconf_backend_get(pdata->backend, pdata->channel, property,
+                           &value, NULL);
+        if (G_VALUE_TYPE(&value)) {
+            GVariant *val = xfconf_gvalue_to_gvariant(&value);
+            if (val) {
+                g_variant_builder_add(&changed, "{sv}", property, val);
+                g_variant_unref(val);
+            }
+            g_value_unset(&value);
+        } else {
+            g_ptr_array_add(removed, (gpointer)property);
+        }
+    }
+    g_ptr_array_add(removed, NULL);
+
+    xfconf_exported_emit_properties_changed((XfconfExported *)pdata->xfconfd,
+                                            pdata->channel,
+                                            g_variant_builder_end(&changed),
+                                            (const gchar *const *)removed->pdata);
+
+    g_ptr_array_free(removed, TRUE);
+    g_hash_table_destroy(pdata->properties);
+    g_object_unref(G_OBJECT(pdata->backend));
+    g_free(pdata->channel);
+    g_object_unref(G_OBJECT(pdata->xfconfd));
+    g_slice_free(XfconfPropsChangedData, pdata);
+
+    return FALSE;
+}
+
 static void
 xfconf_daemon_backend_property_changed(XfconfBackend *backend,
                                        const gchar *channel,
                                        const gchar *property,
                                        gpointer user_data)
 {
-    XfconfPropChangedData *pdata = g_slice_new0(XfconfPropChangedData);
-    pdata->xfconfd = g_object_ref(XFCONF_DAEMON(user_data));
+    XfconfDaemon *xfconfd = XFCONF_DAEMON(user_data);
+    XfconfPropChangedData *pdata;
+
+    /* changes made by SetProperties are sent in one signal once all
+     * of them are applied */
+    if (xfconfd->batch_properties && strcmp(channel, xfconfd->batch_channel) == 0) {
+        g_hash_table_add(xfconfd->batch_properties, g_strdup(property));
+        return;
+    }
+
+    pdata = g_slice_new0(XfconfPropChangedData);
+    pdata->xfconfd = g_object_ref(xfconfd);
     pdata->backend = g_object_ref(XFCONF_BACKEND(backend));
     pdata->channel = g_strdup(channel);
     pdata->property = g_strdup(property);
@@ -137,45 +205,55 @@ xfconf_daemon_backend_property_changed(XfconfBackend *backend,
 }
 
 static gboolean
-xfconf_set_property(XfconfExported *skeleton,
-                    GDBusMethodInvocation *invocation,
-                    const gchar *channel,
-                    const gchar *property,
-                    GVariant *variant,
-                    XfconfDaemon *xfconfd)
+xfconf_daemon_check_unlocked(XfconfDaemon *xfconfd,
+                             const gchar *channel,
+                             const gchar *property,
+                             GError **error)
 {
     GList *l;
-    GError *error = NULL;
-    GValue *value;
 
     /* if there's more than one backend, we need to make sure the
      * property isn't locked on ANY of them */
-    if (G_UNLIKELY(xfconfd->backends->next)) {
-        for (l = xfconfd->backends; l; l = l->next) {
-            gboolean locked = FALSE;
+    if (G_LIKELY(!xfconfd->backends->next)) {
+        return TRUE;
+    }
 
-            if (!xfconf_backend_is_property_locked(l->data, channel, property, &locked, &error)) {
-                break;
-            }
+    for (l = xfconfd->backends; l; l = l->next) {
+        gboolean locked = FALSE;
 
-            if (locked) {
-                g_set_error(&error, XFCONF_ERROR,
-                            XFCONF_ERROR_PERMISSION_DENIED,
-                            _("Permission denied while modifying property \"%s\" on channel \"%s\""),
-                            property, channel);
-                break;
-            }
+        if (!xfconf_backend_is_property_locked(l->data, channel, property, &locked, error)) {
+            return FALSE;
         }
 
-        /* there is always an error set if something failed or the
-         * property is locked */
-        if (error) {
-            g_dbus_method_invocation_return_gerror(invocation, error);
-            g_error_free(error);
-            return G_DBUS_METHOD_INVOCATION_UNHANDLED;
+        if (locked) {
+            g_set_error(error, XFCONF_ERROR,
+                        XFCONF_ERROR_PERMISSION_DENIED,
+                        _("Permission denied while modifying property \"%s\" on channel \"%s\""),
+                        property, channel);
+            return FALSE;
         }
     }
 
+    return TRUE;
+}
+
+static gboolean
+xfconf_set_property(XfconfExported *skeleton,
+                    GDBusMethodInvocation *invocation,
+                    const gchar *channel,
+                    const gchar *property,
+                    GVariant *variant,
+                    XfconfDaemon *xfconfd)
+{
+    GError *error = NULL;
+    GValue *value;
+
+    if (!xfconf_daemon_check_unlocked(xfconfd, channel, property, &error)) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+        return G_DBUS_METHOD_INVOCATION_UNHANDLED;
+    }
+
     value = xfconf_gvariant_to_gvalue(variant);
     /* only write to first backend */
     if (xfconf_backend_set(xfconfd->backends->data, channel, property, value, &error)) {
@@ -190,6 +268,107 @@ xfconf_set_property(XfconfExported *skeleton,
     return G_DBUS_METHOD_INVOCATION_UNHANDLED;
 }
 
+typedef struct
+{
+    const gchar *property;
+    GValue value;
+} XfconfOldValue;
+
+static gboolean
+xfconf_set_properties(XfconfExported *skeleton,
+                      GDBusMethodInvocation *invocation,
+                      const gchar *channel,
+                      GVariant *properties,
+                      XfconfDaemon *xfconfd)
+{
+    XfconfBackend *backend = xfconfd->backends->data;
+    GVariantIter iter;
+    GVariant *variant;
+    GArray *old_values;
+    const gchar *property;
+    GError *error = NULL;
+    guint i;
+
+    /* check all locks before touching anything */
+    g_variant_iter_init(&iter, properties);
+    while (!error && g_variant_iter_next(&iter, "{&sv}", &property, &variant)) {
+        xfconf_daemon_check_unlocked(xfconfd, channel, property, &error);
+        g_variant_unref(variant);
+    }
+
+    if (error) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+        return G_DBUS_METHOD_INVOCATION_UNHANDLED;
+    }
+
+    xfconfd->batch_channel = channel;
+    xfconfd->batch_properties = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                      (GDestroyNotify)g_free, NULL);
+
+    /* only write to first backend, keeping the previous values around
+     * so a failure half way through can be rolled back.  Only values the
+     * user set are kept, a property that just had a system default is
+     * reset instead, so it doesn't stick to the default once rolled back */
+    old_values = g_array_new(FALSE, FALSE, sizeof(XfconfOldValue));
+    g_variant_iter_init(&iter, properties);
+    while (!error && g_variant_iter_next(&iter, "{&sv}", &property, &variant)) {
+        XfconfOldValue old_value = { property, G_VALUE_INIT };
+        GValue *value = xfconf_gvariant_to_gvalue(variant);
+
+        xfconf_backend_get_user_value(backend, channel, property, &old_value.value, NULL);
+        if (xfconf_backend_set(backend, channel, property, value, &error)) {
+            g_array_append_val(old_values, old_value);
+        } else if (G_VALUE_TYPE(&old_value.value)) {
+            g_value_unset(&old_value.value);
+        }
+
+        _xfconf_gvalue_free(value);
+        g_variant_unref(variant);
+    }
+
+    /* undo in reverse order, so a property listed twice gets back
+     * the value it had before the call */
+    for (i = old_values->len; i > 0; --i) {
+        XfconfOldValue *old_value = &g_array_index(old_values, XfconfOldValue, i - 1);
+
+        if (G_VALUE_TYPE(&old_value->value)) {
+            if (error) {
+                xfconf_backend_set(backend, channel, old_value->property,
+                                   &old_value->value, NULL);
+            }
+            g_value_unset(&old_value->value);
+        } else if (error) {
+            xfconf_backend_reset(backend, channel, old_value->property, FALSE, NULL);
+        }
+    }
+    g_array_free(old_values, TRUE);
+
+    /* nothing changed if we rolled back */
+    if (!error && g_hash_table_size(xfconfd->batch_properties) > 0) {
+        XfconfPropsChangedData *pdata = g_slice_new0(XfconfPropsChangedData);
+        pdata->xfconfd = g_object_ref(xfconfd);
+        pdata->backend = g_object_ref(backend);
+        pdata->channel = g_strdup(channel);
+        pdata->properties = xfconfd->batch_properties;
+        g_idle_add(xfconf_daemon_emit_properties_changed_idled, pdata);
+    } else {
+        g_hash_table_destroy(xfconfd->batch_properties);
+    }
+
+    xfconfd->batch_channel = NULL;
+    xfconfd->batch_properties = NULL;
+
+    if (error) {
+        g_dbus_method_invocation_return_gerror(invocation, error);
+        g_error_free(error);
+    } else {
+        xfconf_exported_complete_set_properties(skeleton, invocation);
+    }
+
+    return G_DBUS_METHOD_INVOCATION_UNHANDLED;
+}
+
 
 static gboolean
 xfconf_get_property(XfconfExported *skeleton,
@@ -229,6 +408,43 @@ xfconf_get_property(XfconfExported *skeleton,
     return G_DBUS_METHOD_INVOCATION_UNHANDLED;
 }
 
+static gboolean
+xfconf_get_properties(XfconfExported *skeleton,
+                      GDBusMethodInvocation *invocation,
+                      const gchar *channel,
+                      const gchar *const *properties,
+                      XfconfDaemon *xfconfd)
+{
+    GHashTable *values;
+    GList *l;
+    guint i;
+
+    values = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                   NULL, (GDestroyNotify)_xfconf_gvalue_free);
+
+    /* missing properties are left out of the reply instead of
+     * failing the whole call */
+    for (i = 0; properties[i]; ++i) {
+        GValue *value = g_new0(GValue, 1);
+
+        for (l = xfconfd->backends; l; l = l->next) {
+            if (xfconf_backend_get(l->data, channel, properties[i], value, NULL)) {
+                g_hash_table_replace(values, (gpointer)properties[i], value);
+                value = NULL;
+                break;
+            }
+        }
+
+        g_free(value);
+    }
+
+    xfconf_exported_complete_get_properties(skeleton, invocation,
+                                            xfconf_hash_to_gvariant(values));
+    g_hash_table_destroy(values);
+
+    return G_DBUS_METHOD_INVOCATION_UNHANDLED;
+}
+
 static gboolean
 xfconf_get_all_properties(XfconfExported *skeleton,
                           GDBusMethodInvocation *invocation,
@@ -515,11 +731,13 @@ typedef struct
 
 static const XfconfExportedSignal xfconf_exported_signals[] = {
     { "handle-get-all-properties", G_CALLBACK(xfconf_get_all_properties) },
+    { "handle-get-properties", G_CALLBACK(xfconf_get_properties) },
     { "handle-get-property", G_CALLBACK(xfconf_get_property) },
     { "handle-is-property-locked", G_CALLBACK(xfconf_is_property_locked) },
     { "handle-list-channels", G_CALLBACK(xfconf_list_channels) },
     { "handle-property-exists", G_CALLBACK(xfconf_property_exists) },
     { "handle-reset-property", G_CALLBACK(xfconf_reset_property) },
+    { "handle-set-properties", G_CALLBACK(xfconf_set_properties) },
     { "handle-set-property", G_CALLBACK(xfconf_set_property) },
 };
 
@@ -1989,6 +1989,7 @@ clientFrame (DisplayInfo *display_info, Window w, gboolean recapture)
     {
         xfwmWindowCreate (screen_info, c->visual, c->depth, c->frame,
             &c->buttons[i], BUTTON_EVENT_MASK, None);
+        myDisplayAddClientWindow (display_info, MYWINDOW_XWINDOW (c->buttons[i]), c, SEARCH_BUTTON);
     }
     clientUpdateIconPix (c);
 
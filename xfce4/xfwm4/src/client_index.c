@@ -0,0 +1,169 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#include <X11/X.h>
+#include <glib.h>
+
+#include "client_index.h"
+
+/*
+ * Maps every X window a managed client owns to the client, so that the
+ * lookup on each X event does not walk all clients. A window may belong to
+ * several clients, e.g. a user time window shared by the windows of an
+ * application, so each entry is a list, oldest client first like in
+ * display->clients. The clients are never dereferenced here.
+ */
+struct _ClientIndex
+{
+    GHashTable *windows;
+};
+
+typedef struct
+{
+    struct _Client *c;
+    unsigned short mode;
+} ClientWindow;
+
+static void
+freeClientWindows (gpointer data)
+{
+    g_slist_free_full ((GSList *) data, g_free);
+}
+
+ClientIndex *
+clientIndexNew (void)
+{
+    ClientIndex *index;
+
+    index = g_new0 (ClientIndex, 1);
+    index->windows = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, freeClientWindows);
+
+    return index;
+}
+
+void
+clientIndexFree (ClientIndex *index)
+{
+    g_return_if_fail (index != NULL);
+
+    g_hash_table_destroy (index->windows);
+    g_free (index);
+}
+
+void
+clientIndexAdd (ClientIndex *index, Window w, struct _Client *c, unsigned short mode)
+{
+    ClientWindow *cw;
+    GSList *list, *l;
+
+    g_return_if_fail (index != NULL);
+    g_return_if_fail (c != NULL);
+
+    if (w == None)
+    {
+        return;
+    }
+
+    list = g_hash_table_lookup (index->windows, (gconstpointer) w);
+    for (l = list; l; l = g_slist_next (l))
+    {
+        cw = (ClientWindow *) l->data;
+        if (cw->c == c)
+        {
+            cw->mode |= mode;
+            return;
+        }
+    }
+
+    cw = g_new0 (ClientWindow, 1);
+    cw->c = c;
+    cw->mode = mode;
+
+    if (list)
+    {
+        /* the head of the list stays the same */
+        list = g_slist_append (list, cw);
+    }
+    else
+    {
+        g_hash_table_insert (index->windows, (gpointer) w, g_slist_prepend (NULL, cw));
+    }
+}
+
+void
+clientIndexRemove (ClientIndex *index, Window w, struct _Client *c, unsigned short mode)
+{
+    ClientWindow *cw;
+    GSList *list, *l;
+
+    g_return_if_fail (index != NULL);
+    g_return_if_fail (c != NULL);
+
+    if (w == None)
+    {
+        return;
+    }
+
+    list = g_hash_table_lookup (index->windows, (gconstpointer) w);
+    for (l = list; l; l = g_slist_next (l))
+    {
+        cw = (ClientWindow *) l->data;
+        if (cw->c != c)
+        {
+            continue;
+        }
+
+        cw->mode &= ~mode;
+        if (cw->mode == 0)
+        {
+            /* the head of the list may change, don't let the table free it */
+            g_hash_table_steal (index->windows, (gconstpointer) w);
+            list = g_slist_delete_link (list, l);
+            g_free (cw);
+            if (list)
+            {
+                g_hash_table_insert (index->windows, (gpointer) w, list);
+            }
+        }
+        return;
+    }
+}
+
+struct _Client *
+clientIndexLookup (ClientIndex *index, Window w, unsigned short mode)
+{
+    ClientWindow *cw;
+    GSList *list;
+
+    g_return_val_if_fail (index != NULL, NULL);
+
+    for (list = g_hash_table_lookup (index->windows, (gconstpointer) w); list; list = g_slist_next (list))
+    {
+        cw = (ClientWindow *) list->data;
+        if (cw->mode & mode)
+        {
+            return cw->c;
+        }
+    }
+
+    return NULL;
+}
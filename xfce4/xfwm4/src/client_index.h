@@ -0,0 +1,47 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#ifndef INC_CLIENT_INDEX_H
+#define INC_CLIENT_INDEX_H
+
+#include <X11/X.h>
+#include <glib.h>
+
+struct _Client;
+
+typedef struct _ClientIndex ClientIndex;
+
+ClientIndex             *clientIndexNew                         (void);
+void                     clientIndexFree                        (ClientIndex *);
+void                     clientIndexAdd                         (ClientIndex *,
+                                                                 Window,
+                                                                 struct _Client *,
+                                                                 unsigned short);
+void                     clientIndexRemove                      (ClientIndex *,
+                                                                 Window,
+                                                                 struct _Client *,
+                                                                 unsigned short);
+struct _Client          *clientIndexLookup                      (ClientIndex *,
+                                                                 Window,
+                                                                 unsigned short);
+
+#endif /* INC_CLIENT_INDEX_H */
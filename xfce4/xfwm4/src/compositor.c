@@ -27,9 +27,12 @@
 #include <X11/Xatom.h>
 #include <X11/extensions/shape.h>
 
+#include <errno.h>
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <math.h>
 #include <string.h>
+#include <unistd.h>
 #include <libxfce4util/libxfce4util.h>
 
 #ifdef HAVE_EPOXY
@@ -98,6 +101,10 @@
 #define WIN_IS_REDIRECTED(cw)           (cw->redirected)
 #define WIN_IS_SHADED(cw)               (WIN_HAS_CLIENT(cw) && FLAG_TEST (cw->c->flags, CLIENT_FLAG_SHADED))
 
+/* a region request made while painting a frame, counted in its stats */
+#define FRAME_REGION_OP(screen_info, request) \
+    G_STMT_START { (screen_info)->frame_stats.region_ops++; request; } G_STMT_END
+
 #ifndef TIMEOUT_REPAINT_PRIORITY
 #define TIMEOUT_REPAINT_PRIORITY   G_PRIORITY_DEFAULT
 #endif /* TIMEOUT_REPAINT_PRIORITY */
@@ -143,6 +150,7 @@ struct _CWindow
     Picture picture;
     Picture saved_picture;
     Picture shadow;
+    ShadowTiles *shadow_tiles; /* shared, owned by the screen */
     Picture alphaPict;
     Picture alphaBorderPict;
 
@@ -150,6 +158,7 @@ struct _CWindow
     XserverRegion clientSize;
     XserverRegion borderClip;
     XserverRegion extents;
+    XRectangle extents_rect;   /* bounds of extents, on the client side */
     XserverRegion opaque_region;
 
     gint shadow_dx;
@@ -678,6 +687,243 @@ shadow_picture (ScreenInfo *screen_info, gdouble opacity,
     return shadowPicture;
 }
 
+/*
+ * Once the shadow is at least twice the gaussian size in both directions,
+ * make_shadow() only repeats the corners, the edge rows and columns and the
+ * center value, none of which depend on the window size. Such shadows are
+ * composited as nine slices from tiles built once per opacity level, so that
+ * resizing a window does not regenerate and upload its whole shadow.
+ */
+struct _ShadowTiles
+{
+    Picture corners;    /* the shadow of a (2 * size + 1) square, corners only used */
+    Picture top;        /* 1 x size, repeated */
+    Picture bottom;     /* 1 x size, repeated */
+    Picture left;       /* size x 1, repeated */
+    Picture right;      /* size x 1, repeated */
+    Picture center;     /* 1 x 1, repeated */
+};
+
+static void
+shadow_size (ScreenInfo *screen_info, gint width, gint height, gint *swidth, gint *sheight)
+{
+    /* same as make_shadow() */
+    *swidth = width + screen_info->gaussianMap->size
+              - screen_info->params->shadow_delta_width - screen_info->params->shadow_delta_x;
+    *sheight = height + screen_info->gaussianMap->size
+              - screen_info->params->shadow_delta_height - screen_info->params->shadow_delta_y;
+}
+
+static Picture
+shadow_tile_picture (ScreenInfo *screen_info, Pixmap source, GC gc,
+                     gint x, gint y, gint width, gint height)
+{
+    DisplayInfo *display_info;
+    XRenderPictureAttributes pa;
+    Pixmap pixmap;
+    Picture picture;
+
+    display_info = screen_info->display_info;
+    pixmap = XCreatePixmap (display_info->dpy, screen_info->output, width, height, 8);
+    g_return_val_if_fail (pixmap != None, None);
+
+    XCopyArea (display_info->dpy, source, pixmap, gc, x, y, width, height, 0, 0);
+
+    pa.repeat = TRUE;
+    picture = XRenderCreatePicture (display_info->dpy, pixmap,
+                                    XRenderFindStandardFormat (display_info->dpy, PictStandardA8),
+                                    CPRepeat, &pa);
+    XFreePixmap (display_info->dpy, pixmap);
+
+    return picture;
+}
+
+static void
+free_shadow_tiles (ScreenInfo *screen_info, ShadowTiles *tiles)
+{
+    Display *dpy;
+
+    dpy = screen_info->display_info->dpy;
+    if (tiles->corners)
+    {
+        XRenderFreePicture (dpy, tiles->corners);
+    }
+    if (tiles->top)
+    {
+        XRenderFreePicture (dpy, tiles->top);
+    }
+    if (tiles->bottom)
+    {
+        XRenderFreePicture (dpy, tiles->bottom);
+    }
+    if (tiles->left)
+    {
+        XRenderFreePicture (dpy, tiles->left);
+    }
+    if (tiles->right)
+    {
+        XRenderFreePicture (dpy, tiles->right);
+    }
+    if (tiles->center)
+    {
+        XRenderFreePicture (dpy, tiles->center);
+    }
+    g_free (tiles);
+}
+
+static ShadowTiles *
+shadow_tiles (ScreenInfo *screen_info, gdouble opacity,
+              gint width, gint height, gint *wp, gint *hp)
+{
+    DisplayInfo *display_info;
+    ShadowTiles *tiles;
+    XImage *shadowImage;
+    Pixmap shadowPixmap;
+    GC gc;
+    gint opacity_int;
+    gint swidth, sheight;
+    gint size, tile_size;
+
+    g_return_val_if_fail (screen_info != NULL, NULL);
+    TRACE ("entering");
+
+    size = screen_info->gaussianSize;
+    opacity_int = (gint) (opacity * 25);
+    if ((size <= 0) || (opacity_int < 0) || (opacity_int > 25))
+    {
+        return NULL;
+    }
+
+    /* smaller shadows are not made of repeated slices */
+    shadow_size (screen_info, width, height, &swidth, &sheight);
+    if ((swidth < 2 * size) || (sheight < 2 * size))
+    {
+        return NULL;
+    }
+
+    *wp = swidth;
+    *hp = sheight;
+
+    tiles = screen_info->shadowTiles[opacity_int];
+    if (tiles)
+    {
+        return tiles;
+    }
+
+    display_info = screen_info->display_info;
+    tile_size = 2 * size + 1;
+    shadowImage = make_shadow (screen_info, opacity,
+                               tile_size + width - swidth,
+                               tile_size + height - sheight);
+    if (shadowImage == NULL)
+    {
+        return NULL;
+    }
+
+    shadowPixmap = XCreatePixmap (display_info->dpy, screen_info->output,
+                                  shadowImage->width, shadowImage->height, 8);
+    if (shadowPixmap == None)
+    {
+        XDestroyImage (shadowImage);
+        g_warning ("(shadowPixmap != None) failed");
+        return NULL;
+    }
+
+    gc = XCreateGC (display_info->dpy, shadowPixmap, 0, NULL);
+    XPutImage (display_info->dpy, shadowPixmap, gc, shadowImage, 0, 0, 0, 0,
+               shadowImage->width, shadowImage->height);
+    XDestroyImage (shadowImage);
+
+    tiles = g_new0 (ShadowTiles, 1);
+    tiles->corners = XRenderCreatePicture (display_info->dpy, shadowPixmap,
+                                           XRenderFindStandardFormat (display_info->dpy, PictStandardA8),
+                                           0, NULL);
+    tiles->top = shadow_tile_picture (screen_info, shadowPixmap, gc, size, 0, 1, size);
+    tiles->bottom = shadow_tile_picture (screen_info, shadowPixmap, gc, size, size + 1, 1, size);
+    tiles->left = shadow_tile_picture (screen_info, shadowPixmap, gc, 0, size, size, 1);
+    tiles->right = shadow_tile_picture (screen_info, shadowPixmap, gc, size + 1, size, size, 1);
+    tiles->center = shadow_tile_picture (screen_info, shadowPixmap, gc, size, size, 1, 1);
+
+    XFreeGC (display_info->dpy, gc);
+    XFreePixmap (display_info->dpy, shadowPixmap);
+
+    if (!(tiles->corners && tiles->top && tiles->bottom && tiles->left && tiles->right && tiles->center))
+    {
+        g_warning ("Failed to create the shadow tiles");
+        free_shadow_tiles (screen_info, tiles);
+        return NULL;
+    }
+
+    screen_info->shadowTiles[opacity_int] = tiles;
+
+    return tiles;
+}
+
+static void
+composite_shadow_tile (ScreenInfo *screen_info, Picture tile, Picture dest,
+                       gint tile_x, gint tile_y, gint x, gint y, gint width, gint height)
+{
+    if ((width <= 0) || (height <= 0))
+    {
+        return;
+    }
+
+    XRenderComposite (screen_info->display_info->dpy, PictOpOver, screen_info->blackPicture, tile,
+                      dest, 0, 0, tile_x, tile_y, x, y, width, height);
+}
+
+static void
+paint_shadow (CWindow *cw, Picture paint_buffer)
+{
+    ScreenInfo *screen_info;
+    ShadowTiles *tiles;
+    gint x, y, w, h, size;
+
+    g_return_if_fail (cw != NULL);
+    TRACE ("window 0x%lx", cw->id);
+
+    screen_info = cw->screen_info;
+    x = cw->attr.x + cw->shadow_dx;
+    y = cw->attr.y + cw->shadow_dy;
+    w = cw->shadow_width;
+    h = cw->shadow_height;
+
+    if (cw->shadow)
+    {
+        XRenderComposite (screen_info->display_info->dpy, PictOpOver,
+                          screen_info->blackPicture, cw->shadow,
+                          paint_buffer, 0, 0, 0, 0, x, y, w, h);
+        return;
+    }
+
+    tiles = cw->shadow_tiles;
+    size = screen_info->gaussianSize;
+
+    /* corners */
+    composite_shadow_tile (screen_info, tiles->corners, paint_buffer,
+                           0, 0, x, y, size, size);
+    composite_shadow_tile (screen_info, tiles->corners, paint_buffer,
+                           size + 1, 0, x + w - size, y, size, size);
+    composite_shadow_tile (screen_info, tiles->corners, paint_buffer,
+                           0, size + 1, x, y + h - size, size, size);
+    composite_shadow_tile (screen_info, tiles->corners, paint_buffer,
+                           size + 1, size + 1, x + w - size, y + h - size, size, size);
+
+    /* edges */
+    composite_shadow_tile (screen_info, tiles->top, paint_buffer,
+                           0, 0, x + size, y, w - 2 * size, size);
+    composite_shadow_tile (screen_info, tiles->bottom, paint_buffer,
+                           0, 0, x + size, y + h - size, w - 2 * size, size);
+    composite_shadow_tile (screen_info, tiles->left, paint_buffer,
+                           0, 0, x, y + size, size, h - 2 * size);
+    composite_shadow_tile (screen_info, tiles->right, paint_buffer,
+                           0, 0, x + w - size, y + size, size, h - 2 * size);
+
+    /* center */
+    composite_shadow_tile (screen_info, tiles->center, paint_buffer,
+                           0, 0, x + size, y + size, w - 2 * size, h - 2 * size);
+}
+
 static Picture
 solid_picture (ScreenInfo *screen_info, gboolean argb,
                gdouble a, gdouble r, gdouble g, gdouble b)
@@ -831,6 +1077,7 @@ free_win_data (CWindow *cw, gboolean delete)
         XRenderFreePicture (display_info->dpy, cw->shadow);
         cw->shadow = None;
     }
+    cw->shadow_tiles = NULL;
 
     if (cw->alphaPict)
     {
@@ -1088,6 +1335,194 @@ cursor_to_picture (ScreenInfo *screen_info, XFixesCursorImage *cursor)
     return picture;
 }
 
+/*
+ * Frame timeline, recorded only while turned on with SIGUSR2 and saved as
+ * a Chrome trace (chrome://tracing, Perfetto) when it is turned off again.
+ * The last FRAME_TRACE_SIZE frames are kept.
+ */
+#define FRAME_TRACE_SIZE 1024
+
+typedef struct
+{
+    gint64 start;           /* monotonic µs, when repair_screen() started painting */
+    gint64 paint_time;
+    gint64 fence_start;
+    gint64 fence_wait;
+    gint64 present_start;
+    gint64 present_latency; /* -1 until the present is completed */
+    guint damage_area;      /* in pixels */
+    CompositorFrameStats stats;
+} FrameTiming;
+
+struct _FrameTrace
+{
+    FrameTiming frames[FRAME_TRACE_SIZE];
+    guint64 n_frames;           /* frames recorded since the trace started */
+    guint64 pending_present;    /* frame number + 1 awaiting its completion, or 0 */
+    gboolean painting;
+};
+
+static guint
+region_area (Display *dpy, XserverRegion region)
+{
+    XRectangle *rects;
+    guint area;
+    int i, n;
+
+    area = 0;
+    rects = XFixesFetchRegion (dpy, region, &n);
+    if (rects)
+    {
+        /* the rectangles of a region never overlap */
+        for (i = 0; i < n; i++)
+        {
+            area += rects[i].width * rects[i].height;
+        }
+        XFree (rects);
+    }
+
+    return area;
+}
+
+static FrameTiming *
+frame_trace_painting (ScreenInfo *screen_info)
+{
+    FrameTrace *trace;
+
+    trace = screen_info->frame_trace;
+    if ((trace == NULL) || !trace->painting)
+    {
+        return NULL;
+    }
+
+    return &trace->frames[(trace->n_frames - 1) % FRAME_TRACE_SIZE];
+}
+
+static void
+frame_trace_begin (ScreenInfo *screen_info, XserverRegion damage)
+{
+    FrameTrace *trace;
+    FrameTiming *frame;
+
+    trace = screen_info->frame_trace;
+    if (trace == NULL)
+    {
+        return;
+    }
+
+    frame = &trace->frames[trace->n_frames % FRAME_TRACE_SIZE];
+    trace->n_frames++;
+    trace->painting = TRUE;
+
+    memset (frame, 0, sizeof (FrameTiming));
+    frame->present_latency = -1;
+    frame->damage_area = region_area (myScreenGetXDisplay (screen_info), damage);
+    frame->start = g_get_monotonic_time ();
+}
+
+static void
+frame_trace_end (ScreenInfo *screen_info)
+{
+    FrameTiming *frame;
+
+    frame = frame_trace_painting (screen_info);
+    if (frame == NULL)
+    {
+        return;
+    }
+
+    frame->paint_time = g_get_monotonic_time () - frame->start;
+    frame->stats = screen_info->frame_stats;
+    screen_info->frame_trace->painting = FALSE;
+}
+
+#ifdef HAVE_PRESENT_EXTENSION
+static void
+frame_trace_present_complete (ScreenInfo *screen_info)
+{
+    FrameTrace *trace;
+    FrameTiming *frame;
+
+    trace = screen_info->frame_trace;
+    if ((trace == NULL) || (trace->pending_present == 0))
+    {
+        return;
+    }
+
+    /* unless the frame was pushed out of the ring meanwhile */
+    if (trace->n_frames - trace->pending_present < FRAME_TRACE_SIZE)
+    {
+        frame = &trace->frames[(trace->pending_present - 1) % FRAME_TRACE_SIZE];
+        frame->present_latency = g_get_monotonic_time () - frame->present_start;
+    }
+    trace->pending_present = 0;
+}
+#endif /* HAVE_PRESENT_EXTENSION */
+
+static gboolean
+frame_trace_write (ScreenInfo *screen_info, const gchar *filename, GError **error)
+{
+    FrameTrace *trace;
+    FrameTiming *frame;
+    GString *json;
+    guint64 first, i;
+    gboolean result;
+    gint pid, tid;
+
+    trace = screen_info->frame_trace;
+    pid = (gint) getpid ();
+    tid = screen_info->screen;
+    first = (trace->n_frames > FRAME_TRACE_SIZE) ? trace->n_frames - FRAME_TRACE_SIZE : 0;
+
+    json = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    g_string_append_printf (json,
+                            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                            "\"args\":{\"name\":\"xfwm4 compositor, screen %d\"}}",
+                            pid, tid, tid);
+
+    for (i = first; i < trace->n_frames; i++)
+    {
+        frame = &trace->frames[i % FRAME_TRACE_SIZE];
+
+        g_string_append_printf (json,
+                                ",\n{\"name\":\"paint\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                                "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ","
+                                "\"args\":{\"frame\":%" G_GUINT64_FORMAT ",\"damage_area\":%u,"
+                                "\"windows_painted\":%u,\"windows_culled\":%u,\"region_ops\":%u}}",
+                                pid, tid, frame->start, frame->paint_time, i, frame->damage_area,
+                                frame->stats.windows_painted, frame->stats.windows_culled,
+                                frame->stats.region_ops);
+        g_string_append_printf (json,
+                                ",\n{\"name\":\"damage\",\"ph\":\"C\",\"pid\":%d,\"tid\":%d,"
+                                "\"ts\":%" G_GINT64_FORMAT ",\"args\":{\"pixels\":%u}}",
+                                pid, tid, frame->start, frame->damage_area);
+        if (frame->fence_start != 0)
+        {
+            g_string_append_printf (json,
+                                    ",\n{\"name\":\"fence wait\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                                    "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT "}",
+                                    pid, tid, frame->fence_start, frame->fence_wait);
+        }
+        if (frame->present_latency >= 0)
+        {
+            /* completes after the paint, hence async events on their own track */
+            g_string_append_printf (json,
+                                    ",\n{\"name\":\"present\",\"cat\":\"present\",\"ph\":\"b\",\"id\":%" G_GUINT64_FORMAT ","
+                                    "\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT "}"
+                                    ",\n{\"name\":\"present\",\"cat\":\"present\",\"ph\":\"e\",\"id\":%" G_GUINT64_FORMAT ","
+                                    "\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT "}",
+                                    i, pid, tid, frame->present_start,
+                                    i, pid, tid, frame->present_start + frame->present_latency);
+        }
+    }
+    g_string_append (json, "\n]}\n");
+
+    result = g_file_set_contents (filename, json->str, json->len, error);
+    g_string_free (json, TRUE);
+
+    return result;
+}
+
 #ifdef HAVE_EPOXY
 static gboolean
 check_gl_error (void)
@@ -1830,6 +2265,7 @@ redraw_glx_screen (ScreenInfo *screen_info)
 static void
 redraw_glx_texture (ScreenInfo *screen_info, gushort buffer)
 {
+    FrameTiming *frame;
 #ifdef DEBUG
     gint64 t1, t2;
 #endif /* DEBUG */
@@ -1837,7 +2273,16 @@ redraw_glx_texture (ScreenInfo *screen_info, gushort buffer)
     TRACE ("(re)Drawing GLX pixmap 0x%lx/texture 0x%x",
            screen_info->glx_drawable[buffer], screen_info->rootTexture);
 
+    frame = frame_trace_painting (screen_info);
+    if (frame)
+    {
+        frame->fence_start = g_get_monotonic_time ();
+    }
     fence_sync (screen_info, buffer);
+    if (frame)
+    {
+        frame->fence_wait = g_get_monotonic_time () - frame->fence_start;
+    }
 #ifdef DEBUG
     t1 = g_get_monotonic_time ();
 #endif /* DEBUG */
@@ -1932,6 +2377,7 @@ present_flip (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
 {
     static guint32 present_serial;
     DisplayInfo *display_info;
+    FrameTiming *frame;
     int result;
 
     g_return_if_fail (screen_info != NULL);
@@ -1954,6 +2400,13 @@ present_flip (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
 
     screen_info->present_pending = TRUE;
     DBG ("present flip requested, present pending...");
+
+    frame = frame_trace_painting (screen_info);
+    if (frame)
+    {
+        frame->present_start = g_get_monotonic_time ();
+        screen_info->frame_trace->pending_present = screen_info->frame_trace->n_frames;
+    }
 }
 #endif /* HAVE_PRESENT_EXTENSION */
 
@@ -2004,7 +2457,7 @@ win_extents (CWindow *cw)
         cw->shadow_dx = SHADOW_OFFSET_X + screen_info->params->shadow_delta_x;
         cw->shadow_dy = SHADOW_OFFSET_Y + screen_info->params->shadow_delta_y;
 
-        if (!(cw->shadow))
+        if (!(cw->shadow) && !(cw->shadow_tiles))
         {
             double shadow_opacity;
             shadow_opacity = (double) screen_info->params->frame_opacity
@@ -2012,10 +2465,17 @@ win_extents (CWindow *cw)
                            * cw->opacity
                            / (NET_WM_OPAQUE * 100.0);
 
-            cw->shadow = shadow_picture (screen_info, shadow_opacity,
-                                         cw->attr.width + 2 * cw->attr.border_width,
-                                         cw->attr.height + 2 * cw->attr.border_width,
-                                         &cw->shadow_width, &cw->shadow_height);
+            cw->shadow_tiles = shadow_tiles (screen_info, shadow_opacity,
+                                             cw->attr.width + 2 * cw->attr.border_width,
+                                             cw->attr.height + 2 * cw->attr.border_width,
+                                             &cw->shadow_width, &cw->shadow_height);
+            if (!(cw->shadow_tiles))
+            {
+                cw->shadow = shadow_picture (screen_info, shadow_opacity,
+                                             cw->attr.width + 2 * cw->attr.border_width,
+                                             cw->attr.height + 2 * cw->attr.border_width,
+                                             &cw->shadow_width, &cw->shadow_height);
+            }
         }
 
         sr.x = cw->attr.x + cw->shadow_dx;
@@ -2042,11 +2502,16 @@ win_extents (CWindow *cw)
             r.height = sr.y + sr.height - r.y;
         }
     }
-    else if (cw->shadow)
+    else
     {
-        XRenderFreePicture (display_info->dpy, cw->shadow);
-        cw->shadow = None;
+        if (cw->shadow)
+        {
+            XRenderFreePicture (display_info->dpy, cw->shadow);
+            cw->shadow = None;
+        }
+        cw->shadow_tiles = NULL;
     }
+    cw->extents_rect = r;
     return XFixesCreateRegion (display_info->dpy, &r, 1);
 }
 
@@ -2300,7 +2765,7 @@ paint_win (CWindow *cw, XserverRegion region, Picture paint_buffer, gboolean sol
         /* Client Window */
         if (paint_solid)
         {
-            XFixesSetPictureClipRegion (display_info->dpy, paint_buffer, 0, 0, region);
+            FRAME_REGION_OP (screen_info, XFixesSetPictureClipRegion (display_info->dpy, paint_buffer, 0, 0, region));
             XRenderComposite (display_info->dpy, PictOpSrc, cw->picture, None,
                               paint_buffer,
                               frame_left, frame_top,
@@ -2309,7 +2774,7 @@ paint_win (CWindow *cw, XserverRegion region, Picture paint_buffer, gboolean sol
                               frame_width - frame_left - frame_right, frame_height - frame_top - frame_bottom);
 
             /* clientSize is set in paint_all() prior to calling paint_win() */
-            XFixesSubtractRegion (display_info->dpy, region, region, cw->clientSize);
+            FRAME_REGION_OP (screen_info, XFixesSubtractRegion (display_info->dpy, region, region, cw->clientSize));
         }
         else if (!solid_part)
         {
@@ -2329,12 +2794,12 @@ paint_win (CWindow *cw, XserverRegion region, Picture paint_buffer, gboolean sol
         get_paint_bounds (cw, &x, &y, &w, &h);
         if (paint_solid)
         {
-            XFixesSetPictureClipRegion (display_info->dpy, paint_buffer, 0, 0, region);
+            FRAME_REGION_OP (screen_info, XFixesSetPictureClipRegion (display_info->dpy, paint_buffer, 0, 0, region));
             XRenderComposite (display_info->dpy, PictOpSrc,
                               cw->picture, None,
                               paint_buffer,
                               0, 0, 0, 0, x, y, w, h);
-            XFixesSubtractRegion (display_info->dpy, region, region, cw->borderSize);
+            FRAME_REGION_OP (screen_info, XFixesSubtractRegion (display_info->dpy, region, region, cw->borderSize));
         }
         else if (!solid_part)
         {
@@ -2365,17 +2830,79 @@ clip_opaque_region (CWindow *cw, XserverRegion region)
     screen_info = cw->screen_info;
     display_info = screen_info->display_info;
 
-    opaque_region = XFixesCreateRegion (display_info->dpy, NULL, 0);
-    XFixesCopyRegion (display_info->dpy, opaque_region, cw->opaque_region);
-    translate_to_client_region (cw, opaque_region);
+    FRAME_REGION_OP (screen_info, opaque_region = XFixesCreateRegion (display_info->dpy, NULL, 0));
+    FRAME_REGION_OP (screen_info, XFixesCopyRegion (display_info->dpy, opaque_region, cw->opaque_region));
+    FRAME_REGION_OP (screen_info, translate_to_client_region (cw, opaque_region));
     /* cw->borderSize and cw->clientSize are already updated in paint_all() */
     if (cw->clientSize)
     {
-        XFixesIntersectRegion (display_info->dpy, opaque_region, opaque_region, cw->clientSize);
+        FRAME_REGION_OP (screen_info, XFixesIntersectRegion (display_info->dpy, opaque_region, opaque_region, cw->clientSize));
     }
-    XFixesIntersectRegion (display_info->dpy, opaque_region, opaque_region, cw->borderSize);
-    XFixesSubtractRegion (display_info->dpy, region, region, opaque_region);
-    XFixesDestroyRegion (display_info->dpy, opaque_region);
+    FRAME_REGION_OP (screen_info, XFixesIntersectRegion (display_info->dpy, opaque_region, opaque_region, cw->borderSize));
+    FRAME_REGION_OP (screen_info, XFixesSubtractRegion (display_info->dpy, region, region, opaque_region));
+    FRAME_REGION_OP (screen_info, XFixesDestroyRegion (display_info->dpy, opaque_region));
+}
+
+/*
+ * The part of the window paint_win() paints solid and removes from the
+ * paint region, as a rectangle. Frames may have rounded corners and shaped
+ * windows are not rectangular, so only the client area of framed windows
+ * and unshaped windows without frame qualify.
+ */
+static gboolean
+get_opaque_bounds (CWindow *cw, XRectangle *rect)
+{
+    gint x, y, w, h;
+
+    if (!WIN_IS_OPAQUE(cw) || WIN_IS_SHAPED(cw) || WIN_IS_SHADED(cw) || !cw->picture)
+    {
+        return FALSE;
+    }
+
+    x = cw->attr.x;
+    y = cw->attr.y;
+    w = cw->attr.width + 2 * cw->attr.border_width;
+    h = cw->attr.height + 2 * cw->attr.border_width;
+    if (WIN_HAS_FRAME(cw))
+    {
+        x += frameLeft (cw->c);
+        y += frameTop (cw->c);
+        w = cw->attr.width - frameLeft (cw->c) - frameRight (cw->c);
+        h = cw->attr.height - frameTop (cw->c) - frameBottom (cw->c);
+    }
+    if ((w <= 0) || (h <= 0))
+    {
+        return FALSE;
+    }
+
+    rect->x = x;
+    rect->y = y;
+    rect->width = w;
+    rect->height = h;
+
+    return TRUE;
+}
+
+/* whether an opaque window painted above covers all of the window and its shadow */
+static gboolean
+is_occluded (ScreenInfo *screen_info, CWindow *cw)
+{
+    XRectangle *r, *o;
+    guint i;
+
+    r = &cw->extents_rect;
+    for (i = 0; i < screen_info->paint_occluders->len; i++)
+    {
+        o = &g_array_index (screen_info->paint_occluders, XRectangle, i);
+        if ((r->x >= o->x) && (r->y >= o->y) &&
+            (r->x + r->width <= o->x + o->width) &&
+            (r->y + r->height <= o->y + o->height))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
 }
 
 static int
@@ -2407,12 +2934,14 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
     DisplayInfo *display_info;
     XserverRegion paint_region;
     XRectangle region_bounds;
+    XRectangle opaque_bounds;
     Picture paint_buffer;
     Display *dpy;
     GList *list;
     gint screen_width;
     gint screen_height;
     CWindow *cw;
+    guint i;
 
     TRACE ("buffer %d", buffer);
     g_return_if_fail (screen_info);
@@ -2458,9 +2987,13 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
     {
         paint_buffer = screen_info->rootBuffer[buffer];
     }
+    memset (&screen_info->frame_stats, 0, sizeof (CompositorFrameStats));
+
     /* Copy the original given region */
-    paint_region = XFixesCreateRegion (dpy, NULL, 0);
-    XFixesCopyRegion (dpy, paint_region, region);
+    FRAME_REGION_OP (screen_info, paint_region = XFixesCreateRegion (dpy, NULL, 0));
+    FRAME_REGION_OP (screen_info, XFixesCopyRegion (dpy, paint_region, region));
+    g_ptr_array_set_size (screen_info->paint_stack, 0);
+    g_array_set_size (screen_info->paint_occluders, 0);
 
     /*
      * Painting from top to bottom, reducing the clipping area at each iteration.
@@ -2496,6 +3029,16 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
         {
             cw->extents = win_extents (cw);
         }
+
+        /* nothing of it would show, don't bother the X server */
+        if (is_occluded (screen_info, cw))
+        {
+            TRACE ("skipped, occluded 0x%lx", cw->id);
+            screen_info->frame_stats.windows_culled++;
+            cw->skipped = TRUE;
+            continue;
+        }
+
         if (cw->picture == None)
         {
             cw->picture = get_window_picture (cw);
@@ -2511,12 +3054,16 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
         if (WIN_IS_OPAQUE(cw))
         {
             paint_win (cw, paint_region, paint_buffer, TRUE);
+            if (get_opaque_bounds (cw, &opaque_bounds))
+            {
+                g_array_append_val (screen_info->paint_occluders, opaque_bounds);
+            }
         }
 
         if (cw->borderClip == None)
         {
-            cw->borderClip = XFixesCreateRegion (dpy, NULL, 0);
-            XFixesCopyRegion (dpy, cw->borderClip, paint_region);
+            FRAME_REGION_OP (screen_info, cw->borderClip = XFixesCreateRegion (dpy, NULL, 0));
+            FRAME_REGION_OP (screen_info, XFixesCopyRegion (dpy, cw->borderClip, paint_region));
         }
 
         if ((cw->opacity == NET_WM_OPAQUE) && !WIN_IS_SHADED(cw))
@@ -2525,13 +3072,15 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
         }
 
         cw->skipped = FALSE;
+        g_ptr_array_add (screen_info->paint_stack, cw);
     }
+    screen_info->frame_stats.windows_painted = screen_info->paint_stack->len;
 
     /*
      * region has changed because of the XFixesSubtractRegion (),
      * reapply clipping for the last iteration.
      */
-    XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, paint_region);
+    FRAME_REGION_OP (screen_info, XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, paint_region));
     if (!is_region_empty (dpy, paint_region))
     {
         paint_root (screen_info, paint_buffer);
@@ -2539,32 +3088,23 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
 
     /*
      * Painting from bottom to top, translucent windows and shadows are painted now...
+     * only the windows which were not skipped above are left in paint_stack.
      */
-    for (list = g_list_last(screen_info->cwindows); list; list = g_list_previous (list))
+    for (i = screen_info->paint_stack->len; i > 0; i--)
     {
         XserverRegion shadowClip;
 
-        cw = (CWindow *) list->data;
+        cw = (CWindow *) g_ptr_array_index (screen_info->paint_stack, i - 1);
         shadowClip = None;
         TRACE ("painting backward 0x%lx", cw->id);
 
-        if (cw->skipped)
-        {
-            TRACE ("skipped 0x%lx", cw->id);
-            continue;
-        }
-
-        if (cw->shadow)
+        if (cw->shadow || cw->shadow_tiles)
         {
-            shadowClip = XFixesCreateRegion (dpy, NULL, 0);
-            XFixesSubtractRegion (dpy, shadowClip, cw->borderClip, cw->borderSize);
+            FRAME_REGION_OP (screen_info, shadowClip = XFixesCreateRegion (dpy, NULL, 0));
+            FRAME_REGION_OP (screen_info, XFixesSubtractRegion (dpy, shadowClip, cw->borderClip, cw->borderSize));
 
-            XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, shadowClip);
-            XRenderComposite (dpy, PictOpOver, screen_info->blackPicture, cw->shadow,
-                              paint_buffer, 0, 0, 0, 0,
-                              cw->attr.x + cw->shadow_dx,
-                              cw->attr.y + cw->shadow_dy,
-                              cw->shadow_width, cw->shadow_height);
+            FRAME_REGION_OP (screen_info, XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, shadowClip));
+            paint_shadow (cw, paint_buffer);
         }
 
         if (cw->picture)
@@ -2577,23 +3117,28 @@ paint_all (ScreenInfo *screen_info, XserverRegion region, gushort buffer)
                                                0.0, /* green */
                                                0.0  /* blue  */);
             }
-            XFixesIntersectRegion (dpy, cw->borderClip, cw->borderClip, cw->borderSize);
-            XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, cw->borderClip);
+            FRAME_REGION_OP (screen_info, XFixesIntersectRegion (dpy, cw->borderClip, cw->borderClip, cw->borderSize));
+            FRAME_REGION_OP (screen_info, XFixesSetPictureClipRegion (dpy, paint_buffer, 0, 0, cw->borderClip));
             paint_win (cw, paint_region, paint_buffer, FALSE);
         }
 
         if (shadowClip)
         {
-            XFixesDestroyRegion (dpy, shadowClip);
+            FRAME_REGION_OP (screen_info, XFixesDestroyRegion (dpy, shadowClip));
         }
 
         if (cw->borderClip)
         {
-            XFixesDestroyRegion (dpy, cw->borderClip);
+            FRAME_REGION_OP (screen_info, XFixesDestroyRegion (dpy, cw->borderClip));
             cw->borderClip = None;
         }
     }
 
+    TRACE ("painted %u windows, culled %u, %u region operations",
+           screen_info->frame_stats.windows_painted,
+           screen_info->frame_stats.windows_culled,
+           screen_info->frame_stats.region_ops);
+
     TRACE ("copying data back to screen");
 #ifdef HAVE_EPOXY
     if (screen_info->use_glx)
@@ -2754,7 +3299,9 @@ repair_screen (ScreenInfo *screen_info)
         }
 
         remove_timeouts (screen_info);
+        frame_trace_begin (screen_info, damage);
         paint_all (screen_info, damage, screen_info->current_buffer);
+        frame_trace_end (screen_info);
 
         if (screen_info->use_n_buffers > 1)
         {
@@ -3082,10 +3629,14 @@ set_win_opacity (CWindow *cw, guint32 opacity)
 
     cw->opacity = opacity;
     determine_mode(cw);
-    if (cw->shadow)
+    if (cw->shadow || cw->shadow_tiles)
     {
-        XRenderFreePicture (display_info->dpy, cw->shadow);
-        cw->shadow = None;
+        if (cw->shadow)
+        {
+            XRenderFreePicture (display_info->dpy, cw->shadow);
+            cw->shadow = None;
+        }
+        cw->shadow_tiles = NULL;
         if (cw->extents)
         {
             XFixesDestroyRegion (display_info->dpy, cw->extents);
@@ -3404,6 +3955,7 @@ add_win (DisplayInfo *display_info, Window id, Client *c)
     new->clientSize = None;
     new->extents = None;
     new->shadow = None;
+    new->shadow_tiles = NULL;
     new->shadow_dx = 0;
     new->shadow_dy = 0;
     new->shadow_width = 0;
@@ -3545,6 +4097,8 @@ resize_win (CWindow *cw, gint x, gint y, gint width, gint height, gint bw)
             XRenderFreePicture (display_info->dpy, cw->shadow);
             cw->shadow = None;
         }
+        /* the tiles are shared, the size of the shadow is not */
+        cw->shadow_tiles = NULL;
     }
 
     if ((cw->attr.width != width) || (cw->attr.height != height) ||
@@ -3619,6 +4173,7 @@ reshape_win (CWindow *cw)
         XRenderFreePicture (display_info->dpy, cw->shadow);
         cw->shadow = None;
     }
+    cw->shadow_tiles = NULL;
 
     if (cw->borderSize)
     {
@@ -4223,6 +4778,7 @@ compositorHandlePresentCompleteNotify (DisplayInfo *display_info, XPresentComple
         {
              DBG ("present completed, present pending cleared");
              screen_info->present_pending = FALSE;
+             frame_trace_present_complete (screen_info);
              break;
         }
     }
@@ -4895,6 +5451,8 @@ compositorManageScreen (ScreenInfo *screen_info)
     screen_info->screenRegion = get_screen_region (screen_info);
     screen_info->cwindows = NULL;
     screen_info->cwindow_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
+    screen_info->paint_stack = g_ptr_array_new ();
+    screen_info->paint_occluders = g_array_new (FALSE, FALSE, sizeof (XRectangle));
     screen_info->wins_unredirected = 0;
     screen_info->compositor_timeout_id = 0;
     screen_info->zoomed = FALSE;
@@ -4993,6 +5551,7 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
     DisplayInfo *display_info;
     GList *list;
     gushort buffer;
+    guint i;
 
     g_return_if_fail (screen_info != NULL);
     TRACE ("entering compositorUnmanageScreen");
@@ -5022,6 +5581,12 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
 
     g_hash_table_destroy(screen_info->cwindow_hash);
     screen_info->cwindow_hash = NULL;
+    g_ptr_array_free (screen_info->paint_stack, TRUE);
+    screen_info->paint_stack = NULL;
+    g_array_free (screen_info->paint_occluders, TRUE);
+    screen_info->paint_occluders = NULL;
+    g_free (screen_info->frame_trace);
+    screen_info->frame_trace = NULL;
     g_list_free (screen_info->cwindows);
     screen_info->cwindows = NULL;
 
@@ -5094,6 +5659,15 @@ compositorUnmanageScreen (ScreenInfo *screen_info)
         screen_info->cursorPicture = None;
     }
 
+    for (i = 0; i < G_N_ELEMENTS (screen_info->shadowTiles); i++)
+    {
+        if (screen_info->shadowTiles[i])
+        {
+            free_shadow_tiles (screen_info, screen_info->shadowTiles[i]);
+            screen_info->shadowTiles[i] = NULL;
+        }
+    }
+
     if (screen_info->shadowTop)
     {
         g_free (screen_info->shadowTop);
@@ -5364,3 +5938,56 @@ compositorSetVblankMode (ScreenInfo *screen_info,
     screen_info->vblank_mode = vblank_mode;
 #endif /* HAVE_COMPOSITOR */
 }
+
+void
+compositorToggleFrameTrace (DisplayInfo *display_info)
+{
+#ifdef HAVE_COMPOSITOR
+    ScreenInfo *screen_info;
+    GSList *list;
+    GError *error;
+    gchar *dirname;
+    gchar *filename;
+
+    g_return_if_fail (display_info != NULL);
+    TRACE ("entering");
+
+    for (list = display_info->screens; list; list = g_slist_next (list))
+    {
+        screen_info = (ScreenInfo *) list->data;
+
+        if (screen_info->frame_trace == NULL)
+        {
+            if (screen_info->compositor_active)
+            {
+                screen_info->frame_trace = g_new0 (FrameTrace, 1);
+                g_message ("Recording compositor frame timings for screen %d", screen_info->screen);
+            }
+            continue;
+        }
+
+        dirname = g_build_filename (g_get_user_cache_dir (), "xfwm4", NULL);
+        filename = g_strdup_printf ("%s/frame-trace-%d-%" G_GINT64_FORMAT ".json", dirname,
+                                    screen_info->screen, g_get_real_time () / G_USEC_PER_SEC);
+        error = NULL;
+        if (g_mkdir_with_parents (dirname, 0700) != 0)
+        {
+            g_warning ("Cannot create directory %s: %s", dirname, g_strerror (errno));
+        }
+        else if (!frame_trace_write (screen_info, filename, &error))
+        {
+            g_warning ("Cannot save frame timings: %s", error->message);
+            g_error_free (error);
+        }
+        else
+        {
+            g_message ("Compositor frame timings saved to %s", filename);
+        }
+        g_free (filename);
+        g_free (dirname);
+
+        g_free (screen_info->frame_trace);
+        screen_info->frame_trace = NULL;
+    }
+#endif /* HAVE_COMPOSITOR */
+}
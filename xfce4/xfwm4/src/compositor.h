@@ -69,6 +69,7 @@ void                     compositorRebuildScreen                (ScreenInfo *);
 vblankMode               compositorParseVblankMode              (const gchar *);
 void                     compositorSetVblankMode                (ScreenInfo *,
                                                                  vblankMode);
+void                     compositorToggleFrameTrace             (DisplayInfo *);
 
 
 #endif /* INC_COMPOSITOR_H */
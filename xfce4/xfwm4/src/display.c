@@ -330,6 +330,7 @@ myDisplayInit (GdkDisplay *gdisplay)
     display->xfilter = NULL;
     display->screens = NULL;
     display->clients = NULL;
+    display->client_windows = clientIndexNew ();
     display->xgrabcount = 0;
     display->double_click_time = 250;
     display->double_click_distance = 5;
@@ -373,6 +374,9 @@ myDisplayClose (DisplayInfo *display)
     g_slist_free (display->clients);
     display->clients = NULL;
 
+    clientIndexFree (display->client_windows);
+    display->client_windows = NULL;
+
     g_slist_free (display->screens);
     display->screens = NULL;
 
@@ -526,32 +530,61 @@ myDisplayAddClient (DisplayInfo *display, Client *c)
     g_return_if_fail (display != NULL);
 
     display->clients = g_slist_append (display->clients, c);
+
+    myDisplayAddClientWindow (display, c->window, c, SEARCH_WINDOW);
+    myDisplayAddClientWindow (display, c->frame, c, SEARCH_FRAME);
+    myDisplayAddClientWindow (display, c->user_time_win, c, SEARCH_WIN_USER_TIME);
+    /* buttons are created later on, clientFrame() adds those */
 }
 
 void
 myDisplayRemoveClient (DisplayInfo *display, Client *c)
 {
+    int b;
+
     g_return_if_fail (c != None);
     g_return_if_fail (display != NULL);
 
     display->clients = g_slist_remove (display->clients, c);
+
+    myDisplayRemoveClientWindow (display, c->window, c, SEARCH_WINDOW);
+    myDisplayRemoveClientWindow (display, c->frame, c, SEARCH_FRAME);
+    myDisplayRemoveClientWindow (display, c->user_time_win, c, SEARCH_WIN_USER_TIME);
+    for (b = 0; b < BUTTON_COUNT; b++)
+    {
+        myDisplayRemoveClientWindow (display, MYWINDOW_XWINDOW (c->buttons[b]), c, SEARCH_BUTTON);
+    }
+}
+
+void
+myDisplayAddClientWindow (DisplayInfo *display, Window w, Client *c, unsigned short mode)
+{
+    g_return_if_fail (display != NULL);
+
+    clientIndexAdd (display->client_windows, w, c, mode);
+}
+
+void
+myDisplayRemoveClientWindow (DisplayInfo *display, Window w, Client *c, unsigned short mode)
+{
+    g_return_if_fail (display != NULL);
+
+    clientIndexRemove (display->client_windows, w, c, mode);
 }
 
 Client *
 myDisplayGetClientFromWindow (DisplayInfo *display, Window w, unsigned short mode)
 {
-    GSList *list;
+    Client *c;
 
     g_return_val_if_fail (w != None, NULL);
     g_return_val_if_fail (display != NULL, NULL);
 
-    for (list = display->clients; list; list = g_slist_next (list))
+    c = clientIndexLookup (display->client_windows, w, mode);
+    if (c)
     {
-        Client *c = (Client *) list->data;
-        if (clientGetFromWindow (c, w, mode))
-        {
-            return (c);
-        }
+        TRACE ("found \"%s\" (0x%lx)", c->name, c->window);
+        return (c);
     }
     TRACE ("no client found");
 
@@ -61,6 +61,7 @@
 #include <glib.h>
 #include <libxfce4ui/libxfce4ui.h>
 
+#include "client_index.h"
 #include "event_filter.h"
 
 /*
@@ -285,6 +286,7 @@ struct _DisplayInfo
     XfceSMClient *session;
     gboolean quit;
     gboolean reload;
+    gboolean toggle_frame_trace;
 
     Window timestamp_win;
     Cursor busy_cursor;
@@ -298,6 +300,8 @@ struct _DisplayInfo
     XfwmDevices *devices;
     GSList *screens;
     GSList *clients;
+    /* X window -> clients, see myDisplayAddClientWindow() */
+    ClientIndex *client_windows;
 
     gboolean have_shape;
     gboolean have_render;
@@ -381,6 +385,14 @@ void                     myDisplayAddClient                     (DisplayInfo *,
                                                                  Client *);
 void                     myDisplayRemoveClient                  (DisplayInfo *,
                                                                  Client *);
+void                     myDisplayAddClientWindow               (DisplayInfo *,
+                                                                 Window,
+                                                                 Client *,
+                                                                 unsigned short);
+void                     myDisplayRemoveClientWindow            (DisplayInfo *,
+                                                                 Window,
+                                                                 Client *,
+                                                                 unsigned short);
 Client                  *myDisplayGetClientFromWindow           (DisplayInfo *,
                                                                  Window,
                                                                  unsigned short);
@@ -2279,6 +2279,11 @@ handleEvent (DisplayInfo *display_info, XfwmEvent *event)
             xfce_sm_client_set_restart_style(display_info->session, XFCE_SM_CLIENT_RESTART_NORMAL);
             gtk_main_quit ();
         }
+        if (display_info->toggle_frame_trace)
+        {
+            compositorToggleFrameTrace (display_info);
+            display_info->toggle_frame_trace = FALSE;
+        }
     }
 
     compositorHandleEvent (display_info, event->meta.xevent);
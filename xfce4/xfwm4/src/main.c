@@ -166,6 +166,9 @@ handleSignal (int sig)
             case SIGUSR1:
                 display_info->reload = TRUE;
                 break;
+            case SIGUSR2:
+                display_info->toggle_frame_trace = TRUE;
+                break;
             default:
                 break;
         }
@@ -188,6 +191,7 @@ setupHandler (gboolean install)
     sigaction (SIGTERM, &act, NULL);
     sigaction (SIGHUP,  &act, NULL);
     sigaction (SIGUSR1, &act, NULL);
+    sigaction (SIGUSR2, &act, NULL);
 }
 
 static void
@@ -1620,6 +1620,12 @@ clientAddUserTimeWin (Client * c)
         XSelectInput (display_info->dpy, c->user_time_win, PropertyChangeMask);
         myDisplayErrorTrapPopIgnored (display_info);
     }
+
+    /* unmanaged clients get indexed by clientAddToList() */
+    if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_MANAGED))
+    {
+        myDisplayAddClientWindow (display_info, c->user_time_win, c, SEARCH_WIN_USER_TIME);
+    }
 }
 
 void
@@ -1642,4 +1648,9 @@ clientRemoveUserTimeWin (Client * c)
         XSelectInput (display_info->dpy, c->user_time_win, NoEventMask);
         myDisplayErrorTrapPopIgnored (display_info);
     }
+
+    if (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_MANAGED))
+    {
+        myDisplayRemoveClientWindow (display_info, c->user_time_win, c, SEARCH_WIN_USER_TIME);
+    }
 }
@@ -20,6 +20,7 @@
 
  */
 
+#include <stdlib.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <glib.h>
@@ -31,6 +32,7 @@
 #include "misc.h"
 #include "client.h"
 #include "placement.h"
+#include "placement_index.h"
 #include "transients.h"
 #include "workspaces.h"
 #include "frame.h"
@@ -39,34 +41,6 @@
 #define USE_CLIENT_STRUTS(c) (FLAG_TEST (c->xfwm_flags, XFWM_FLAG_VISIBLE) && \
                               FLAG_TEST (c->flags, CLIENT_FLAG_HAS_STRUT))
 
-/* Compute rectangle overlap area */
-
-static inline unsigned long
-segment_overlap (int x0, int x1, int tx0, int tx1)
-{
-    if (tx0 > x0)
-    {
-        x0 = tx0;
-    }
-    if (tx1 < x1)
-    {
-        x1 = tx1;
-    }
-    if (x1 <= x0)
-    {
-        return 0;
-    }
-    return (x1 - x0);
-}
-
-static inline unsigned long
-overlap (int x0, int y0, int x1, int y1, int tx0, int ty0, int tx1, int ty1)
-{
-    /* Compute overlapping box */
-    return (segment_overlap (x0, x1, tx0, tx1)
-            * segment_overlap (y0, y1, ty0, ty1));
-}
-
 static inline void
 set_rectangle (GdkRectangle * rect, gint x, gint y, gint width, gint height)
 {
@@ -633,179 +607,68 @@ clientAutoMaximize (Client * c, int full_w, int full_h)
 static void
 smartPlacement (Client * c, int full_x, int full_y, int full_w, int full_h)
 {
-    Client *c2;
     ScreenInfo *screen_info;
+    PlacementFrame frame;
+    PlacementRect *rects, *r;
+    Client *c2;
     gfloat best_overlaps;
-    guint i;
-    gint test_x, test_y, xmax, ymax, best_x, best_y;
-    gint frame_height, frame_width, frame_left, frame_top;
-    gint c2_x, c2_y;
-    gint xmin, ymin;
+    guint i, n_rects;
+    gint best_x, best_y;
 
     g_return_if_fail (c != NULL);
 
     TRACE ("client \"%s\" (0x%lx)", c->name, c->window);
 
     screen_info = c->screen_info;
-    frame_height = frameExtentHeight (c);
-    frame_width = frameExtentWidth (c);
-    frame_left = frameExtentLeft(c);
-    frame_top = frameExtentTop (c);
+
+    frame.height = frameExtentHeight (c);
+    frame.width = frameExtentWidth (c);
+    frame.left = frameExtentLeft(c);
+    frame.top = frameExtentTop (c);
 
     /* max coordinates (bottom-right) */
-    xmax = full_x + full_w - c->width - frameExtentRight (c);
-    ymax = full_y + full_h - c->height - frameExtentBottom (c);
+    frame.xmax = full_x + full_w - c->width - frameExtentRight (c);
+    frame.ymax = full_y + full_h - c->height - frameExtentBottom (c);
 
     /* min coordinates (top-left) */
-    xmin = full_x + frameExtentLeft (c);
-    ymin = full_y + frameExtentTop (c);
-
-    /* start with worst-case position at top-left */
-    best_overlaps = G_MAXFLOAT;
-    best_x = xmin;
-    best_y = ymin;
+    frame.xmin = full_x + frameExtentLeft (c);
+    frame.ymin = full_y + frameExtentTop (c);
 
-    TRACE ("analyzing %i clients", screen_info->client_count);
+    /* the windows to avoid, collected once for all tested positions */
+    rects = g_new (PlacementRect, MAX (screen_info->client_count, 1));
+    n_rects = 0;
 
-    test_y = ymin;
-    do
+    for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
     {
-        gint next_test_y = G_MAXINT;
-        gboolean first_test_x = TRUE;
-
-        TRACE ("testing y position %d", test_y);
-
-        test_x = xmin;
-        do
+        if ((c2 == c) || (c2->type == WINDOW_DESKTOP)
+            || (c->win_workspace != c2->win_workspace)
+            || !FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE))
         {
-            gfloat count_overlaps = 0.0;
-            gint next_test_x = G_MAXINT;
-            gint c2_next_test_x;
-            gint c2_next_test_y;
-            gint c2_frame_height;
-            gint c2_frame_width;
-
-            TRACE ("testing x position %d", test_x);
-
-            for (c2 = screen_info->clients, i = 0; i < screen_info->client_count; c2 = c2->next, i++)
-            {
-                if ((c2 != c) && (c2->type != WINDOW_DESKTOP)
-                    && (c->win_workspace == c2->win_workspace)
-                    && FLAG_TEST (c2->xfwm_flags, XFWM_FLAG_VISIBLE))
-                {
-                    c2_x = frameExtentX (c2);
-                    c2_frame_width = frameExtentWidth (c2);
-                    if (c2_x >= full_x + full_w
-                        || c2_x + c2_frame_width < full_x)
-                    {
-                        /* skip clients on right-of or left-of monitor */
-                        continue;
-                    }
-
-                    c2_y = frameExtentY (c2);
-                    c2_frame_height = frameExtentHeight (c2);
-                    if (c2_y >= full_y + full_h
-                        || c2_y + c2_frame_height < full_y)
-                    {
-                        /* skip clients on above-of or below-of monitor */
-                        continue;
-                    }
-
-                    count_overlaps += overlap (test_x - frame_left,
-                                               test_y - frame_top,
-                                               test_x - frame_left + frame_width,
-                                               test_y - frame_top + frame_height,
-                                               c2_x,
-                                               c2_y,
-                                               c2_x + c2_frame_width,
-                                               c2_y + c2_frame_height);
-
-                    /* find the next x boundy for the step */
-                    if (test_x > c2_x)
-                    {
-                        /* test location is beyond the x of the window,
-                         * take the window right corner as next target */
-                        c2_x += c2_frame_width;
-                    }
-                    c2_next_test_x = MIN (c2_x, xmax);
-                    if (c2_next_test_x < next_test_x
-                        && c2_next_test_x > test_x)
-                    {
-                        /* set new optimal next x step position */
-                        next_test_x = c2_next_test_x;
-                    }
-
-                    if (first_test_x)
-                    {
-                        /* find the next y boundry step */
-                        if (test_y > c2_y)
-                        {
-                            /* test location is beyond the y of the window,
-                             * take the window bottom corner as next target */
-                            c2_y += c2_frame_height;
-                        }
-                        c2_next_test_y = MIN (c2_y, ymax);
-                        if (c2_next_test_y < next_test_y
-                            && c2_next_test_y > test_y)
-                        {
-                            /* set new optimal next y step position */
-                            next_test_y = c2_next_test_y;
-                        }
-                    }
-                }
-            }
-
-            /* don't look for the next y boundry this x row */
-            first_test_x = FALSE;
-
-            if (count_overlaps < best_overlaps)
-            {
-                /* found position with less overlap */
-                best_x = test_x;
-                best_y = test_y;
-                best_overlaps = count_overlaps;
-
-                if (count_overlaps == 0.0f)
-                {
-                    /* overlap is ideal, stop searching */
-                    TRACE ("found position without overlap");
-                    goto found_best;
-                }
-            }
-
-            if (G_LIKELY (next_test_x != G_MAXINT))
-            {
-                test_x = MAX (next_test_x, next_test_x + frameExtentLeft (c));
-                if (test_x > xmax)
-                {
-                   /* always clamp on the monitor */
-                   test_x = xmax;
-                }
-            }
-            else
-            {
-                test_x++;
-            }
+            continue;
         }
-        while (test_x <= xmax);
 
-        if (G_LIKELY (next_test_y != G_MAXINT))
+        r = &rects[n_rects];
+        r->x0 = frameExtentX (c2);
+        r->x1 = r->x0 + frameExtentWidth (c2);
+        if (r->x0 >= full_x + full_w || r->x1 < full_x)
         {
-            test_y = MAX (next_test_y, next_test_y + frameExtentTop (c));
-            if (test_y > ymax)
-            {
-                /* always clamp on the monitor */
-                test_y = ymax;
-            }
+            /* skip clients on right-of or left-of monitor */
+            continue;
         }
-        else
+
+        r->y0 = frameExtentY (c2);
+        r->y1 = r->y0 + frameExtentHeight (c2);
+        if (r->y0 >= full_y + full_h || r->y1 < full_y)
         {
-            test_y++;
+            /* skip clients on above-of or below-of monitor */
+            continue;
         }
+
+        n_rects++;
     }
-    while (test_y <= ymax);
 
-    found_best:
+    best_overlaps = placementFindBest (rects, n_rects, &frame, &best_x, &best_y);
+    g_free (rects);
 
     TRACE ("overlaps %f at %d,%d (x,y)", best_overlaps, best_x, best_y);
 
@@ -0,0 +1,302 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <libxfce4util/libxfce4util.h>
+
+#include "placement_index.h"
+
+/*
+ * The search behind smartPlacement(), on plain rectangles so that it can be
+ * tested without a display. The window edges are sorted per axis so that the
+ * next candidate position can be found without walking all windows for every
+ * tested position.
+ */
+typedef struct
+{
+    gint start;
+    gint end;
+} PlacementSpan;
+
+typedef struct
+{
+    gint *starts;           /* sorted */
+    PlacementSpan *spans;   /* sorted by end */
+} PlacementAxis;
+
+typedef struct
+{
+    const PlacementRect *rects;  /* in client list order, the order overlaps add up in */
+    const PlacementRect **row;   /* the rects crossing the currently tested row */
+    PlacementAxis x_axis;
+    PlacementAxis y_axis;
+    guint n_rects;
+    guint n_row;
+} PlacementIndex;
+
+static int
+compareEdges (gconstpointer a, gconstpointer b)
+{
+    gint ea = *((const gint *) a);
+    gint eb = *((const gint *) b);
+
+    return (ea > eb) - (ea < eb);
+}
+
+static int
+compareSpanEnds (gconstpointer a, gconstpointer b)
+{
+    return compareEdges (&((const PlacementSpan *) a)->end,
+                         &((const PlacementSpan *) b)->end);
+}
+
+static void
+placementAxisInit (PlacementAxis *axis, const PlacementRect *rects, guint n_rects, gboolean vertical)
+{
+    guint i;
+
+    axis->starts = g_new (gint, MAX (n_rects, 1));
+    axis->spans = g_new (PlacementSpan, MAX (n_rects, 1));
+    for (i = 0; i < n_rects; i++)
+    {
+        axis->spans[i].start = vertical ? rects[i].y0 : rects[i].x0;
+        axis->spans[i].end = vertical ? rects[i].y1 : rects[i].x1;
+        axis->starts[i] = axis->spans[i].start;
+    }
+    qsort (axis->starts, n_rects, sizeof (gint), compareEdges);
+    qsort (axis->spans, n_rects, sizeof (PlacementSpan), compareSpanEnds);
+}
+
+/* index of the first span ending after pos, or of the first start after pos */
+static guint
+placementAxisUpperBound (PlacementAxis *axis, guint n, gint pos, gboolean ends)
+{
+    guint low, high, mid;
+    gint edge;
+
+    low = 0;
+    high = n;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        edge = ends ? axis->spans[mid].end : axis->starts[mid];
+        if (edge <= pos)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * The next position worth testing after pos: the nearest window edge past pos,
+ * taking the far edge of the windows pos is inside of and the near edge of the
+ * windows beyond pos, like the former walk over all clients did, clamped to max.
+ */
+static gint
+placementAxisNext (PlacementAxis *axis, guint n, gint pos, gint max)
+{
+    gint next;
+    guint i;
+
+    if (max <= pos)
+    {
+        return G_MAXINT;
+    }
+
+    next = G_MAXINT;
+    i = placementAxisUpperBound (axis, n, pos, FALSE);
+    if (i < n)
+    {
+        next = axis->starts[i];
+    }
+
+    for (i = placementAxisUpperBound (axis, n, pos, TRUE); i < n && axis->spans[i].end < next; i++)
+    {
+        if (axis->spans[i].start < pos)
+        {
+            next = axis->spans[i].end;
+            break;
+        }
+    }
+
+    return (next == G_MAXINT) ? G_MAXINT : MIN (next, max);
+}
+
+static void
+placementIndexInit (PlacementIndex *index, const PlacementRect *rects, guint n_rects)
+{
+    index->rects = rects;
+    index->row = g_new (const PlacementRect *, MAX (n_rects, 1));
+    index->n_rects = n_rects;
+    index->n_row = 0;
+
+    placementAxisInit (&index->x_axis, rects, n_rects, FALSE);
+    placementAxisInit (&index->y_axis, rects, n_rects, TRUE);
+}
+
+static void
+placementIndexSetRow (PlacementIndex *index, gint y0, gint y1)
+{
+    guint i;
+
+    /* windows outside of the row cannot overlap any position on it */
+    index->n_row = 0;
+    for (i = 0; i < index->n_rects; i++)
+    {
+        if (segment_overlap (y0, y1, index->rects[i].y0, index->rects[i].y1))
+        {
+            index->row[index->n_row++] = &index->rects[i];
+        }
+    }
+}
+
+static void
+placementIndexFree (PlacementIndex *index)
+{
+    g_free (index->x_axis.starts);
+    g_free (index->x_axis.spans);
+    g_free (index->y_axis.starts);
+    g_free (index->y_axis.spans);
+    g_free (index->row);
+}
+
+/*
+ * Finds the position in the given range where the frame overlaps the
+ * rectangles the least, the first one without any overlap, scanning
+ * rows top to bottom and positions left to right. Returns the overlap.
+ */
+gfloat
+placementFindBest (const PlacementRect *rects, guint n_rects, const PlacementFrame *frame,
+                   gint *best_x, gint *best_y)
+{
+    PlacementIndex index;
+    const PlacementRect *r;
+    gfloat best_overlaps;
+    guint i;
+    gint test_x, test_y;
+
+    g_return_val_if_fail (frame != NULL, G_MAXFLOAT);
+    g_return_val_if_fail (best_x != NULL && best_y != NULL, G_MAXFLOAT);
+
+    /* start with worst-case position at top-left */
+    best_overlaps = G_MAXFLOAT;
+    *best_x = frame->xmin;
+    *best_y = frame->ymin;
+
+    placementIndexInit (&index, rects, n_rects);
+
+    TRACE ("analyzing %u clients", n_rects);
+
+    test_y = frame->ymin;
+    do
+    {
+        gint next_test_y;
+
+        TRACE ("testing y position %d", test_y);
+
+        /* find the next y boundry step */
+        next_test_y = placementAxisNext (&index.y_axis, index.n_rects, test_y, frame->ymax);
+        placementIndexSetRow (&index, test_y - frame->top, test_y - frame->top + frame->height);
+
+        test_x = frame->xmin;
+        do
+        {
+            gfloat count_overlaps = 0.0;
+            gint next_test_x;
+
+            TRACE ("testing x position %d", test_x);
+
+            for (i = 0; i < index.n_row; i++)
+            {
+                r = index.row[i];
+                count_overlaps += overlap (test_x - frame->left,
+                                           test_y - frame->top,
+                                           test_x - frame->left + frame->width,
+                                           test_y - frame->top + frame->height,
+                                           r->x0,
+                                           r->y0,
+                                           r->x1,
+                                           r->y1);
+            }
+
+            if (count_overlaps < best_overlaps)
+            {
+                /* found position with less overlap */
+                *best_x = test_x;
+                *best_y = test_y;
+                best_overlaps = count_overlaps;
+
+                if (count_overlaps == 0.0f)
+                {
+                    /* overlap is ideal, stop searching */
+                    TRACE ("found position without overlap");
+                    goto found_best;
+                }
+            }
+
+            /* find the next x boundy for the step */
+            next_test_x = placementAxisNext (&index.x_axis, index.n_rects, test_x, frame->xmax);
+            if (G_LIKELY (next_test_x != G_MAXINT))
+            {
+                test_x = MAX (next_test_x, next_test_x + frame->left);
+                if (test_x > frame->xmax)
+                {
+                   /* always clamp on the monitor */
+                   test_x = frame->xmax;
+                }
+            }
+            else
+            {
+                test_x++;
+            }
+        }
+        while (test_x <= frame->xmax);
+
+        if (G_LIKELY (next_test_y != G_MAXINT))
+        {
+            test_y = MAX (next_test_y, next_test_y + frame->top);
+            if (test_y > frame->ymax)
+            {
+                /* always clamp on the monitor */
+                test_y = frame->ymax;
+            }
+        }
+        else
+        {
+            test_y++;
+        }
+    }
+    while (test_y <= frame->ymax);
+
+    found_best:
+
+    placementIndexFree (&index);
+
+    return best_overlaps;
+}
@@ -0,0 +1,78 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#ifndef INC_PLACEMENT_INDEX_H
+#define INC_PLACEMENT_INDEX_H
+
+#include <glib.h>
+
+/* Compute rectangle overlap area */
+
+static inline unsigned long
+segment_overlap (int x0, int x1, int tx0, int tx1)
+{
+    if (tx0 > x0)
+    {
+        x0 = tx0;
+    }
+    if (tx1 < x1)
+    {
+        x1 = tx1;
+    }
+    if (x1 <= x0)
+    {
+        return 0;
+    }
+    return (x1 - x0);
+}
+
+static inline unsigned long
+overlap (int x0, int y0, int x1, int y1, int tx0, int ty0, int tx1, int ty1)
+{
+    /* Compute overlapping box */
+    return (segment_overlap (x0, x1, tx0, tx1)
+            * segment_overlap (y0, y1, ty0, ty1));
+}
+
+/* frame extents of a window the placed client should not overlap */
+typedef struct
+{
+    gint x0, y0, x1, y1;
+} PlacementRect;
+
+typedef struct
+{
+    /* range of the client position */
+    gint xmin, ymin;
+    gint xmax, ymax;
+    /* frame extents of the placed client */
+    gint left, top;
+    gint width, height;
+} PlacementFrame;
+
+gfloat                   placementFindBest                      (const PlacementRect *,
+                                                                 guint,
+                                                                 const PlacementFrame *,
+                                                                 gint *,
+                                                                 gint *);
+
+#endif /* INC_PLACEMENT_INDEX_H */
@@ -72,6 +72,17 @@ struct _gaussian_conv {
 };
 typedef struct _gaussian_conv gaussian_conv;
 
+typedef struct _ShadowTiles ShadowTiles;
+typedef struct _FrameTrace FrameTrace;
+
+/* counters of the last frame painted by paint_all() */
+typedef struct
+{
+    guint windows_painted;
+    guint windows_culled;
+    guint region_ops;
+} CompositorFrameStats;
+
 #endif /* HAVE_COMPOSITOR */
 
 typedef enum
@@ -181,12 +192,17 @@ struct _ScreenInfo
 #endif
     GList *cwindows;
     GHashTable *cwindow_hash;
+    GPtrArray *paint_stack;     /* windows painted in the current frame, top first */
+    GArray *paint_occluders;    /* XRectangle of the opaque windows painted so far */
+    CompositorFrameStats frame_stats;
+    FrameTrace *frame_trace;    /* NULL unless frame timings are being recorded */
     Window output;
 
     gaussian_conv *gaussianMap;
     gint gaussianSize;
     guchar *shadowCorner;
     guchar *shadowTop;
+    ShadowTiles *shadowTiles[26]; /* per opacity level, see shadow_tiles() */
 
     gushort current_buffer;
     gushort use_n_buffers;
@@ -0,0 +1,262 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#include <X11/X.h>
+#include <glib.h>
+
+#include "client_index.h"
+#include "display.h"
+
+/* the windows of a managed client, what clientGetFromWindow() compares,
+ * with as many buttons as the one of client.h */
+struct _Client
+{
+    struct _Client *next;
+    Window window;
+    Window frame;
+    Window user_time_win;
+    Window buttons[BUTTON_COUNT];
+};
+
+/*
+ * The lookup as it was before the client windows got indexed: a walk over
+ * all clients, comparing each window of each client like clientGetFromWindow().
+ */
+static struct _Client *
+scanClients (struct _Client *clients, guint n_clients, Window w, unsigned short mode)
+{
+    struct _Client *c;
+    guint i;
+    gint b;
+
+    for (c = clients, i = 0; i < n_clients; c = c->next, i++)
+    {
+        if ((mode & SEARCH_WINDOW) && c->window == w)
+        {
+            return c;
+        }
+        if ((mode & SEARCH_FRAME) && c->frame == w)
+        {
+            return c;
+        }
+        if ((mode & SEARCH_WIN_USER_TIME) && c->user_time_win == w)
+        {
+            return c;
+        }
+        if (mode & SEARCH_BUTTON)
+        {
+            for (b = 0; b < BUTTON_COUNT; b++)
+            {
+                if (c->buttons[b] == w)
+                {
+                    return c;
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Clients with consecutive window ids like the X server hands them out,
+ * every group of four sharing one user time window like the windows of
+ * an application do.
+ */
+static struct _Client *
+createClients (ClientIndex *index, guint n_clients)
+{
+    struct _Client *clients;
+    Window w;
+    guint i;
+    gint b;
+
+    clients = g_new0 (struct _Client, n_clients);
+    w = 0x200000;
+    for (i = 0; i < n_clients; i++)
+    {
+        struct _Client *c = &clients[i];
+
+        c->next = &clients[(i + 1) % n_clients];
+        c->window = w++;
+        c->frame = w++;
+        c->user_time_win = (i % 4 == 0) ? w++ : clients[i - i % 4].user_time_win;
+        for (b = 0; b < BUTTON_COUNT; b++)
+        {
+            c->buttons[b] = w++;
+        }
+
+        clientIndexAdd (index, c->window, c, SEARCH_WINDOW);
+        clientIndexAdd (index, c->frame, c, SEARCH_FRAME);
+        clientIndexAdd (index, c->user_time_win, c, SEARCH_WIN_USER_TIME);
+        for (b = 0; b < BUTTON_COUNT; b++)
+        {
+            clientIndexAdd (index, c->buttons[b], c, SEARCH_BUTTON);
+        }
+    }
+
+    return clients;
+}
+
+static void
+testLookup (void)
+{
+    static const unsigned short modes[] = {
+        SEARCH_WINDOW,
+        SEARCH_FRAME,
+        SEARCH_BUTTON,
+        SEARCH_WIN_USER_TIME,
+        SEARCH_WINDOW | SEARCH_FRAME,
+        SEARCH_FRAME | SEARCH_BUTTON,
+        SEARCH_WINDOW | SEARCH_FRAME | SEARCH_BUTTON | SEARCH_WIN_USER_TIME,
+    };
+    struct _Client *clients;
+    ClientIndex *index;
+    Window w;
+    guint i;
+
+    index = clientIndexNew ();
+    clients = createClients (index, 64);
+
+    /* every window, the ones nobody owns included, with every mode */
+    for (w = 0x200000 - 4; w < 0x200000 + 64 * 10; w++)
+    {
+        for (i = 0; i < G_N_ELEMENTS (modes); i++)
+        {
+            g_assert_true (clientIndexLookup (index, w, modes[i]) == scanClients (clients, 64, w, modes[i]));
+        }
+    }
+
+    clientIndexFree (index);
+    g_free (clients);
+}
+
+static void
+testSharedWindow (void)
+{
+    struct _Client *clients;
+    ClientIndex *index;
+    Window user_time_win;
+
+    index = clientIndexNew ();
+    clients = createClients (index, 4);
+    user_time_win = clients[0].user_time_win;
+
+    /* the oldest client owning the window is found first */
+    g_assert_true (clientIndexLookup (index, user_time_win, SEARCH_WIN_USER_TIME) == &clients[0]);
+
+    /* removing the head of the list keeps the others */
+    clientIndexRemove (index, user_time_win, &clients[0], SEARCH_WIN_USER_TIME);
+    g_assert_true (clientIndexLookup (index, user_time_win, SEARCH_WIN_USER_TIME) == &clients[1]);
+    clientIndexRemove (index, user_time_win, &clients[2], SEARCH_WIN_USER_TIME);
+    g_assert_true (clientIndexLookup (index, user_time_win, SEARCH_WIN_USER_TIME) == &clients[1]);
+    clientIndexRemove (index, user_time_win, &clients[1], SEARCH_WIN_USER_TIME);
+    g_assert_true (clientIndexLookup (index, user_time_win, SEARCH_WIN_USER_TIME) == &clients[3]);
+    clientIndexRemove (index, user_time_win, &clients[3], SEARCH_WIN_USER_TIME);
+    g_assert_null (clientIndexLookup (index, user_time_win, SEARCH_WIN_USER_TIME));
+
+    /* a window owned in several ways stays until the last of them goes */
+    clientIndexAdd (index, clients[1].window, &clients[1], SEARCH_FRAME);
+    clientIndexRemove (index, clients[1].window, &clients[1], SEARCH_WINDOW);
+    g_assert_null (clientIndexLookup (index, clients[1].window, SEARCH_WINDOW));
+    g_assert_true (clientIndexLookup (index, clients[1].window, SEARCH_FRAME) == &clients[1]);
+    clientIndexRemove (index, clients[1].window, &clients[1], SEARCH_FRAME);
+    g_assert_null (clientIndexLookup (index, clients[1].window, SEARCH_FRAME));
+
+    clientIndexFree (index);
+    g_free (clients);
+}
+
+static void
+testPerformance (void)
+{
+    static const guint counts[] = { 10, 100, 1000 };
+    struct _Client *clients;
+    ClientIndex *index;
+    GRand *rand;
+    gdouble scan_time, index_time;
+    Window *windows;
+    guint found;
+    guint i, j;
+
+    if (!g_test_perf ())
+    {
+        g_test_skip ("only run with -m perf");
+        return;
+    }
+
+#define LOOKUPS 100000
+
+    rand = g_rand_new_with_seed (20111);
+    windows = g_new (Window, LOOKUPS);
+    for (i = 0; i < G_N_ELEMENTS (counts); i++)
+    {
+        index = clientIndexNew ();
+        clients = createClients (index, counts[i]);
+
+        /* the frames and buttons the pointer events are reported on */
+        for (j = 0; j < LOOKUPS; j++)
+        {
+            windows[j] = clients[g_rand_int_range (rand, 0, counts[i])].frame + g_rand_int_range (rand, 0, 2) * 2;
+        }
+
+        found = 0;
+        g_test_timer_start ();
+        for (j = 0; j < LOOKUPS; j++)
+        {
+            found += scanClients (clients, counts[i], windows[j], SEARCH_FRAME | SEARCH_BUTTON) != NULL;
+        }
+        scan_time = g_test_timer_elapsed ();
+        g_assert_cmpuint (found, ==, LOOKUPS);
+
+        found = 0;
+        g_test_timer_start ();
+        for (j = 0; j < LOOKUPS; j++)
+        {
+            found += clientIndexLookup (index, windows[j], SEARCH_FRAME | SEARCH_BUTTON) != NULL;
+        }
+        index_time = g_test_timer_elapsed ();
+        g_assert_cmpuint (found, ==, LOOKUPS);
+
+        g_test_message ("%u clients: former scan %.1f ns, indexed %.1f ns per lookup",
+                        counts[i], scan_time * 1e9 / LOOKUPS, index_time * 1e9 / LOOKUPS);
+
+        clientIndexFree (index);
+        g_free (clients);
+    }
+    g_free (windows);
+    g_rand_free (rand);
+
+#undef LOOKUPS
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/client-index/lookup", testLookup);
+    g_test_add_func ("/client-index/shared-window", testSharedWindow);
+    g_test_add_func ("/client-index/performance", testPerformance);
+
+    return g_test_run ();
+}
@@ -0,0 +1,323 @@
+/*      $Id$
+
+        This program is free software; you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation; either version 2, or (at your option)
+        any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program; if not, write to the Free Software
+        Foundation, Inc., Inc., 51 Franklin Street, Fifth Floor, Boston,
+        MA 02110-1301, USA.
+
+
+        xfwm4    - (c) 2002-2022 Olivier Fourdan
+
+ */
+
+#include <glib.h>
+
+#include "placement_index.h"
+
+/* a 1920x1080 monitor and a 600x400 client with the default theme borders */
+#define MONITOR_WIDTH 1920
+#define MONITOR_HEIGHT 1080
+#define CLIENT_WIDTH 600
+#define CLIENT_HEIGHT 400
+#define FRAME_LEFT 4
+#define FRAME_RIGHT 4
+#define FRAME_TOP 28
+#define FRAME_BOTTOM 4
+
+/*
+ * smartPlacement() as it was before the window edges got indexed: every
+ * tested position walks all windows, both for the overlap and for the
+ * next position to test. The indexed search must find the same position.
+ */
+static gfloat
+scanPlacement (const PlacementRect *rects, guint n_rects, const PlacementFrame *frame,
+               gint *best_x, gint *best_y)
+{
+    gfloat best_overlaps;
+    guint i;
+    gint test_x, test_y;
+
+    best_overlaps = G_MAXFLOAT;
+    *best_x = frame->xmin;
+    *best_y = frame->ymin;
+
+    test_y = frame->ymin;
+    do
+    {
+        gint next_test_y = G_MAXINT;
+        gboolean first_test_x = TRUE;
+
+        test_x = frame->xmin;
+        do
+        {
+            gfloat count_overlaps = 0.0;
+            gint next_test_x = G_MAXINT;
+
+            for (i = 0; i < n_rects; i++)
+            {
+                gint c2_x = rects[i].x0;
+                gint c2_y = rects[i].y0;
+                gint c2_next;
+
+                count_overlaps += overlap (test_x - frame->left,
+                                           test_y - frame->top,
+                                           test_x - frame->left + frame->width,
+                                           test_y - frame->top + frame->height,
+                                           rects[i].x0,
+                                           rects[i].y0,
+                                           rects[i].x1,
+                                           rects[i].y1);
+
+                if (test_x > c2_x)
+                {
+                    c2_x = rects[i].x1;
+                }
+                c2_next = MIN (c2_x, frame->xmax);
+                if (c2_next < next_test_x && c2_next > test_x)
+                {
+                    next_test_x = c2_next;
+                }
+
+                if (first_test_x)
+                {
+                    if (test_y > c2_y)
+                    {
+                        c2_y = rects[i].y1;
+                    }
+                    c2_next = MIN (c2_y, frame->ymax);
+                    if (c2_next < next_test_y && c2_next > test_y)
+                    {
+                        next_test_y = c2_next;
+                    }
+                }
+            }
+            first_test_x = FALSE;
+
+            if (count_overlaps < best_overlaps)
+            {
+                *best_x = test_x;
+                *best_y = test_y;
+                best_overlaps = count_overlaps;
+
+                if (count_overlaps == 0.0f)
+                {
+                    return best_overlaps;
+                }
+            }
+
+            if (next_test_x != G_MAXINT)
+            {
+                test_x = MIN (MAX (next_test_x, next_test_x + frame->left), frame->xmax);
+            }
+            else
+            {
+                test_x++;
+            }
+        }
+        while (test_x <= frame->xmax);
+
+        if (next_test_y != G_MAXINT)
+        {
+            test_y = MIN (MAX (next_test_y, next_test_y + frame->top), frame->ymax);
+        }
+        else
+        {
+            test_y++;
+        }
+    }
+    while (test_y <= frame->ymax);
+
+    return best_overlaps;
+}
+
+static void
+initFrame (PlacementFrame *frame)
+{
+    frame->xmin = FRAME_LEFT;
+    frame->ymin = FRAME_TOP;
+    frame->xmax = MONITOR_WIDTH - CLIENT_WIDTH - FRAME_RIGHT;
+    frame->ymax = MONITOR_HEIGHT - CLIENT_HEIGHT - FRAME_BOTTOM;
+    frame->left = FRAME_LEFT;
+    frame->top = FRAME_TOP;
+    frame->width = FRAME_LEFT + CLIENT_WIDTH + FRAME_RIGHT;
+    frame->height = FRAME_TOP + CLIENT_HEIGHT + FRAME_BOTTOM;
+}
+
+/* windows on the monitor, some of them partly off it like the ones
+ * smartPlacement() keeps because they still cross the monitor */
+static PlacementRect *
+randomRects (GRand *rand, guint n_rects)
+{
+    PlacementRect *rects;
+    guint i;
+
+    rects = g_new (PlacementRect, MAX (n_rects, 1));
+    for (i = 0; i < n_rects; i++)
+    {
+        gint width = g_rand_int_range (rand, 50, 1200);
+        gint height = g_rand_int_range (rand, 50, 800);
+
+        rects[i].x0 = g_rand_int_range (rand, -width / 2, MONITOR_WIDTH);
+        rects[i].y0 = g_rand_int_range (rand, -height / 2, MONITOR_HEIGHT);
+        rects[i].x1 = rects[i].x0 + width;
+        rects[i].y1 = rects[i].y0 + height;
+    }
+
+    return rects;
+}
+
+static void
+checkSame (const PlacementRect *rects, guint n_rects, const PlacementFrame *frame)
+{
+    gfloat scan_overlaps, best_overlaps;
+    gint scan_x, scan_y, best_x, best_y;
+
+    scan_overlaps = scanPlacement (rects, n_rects, frame, &scan_x, &scan_y);
+    best_overlaps = placementFindBest (rects, n_rects, frame, &best_x, &best_y);
+
+    g_assert_cmpint (best_x, ==, scan_x);
+    g_assert_cmpint (best_y, ==, scan_y);
+    g_assert_cmpfloat (best_overlaps, ==, scan_overlaps);
+}
+
+static void
+testNoWindows (void)
+{
+    PlacementFrame frame;
+    gint best_x, best_y;
+
+    initFrame (&frame);
+    g_assert_cmpfloat (placementFindBest (NULL, 0, &frame, &best_x, &best_y), ==, 0.0f);
+    g_assert_cmpint (best_x, ==, frame.xmin);
+    g_assert_cmpint (best_y, ==, frame.ymin);
+}
+
+static void
+testCovered (void)
+{
+    PlacementRect rects[] = {
+        { 0, 0, MONITOR_WIDTH, MONITOR_HEIGHT },
+        { 0, 0, MONITOR_WIDTH / 2, MONITOR_HEIGHT },
+        { MONITOR_WIDTH / 3, MONITOR_HEIGHT / 3, MONITOR_WIDTH, MONITOR_HEIGHT },
+    };
+    PlacementFrame frame;
+
+    /* no free spot, the whole monitor gets scanned */
+    initFrame (&frame);
+    checkSame (rects, G_N_ELEMENTS (rects), &frame);
+}
+
+static void
+testRandom (void)
+{
+    PlacementFrame frame;
+    PlacementRect *rects;
+    GRand *rand;
+    guint n_rects;
+    guint i;
+
+    rand = g_rand_new_with_seed (20021);
+    initFrame (&frame);
+    for (i = 0; i < 500; i++)
+    {
+        n_rects = g_rand_int_range (rand, 1, 40);
+        rects = randomRects (rand, n_rects);
+        checkSame (rects, n_rects, &frame);
+        g_free (rects);
+    }
+    g_rand_free (rand);
+}
+
+static void
+testTiled (void)
+{
+    PlacementFrame frame;
+    PlacementRect *rects;
+    guint n_rects;
+    guint i;
+
+    /* a grid of windows sharing their edges, with one cell left free */
+    initFrame (&frame);
+    rects = g_new (PlacementRect, 64);
+    n_rects = 0;
+    for (i = 0; i < 64; i++)
+    {
+        if (i == 45)
+        {
+            continue;
+        }
+        rects[n_rects].x0 = (i % 8) * (MONITOR_WIDTH / 8);
+        rects[n_rects].y0 = (i / 8) * (MONITOR_HEIGHT / 8);
+        rects[n_rects].x1 = rects[n_rects].x0 + MONITOR_WIDTH / 8;
+        rects[n_rects].y1 = rects[n_rects].y0 + MONITOR_HEIGHT / 8;
+        n_rects++;
+    }
+    checkSame (rects, n_rects, &frame);
+    g_free (rects);
+}
+
+static void
+testPerformance (void)
+{
+    static const guint counts[] = { 10, 50, 100, 200 };
+    PlacementFrame frame;
+    PlacementRect *rects;
+    GRand *rand;
+    gdouble scan_time, best_time;
+    gint best_x, best_y;
+    guint i, round;
+
+    if (!g_test_perf ())
+    {
+        g_test_skip ("only run with -m perf");
+        return;
+    }
+
+    rand = g_rand_new_with_seed (20022);
+    initFrame (&frame);
+    for (i = 0; i < G_N_ELEMENTS (counts); i++)
+    {
+        scan_time = best_time = 0.0;
+        for (round = 0; round < 10; round++)
+        {
+            rects = randomRects (rand, counts[i]);
+
+            g_test_timer_start ();
+            scanPlacement (rects, counts[i], &frame, &best_x, &best_y);
+            scan_time += g_test_timer_elapsed ();
+
+            g_test_timer_start ();
+            placementFindBest (rects, counts[i], &frame, &best_x, &best_y);
+            best_time += g_test_timer_elapsed ();
+
+            g_free (rects);
+        }
+        g_test_message ("%u windows: former scan %.3f ms, indexed %.3f ms per placement",
+                        counts[i], scan_time * 100.0, best_time * 100.0);
+    }
+    g_rand_free (rand);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/placement/no-windows", testNoWindows);
+    g_test_add_func ("/placement/covered", testCovered);
+    g_test_add_func ("/placement/random", testRandom);
+    g_test_add_func ("/placement/tiled", testTiled);
+    g_test_add_func ("/placement/performance", testPerformance);
+
+    return g_test_run ();
+}